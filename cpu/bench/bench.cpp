@@ -0,0 +1,236 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#include <benchmark/benchmark.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <string>
+#include <thread>
+
+#include "generator.h"
+#include "grid.h"
+#include "planner.h"
+#include "solver.h"
+
+namespace {
+// Neighbourhoods hold about this many points whatever the size, see Radius_.
+constexpr uint64_t kMinPts = 32;
+
+const std::vector<int64_t> kSizes{1 << 16, 1 << 20};
+// the bitmap adjacency takes N^2/8 bytes.
+const std::vector<int64_t> kBitmapSizes{1 << 12, 1 << 15};
+const std::vector<int64_t> kShapes{
+    static_cast<int64_t>(DBSCAN::generator::Shape::Uniform),
+    static_cast<int64_t>(DBSCAN::generator::Shape::Gaussian),
+    static_cast<int64_t>(DBSCAN::generator::Shape::Skew),
+    static_cast<int64_t>(DBSCAN::generator::Shape::Duplicates)};
+// single-threaded and all cores
+const std::vector<int64_t> kThreads = [] {
+  const auto num_cores =
+      std::clamp<int64_t>(std::thread::hardware_concurrency(), 1, 255);
+  return num_cores > 1 ? std::vector<int64_t>{1, num_cores}
+                       : std::vector<int64_t>{1};
+}();
+
+// A blob of the default generator holds N/20 points with a spread of 0.1,
+// so near its centre a disc of radius r holds N/20 * r^2 / (2 * 0.1^2) =
+// 2.5 * N * r^2 points; this radius gives about kMinPts.
+float Radius_(const uint64_t num_vtx) {
+  return std::sqrt(kMinPts / (2.5f * num_vtx));
+}
+
+// Datasets are generated once per (size, shape) and copied into each run.
+const DBSCAN::input_type::TwoDimPoints& Dataset_(
+    const benchmark::State& state) {
+  static std::map<std::pair<int64_t, int64_t>,
+                  std::unique_ptr<DBSCAN::input_type::TwoDimPoints>>
+      cache;
+  auto& points = cache[{state.range(0), state.range(1)}];
+  if (points == nullptr) {
+    DBSCAN::generator::Options options;
+    options.num_vtx = state.range(0);
+    options.shape = static_cast<DBSCAN::generator::Shape>(state.range(1));
+    points = DBSCAN::generator::Generate(
+        options, std::thread::hardware_concurrency());
+  }
+  return *points;
+}
+
+std::unique_ptr<DBSCAN::Grid> MakeGrid_(
+    const DBSCAN::input_type::TwoDimPoints& points, const float radius,
+    const uint8_t num_threads) {
+  // same bounds as Solver::Reset
+  float max_x = std::numeric_limits<float>::lowest(), max_y = max_x;
+  float min_x = std::numeric_limits<float>::max(), min_y = min_x;
+  for (uint64_t vtx = 0; vtx < points.d1.size(); ++vtx) {
+    max_x = std::max(max_x, points.d1[vtx] + radius / 2);
+    min_x = std::min(min_x, points.d1[vtx] - radius / 2);
+    max_y = std::max(max_y, points.d2[vtx] + radius / 2);
+    min_y = std::min(min_y, points.d2[vtx] - radius / 2);
+  }
+  return std::make_unique<DBSCAN::Grid>(max_x, max_y, min_x, min_y, radius,
+                                        points.d1.size(), num_threads);
+}
+
+enum class Stage { InsertEdges, FinalizeGraph, ClassifyNoises, Identify };
+
+// Runs the pipeline with |plan| up to |stage| untimed, then times |stage|
+// alone.
+void BM_Stage_(benchmark::State& state, const Stage stage,
+               const DBSCAN::planner::Plan& plan = {}) {
+  const auto& dataset = Dataset_(state);
+  const uint64_t num_vtx = dataset.d1.size();
+  const auto num_threads = static_cast<uint8_t>(state.range(2));
+  DBSCAN::Solver solver(
+      std::make_unique<DBSCAN::input_type::TwoDimPoints>(dataset), kMinPts,
+      Radius_(num_vtx), num_threads);
+  solver.set_plan(plan);
+  for (auto _ : state) {
+    state.PauseTiming();
+    solver.Reset(std::make_unique<DBSCAN::input_type::TwoDimPoints>(dataset),
+                 kMinPts, Radius_(num_vtx));
+    solver.ConstructGrid();
+    if (stage > Stage::InsertEdges) solver.InsertEdges();
+    if (stage > Stage::FinalizeGraph) solver.FinalizeGraph();
+    if (stage > Stage::ClassifyNoises) solver.ClassifyNoises();
+    state.ResumeTiming();
+    switch (stage) {
+      case Stage::InsertEdges:
+        solver.InsertEdges();
+        break;
+      case Stage::FinalizeGraph:
+        solver.FinalizeGraph();
+        break;
+      case Stage::ClassifyNoises:
+        solver.ClassifyNoises();
+        break;
+      case Stage::Identify:
+        solver.IdentifyClusters();
+        break;
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * num_vtx);
+}
+
+void BM_GridConstruct(benchmark::State& state) {
+  const auto& dataset = Dataset_(state);
+  const auto num_threads = static_cast<uint8_t>(state.range(2));
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto grid = MakeGrid_(dataset, Radius_(dataset.d1.size()), num_threads);
+    state.ResumeTiming();
+    grid->Construct(dataset.d1, dataset.d2);
+  }
+  state.SetItemsProcessed(state.iterations() * dataset.d1.size());
+}
+
+void BM_GetNeighbouringVtx(benchmark::State& state) {
+  const auto& dataset = Dataset_(state);
+  const uint64_t num_vtx = dataset.d1.size();
+  auto grid = MakeGrid_(dataset, Radius_(num_vtx), 1u);
+  grid->Construct(dataset.d1, dataset.d2);
+  std::vector<uint64_t> nbs;
+  uint64_t num_candidates = 0;
+  for (auto _ : state) {
+    for (uint64_t u = 0; u < num_vtx; ++u) {
+      grid->GetNeighbouringVtx(u, dataset.d1[u], dataset.d2[u], nbs);
+      num_candidates += nbs.size();
+    }
+    benchmark::DoNotOptimize(num_candidates);
+  }
+  state.SetItemsProcessed(state.iterations() * num_vtx);
+  state.counters["candidates/vtx"] =
+      static_cast<double>(num_candidates) / (state.iterations() * num_vtx);
+}
+
+void BM_FinalizeGraph(benchmark::State& state) {
+  BM_Stage_(state, Stage::FinalizeGraph);
+}
+void BM_ClassifyNoises(benchmark::State& state) {
+  BM_Stage_(state, Stage::ClassifyNoises);
+}
+
+// as DBSCAN_BENCHMARK below, with |sizes|.
+void Configure_(benchmark::internal::Benchmark* const bench,
+                const std::vector<int64_t>& sizes) {
+  bench->ArgsProduct({sizes, kShapes, kThreads})
+      ->ArgNames({"n", "shape", "threads"})
+      ->Unit(benchmark::kMillisecond)
+      ->UseRealTime();
+}
+
+/*
+ * BM_InsertEdges/<adjacency>/<kernel> for every adjacency and kernel this
+ * host runs, and BM_IdentifyClusters/<labeller> for both labellers, also on
+ * the implicit store (BM_IdentifyClusters/implicit/<labeller>), so that the
+ * variants are compared in one process.
+ */
+void RegisterVariants_() {
+  using DBSCAN::Adjacency;
+  for (const auto adjacency :
+       {Adjacency::Csr, Adjacency::BlockedBitmap, Adjacency::Bitmap}) {
+    for (const auto kernel : DBSCAN::kernels::Available()) {
+      DBSCAN::planner::Plan plan;
+      plan.adjacency = adjacency;
+      plan.kernel = kernel;
+      const std::string name = "BM_InsertEdges/" +
+                               DBSCAN::planner::ToString(adjacency) + "/" +
+                               DBSCAN::planner::ToString(kernel);
+      Configure_(benchmark::RegisterBenchmark(
+                     name.c_str(),
+                     [plan](benchmark::State& state) {
+                       BM_Stage_(state, Stage::InsertEdges, plan);
+                     }),
+                 adjacency == Adjacency::Bitmap ? kBitmapSizes : kSizes);
+    }
+  }
+  for (const bool implicit : {false, true}) {
+    for (const auto labeller :
+         {DBSCAN::Labeller::Bfs, DBSCAN::Labeller::UnionFind}) {
+      DBSCAN::planner::Plan plan;
+      if (implicit) plan.adjacency = Adjacency::Implicit;
+      plan.labeller = labeller;
+      const std::string name = std::string("BM_IdentifyClusters/") +
+                               (implicit ? "implicit/" : "") +
+                               DBSCAN::planner::ToString(labeller);
+      Configure_(benchmark::RegisterBenchmark(
+                     name.c_str(),
+                     [plan](benchmark::State& state) {
+                       BM_Stage_(state, Stage::Identify, plan);
+                     }),
+                 kSizes);
+    }
+  }
+}
+}  // namespace
+
+// args: number of points, generator::Shape, number of threads
+#define DBSCAN_BENCHMARK(fn)                   \
+  BENCHMARK(fn)                                \
+      ->ArgsProduct({kSizes, kShapes, kThreads}) \
+      ->ArgNames({"n", "shape", "threads"})    \
+      ->Unit(benchmark::kMillisecond)          \
+      ->UseRealTime()
+
+DBSCAN_BENCHMARK(BM_GridConstruct);
+DBSCAN_BENCHMARK(BM_GetNeighbouringVtx);
+DBSCAN_BENCHMARK(BM_FinalizeGraph);
+DBSCAN_BENCHMARK(BM_ClassifyNoises);
+
+int main(int argc, char* argv[]) {
+  // the per-stage timing lines would drown the report.
+  auto logger = spdlog::stdout_color_mt("console");
+  logger->set_level(spdlog::level::warn);
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+  RegisterVariants_();
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
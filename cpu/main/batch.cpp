@@ -0,0 +1,44 @@
+#include <spdlog/sinks/stdout_color_sinks.h>
+
+#include <cxxopts.hpp>
+#include <fstream>
+
+#include "batch.h"
+
+int main(int argc, char* argv[]) {
+#if defined(DBSCAN_TESTING)
+  fprintf(stderr, "DBSCAN_TESTING enabled, something is wrong...\n");
+  return 0;
+#endif
+  // per-stage timings of thousands of small jobs are noise; keep warnings.
+  auto logger = spdlog::stdout_color_mt("console");
+  logger->set_level(spdlog::level::warn);
+
+  cxxopts::Options options("DBSCAN-batch", "DBSCAN over many small datasets");
+  // clang-format off
+  options.add_options()
+      ("m,manifest", "Manifest filename, one \"<input> <eps> <min_pts> [output]\" per line", cxxopts::value<std::string>())
+      ("t,num-threads", "Number of jobs clustered concurrently", cxxopts::value<uint8_t>()->default_value("1"))
+      ;
+  // clang-format on
+  auto args = options.parse(argc, argv);
+
+  std::string manifest = args["manifest"].as<std::string>();
+  uint8_t num_threads = args["num-threads"].as<uint8_t>();
+
+  const auto jobs = DBSCAN::batch::ReadManifest(manifest);
+  auto const start = std::chrono::high_resolution_clock::now();
+  const uint64_t num_failed = DBSCAN::batch::Run(
+      jobs, num_threads,
+      [&jobs](const uint64_t job, const DBSCAN::Solver& solver) {
+        if (jobs[job].output.empty()) return;
+        std::ofstream ofs(jobs[job].output);
+        for (const auto& l : solver.cluster_ids) ofs << l << '\n';
+      });
+  auto const end = std::chrono::high_resolution_clock::now();
+  auto const duration =
+      std::chrono::duration_cast<std::chrono::duration<double>>(end - start);
+  spdlog::info("{} jobs ({} failed) take {} sec", jobs.size(), num_failed,
+               duration.count());
+  return num_failed == 0 ? 0 : 1;
+}
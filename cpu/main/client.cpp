@@ -0,0 +1,85 @@
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/spdlog.h>
+
+#include <cxxopts.hpp>
+
+#include "output.h"
+#include "server.h"
+
+int main(int argc, char* argv[]) {
+#if defined(DBSCAN_TESTING)
+  fprintf(stderr, "DBSCAN_TESTING enabled, something is wrong...\n");
+  return 0;
+#endif
+  auto logger = spdlog::stdout_color_mt("console");
+  logger->set_level(spdlog::level::info);
+
+  cxxopts::Options options("DBSCAN-client", "Requests to a cpu-server");
+  // clang-format off
+  options.add_options()
+      ("s,socket", "Unix socket of the server", cxxopts::value<std::string>()->default_value("/tmp/dbscan.sock"))
+      ("d,dataset", "Name of the dataset", cxxopts::value<std::string>())
+      ("i,input", "Load this file as the dataset first", cxxopts::value<std::string>())
+      ("r,eps", "Clustering radius", cxxopts::value<float>())
+      ("n,min-pts", "Number of points within radius", cxxopts::value<size_t>())
+      ("region", "Only label the points in min_x,min_y,max_x,max_y", cxxopts::value<std::vector<float>>())
+      ("p,print", "Print clustering IDs") // boolean
+      ("o,output", "Write clustering IDs to a file ('-' for stdout)", cxxopts::value<std::string>())
+      ("memberships", "Also write the core/border/noise column") // boolean
+      ("shutdown", "Stop the server") // boolean
+      ;
+  // clang-format on
+  auto args = options.parse(argc, argv);
+
+  DBSCAN::server::Client client(args["socket"].as<std::string>());
+  if (args["shutdown"].as<bool>()) {
+    client.Shutdown();
+    return 0;
+  }
+  const auto name = args["dataset"].as<std::string>();
+  if (args.count("input")) {
+    const uint64_t num_vtx =
+        client.Load(name, args["input"].as<std::string>());
+    spdlog::info("loaded {} points as {}", num_vtx, name);
+  }
+  if (!args.count("eps")) return 0;
+
+  DBSCAN::server::Query query;
+  query.dataset = name;
+  query.eps = args["eps"].as<float>();
+  query.min_pts = args["min-pts"].as<size_t>();
+  if (args.count("region")) {
+    const auto& bounds = args["region"].as<std::vector<float>>();
+    if (bounds.size() != 4)
+      throw std::runtime_error("--region takes min_x,min_y,max_x,max_y");
+    query.has_region = true;
+    query.box = {bounds[0], bounds[1], bounds[2], bounds[3]};
+  }
+  auto const start = std::chrono::high_resolution_clock::now();
+  const auto reply = client.Cluster(query);
+  auto const end = std::chrono::high_resolution_clock::now();
+  auto const duration =
+      std::chrono::duration_cast<std::chrono::duration<double>>(end - start);
+  spdlog::info("DBSCAN takes {} sec{}", duration.count(),
+               reply.cached ? " (cached)" : "");
+
+  std::string output;
+  if (args.count("output")) {
+    output = args["output"].as<std::string>();
+  } else if (args["print"].as<bool>()) {
+    output = "-";
+  }
+  if (output.empty()) return 0;
+  const bool with_memberships = args["memberships"].as<bool>();
+  if (query.has_region) {
+    DBSCAN::output::WriteRegion(output, reply.labels, with_memberships);
+  } else {
+    const std::vector<int> cluster_ids(reply.labels.clusters.cbegin(),
+                                       reply.labels.clusters.cend());
+    DBSCAN::output::Write(output, DBSCAN::output::Format::Text, cluster_ids,
+                          with_memberships ? &reply.labels.memberships
+                                           : nullptr,
+                          1u);
+  }
+  return 0;
+}
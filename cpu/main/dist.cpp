@@ -0,0 +1,55 @@
+#include <spdlog/sinks/stdout_color_sinks.h>
+
+#include <cxxopts.hpp>
+
+#include "distributed.h"
+#include "output.h"
+
+int main(int argc, char* argv[]) {
+#if defined(DBSCAN_TESTING)
+  fprintf(stderr, "DBSCAN_TESTING enabled, something is wrong...\n");
+  return 0;
+#endif
+  auto logger = spdlog::stdout_color_mt("console");
+  logger->set_level(spdlog::level::info);
+
+  cxxopts::Options options("DBSCAN-dist", "DBSCAN over worker processes");
+  // clang-format off
+  options.add_options()
+      ("p,print", "Print clustering IDs") // boolean
+      ("r,eps", "Clustering radius", cxxopts::value<float>())
+      ("n,min-pts", "Number of points within radius", cxxopts::value<size_t>())
+      ("i,input", "Input filename", cxxopts::value<std::string>())
+      ("w,num-workers", "Number of worker processes", cxxopts::value<uint32_t>()->default_value("2"))
+      ("t,num-threads", "Number of threads per worker", cxxopts::value<uint8_t>()->default_value("1"))
+      ;
+  // clang-format on
+  auto args = options.parse(argc, argv);
+
+  bool output_labels = args["print"].as<bool>();
+  float radius = args["eps"].as<float>();
+  uint min_pts = args["min-pts"].as<size_t>();
+  std::string input = args["input"].as<std::string>();
+  uint32_t num_workers = args["num-workers"].as<uint32_t>();
+  uint8_t num_threads = args["num-threads"].as<uint8_t>();
+
+  const auto dataset = DBSCAN::input_type::TwoDimPoints::Read(input);
+  auto const start = std::chrono::high_resolution_clock::now();
+  DBSCAN::distributed::Coordinator coordinator(min_pts, radius, num_workers,
+                                               num_threads);
+  DBSCAN::transport::ForkTransport transport;
+  std::vector<int> cluster_ids;
+  std::vector<DBSCAN::membership> memberships;
+  coordinator.Run(*dataset, transport, cluster_ids, memberships);
+  auto const end = std::chrono::high_resolution_clock::now();
+  auto const duration =
+      std::chrono::duration_cast<std::chrono::duration<double>>(end - start);
+  spdlog::info("DBSCAN takes {} sec", duration.count());
+
+  if (output_labels) {
+    DBSCAN::output::Write("-", DBSCAN::output::Format::Text, cluster_ids,
+                          nullptr, 1u);
+  }
+
+  return 0;
+}
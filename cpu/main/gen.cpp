@@ -0,0 +1,48 @@
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/spdlog.h>
+
+#include <cxxopts.hpp>
+
+#include "generator.h"
+
+int main(int argc, char* argv[]) {
+#if defined(DBSCAN_TESTING)
+  fprintf(stderr, "DBSCAN_TESTING enabled, something is wrong...\n");
+  return 0;
+#endif
+  auto logger = spdlog::stdout_color_mt("console");
+  logger->set_level(spdlog::level::info);
+
+  cxxopts::Options options("DBSCAN-gen", "Synthetic DBSCAN inputs");
+  // clang-format off
+  options.add_options()
+      ("o,output", "Output filename", cxxopts::value<std::string>())
+      ("n,num-points", "Number of points", cxxopts::value<uint64_t>())
+      ("s,shape", "uniform, gaussian, skew or duplicates", cxxopts::value<std::string>()->default_value("gaussian"))
+      ("b,num-blobs", "Number of blobs", cxxopts::value<uint32_t>()->default_value("20"))
+      ("spread", "Standard deviation of each blob", cxxopts::value<float>()->default_value("0.1"))
+      ("seed", "Random seed", cxxopts::value<uint64_t>()->default_value("42"))
+      ("t,num-threads", "Number of threads", cxxopts::value<uint8_t>()->default_value("1"))
+      ;
+  // clang-format on
+  auto args = options.parse(argc, argv);
+
+  DBSCAN::generator::Options gen;
+  gen.shape = DBSCAN::generator::ParseShape(args["shape"].as<std::string>());
+  gen.num_vtx = args["num-points"].as<uint64_t>();
+  gen.num_blobs = args["num-blobs"].as<uint32_t>();
+  gen.spread = args["spread"].as<float>();
+  gen.seed = args["seed"].as<uint64_t>();
+  std::string output = args["output"].as<std::string>();
+  uint8_t num_threads = args["num-threads"].as<uint8_t>();
+
+  auto const start = std::chrono::high_resolution_clock::now();
+  const auto points = DBSCAN::generator::Generate(gen, num_threads);
+  DBSCAN::generator::Write(output, *points, num_threads);
+  auto const end = std::chrono::high_resolution_clock::now();
+  auto const duration =
+      std::chrono::duration_cast<std::chrono::duration<double>>(end - start);
+  spdlog::info("generating {} points takes {} sec", gen.num_vtx,
+               duration.count());
+  return 0;
+}
@@ -1,9 +1,12 @@
 #include <spdlog/sinks/stdout_color_sinks.h>
 
 #include <cxxopts.hpp>
-#include <iostream>
 
+#include "approx.h"
+#include "model.h"
+#include "output.h"
 #include "solver.h"
+#include "tiled.h"
 
 int main(int argc, char* argv[]) {
 #if defined(DBSCAN_TESTING)
@@ -17,10 +20,32 @@ int main(int argc, char* argv[]) {
   // clang-format off
   options.add_options()
       ("p,print", "Print clustering IDs") // boolean
+      ("o,output", "Write clustering IDs to a file ('-' for stdout)", cxxopts::value<std::string>())
+      ("output-format", "Output format: text or binary", cxxopts::value<std::string>()->default_value("text"))
+      ("memberships", "Also write the core/border/noise column") // boolean
+      ("summary", "Write per-cluster statistics to a file ('-' for stdout)", cxxopts::value<std::string>())
+      ("summary-format", "Summary format: csv or binary", cxxopts::value<std::string>()->default_value("csv"))
+      ("metrics-out", "Write per-stage metrics as JSON to a file", cxxopts::value<std::string>())
+      ("graph-cache", "Reuse the neighbour graph in this file, or save it there", cxxopts::value<std::string>())
+      ("perf-counters", "Count cycles, cache/TLB and branch misses per stage") // boolean
+      ("adjacency", "Edge representation: auto, bitmap, csr, blocked or implicit", cxxopts::value<std::string>()->default_value("auto"))
+      ("kernel", "Distance kernel: avx512, avx or scalar (default: planned)", cxxopts::value<std::string>())
+      ("labeller", "Cluster labelling: bfs or union-find", cxxopts::value<std::string>()->default_value("bfs"))
+      ("index", "Candidates of the adjacency lists: grid or kdtree", cxxopts::value<std::string>()->default_value("grid"))
+      ("metric", "Distance: euclidean, manhattan, chebyshev or haversine", cxxopts::value<std::string>()->default_value("euclidean"))
+      ("collapse-duplicates", "Merge duplicate points into weighted vertices") // boolean
+      ("duplicate-tolerance", "Also merge the points within one cell of this size", cxxopts::value<float>()->default_value("0"))
+      ("region", "Only label the points in min_x,min_y,max_x,max_y, as a full run would", cxxopts::value<std::vector<float>>())
+      ("memory-limit", "Memory budget in MB for the auto plan (0 = none)", cxxopts::value<uint64_t>()->default_value("0"))
       ("r,eps", "Clustering radius", cxxopts::value<float>())
       ("n,min-pts", "Number of points within radius", cxxopts::value<size_t>())
       ("i,input", "Input filename", cxxopts::value<std::string>())
       ("t,num-threads", "Number of threads", cxxopts::value<uint8_t>()->default_value("1"))
+      ("save-model", "Save the fitted core points to a model file", cxxopts::value<std::string>())
+      ("huge-pages", "Back the grid and graph buffers with huge pages") // boolean
+      ("numa", "Pin threads to NUMA nodes and give each a strip of the grid") // boolean
+      ("tiled", "Cluster one spatial tile per thread and merge the borders") // boolean
+      ("approx-rho", "Run rho-approximate DBSCAN with this tolerance", cxxopts::value<float>())
       ;
   // clang-format on
   auto args = options.parse(argc, argv);
@@ -30,16 +55,145 @@ int main(int argc, char* argv[]) {
   uint min_pts = args["min-pts"].as<size_t>();
   std::string input = args["input"].as<std::string>();
   uint8_t num_threads = args["num-threads"].as<uint8_t>();
+  bool huge_pages = args["huge-pages"].as<bool>();
+  bool numa_aware = args["numa"].as<bool>();
+  std::string output;
+  if (args.count("output")) {
+    output = args["output"].as<std::string>();
+  } else if (output_labels) {
+    output = "-";
+  }
+  auto output_format =
+      DBSCAN::output::ParseFormat(args["output-format"].as<std::string>());
+  bool with_memberships = args["memberships"].as<bool>();
+  auto summary_format =
+      DBSCAN::summary::ParseFormat(args["summary-format"].as<std::string>());
 
   logger->debug("radius {} min_pts {}", radius, min_pts);
 
-  DBSCAN::Solver solver(input, min_pts, radius, num_threads);
+  auto const write_output = [&](const std::vector<int>& cluster_ids,
+                                const std::vector<DBSCAN::membership>& ms) {
+    if (output.empty()) return;
+    auto const start = std::chrono::high_resolution_clock::now();
+    DBSCAN::output::Write(output, output_format, cluster_ids,
+                          with_memberships ? &ms : nullptr, num_threads);
+    auto const end = std::chrono::high_resolution_clock::now();
+    auto const duration =
+        std::chrono::duration_cast<std::chrono::duration<double>>(end - start);
+    spdlog::info("writing output takes {} sec", duration.count());
+  };
+  auto const write_summary = [&](const DBSCAN::summary::Summary& summary) {
+    DBSCAN::summary::Write(args["summary"].as<std::string>(), summary_format,
+                           summary);
+  };
+
+  if (args.count("metrics-out") &&
+      (args.count("approx-rho") || args["tiled"].as<bool>())) {
+    spdlog::warn("--metrics-out is only recorded by the default engine");
+  }
+  const auto metric =
+      DBSCAN::metric::ParseMetric(args["metric"].as<std::string>());
+  if (args.count("region") &&
+      (args.count("approx-rho") || args["tiled"].as<bool>() ||
+       args["collapse-duplicates"].as<bool>() || args.count("summary") ||
+       args.count("save-model") || args.count("graph-cache"))) {
+    spdlog::warn("--region only runs with the default engine and writes the "
+                 "labels of the region alone");
+  }
+  if (args["collapse-duplicates"].as<bool>() &&
+      (args.count("approx-rho") || args["tiled"].as<bool>())) {
+    spdlog::warn("--collapse-duplicates only applies to the default engine");
+  }
+  if (metric != DBSCAN::metric::Metric::Euclidean &&
+      (args.count("approx-rho") || args["tiled"].as<bool>() ||
+       args.count("save-model"))) {
+    spdlog::warn("--metric only applies to the default engine; "
+                 "the others and saved models stay Euclidean");
+  }
+
+  if (args.count("approx-rho")) {
+    const auto dataset = DBSCAN::input_type::TwoDimPoints::Read(input);
+    auto const start = std::chrono::high_resolution_clock::now();
+    DBSCAN::ApproxSolver solver(min_pts, radius, args["approx-rho"].as<float>(),
+                                num_threads);
+    std::vector<int> cluster_ids;
+    std::vector<DBSCAN::membership> memberships;
+    solver.Run(*dataset, cluster_ids, memberships);
+    auto const end = std::chrono::high_resolution_clock::now();
+    auto const duration =
+        std::chrono::duration_cast<std::chrono::duration<double>>(end - start);
+    spdlog::info("DBSCAN takes {} sec", duration.count());
+    write_output(cluster_ids, memberships);
+    if (args.count("summary")) {
+      write_summary(DBSCAN::summary::Summarize(*dataset, cluster_ids,
+                                               memberships, num_threads));
+    }
+    return 0;
+  }
+
+  if (args["tiled"].as<bool>()) {
+    const auto dataset = DBSCAN::input_type::TwoDimPoints::Read(input);
+    auto const start = std::chrono::high_resolution_clock::now();
+    DBSCAN::TiledSolver solver(min_pts, radius, num_threads);
+    std::vector<int> cluster_ids;
+    std::vector<DBSCAN::membership> memberships;
+    solver.Run(*dataset, cluster_ids, memberships);
+    auto const end = std::chrono::high_resolution_clock::now();
+    auto const duration =
+        std::chrono::duration_cast<std::chrono::duration<double>>(end - start);
+    spdlog::info("DBSCAN takes {} sec", duration.count());
+    write_output(cluster_ids, memberships);
+    if (args.count("summary")) {
+      write_summary(DBSCAN::summary::Summarize(*dataset, cluster_ids,
+                                               memberships, num_threads));
+    }
+    return 0;
+  }
+
+  DBSCAN::Solver solver(input, min_pts, radius, num_threads, huge_pages);
+  solver.set_numa_aware(numa_aware);
+  solver.set_metric(metric);
+  solver.set_profiling(args["perf-counters"].as<bool>());
+  if (args.count("region")) {
+    const auto& bounds = args["region"].as<std::vector<float>>();
+    if (bounds.size() != 4)
+      throw std::runtime_error("--region takes min_x,min_y,max_x,max_y");
+    const auto result =
+        solver.QueryRegion({bounds[0], bounds[1], bounds[2], bounds[3]});
+    if (!output.empty())
+      DBSCAN::output::WriteRegion(output, result, with_memberships);
+    if (args.count("metrics-out"))
+      solver.metrics().Write(args["metrics-out"].as<std::string>());
+    return 0;
+  }
   auto const start = std::chrono::high_resolution_clock::now();
-#if !defined(BIT_ADJ)
-  solver.construct_grid();
-#endif
-  solver.InsertEdges();
-  solver.FinalizeGraph();
+  if (args["collapse-duplicates"].as<bool>())
+    solver.CollapseDuplicates(args["duplicate-tolerance"].as<float>());
+  const std::string graph_cache =
+      args.count("graph-cache") ? args["graph-cache"].as<std::string>() : "";
+  if (graph_cache.empty() || !solver.LoadGraph(graph_cache)) {
+    solver.ConstructGrid();
+    auto plan =
+        args["adjacency"].as<std::string>() == "auto"
+            ? solver.PlanGraph(args["memory-limit"].as<uint64_t>() << 20u)
+            : DBSCAN::planner::Plan();
+    if (args["adjacency"].as<std::string>() != "auto")
+      plan.adjacency =
+          DBSCAN::planner::ParseAdjacency(args["adjacency"].as<std::string>());
+    if (args.count("kernel"))
+      plan.kernel =
+          DBSCAN::planner::ParseKernel(args["kernel"].as<std::string>());
+    plan.index = DBSCAN::planner::ParseIndex(args["index"].as<std::string>());
+    solver.set_plan(plan);
+    solver.InsertEdges();
+    solver.FinalizeGraph();
+    if (!graph_cache.empty()) solver.SaveGraph(graph_cache);
+  }
+  // also for a graph from the cache.
+  auto plan = solver.plan();
+  plan.labeller =
+      DBSCAN::planner::ParseLabeller(args["labeller"].as<std::string>());
+  solver.set_plan(plan);
   solver.ClassifyNoises();
   solver.IdentifyClusters();
   auto const end = std::chrono::high_resolution_clock::now();
@@ -47,11 +201,18 @@ int main(int argc, char* argv[]) {
       std::chrono::duration_cast<std::chrono::duration<double>>(end - start);
   spdlog::info("DBSCAN takes {} sec", duration.count());
 
-  if (output_labels) {
-    for (const auto& l : solver.cluster_ids) {
-      std::cout << l << std::endl;
-    }
+  if (args.count("metrics-out")) {
+    solver.metrics().Write(args["metrics-out"].as<std::string>());
   }
 
+  if (args.count("save-model")) {
+    DBSCAN::FittedModel model(solver, num_threads);
+    model.Save(args["save-model"].as<std::string>());
+    spdlog::info("saved a model of {} core points", model.num_cores());
+  }
+
+  write_output(solver.cluster_ids, solver.memberships);
+  if (args.count("summary")) write_summary(solver.Summarize());
+
   return 0;
 }
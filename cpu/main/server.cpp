@@ -0,0 +1,40 @@
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/spdlog.h>
+
+#include <cxxopts.hpp>
+
+#include "server.h"
+
+int main(int argc, char* argv[]) {
+#if defined(DBSCAN_TESTING)
+  fprintf(stderr, "DBSCAN_TESTING enabled, something is wrong...\n");
+  return 0;
+#endif
+  auto logger = spdlog::stdout_color_mt("console");
+  logger->set_level(spdlog::level::info);
+
+  cxxopts::Options options("DBSCAN-server", "DBSCAN over resident datasets");
+  // clang-format off
+  options.add_options()
+      ("s,socket", "Unix socket to listen on", cxxopts::value<std::string>()->default_value("/tmp/dbscan.sock"))
+      ("w,num-workers", "Number of requests served at once", cxxopts::value<uint32_t>()->default_value("2"))
+      ("t,num-threads", "Number of threads per request", cxxopts::value<uint8_t>()->default_value("1"))
+      ("cache-entries", "Number of results kept", cxxopts::value<uint64_t>()->default_value("64"))
+      ("drop-graphs", "Rebuild the graph of every request instead of keeping it") // boolean
+      ("solvers-per-dataset", "Number of eps whose solver a dataset keeps", cxxopts::value<uint32_t>()->default_value("4"))
+      ("idle-timeout-ms", "Hang up on a client idle this long (0 = never)", cxxopts::value<uint32_t>()->default_value("60000"))
+      ("quiet", "Only log warnings and errors") // boolean
+      ;
+  // clang-format on
+  auto args = options.parse(argc, argv);
+  if (args["quiet"].as<bool>()) logger->set_level(spdlog::level::warn);
+
+  DBSCAN::server::Server server(args["num-workers"].as<uint32_t>(),
+                                args["num-threads"].as<uint8_t>(),
+                                args["cache-entries"].as<uint64_t>(),
+                                !args["drop-graphs"].as<bool>(),
+                                args["solvers-per-dataset"].as<uint32_t>(),
+                                args["idle-timeout-ms"].as<uint32_t>());
+  server.Serve(args["socket"].as<std::string>());
+  return 0;
+}
@@ -0,0 +1,68 @@
+#include <spdlog/sinks/stdout_color_sinks.h>
+
+#include <algorithm>
+#include <cxxopts.hpp>
+#include <iostream>
+
+#include "streaming.h"
+
+int main(int argc, char* argv[]) {
+#if defined(DBSCAN_TESTING)
+  fprintf(stderr, "DBSCAN_TESTING enabled, something is wrong...\n");
+  return 0;
+#endif
+  auto logger = spdlog::stdout_color_mt("console");
+  logger->set_level(spdlog::level::info);
+
+  cxxopts::Options options("DBSCAN-stream",
+                           "DBSCAN over a sliding time window");
+  // clang-format off
+  options.add_options()
+      ("p,print", "Print clustering IDs of every snapshot") // boolean
+      ("r,eps", "Clustering radius", cxxopts::value<float>())
+      ("n,min-pts", "Number of points within radius", cxxopts::value<size_t>())
+      ("i,input", "Replay filename, one \"<t> <x> <y>\" per line", cxxopts::value<std::string>())
+      ("w,window", "Window length in seconds", cxxopts::value<double>())
+      ("c,cadence", "Seconds between snapshots", cxxopts::value<double>()->default_value("1"))
+      ;
+  // clang-format on
+  auto args = options.parse(argc, argv);
+
+  bool output_labels = args["print"].as<bool>();
+  float radius = args["eps"].as<float>();
+  uint min_pts = args["min-pts"].as<size_t>();
+  std::string input = args["input"].as<std::string>();
+  double window = args["window"].as<double>();
+  double cadence = args["cadence"].as<double>();
+
+  DBSCAN::streaming::ReplaySource source(input);
+  DBSCAN::streaming::WindowedSolver solver(
+      min_pts, radius, window, cadence,
+      [&logger, output_labels](const DBSCAN::streaming::Snapshot& snapshot) {
+        const auto& ids = snapshot.cluster_ids;
+        const int num_clusters =
+            ids.empty() ? 0 : *std::max_element(ids.cbegin(), ids.cend()) + 1;
+        logger->info("t={} points={} clusters={} noise={}", snapshot.time,
+                     ids.size(), num_clusters,
+                     std::count(ids.cbegin(), ids.cend(), -1));
+        if (output_labels) {
+          std::cout << "# t=" << snapshot.time << " n=" << ids.size() << '\n';
+          for (const auto& l : ids) std::cout << l << '\n';
+          std::cout.flush();
+        }
+      });
+  auto const start = std::chrono::high_resolution_clock::now();
+  DBSCAN::streaming::TimedPoint p{};
+  uint64_t num_points = 0;
+  while (source.Next(p)) {
+    solver.Push(p);
+    ++num_points;
+  }
+  solver.Flush();
+  auto const end = std::chrono::high_resolution_clock::now();
+  auto const duration =
+      std::chrono::duration_cast<std::chrono::duration<double>>(end - start);
+  spdlog::info("streaming {} points takes {} sec", num_points,
+               duration.count());
+  return 0;
+}
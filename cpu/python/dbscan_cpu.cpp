@@ -0,0 +1,156 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "approx.h"
+#include "solver.h"
+#include "threads.h"
+#include "tiled.h"
+
+namespace py = pybind11;
+
+namespace {
+using Points = py::array_t<float>;
+
+// A 1-D numpy array of T over the buffer of |values|, which it takes over
+// instead of copying.
+template <class T, class U = T>
+py::array_t<T> ToArray_(std::vector<U>&& values) {
+  static_assert(sizeof(T) <= sizeof(U), "T must fit in the buffer of U");
+  auto* const owned = new std::vector<U>(std::move(values));
+  py::capsule owner(owned, [](void* p) {
+    delete static_cast<std::vector<U>*>(p);
+  });
+  return py::array_t<T>(static_cast<py::ssize_t>(owned->size()),
+                        reinterpret_cast<T*>(owned->data()), owner);
+}
+
+/*
+ * The solvers read x and y as separate columns. A column-major (n, 2) array or
+ * a C-contiguous (2, n) one already holds them, so the points read the numpy
+ * buffer in place. A C-contiguous (n, 2) array interleaves them and is split
+ * into two aligned columns, the only copy of the points.
+ */
+std::unique_ptr<const DBSCAN::input_type::TwoDimPoints> Columns_(
+    const Points& xy, const uint8_t num_threads) {
+  using DBSCAN::input_type::TwoDimPoints;
+  constexpr auto kFloat = static_cast<py::ssize_t>(sizeof(float));
+  if (xy.ndim() != 2 || (xy.shape(0) != 2 && xy.shape(1) != 2)) {
+    throw std::invalid_argument("points must have shape (n, 2) or (2, n)");
+  }
+  // a view of const points: the array may be read-only.
+  const float* const data = xy.data();
+  if (xy.shape(1) == 2 && xy.strides(0) == kFloat) {
+    const uint64_t n = xy.shape(0);
+    return TwoDimPoints::View(data, data + xy.strides(1) / kFloat, n);
+  }
+  const bool rows = xy.shape(1) == 2 && xy.strides(1) == kFloat &&
+                    xy.strides(0) == 2 * kFloat;
+  if (!rows && xy.shape(0) == 2 && xy.strides(1) == kFloat) {
+    const uint64_t n = xy.shape(1);
+    return TwoDimPoints::View(data, data + xy.strides(0) / kFloat, n);
+  }
+  if (!rows) {
+    throw std::invalid_argument(
+        "points must be C-contiguous or column-major float32");
+  }
+  const uint64_t n = xy.shape(0);
+  auto points = std::make_unique<TwoDimPoints>(n);
+  const uint64_t chunk = (n + num_threads - 1) / num_threads;
+  DBSCAN::utils::run_threads(num_threads, [&](const uint8_t tid) {
+    const uint64_t end = std::min(n, (tid + 1) * chunk);
+    for (uint64_t i = tid * chunk; i < end; ++i) {
+      points->d1[i] = data[2 * i];
+      points->d2[i] = data[2 * i + 1];
+    }
+  });
+  return points;
+}
+
+/*
+ * Narrows |memberships| to one byte each within their own buffer. Byte i is
+ * written after membership i is read and before any later one, so no
+ * membership is overwritten unread.
+ */
+void Narrow_(std::vector<DBSCAN::membership>& memberships) {
+  auto* const kinds = reinterpret_cast<uint8_t*>(memberships.data());
+  for (uint64_t i = 0; i < memberships.size(); ++i) {
+    kinds[i] = static_cast<uint8_t>(memberships[i]);
+  }
+}
+
+/*
+ * Labels (int32, -1 for noise) and memberships (uint8: 0 core, 1 border,
+ * 2 noise) of the float32 |points|. The GIL is released from the split of
+ * the columns to the last label.
+ */
+py::tuple Fit_(const Points& points, const float eps, const uint64_t min_pts,
+               const unsigned num_threads, const std::string& engine,
+               const float rho) {
+  if (num_threads == 0 || num_threads > 255) {
+    throw std::invalid_argument("num_threads must be within [1, 255]");
+  }
+  if (engine != "exact" && engine != "tiled" && engine != "approx") {
+    throw std::invalid_argument("engine must be exact, tiled or approx");
+  }
+  const auto threads = static_cast<uint8_t>(num_threads);
+  std::vector<int> cluster_ids;
+  std::vector<DBSCAN::membership> memberships;
+  {
+    py::gil_scoped_release release;
+    auto dataset = Columns_(points, threads);
+    if (engine == "exact") {
+      DBSCAN::Solver solver(std::move(dataset), min_pts, eps, threads);
+      solver.ConstructGrid();
+      solver.PlanGraph();
+      solver.InsertEdges();
+      solver.FinalizeGraph();
+      solver.ClassifyNoises();
+      solver.IdentifyClusters();
+      cluster_ids = std::move(solver.cluster_ids);
+      memberships = std::move(solver.memberships);
+    } else if (engine == "tiled") {
+      DBSCAN::TiledSolver(min_pts, eps, threads)
+          .Run(*dataset, cluster_ids, memberships);
+    } else {
+      DBSCAN::ApproxSolver(min_pts, eps, rho, threads)
+          .Run(*dataset, cluster_ids, memberships);
+    }
+    Narrow_(memberships);
+  }
+  return py::make_tuple(ToArray_<int>(std::move(cluster_ids)),
+                        ToArray_<uint8_t>(std::move(memberships)));
+}
+}  // namespace
+
+PYBIND11_MODULE(dbscan_cpu, m) {
+  m.doc() = "Multi-threaded DBSCAN on the CPU";
+  // the solvers log through "console"; only warnings by default.
+  if (spdlog::get("console") == nullptr) {
+    spdlog::stderr_color_mt("console")->set_level(spdlog::level::warn);
+  }
+  m.def("fit", &Fit_,
+        "Cluster a float32 array of shape (n, 2) or (2, n).\n\n"
+        "A column-major (n, 2) or C-contiguous (2, n) array is read in "
+        "place; a C-contiguous (n, 2) one is copied into x and y columns "
+        "first. "
+        "min_pts counts the neighbours within eps besides the point itself "
+        "(sklearn's min_samples - 1). engine is 'exact', 'tiled' (a spatial "
+        "tile per thread) or 'approx' (rho-approximate). Returns (labels, "
+        "memberships): int32 cluster ids with -1 for noise, and uint8 "
+        "0 core / 1 border / 2 noise.",
+        py::arg("points").noconvert(), py::arg("eps"), py::arg("min_pts"),
+        py::arg("num_threads") = 1u, py::arg("engine") = "exact",
+        py::arg("rho") = 0.f);
+}
@@ -0,0 +1,61 @@
+import os
+import subprocess
+
+import numpy as np
+import pytest
+
+import dbscan_cpu
+
+EPS = 0.15
+MIN_PTS = 30
+
+
+@pytest.fixture(scope='module')
+def points():
+  return np.loadtxt(os.environ['TEST_INPUT'], skiprows=1, usecols=(1, 2),
+                    dtype=np.float32)
+
+
+@pytest.fixture(scope='module')
+def expected(points, tmp_path_factory):
+  """Labels and memberships of the same input from cpu-main's Solver."""
+  output = tmp_path_factory.mktemp('cpu-main') / 'labels.bin'
+  subprocess.run([os.environ['CPU_MAIN'],
+                  '--input=' + os.environ['TEST_INPUT'], '--eps=' + str(EPS),
+                  '--min-pts=' + str(MIN_PTS), '--output=' + str(output),
+                  '--output-format=binary', '--memberships'], check=True)
+  n = len(points)
+  labels = np.fromfile(output, dtype=np.int32, count=n)
+  memberships = np.fromfile(output, dtype=np.uint8, offset=4 * n)
+  return labels, memberships
+
+
+def read_only(xy):
+  columns = np.asfortranarray(xy)
+  columns.setflags(write=False)
+  return columns
+
+
+@pytest.mark.parametrize('layout', [
+    np.ascontiguousarray,  # (n, 2) rows, copied into columns
+    np.asfortranarray,  # (n, 2) columns, read in place
+    lambda xy: np.ascontiguousarray(xy.T),  # (2, n) columns, read in place
+    read_only,  # a view of read-only columns
+])
+@pytest.mark.parametrize('num_threads', [1, 4])
+def test_fit_matches_solver(points, expected, layout, num_threads):
+  xy = layout(points)
+  labels, memberships = dbscan_cpu.fit(xy, EPS, MIN_PTS,
+                                       num_threads=num_threads)
+  assert labels.dtype == np.int32 and memberships.dtype == np.uint8
+  np.testing.assert_array_equal(labels, expected[0])
+  np.testing.assert_array_equal(memberships, expected[1])
+  # the points read in place are left untouched.
+  np.testing.assert_array_equal(xy if xy.shape[1] == 2 else xy.T, points)
+
+
+def test_fit_rejects_other_layouts(points):
+  with pytest.raises(ValueError):
+    dbscan_cpu.fit(points[::2], EPS, MIN_PTS)
+  with pytest.raises(TypeError):
+    dbscan_cpu.fit(points.astype(np.float64), EPS, MIN_PTS)
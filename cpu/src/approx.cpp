@@ -0,0 +1,359 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#include "approx.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+#include "threads.h"
+
+// ctor
+DBSCAN::ApproxSolver::ApproxSolver(const uint64_t min_pts, const float radius,
+                                   const float rho, const uint8_t num_threads)
+    : min_pts_(min_pts),
+      radius_(radius),
+      rho_(rho),
+      squared_radius_(radius * radius),
+      squared_outer_radius_(radius * (1 + rho) * radius * (1 + rho)),
+      num_threads_(num_threads) {
+  logger_ = spdlog::get("console");
+  if (logger_ == nullptr) {
+    throw std::runtime_error("logger not created!");
+  }
+  if (num_threads_ == 0) throw std::runtime_error("need at least one thread!");
+  if (!(rho_ >= 0)) throw std::runtime_error("rho must be non-negative!");
+  // a node at depth d spans a diagonal of radius/2^d; once that is within
+  // rho*radius a node touching the radius is inside radius*(1+rho).
+  max_depth_ = kMaxDepth;
+  if (rho_ > 0) {
+    max_depth_ = std::min<uint32_t>(
+        kMaxDepth, std::max(0.f, std::ceil(std::log2(1 / rho_))));
+  }
+  cell_side_ = radius_ / std::sqrt(2.f);
+  const auto reach =
+      static_cast<int64_t>(std::ceil((1 + rho_) * std::sqrt(2.f)));
+  for (int64_t dy = -reach; dy <= reach; ++dy) {
+    for (int64_t dx = -reach; dx <= reach; ++dx) {
+      const float gap_x = std::max<int64_t>(std::abs(dx) - 1, 0) * cell_side_;
+      const float gap_y = std::max<int64_t>(std::abs(dy) - 1, 0) * cell_side_;
+      if (gap_x * gap_x + gap_y * gap_y <= squared_outer_radius_)
+        offsets_.emplace_back(dy, dx);
+    }
+  }
+}
+
+void DBSCAN::ApproxSolver::Run(const DBSCAN::input_type::TwoDimPoints& dataset,
+                               std::vector<int>& cluster_ids,
+                               std::vector<DBSCAN::membership>& memberships) {
+  using namespace std::chrono;
+  const uint64_t num_vtx = dataset.d1.size();
+  cluster_ids.assign(num_vtx, -1);
+  memberships.assign(num_vtx, DBSCAN::membership::Noise);
+  num_decisions_ = num_ambiguous_ = 0;
+  if (num_vtx == 0) return;
+
+  auto t0 = high_resolution_clock::now();
+  BuildCells_(dataset);
+  const uint64_t num_cells = cell_root_.size();
+  auto t1 = high_resolution_clock::now();
+  logger_->info("building {} cells and {} tree nodes takes {} seconds",
+                num_cells, nodes_.size(),
+                duration_cast<duration<double>>(t1 - t0).count());
+
+  // calls |f(nc)| for every non-empty cell that may hold a point within
+  // radius*(1+rho) of a point in cell |c|.
+  const auto for_each_nb_cell = [this](const uint64_t c, const auto& f) {
+    const int64_t row = c / grid_cols_, col = c % grid_cols_;
+    for (const auto& [dy, dx] : offsets_) {
+      const int64_t r = row + dy, l = col + dx;
+      if (r < 0 || r >= grid_rows_ || l < 0 || l >= grid_cols_) continue;
+      const uint64_t nc = r * grid_cols_ + l;
+      if (cell_root_[nc] >= 0) f(nc);
+    }
+  };
+
+  // the vertex itself is counted too, hence |min_pts_| + 1.
+  const uint64_t threshold = min_pts_ + 1;
+  std::vector<Stats> stats(num_threads_);
+  is_core_.assign(num_vtx, 0);
+  // a cell is within the radius of itself, but only up to rounding: the cell
+  // side is radius/sqrt(2) in floats and the cell of a point is rounded too.
+  // With rho = 0 the shortcut must agree with the exact kernel, so the cell's
+  // tight box is checked with the same squared-distance expression; every
+  // pair inside the box is then within the radius as well.
+  const auto within_radius = [this](const uint64_t c) {
+    if (rho_ > 0) return true;
+    const Node& root = nodes_[cell_root_[c]];
+    return MaxDist_(root, root.x_lo, root.y_lo) <= squared_radius_;
+  };
+  DBSCAN::utils::run_threads(num_threads_, [&](const uint8_t tid) {
+    for (uint64_t p = tid; p < num_vtx; p += num_threads_) {
+      const uint64_t c = cell_of_[order_[p]];
+      if (cell_start_[c + 1] - cell_start_[c] >= threshold &&
+          within_radius(c)) {
+        is_core_[p] = 1;
+        continue;
+      }
+      uint64_t count = 0;
+      for_each_nb_cell(c, [&](const uint64_t nc) {
+        if (count < threshold)
+          count += Count_(cell_root_[nc], xs_[p], ys_[p], threshold - count,
+                          stats[tid]);
+      });
+      is_core_[p] = count >= threshold;
+    }
+  });
+  // children are stored after their parents.
+  for (auto it = nodes_.rbegin(); it != nodes_.rend(); ++it) {
+    it->num_core = 0;
+    if (it->first_child < 0) {
+      for (uint64_t p = it->begin; p < it->end; ++p)
+        it->num_core += is_core_[p];
+    } else {
+      for (int64_t q = 0; q < 4; ++q)
+        it->num_core += nodes_[it->first_child + q].num_core;
+    }
+  }
+  auto t2 = high_resolution_clock::now();
+  logger_->info("counting neighbours takes {} seconds",
+                duration_cast<duration<double>>(t2 - t1).count());
+
+  // two core cells are connected if a core point of one has a core point of
+  // the other within the radius; each pair is tested from the lower cell.
+  std::vector<std::vector<std::pair<uint64_t, uint64_t>>> edges(num_threads_);
+  DBSCAN::utils::run_threads(num_threads_, [&](const uint8_t tid) {
+    for (uint64_t c = tid; c < num_cells; c += num_threads_) {
+      if (cell_root_[c] < 0 || nodes_[cell_root_[c]].num_core == 0) continue;
+      for_each_nb_cell(c, [&](const uint64_t nc) {
+        if (nc <= c || nodes_[cell_root_[nc]].num_core == 0) return;
+        // probe from the cell with fewer core points.
+        uint64_t probe = c, other = nc;
+        if (nodes_[cell_root_[nc]].num_core < nodes_[cell_root_[c]].num_core)
+          std::swap(probe, other);
+        for (uint64_t p = cell_start_[probe]; p < cell_start_[probe + 1]; ++p) {
+          if (is_core_[p] &&
+              HasCore_(cell_root_[other], xs_[p], ys_[p], stats[tid])) {
+            edges[tid].emplace_back(c, nc);
+            return;
+          }
+        }
+      });
+    }
+  });
+  std::vector<uint64_t> parent(num_cells);
+  std::iota(parent.begin(), parent.end(), 0);
+  const auto find = [&parent](uint64_t c) {
+    // path halving
+    while (parent[c] != c) {
+      parent[c] = parent[parent[c]];
+      c = parent[c];
+    }
+    return c;
+  };
+  for (const auto& thread_edges : edges) {
+    for (const auto& [a, b] : thread_edges) {
+      const uint64_t ra = find(a), rb = find(b);
+      if (ra != rb) parent[std::max(ra, rb)] = std::min(ra, rb);
+    }
+  }
+  auto t3 = high_resolution_clock::now();
+  logger_->info("connecting core cells takes {} seconds",
+                duration_cast<duration<double>>(t3 - t2).count());
+
+  for (uint64_t p = 0; p < num_vtx; ++p) {
+    if (is_core_[p]) memberships[order_[p]] = DBSCAN::membership::Core;
+  }
+  // clusters are numbered by their smallest core vertex.
+  std::vector<int> cluster_of_cell(num_cells, -1);
+  int num_clusters = 0;
+  for (uint64_t vtx = 0; vtx < num_vtx; ++vtx) {
+    if (memberships[vtx] != DBSCAN::membership::Core) continue;
+    int& id = cluster_of_cell[find(cell_of_[vtx])];
+    if (id == -1) id = num_clusters++;
+    cluster_ids[vtx] = id;
+  }
+  for (uint64_t c = 0; c < num_cells; ++c)
+    cluster_of_cell[c] = cluster_of_cell[find(c)];
+  DBSCAN::utils::run_threads(num_threads_, [&](const uint8_t tid) {
+    for (uint64_t p = tid; p < num_vtx; p += num_threads_) {
+      if (is_core_[p]) continue;
+      int best = -1;
+      for_each_nb_cell(cell_of_[order_[p]], [&](const uint64_t nc) {
+        const int id = cluster_of_cell[nc];
+        if (id == -1 || (best != -1 && id >= best)) return;
+        if (HasCore_(cell_root_[nc], xs_[p], ys_[p], stats[tid])) best = id;
+      });
+      if (best != -1) {
+        cluster_ids[order_[p]] = best;
+        memberships[order_[p]] = DBSCAN::membership::Border;
+      }
+    }
+  });
+  auto t4 = high_resolution_clock::now();
+  logger_->info("labelling takes {} seconds",
+                duration_cast<duration<double>>(t4 - t3).count());
+
+  for (const auto& s : stats) {
+    num_decisions_ += s.decisions;
+    num_ambiguous_ += s.ambiguous;
+  }
+  logger_->info("{} of {} node decisions fell into the ambiguous band (rho={})",
+                num_ambiguous_, num_decisions_, rho_);
+}
+
+void DBSCAN::ApproxSolver::BuildCells_(
+    const DBSCAN::input_type::TwoDimPoints& dataset) {
+  const uint64_t num_vtx = dataset.d1.size();
+  min_x_ = *std::min_element(dataset.d1.cbegin(), dataset.d1.cend());
+  min_y_ = *std::min_element(dataset.d2.cbegin(), dataset.d2.cend());
+  const float max_x = *std::max_element(dataset.d1.cbegin(), dataset.d1.cend());
+  const float max_y = *std::max_element(dataset.d2.cbegin(), dataset.d2.cend());
+  grid_cols_ = static_cast<int64_t>((max_x - min_x_) / cell_side_) + 1;
+  grid_rows_ = static_cast<int64_t>((max_y - min_y_) / cell_side_) + 1;
+  const uint64_t num_cells = grid_rows_ * grid_cols_;
+
+  // counting sort of the vertices by cell
+  cell_of_.resize(num_vtx);
+  cell_start_.assign(num_cells + 1, 0);
+  for (uint64_t vtx = 0; vtx < num_vtx; ++vtx) {
+    const auto col = std::min<int64_t>(
+        (dataset.d1[vtx] - min_x_) / cell_side_, grid_cols_ - 1);
+    const auto row = std::min<int64_t>(
+        (dataset.d2[vtx] - min_y_) / cell_side_, grid_rows_ - 1);
+    cell_of_[vtx] = row * grid_cols_ + col;
+    ++cell_start_[cell_of_[vtx] + 1];
+  }
+  for (uint64_t c = 0; c < num_cells; ++c) cell_start_[c + 1] += cell_start_[c];
+  order_.resize(num_vtx);
+  {
+    std::vector<uint64_t> next(cell_start_.cbegin(), cell_start_.cend() - 1);
+    for (uint64_t vtx = 0; vtx < num_vtx; ++vtx)
+      order_[next[cell_of_[vtx]]++] = vtx;
+  }
+
+  nodes_.clear();
+  cell_root_.assign(num_cells, -1);
+  for (uint64_t c = 0; c < num_cells; ++c) {
+    if (cell_start_[c] == cell_start_[c + 1]) continue;
+    cell_root_[c] = nodes_.size();
+    nodes_.emplace_back();
+    BuildTree_(dataset, cell_root_[c], cell_start_[c], cell_start_[c + 1],
+               min_x_ + (c % grid_cols_) * cell_side_,
+               min_y_ + (c / grid_cols_) * cell_side_, cell_side_, 0);
+  }
+  xs_.resize(num_vtx);
+  ys_.resize(num_vtx);
+  for (uint64_t p = 0; p < num_vtx; ++p) {
+    xs_[p] = dataset.d1[order_[p]];
+    ys_[p] = dataset.d2[order_[p]];
+  }
+}
+
+void DBSCAN::ApproxSolver::BuildTree_(
+    const DBSCAN::input_type::TwoDimPoints& dataset, const int64_t idx,
+    const uint64_t begin, const uint64_t end, const float x0, const float y0,
+    const float side, const uint32_t depth) {
+  constexpr float kInf = std::numeric_limits<float>::infinity();
+  Node node{kInf, kInf, -kInf, -kInf, begin, end, 0, -1};
+  for (uint64_t p = begin; p < end; ++p) {
+    const float x = dataset.d1[order_[p]], y = dataset.d2[order_[p]];
+    node.x_lo = std::min(node.x_lo, x);
+    node.y_lo = std::min(node.y_lo, y);
+    node.x_hi = std::max(node.x_hi, x);
+    node.y_hi = std::max(node.y_hi, y);
+  }
+  if (end - begin > kLeafSize && depth < max_depth_) {
+    // split the nominal square, not the tight box, so the diagonal halves.
+    const float half = side / 2, mid_x = x0 + half, mid_y = y0 + half;
+    const auto first = order_.begin() + begin, last = order_.begin() + end;
+    const auto by_x = std::partition(first, last, [&](const uint64_t v) {
+      return dataset.d1[v] < mid_x;
+    });
+    const auto below = [&](const uint64_t v) { return dataset.d2[v] < mid_y; };
+    const auto left_y = std::partition(first, by_x, below);
+    const auto right_y = std::partition(by_x, last, below);
+    const uint64_t cuts[5] = {
+        begin, static_cast<uint64_t>(left_y - order_.begin()),
+        static_cast<uint64_t>(by_x - order_.begin()),
+        static_cast<uint64_t>(right_y - order_.begin()), end};
+    node.first_child = nodes_.size();
+    nodes_.resize(nodes_.size() + 4);
+    for (int64_t q = 0; q < 4; ++q) {
+      BuildTree_(dataset, node.first_child + q, cuts[q], cuts[q + 1],
+                 q < 2 ? x0 : mid_x, q % 2 == 0 ? y0 : mid_y, half,
+                 depth + 1);
+    }
+  }
+  nodes_[idx] = node;
+}
+
+uint64_t DBSCAN::ApproxSolver::Count_(const int64_t idx, const float x,
+                                      const float y, const uint64_t limit,
+                                      Stats& stats) const {
+  const Node& node = nodes_[idx];
+  if (node.begin == node.end) return 0;
+  const float min_dist = MinDist_(node, x, y), max_dist = MaxDist_(node, x, y);
+  if (min_dist > squared_radius_ || max_dist <= squared_outer_radius_) {
+    ++stats.decisions;
+    if (min_dist > squared_radius_) return 0;
+    stats.ambiguous += max_dist > squared_radius_;
+    return node.end - node.begin;
+  }
+  uint64_t count = 0;
+  if (node.first_child < 0) {
+    ++stats.decisions;
+    const auto dist = input_type::TwoDimPoints::euclidean_distance_square;
+    for (uint64_t p = node.begin; p < node.end && count < limit; ++p)
+      count += dist(x, y, xs_[p], ys_[p]) <= squared_radius_;
+    return count;
+  }
+  for (int64_t q = 0; q < 4 && count < limit; ++q)
+    count += Count_(node.first_child + q, x, y, limit - count, stats);
+  return count;
+}
+
+bool DBSCAN::ApproxSolver::HasCore_(const int64_t idx, const float x,
+                                    const float y, Stats& stats) const {
+  const Node& node = nodes_[idx];
+  if (node.num_core == 0) return false;
+  const float min_dist = MinDist_(node, x, y), max_dist = MaxDist_(node, x, y);
+  if (min_dist > squared_radius_ || max_dist <= squared_outer_radius_) {
+    ++stats.decisions;
+    if (min_dist > squared_radius_) return false;
+    stats.ambiguous += max_dist > squared_radius_;
+    return true;
+  }
+  if (node.first_child < 0) {
+    ++stats.decisions;
+    const auto dist = input_type::TwoDimPoints::euclidean_distance_square;
+    for (uint64_t p = node.begin; p < node.end; ++p) {
+      if (is_core_[p] && dist(x, y, xs_[p], ys_[p]) <= squared_radius_)
+        return true;
+    }
+    return false;
+  }
+  for (int64_t q = 0; q < 4; ++q) {
+    if (HasCore_(node.first_child + q, x, y, stats)) return true;
+  }
+  return false;
+}
+
+float DBSCAN::ApproxSolver::MinDist_(const Node& node, const float x,
+                                     const float y) const {
+  const float dx = std::max(std::max(node.x_lo - x, x - node.x_hi), 0.f);
+  const float dy = std::max(std::max(node.y_lo - y, y - node.y_hi), 0.f);
+  return dx * dx + dy * dy;
+}
+
+float DBSCAN::ApproxSolver::MaxDist_(const Node& node, const float x,
+                                     const float y) const {
+  const float dx = std::max(x - node.x_lo, node.x_hi - x);
+  const float dy = std::max(y - node.y_lo, node.y_hi - y);
+  return dx * dx + dy * dy;
+}
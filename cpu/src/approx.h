@@ -0,0 +1,84 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#ifndef DBSCAN_INCLUDE_APPROX_H_
+#define DBSCAN_INCLUDE_APPROX_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "DBSCAN/membership.h"
+#include "dataset.h"
+#include "spdlog/spdlog.h"
+
+namespace DBSCAN {
+/*
+ * rho-approximate DBSCAN (Gan & Tao). The points are bucketed into cells of
+ * side radius/sqrt(2), so the points of a cell are all within the radius of
+ * each other, and every non-empty cell gets a shallow quadtree. Range counts
+ * and "is there a core point near me" queries walk those trees and may take a
+ * whole node once it is inside radius*(1+rho) instead of descending to the
+ * points, so a pair at a distance in (radius, radius*(1+rho)] may or may not
+ * count as neighbours; pairs within the radius always do and pairs beyond
+ * radius*(1+rho) never do. Clusters are connected components of core cells.
+ *
+ * With rho = 0 no approximation is taken and the labels match a
+ * single-threaded |Solver|: clusters are numbered by their smallest core
+ * vertex and a Border vertex joins the smallest adjacent cluster.
+ */
+class ApproxSolver {
+ public:
+  ApproxSolver(uint64_t, float, float, uint8_t);
+  void Run(const DBSCAN::input_type::TwoDimPoints&, std::vector<int>&,
+           std::vector<DBSCAN::membership>&);
+  // Node decisions taken by the last |Run|, and how many of them relied on
+  // the (radius, radius*(1+rho)] band.
+  [[nodiscard]] uint64_t num_decisions() const { return num_decisions_; }
+  [[nodiscard]] uint64_t num_ambiguous() const { return num_ambiguous_; }
+
+ private:
+  // Quadtree node over the positions [begin, end) of |order_|. The box is
+  // the tight bounding box of its points; the four children are adjacent.
+  struct Node {
+    float x_lo, y_lo, x_hi, y_hi;
+    uint64_t begin, end, num_core;
+    int64_t first_child;
+  };
+  struct Stats {
+    uint64_t decisions = 0, ambiguous = 0;
+  };
+  static constexpr uint64_t kLeafSize = 16;
+  static constexpr uint32_t kMaxDepth = 8;
+
+  uint64_t min_pts_;
+  float radius_, rho_, squared_radius_, squared_outer_radius_;
+  uint8_t num_threads_;
+  uint32_t max_depth_;
+  // grid
+  float min_x_, min_y_, cell_side_;
+  int64_t grid_rows_, grid_cols_;
+  std::vector<std::pair<int64_t, int64_t>> offsets_;
+  std::vector<uint64_t> cell_start_, cell_of_, order_;
+  std::vector<int64_t> cell_root_;
+  std::vector<float> xs_, ys_;
+  std::vector<uint8_t> is_core_;
+  std::vector<Node> nodes_;
+  uint64_t num_decisions_ = 0, num_ambiguous_ = 0;
+  std::shared_ptr<spdlog::logger> logger_ = nullptr;
+
+  void BuildCells_(const DBSCAN::input_type::TwoDimPoints&);
+  void BuildTree_(const DBSCAN::input_type::TwoDimPoints&, int64_t, uint64_t,
+                  uint64_t, float, float, float, uint32_t);
+  [[nodiscard]] uint64_t Count_(int64_t, float, float, uint64_t,
+                                Stats&) const;
+  [[nodiscard]] bool HasCore_(int64_t, float, float, Stats&) const;
+  // Squared distance from (x, y) to the nearest point and to the farthest
+  // corner of a node's box.
+  [[nodiscard]] float MinDist_(const Node&, float, float) const;
+  [[nodiscard]] float MaxDist_(const Node&, float, float) const;
+};
+}  // namespace DBSCAN
+
+#endif  // DBSCAN_INCLUDE_APPROX_H_
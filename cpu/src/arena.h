@@ -0,0 +1,200 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#ifndef DBSCAN_INCLUDE_ARENA_H_
+#define DBSCAN_INCLUDE_ARENA_H_
+
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace DBSCAN {
+namespace utils {
+/*
+ * Bump-pointer arena for the scratch buffers of one clustering run. Memory is
+ * carved out of large blocks and only handed back all at once by |Reset|,
+ * which keeps the blocks, so a following run of similar size does not call
+ * malloc/free at all; |Release| frees them instead. |Allocate| may be called
+ * from several threads at once; |Reset| and |Release| must not race with it.
+ *
+ * With |huge_pages| the blocks are mmap'ed with MAP_HUGETLB, falling back to
+ * transparent huge pages (madvise) when no huge pages are reserved.
+ */
+class Arena {
+ public:
+  static constexpr size_t kBlockSize = 4u << 20u;
+  static constexpr size_t kHugePageSize = 2u << 20u;
+
+  explicit Arena(const bool huge_pages = false,
+                 const size_t block_size = kBlockSize)
+      : huge_pages_(huge_pages), block_size_(block_size) {}
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+  ~Arena() { Release(); }
+
+  [[nodiscard]] void* Allocate(const size_t bytes, const size_t alignment) {
+    // offsets are kept multiples of kGranularity; stricter alignments pad.
+    const size_t pad = alignment > kGranularity ? alignment - kGranularity : 0;
+    const size_t need =
+        RoundUp_(std::max<size_t>(bytes + pad, 1), kGranularity);
+    while (true) {
+      Block* const block = curr_.load(std::memory_order_acquire);
+      if (block != nullptr) {
+        const size_t offset =
+            block->used.fetch_add(need, std::memory_order_relaxed);
+        if (offset + need <= block->size) {
+          const auto p = reinterpret_cast<uintptr_t>(block->data + offset);
+          return reinterpret_cast<void*>(RoundUp_(p, alignment));
+        }
+      }
+      Grow_(block, need);
+    }
+  }
+  // Rewind to the first block. Everything allocated so far becomes invalid.
+  void Reset() {
+    for (const auto& block : blocks_) block->used = 0;
+    curr_idx_ = 0;
+    curr_ = blocks_.empty() ? nullptr : blocks_.front().get();
+  }
+  // Hand every block back to the system. Everything allocated so far becomes
+  // invalid.
+  void Release() {
+    for (const auto& block : blocks_) {
+      if (block->mmapped)
+        munmap(block->data, block->size);
+      else
+        std::free(block->data);
+    }
+    blocks_.clear();
+    curr_idx_ = 0;
+    curr_ = nullptr;
+  }
+  // bytes held in blocks, used or not.
+  [[nodiscard]] size_t capacity() const {
+    size_t bytes = 0;
+    for (const auto& block : blocks_) bytes += block->size;
+    return bytes;
+  }
+  [[nodiscard]] size_t num_blocks() const { return blocks_.size(); }
+  [[nodiscard]] bool huge_pages() const { return huge_pages_; }
+
+ private:
+  static constexpr size_t kGranularity = 16;
+  struct Block {
+    char* data;
+    size_t size;
+    bool mmapped;
+    std::atomic<size_t> used{0};
+  };
+  bool huge_pages_;
+  size_t block_size_;
+  std::vector<std::unique_ptr<Block>> blocks_;
+  size_t curr_idx_ = 0;
+  std::atomic<Block*> curr_{nullptr};
+  std::mutex mutex_;
+
+  static constexpr size_t RoundUp_(const size_t n, const size_t multiple) {
+    return (n + multiple - 1) / multiple * multiple;
+  }
+  // Move past |full| to the next block that fits |need| bytes, allocating one
+  // if there is none. A no-op if another thread already moved on.
+  void Grow_(Block* const full, const size_t need) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (curr_.load(std::memory_order_relaxed) != full) return;
+    for (size_t i = full == nullptr ? 0 : curr_idx_ + 1; i < blocks_.size();
+         ++i) {
+      if (blocks_[i]->size >= need) {
+        curr_idx_ = i;
+        curr_.store(blocks_[i].get(), std::memory_order_release);
+        return;
+      }
+    }
+    auto block = std::make_unique<Block>();
+    block->size = std::max(block_size_, need);
+    if (huge_pages_) {
+      block->size = RoundUp_(block->size, kHugePageSize);
+      void* p = mmap(nullptr, block->size, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+      if (p == MAP_FAILED) {
+        p = mmap(nullptr, block->size, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) throw std::bad_alloc();
+#if defined(MADV_HUGEPAGE)
+        madvise(p, block->size, MADV_HUGEPAGE);
+#endif
+      }
+      block->data = static_cast<char*>(p);
+      block->mmapped = true;
+    } else {
+      block->size = RoundUp_(block->size, 64);
+      block->data = static_cast<char*>(aligned_alloc(64, block->size));
+      if (block->data == nullptr) throw std::bad_alloc();
+      block->mmapped = false;
+    }
+    blocks_.push_back(std::move(block));
+    curr_idx_ = blocks_.size() - 1;
+    curr_.store(blocks_.back().get(), std::memory_order_release);
+  }
+};
+
+// Allocates from an |Arena|; deallocation is a no-op and the memory comes back
+// when the arena is reset. Without an arena it falls back to malloc/free.
+// CONSTRUCT=false skips element construction like |NonConstructAllocator|.
+template <class T, bool CONSTRUCT = true>
+class ArenaAllocator {
+ public:
+  typedef T value_type;
+  // containers adopt the arena of the buffer they are assigned from.
+  using propagate_on_container_copy_assignment = std::true_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+  ArenaAllocator() = default;
+  explicit ArenaAllocator(Arena* arena) noexcept : arena_(arena) {}
+  // clang-format off
+  template <class U>
+  constexpr ArenaAllocator(const ArenaAllocator<U, CONSTRUCT>& other) noexcept : arena_(other.arena()) {}
+  template <class U>
+  friend bool operator==(const ArenaAllocator<T, CONSTRUCT>& a, const ArenaAllocator<U, CONSTRUCT>& b) { return a.arena() == b.arena(); }
+  template <class U>
+  friend bool operator!=(const ArenaAllocator<T, CONSTRUCT>& a, const ArenaAllocator<U, CONSTRUCT>& b) { return a.arena() != b.arena(); }
+  // clang-format on
+  [[nodiscard]] T* allocate(std::size_t n) {
+    if (n > std::numeric_limits<std::size_t>::max() / sizeof(T))
+      throw std::bad_alloc();
+    if (arena_ != nullptr)
+      return static_cast<T*>(arena_->Allocate(n * sizeof(T), alignof(T)));
+    if (auto p = static_cast<T*>(std::malloc(n * sizeof(T)))) return p;
+    throw std::bad_alloc();
+  }
+  void deallocate(T* p, std::size_t) noexcept {
+    if (arena_ == nullptr) std::free(p);
+  }
+  template <class U, class... Args>
+  void construct(U* p, Args&&... args) {
+    if constexpr (CONSTRUCT)
+      ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+  }
+  template <class U>
+  struct rebind {
+    typedef ArenaAllocator<U, CONSTRUCT> other;
+  };
+  [[nodiscard]] Arena* arena() const { return arena_; }
+
+ private:
+  Arena* arena_ = nullptr;
+};
+}  // namespace utils
+}  // namespace DBSCAN
+
+#endif  // DBSCAN_INCLUDE_ARENA_H_
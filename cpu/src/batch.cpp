@@ -0,0 +1,85 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#include "batch.h"
+
+#include <atomic>
+#include <fstream>
+#include <future>
+#include <sstream>
+
+#include "threads.h"
+
+std::vector<DBSCAN::batch::Job> DBSCAN::batch::ReadManifest(
+    const std::string& manifest) {
+  std::ifstream ifs(manifest);
+  if (!ifs) throw std::runtime_error("cannot open " + manifest);
+  std::vector<Job> jobs;
+  std::string line;
+  uint64_t line_no = 0;
+  while (std::getline(ifs, line)) {
+    ++line_no;
+    std::istringstream iss(line);
+    Job job;
+    if (!(iss >> job.input) || job.input[0] == '#') continue;
+    if (!(iss >> job.eps >> job.min_pts)) {
+      std::ostringstream oss;
+      oss << manifest << ":" << line_no << " expects <input> <eps> <min_pts>";
+      throw std::runtime_error(oss.str());
+    }
+    iss >> job.output;
+    jobs.push_back(std::move(job));
+  }
+  return jobs;
+}
+
+uint64_t DBSCAN::batch::Run(const std::vector<Job>& jobs,
+                            const uint8_t num_workers,
+                            const Callback& callback) {
+  auto logger = spdlog::get("console");
+  if (logger == nullptr) {
+    throw std::runtime_error("logger not created!");
+  }
+  using Dataset = std::unique_ptr<DBSCAN::input_type::TwoDimPoints>;
+  const auto read = [&jobs](const uint64_t job) {
+    return std::async(std::launch::async,
+                      DBSCAN::input_type::TwoDimPoints::Read, jobs[job].input);
+  };
+  std::atomic<uint64_t> next_job{0}, num_failed{0};
+  DBSCAN::utils::run_threads(num_workers, [&](const uint8_t tid) {
+    std::unique_ptr<Solver> solver = nullptr;
+    uint64_t job = next_job++;
+    std::future<Dataset> pending;
+    if (job < jobs.size()) pending = read(job);
+    while (job < jobs.size()) {
+      // claim and prefetch the next job before clustering this one.
+      const uint64_t following = next_job++;
+      std::future<Dataset> prefetch;
+      if (following < jobs.size()) prefetch = read(following);
+      try {
+        Dataset dataset = pending.get();
+        if (solver == nullptr) {
+          solver = std::make_unique<Solver>(std::move(dataset),
+                                            jobs[job].min_pts, jobs[job].eps,
+                                            1u);
+        } else {
+          solver->Reset(std::move(dataset), jobs[job].min_pts, jobs[job].eps);
+        }
+        solver->ConstructGrid();
+        solver->InsertEdges();
+        solver->FinalizeGraph();
+        solver->ClassifyNoises();
+        solver->IdentifyClusters();
+        callback(job, *solver);
+      } catch (const std::exception& e) {
+        ++num_failed;
+        logger->error("worker {}: job {} ({}) failed: {}", tid, job,
+                      jobs[job].input, e.what());
+      }
+      job = following;
+      pending = std::move(prefetch);
+    }
+  });
+  return num_failed;
+}
@@ -0,0 +1,43 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#ifndef DBSCAN_INCLUDE_BATCH_H_
+#define DBSCAN_INCLUDE_BATCH_H_
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "solver.h"
+
+namespace DBSCAN {
+namespace batch {
+struct Job {
+  std::string input;
+  float eps;
+  uint64_t min_pts;
+  // optional; where the driver writes the cluster ids.
+  std::string output;
+};
+
+/*
+ * One job per line: "<input> <eps> <min_pts> [output]". Blank lines and lines
+ * starting with '#' are skipped.
+ */
+std::vector<Job> ReadManifest(const std::string&);
+
+/*
+ * Clusters many small datasets in one process. Each of the |num_workers|
+ * workers claims jobs one at a time and runs them on its own single-threaded
+ * |Solver|, which is Reset between jobs so its buffers are reused. The input
+ * of a worker's next job is read asynchronously while the current one runs.
+ * |callback(job_idx, solver)| is called from the worker threads once a job is
+ * clustered. Returns the number of jobs that failed.
+ */
+using Callback = std::function<void(uint64_t, const Solver&)>;
+uint64_t Run(const std::vector<Job>&, uint8_t, const Callback&);
+}  // namespace batch
+}  // namespace DBSCAN
+
+#endif  // DBSCAN_INCLUDE_BATCH_H_
@@ -5,20 +5,130 @@
 #ifndef DBSCAN_INCLUDE_DATASET_H_
 #define DBSCAN_INCLUDE_DATASET_H_
 
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "DBSCAN/utils.h"
 
 namespace DBSCAN {
 namespace input_type {
+/*
+ * Allocates 32-byte aligned columns, or hands a column the caller's buffer of
+ * exactly |size| elements, once, so it is read in place. The adopted buffer is
+ * neither initialized nor freed. Any later allocation, e.g. after a
+ * shrink_to_fit, and every copy of the column get storage of their own.
+ */
+template <class T>
+class ColumnAllocator {
+ public:
+  typedef T value_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+  ColumnAllocator() = default;
+  ColumnAllocator(T* adopted, size_t size) noexcept
+      : adopted_(adopted), size_(size) {}
+  // a rebound allocator never adopts.
+  template <class U>
+  constexpr explicit ColumnAllocator(const ColumnAllocator<U>&) noexcept {}
+  friend bool operator==(const ColumnAllocator& a, const ColumnAllocator& b) {
+    return a.adopted_ == b.adopted_;
+  }
+  friend bool operator!=(const ColumnAllocator& a, const ColumnAllocator& b) {
+    return !(a == b);
+  }
+  [[nodiscard]] T* allocate(std::size_t n) {
+    if (adopted_ != nullptr && !handed_out_ && n == size_) {
+      handed_out_ = true;
+      return adopted_;
+    }
+    return utils::AlignedAllocator<T, 32>().allocate(n);
+  }
+  void deallocate(T* p, std::size_t n) noexcept {
+    if (p != adopted_) utils::AlignedAllocator<T, 32>().deallocate(p, n);
+  }
+  template <class U, class... Args>
+  void construct(U* p, Args&&... args) {
+    ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+  }
+  // value-initialization would overwrite the adopted values.
+  template <class U>
+  void construct(U* p) {
+    if (p < adopted_ || p >= adopted_ + size_) {
+      ::new (static_cast<void*>(p)) U();
+    }
+  }
+  ColumnAllocator select_on_container_copy_construction() const { return {}; }
+
+ private:
+  T* adopted_ = nullptr;
+  size_t size_ = 0;
+  // the column's own copy hands the buffer out; copies made after that,
+  // e.g. by a move, carry the flag along.
+  bool handed_out_ = false;
+};
+using Column = std::vector<float, ColumnAllocator<float>>;
+
 struct TwoDimPoints {
-  std::vector<float, DBSCAN::utils::AlignedAllocator<float, 32>> d1, d2;
+  Column d1, d2;
   explicit TwoDimPoints(size_t num_vtx) : d1(num_vtx), d2(num_vtx) {}
+  /*
+   * Points that read |xs| and |ys| in place; both must outlive them. They are
+   * const, so nothing writes through to the caller's buffers, which may be
+   * read-only.
+   */
+  static std::unique_ptr<const TwoDimPoints> View(const float* xs,
+                                                  const float* ys,
+                                                  size_t num_vtx) {
+    return std::unique_ptr<const TwoDimPoints>(
+        new TwoDimPoints(const_cast<float*>(xs), const_cast<float*>(ys),
+                         num_vtx));
+  }
+  /*
+   * Read "<num_vtx>\n<id> <x> <y>\n..." as written by generate_dateset.py. The
+   * whole file is slurped and parsed with strto* since istream extraction
+   * dominates the runtime on small inputs.
+   */
+  static std::unique_ptr<TwoDimPoints> Read(const std::string& input) {
+    std::ifstream ifs(input, std::ios::binary | std::ios::ate);
+    if (!ifs) throw std::runtime_error("cannot open " + input);
+    std::string buf(static_cast<size_t>(ifs.tellg()), '\0');
+    ifs.seekg(0);
+    ifs.read(buf.data(), buf.size());
+    const char* p = buf.c_str();
+    char* end;
+    const uint64_t num_vtx = std::strtoull(p, &end, 10);
+    auto points = std::make_unique<TwoDimPoints>(num_vtx);
+    for (p = end;; p = end) {
+      const uint64_t n = std::strtoull(p, &end, 10);
+      if (end == p) break;
+      const float x = std::strtof(p = end, &end);
+      const float y = std::strtof(p = end, &end);
+      if (end == p || n >= num_vtx) {
+        throw std::runtime_error("malformed vertex " + std::to_string(n) +
+                                 " in " + input);
+      }
+      points->d1[n] = x;
+      points->d2[n] = y;
+    }
+    return points;
+  }
   static inline float euclidean_distance_square(const float px, const float py,
                                                 const float qx,
                                                 const float qy) {
     return (px - qx) * (px - qx) + (py - qy) * (py - qy);
   }
+
+ private:
+  TwoDimPoints(float* xs, float* ys, size_t num_vtx)
+      : d1(num_vtx, ColumnAllocator<float>(xs, num_vtx)),
+        d2(num_vtx, ColumnAllocator<float>(ys, num_vtx)) {}
 };
 }  // namespace input_type
 }  // namespace DBSCAN
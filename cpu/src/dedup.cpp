@@ -0,0 +1,144 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#include "dedup.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+#include "threads.h"
+
+namespace {
+using Entry = std::pair<uint64_t, uint64_t>;
+
+// [begin, end) of the |tid|-th of |num_threads| chunks of |n|.
+std::pair<uint64_t, uint64_t> Chunk_(const uint64_t n, const uint8_t tid,
+                                     const uint8_t num_threads) {
+  const uint64_t size = (n + num_threads - 1) / num_threads;
+  return {std::min(n, tid * size), std::min(n, (tid + 1) * size)};
+}
+
+uint64_t Bits_(const float v) {
+  // adding 0 turns -0 into +0.
+  const float normalized = v + 0.f;
+  uint32_t bits;
+  std::memcpy(&bits, &normalized, sizeof(bits));
+  return bits;
+}
+
+uint64_t Cell_(const float v, const float tolerance) {
+  const double cell = std::floor(static_cast<double>(v) / tolerance);
+  if (!(std::fabs(cell) < 2147483648.0)) {
+    throw std::runtime_error("dedup tolerance too small for the coordinates!");
+  }
+  return static_cast<uint32_t>(static_cast<int64_t>(cell) + 2147483648ll);
+}
+}  // namespace
+
+DBSCAN::dedup::Collapsed DBSCAN::dedup::Collapse(
+    const DBSCAN::input_type::TwoDimPoints& dataset, const float tolerance,
+    const uint8_t num_threads) {
+  const uint64_t n = dataset.d1.size();
+  const auto& xs = dataset.d1;
+  const auto& ys = dataset.d2;
+  std::vector<Entry> entries(n);
+  DBSCAN::utils::run_threads(num_threads, [&](const uint8_t tid) {
+    const auto [begin, end] = Chunk_(n, tid, num_threads);
+    for (uint64_t i = begin; i < end; ++i) {
+      const uint64_t key =
+          tolerance > 0
+              ? Cell_(xs[i], tolerance) << 32u | Cell_(ys[i], tolerance)
+              : Bits_(xs[i]) << 32u | Bits_(ys[i]);
+      entries[i] = {key, i};
+    }
+    std::sort(entries.begin() + begin, entries.begin() + end);
+  });
+  // merge neighbouring sorted runs until one is left.
+  const uint64_t run = (n + num_threads - 1) / num_threads;
+  for (uint64_t width = run; width > 0 && width < n; width *= 2) {
+    DBSCAN::utils::run_threads(num_threads, [&](const uint8_t tid) {
+      for (uint64_t begin = 2 * width * tid; begin < n;
+           begin += 2 * width * num_threads) {
+        const uint64_t mid = std::min(n, begin + width);
+        const uint64_t end = std::min(n, begin + 2 * width);
+        std::inplace_merge(entries.begin() + begin, entries.begin() + mid,
+                           entries.begin() + end);
+      }
+    });
+  }
+
+  // the lowest id of every group comes first in it and represents it.
+  std::vector<uint64_t> rep_of(n), weight_of(n, 0);
+  DBSCAN::utils::run_threads(num_threads, [&](const uint8_t tid) {
+    const auto [begin, end] = Chunk_(n, tid, num_threads);
+    if (begin == end) return;
+    uint64_t first = begin;
+    while (first > 0 && entries[first - 1].first == entries[begin].first)
+      --first;
+    for (uint64_t pos = begin; pos < end; ++pos) {
+      if (entries[pos].first != entries[first].first) first = pos;
+      rep_of[entries[pos].second] = entries[first].second;
+      if (pos == first) {
+        uint64_t last = pos + 1;
+        while (last < n && entries[last].first == entries[pos].first) ++last;
+        weight_of[entries[pos].second] = last - pos;
+      }
+    }
+  });
+  std::vector<Entry>().swap(entries);
+
+  // number the groups in the order of their first ids.
+  std::vector<uint64_t> offsets(num_threads + 1, 0);
+  DBSCAN::utils::run_threads(num_threads, [&](const uint8_t tid) {
+    const auto [begin, end] = Chunk_(n, tid, num_threads);
+    for (uint64_t i = begin; i < end; ++i) offsets[tid + 1] += rep_of[i] == i;
+  });
+  for (uint8_t tid = 0; tid < num_threads; ++tid)
+    offsets[tid + 1] += offsets[tid];
+  const uint64_t num_groups = offsets[num_threads];
+  Collapsed collapsed;
+  collapsed.points =
+      std::make_unique<DBSCAN::input_type::TwoDimPoints>(num_groups);
+  collapsed.weights.resize(num_groups);
+  // |weight_of| of a representative becomes its group.
+  DBSCAN::utils::run_threads(num_threads, [&](const uint8_t tid) {
+    const auto [begin, end] = Chunk_(n, tid, num_threads);
+    uint64_t group = offsets[tid];
+    for (uint64_t i = begin; i < end; ++i) {
+      if (rep_of[i] != i) continue;
+      collapsed.points->d1[group] = xs[i];
+      collapsed.points->d2[group] = ys[i];
+      collapsed.weights[group] = weight_of[i];
+      weight_of[i] = group++;
+    }
+  });
+  DBSCAN::utils::run_threads(num_threads, [&](const uint8_t tid) {
+    const auto [begin, end] = Chunk_(n, tid, num_threads);
+    for (uint64_t i = begin; i < end; ++i) rep_of[i] = weight_of[rep_of[i]];
+  });
+  collapsed.vertex_of = std::move(rep_of);
+  return collapsed;
+}
+
+void DBSCAN::dedup::Expand(const std::vector<uint64_t>& vertex_of,
+                           std::vector<int>& cluster_ids,
+                           std::vector<DBSCAN::membership>& memberships,
+                           const uint8_t num_threads) {
+  const uint64_t n = vertex_of.size();
+  std::vector<int> ids(n);
+  std::vector<DBSCAN::membership> ms(n);
+  DBSCAN::utils::run_threads(num_threads, [&](const uint8_t tid) {
+    const auto [begin, end] = Chunk_(n, tid, num_threads);
+    for (uint64_t i = begin; i < end; ++i) {
+      ids[i] = cluster_ids[vertex_of[i]];
+      ms[i] = memberships[vertex_of[i]];
+    }
+  });
+  cluster_ids.swap(ids);
+  memberships.swap(ms);
+}
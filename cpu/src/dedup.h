@@ -0,0 +1,43 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#ifndef DBSCAN_INCLUDE_DEDUP_H_
+#define DBSCAN_INCLUDE_DEDUP_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "DBSCAN/membership.h"
+#include "dataset.h"
+
+namespace DBSCAN {
+namespace dedup {
+struct Collapsed {
+  // one point per group, at the coordinates of its lowest input id, in the
+  // order of those ids.
+  std::unique_ptr<input_type::TwoDimPoints> points;
+  // number of input points in each group
+  std::vector<uint64_t> weights;
+  // group of every input point
+  std::vector<uint64_t> vertex_of;
+};
+
+/*
+ * Group the points with identical coordinates (bit for bit, with -0 = 0) or,
+ * for a |tolerance| > 0, those in the same tolerance-wide cell of a grid
+ * anchored at the origin, which then all stand at the group's first point.
+ * The (key, id) pairs are sorted one chunk per thread and merged pairwise.
+ * Throws if the coordinates span more than 2^32 such cells.
+ */
+Collapsed Collapse(const input_type::TwoDimPoints&, float tolerance,
+                   uint8_t num_threads);
+
+// Replace the labels of the groups with those of every input point.
+void Expand(const std::vector<uint64_t>& vertex_of, std::vector<int>&,
+            std::vector<DBSCAN::membership>&, uint8_t num_threads);
+}  // namespace dedup
+}  // namespace DBSCAN
+
+#endif  // DBSCAN_INCLUDE_DEDUP_H_
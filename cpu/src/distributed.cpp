@@ -0,0 +1,122 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#include "distributed.h"
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+#include "partition.h"
+
+// ctor
+DBSCAN::distributed::Coordinator::Coordinator(const uint64_t min_pts,
+                                              const float radius,
+                                              const uint32_t num_workers,
+                                              const uint8_t num_threads)
+    : min_pts_(min_pts),
+      radius_(radius),
+      num_workers_(num_workers),
+      num_threads_(num_threads) {
+  logger_ = spdlog::get("console");
+  if (logger_ == nullptr) {
+    throw std::runtime_error("logger not created!");
+  }
+  if (num_workers_ == 0) throw std::runtime_error("need at least one worker!");
+}
+
+void DBSCAN::distributed::Coordinator::Run(
+    const DBSCAN::input_type::TwoDimPoints& dataset,
+    transport::Transport& transport, std::vector<int>& cluster_ids,
+    std::vector<DBSCAN::membership>& memberships) {
+  using namespace std::chrono;
+  auto t0 = high_resolution_clock::now();
+  const auto parts =
+      DBSCAN::partition::KdSplit(dataset, radius_, num_workers_);
+  for (uint32_t w = 0; w < num_workers_; ++w) {
+    logger_->debug("part {}: {} owned, {} halo", w, parts[w].owned.size(),
+                   parts[w].halo.size());
+  }
+  auto t1 = high_resolution_clock::now();
+  logger_->info("partitioning takes {} seconds",
+                duration_cast<duration<double>>(t1 - t0).count());
+
+  auto channels = transport.Spawn(num_workers_, ServeWorker);
+  for (uint32_t w = 0; w < num_workers_; ++w) {
+    const auto& part = parts[w];
+    // owned vertices first, then the halo.
+    std::vector<uint64_t> ids(part.owned);
+    ids.insert(ids.end(), part.halo.cbegin(), part.halo.cend());
+    std::vector<float> xs(ids.size()), ys(ids.size());
+    for (uint64_t i = 0; i < ids.size(); ++i) {
+      xs[i] = dataset.d1[ids[i]];
+      ys[i] = dataset.d2[ids[i]];
+    }
+    transport::Message task;
+    task.Put(min_pts_);
+    task.Put(radius_);
+    task.Put(num_threads_);
+    task.Put<uint64_t>(part.owned.size());
+    task.Put(ids);
+    task.Put(xs);
+    task.Put(ys);
+    channels[w]->Send(task);
+  }
+
+  DBSCAN::partition::Merger merger(dataset.d1.size());
+  for (uint32_t w = 0; w < num_workers_; ++w) {
+    auto reply = channels[w]->Receive();
+    DBSCAN::partition::PartResult result;
+    result.num_clusters = reply.Get<uint64_t>();
+    result.is_core = reply.GetVector<uint8_t>();
+    result.local_clusters = reply.GetVector<int32_t>();
+    result.link_clusters = reply.GetVector<int32_t>();
+    result.link_vtx = reply.GetVector<uint64_t>();
+    result.cand_vtx = reply.GetVector<uint64_t>();
+    result.cand_nbs = reply.GetVector<uint64_t>();
+    merger.Add(parts[w].owned, result);
+    logger_->debug("worker {}: {} cross-part links", w,
+                   result.link_vtx.size());
+  }
+  transport.Join();
+  auto t2 = high_resolution_clock::now();
+  logger_->info("workers take {} seconds",
+                duration_cast<duration<double>>(t2 - t1).count());
+
+  merger.Finish(cluster_ids, memberships);
+  auto t3 = high_resolution_clock::now();
+  logger_->info("merging takes {} seconds",
+                duration_cast<duration<double>>(t3 - t2).count());
+}
+
+void DBSCAN::distributed::ServeWorker(transport::Channel& channel) {
+  auto task = channel.Receive();
+  const auto min_pts = task.Get<uint64_t>();
+  const auto radius = task.Get<float>();
+  const auto num_threads = task.Get<uint8_t>();
+  const auto num_owned = task.Get<uint64_t>();
+  const auto ids = task.GetVector<uint64_t>();
+  const auto xs = task.GetVector<float>();
+  const auto ys = task.GetVector<float>();
+  if (xs.size() != ids.size() || ys.size() != ids.size() ||
+      num_owned > ids.size())
+    throw std::runtime_error("malformed task!");
+
+  auto points =
+      std::make_unique<DBSCAN::input_type::TwoDimPoints>(ids.size());
+  std::copy(xs.cbegin(), xs.cend(), points->d1.begin());
+  std::copy(ys.cbegin(), ys.cend(), points->d2.begin());
+  const auto result = DBSCAN::partition::ClusterPart(
+      ids, num_owned, std::move(points), min_pts, radius, num_threads);
+
+  transport::Message reply;
+  reply.Put(result.num_clusters);
+  reply.Put(result.is_core);
+  reply.Put(result.local_clusters);
+  reply.Put(result.link_clusters);
+  reply.Put(result.link_vtx);
+  reply.Put(result.cand_vtx);
+  reply.Put(result.cand_nbs);
+  channel.Send(reply);
+}
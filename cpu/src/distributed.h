@@ -0,0 +1,48 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#ifndef DBSCAN_INCLUDE_DISTRIBUTED_H_
+#define DBSCAN_INCLUDE_DISTRIBUTED_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "DBSCAN/membership.h"
+#include "dataset.h"
+#include "spdlog/spdlog.h"
+#include "transport.h"
+
+namespace DBSCAN {
+namespace distributed {
+/*
+ * Clusters a dataset across worker processes. The vertices are split into
+ * spatial parts with |partition::KdSplit| and each worker runs the CPU
+ * pipeline on one part plus its halo. The halo holds every neighbour of an
+ * owned vertex, so the core status a worker reports for its own vertices is
+ * exact; halo vertices are only used to link clusters across parts, which
+ * |partition::Merger| then stitches into global ids. The labels match a
+ * single-threaded |Solver| run.
+ */
+class Coordinator {
+ public:
+  // |num_threads| is the number of threads of each worker.
+  Coordinator(uint64_t, float, uint32_t, uint8_t);
+  void Run(const DBSCAN::input_type::TwoDimPoints&, transport::Transport&,
+           std::vector<int>&, std::vector<DBSCAN::membership>&);
+
+ private:
+  uint64_t min_pts_;
+  float radius_;
+  uint32_t num_workers_;
+  uint8_t num_threads_;
+  std::shared_ptr<spdlog::logger> logger_ = nullptr;
+};
+
+// Worker side: clusters the part sent over |channel| and replies.
+void ServeWorker(transport::Channel&);
+}  // namespace distributed
+}  // namespace DBSCAN
+
+#endif  // DBSCAN_INCLUDE_DISTRIBUTED_H_
@@ -0,0 +1,91 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#include "finders.h"
+
+#include <limits>
+
+std::vector<uint64_t> DBSCAN::finders::Strips(const uint64_t num_vtx,
+                                              const uint8_t num_threads) {
+  std::vector<uint64_t> bounds(num_threads + 1);
+  for (uint8_t tid = 0; tid <= num_threads; ++tid)
+    bounds[tid] = num_vtx * tid / num_threads;
+  return bounds;
+}
+
+DBSCAN::finders::CellRanges::CellRanges(const Grid& grid, const float* xs,
+                                        const float* ys,
+                                        const float squared_radius,
+                                        const uint8_t num_threads,
+                                        const numa::Topology* topo)
+    : grid_(grid),
+      order_(grid.vertices_in_cell_order().data()),
+      xs_(xs),
+      ys_(ys),
+      squared_radius_(squared_radius),
+      num_threads_(num_threads),
+      topo_(topo),
+      bounds_(Strips(grid.vertices_in_cell_order().size(), num_threads)),
+      num_local_(num_threads),
+      num_remote_(num_threads),
+      pinned_(num_threads, true) {
+  const uint32_t num_nodes = topo_ == nullptr ? 1 : topo_->num_nodes();
+  std::vector<std::pair<uint64_t, uint64_t>> span_of_node(
+      num_nodes, {std::numeric_limits<uint64_t>::max(), 0});
+  const auto node_of = [this](const uint8_t tid) {
+    return topo_ == nullptr ? 0 : topo_->NodeOfThread(tid, num_threads_);
+  };
+  for (uint8_t tid = 0; tid < num_threads_; ++tid) {
+    auto& span = span_of_node[node_of(tid)];
+    span.first = std::min(span.first, bounds_[tid]);
+    span.second = std::max(span.second, bounds_[tid + 1]);
+  }
+  for (uint8_t tid = 0; tid < num_threads_; ++tid)
+    node_span_.push_back(span_of_node[node_of(tid)]);
+}
+
+DBSCAN::finders::CellRanges::Cursor::Cursor(const CellRanges& finder,
+                                            const uint8_t tid,
+                                            const uint8_t num_threads)
+    : finder_(finder),
+      tid_(tid),
+      next_(finder.bounds_[tid]),
+      end_(finder.bounds_[tid + 1]),
+      node_begin_(finder.node_span_[tid].first),
+      node_end_(finder.node_span_[tid].second) {
+  if (finder_.topo_ != nullptr) {
+    finder_.pinned_[tid_] = numa::PinToNode(
+        *finder_.topo_, finder_.topo_->NodeOfThread(tid, num_threads));
+  }
+}
+
+DBSCAN::finders::CellRanges::Cursor::~Cursor() {
+  finder_.num_local_[tid_] = num_local_;
+  finder_.num_remote_[tid_] = num_remote_;
+}
+
+DBSCAN::finders::TilePairs::TilePairs(const input_type::TwoDimPoints& points,
+                                      const float squared_radius)
+    : xs_(points.d1.data()),
+      ys_(points.d2.data()),
+      num_vtx_(points.d1.size()),
+      squared_radius_(squared_radius) {
+  const uint64_t num_tiles = (num_vtx_ + kTile - 1) / kTile;
+  pairs_.reserve(num_tiles * (num_tiles + 1) / 2);
+  for (uint64_t tu = 0; tu < num_tiles; ++tu) {
+    for (uint64_t tv = tu; tv < num_tiles; ++tv) pairs_.emplace_back(tu, tv);
+  }
+}
+
+uint64_t DBSCAN::finders::TilePairs::Load_(const uint64_t tile,
+                                           float* const xs,
+                                           float* const ys) const {
+  const uint64_t begin = tile * kTile;
+  const uint64_t end = std::min(begin + kTile, num_vtx_);
+  std::fill(xs, xs + kTile, kernels::kPadding);
+  std::fill(ys, ys + kTile, kernels::kPadding);
+  std::copy(xs_ + begin, xs_ + end, xs);
+  std::copy(ys_ + begin, ys_ + end, ys);
+  return end - begin;
+}
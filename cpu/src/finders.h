@@ -0,0 +1,336 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#ifndef DBSCAN_INCLUDE_FINDERS_H_
+#define DBSCAN_INCLUDE_FINDERS_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "dataset.h"
+#include "graph.h"
+#include "grid.h"
+#include "kdtree.h"
+#include "kernels.h"
+#include "metric.h"
+#include "numa.h"
+
+namespace DBSCAN {
+namespace finders {
+/*
+ * A neighbour finder cuts InsertEdges into units (a vertex, a k-d tree leaf,
+ * a pair of tiles) and finds the neighbours within each with a kernel
+ * policy. Every thread opens a |Cursor|, which holds its scratch and hands
+ * out the units of that thread through |Next|. |Visit<Kernel>| reports the
+ * neighbours of a unit to a store of stores.h and returns the number of
+ * candidate pairs it tested. Finders and stores are template parameters of
+ * the insert loops (see |loops::Loops|), so a pairing only compiles where
+ * the store takes what the finder reports.
+ */
+
+// Vertex by vertex, the candidates |Metric| takes from the eps-grid.
+template <class Metric>
+class GridCells {
+ public:
+  GridCells(const Grid& grid, const input_type::TwoDimPoints& points,
+            const float radius)
+      : grid_(grid),
+        xs_(points.d1.data()),
+        ys_(points.d2.data()),
+        num_vtx_(points.d1.size()),
+        radius_(radius),
+        threshold_(Metric::Threshold(radius)) {}
+  [[nodiscard]] uint64_t num_vtx() const { return num_vtx_; }
+
+  // every |num_threads|-th vertex from |tid| on.
+  class Cursor {
+   public:
+    Cursor(const GridCells& finder, const uint8_t tid,
+           const uint8_t num_threads)
+        : next_(tid), step_(num_threads), end_(finder.num_vtx_) {}
+    bool Next(uint64_t& u) {
+      if (next_ >= end_) return false;
+      u = next_;
+      next_ += step_;
+      return true;
+    }
+
+   private:
+    friend class GridCells;
+    uint64_t next_, step_, end_;
+    std::vector<uint64_t> candidates_;
+  };
+
+  template <class Kernel, class Store>
+  uint64_t Visit(Cursor& cursor, const uint64_t u, Store& store) const {
+    auto& nbs = cursor.candidates_;
+    const float ux = xs_[u], uy = ys_[u];
+    Metric::Candidates(grid_, u, ux, uy, radius_, nbs);
+    const typename Kernel::Probe probe(ux, uy, threshold_);
+    store.Begin(u);
+    for (uint64_t i = 0; i < nbs.size(); i += Kernel::kLanes) {
+      store.Add(nbs.data() + i,
+                Kernel::template Within<Metric>(probe, xs_, ys_,
+                                                nbs.data() + i,
+                                                nbs.size() - i));
+    }
+    store.End();
+    return nbs.size();
+  }
+
+ private:
+  const Grid& grid_;
+  const float *xs_, *ys_;
+  uint64_t num_vtx_;
+  float radius_, threshold_;
+};
+
+// Positions [bounds[t], bounds[t+1]) of |num_vtx| belong to thread t.
+std::vector<uint64_t> Strips(uint64_t num_vtx, uint8_t num_threads);
+
+/*
+ * Vertex by vertex in cell order, the 3 runs of the cell order around each
+ * (see |Grid::GetNeighbouringRanges|), tested straight from copies of the
+ * coordinates in that order; Euclidean only. Each thread takes a strip of
+ * |Strips| (cells are row-major, so a horizontal strip of the grid). With a
+ * NUMA topology, a thread is pinned to its node, whose threads own adjacent
+ * strips, and its candidate reads are split into those on its node's strips
+ * and the others, estimated from the ranges rather than measured.
+ */
+class CellRanges {
+ public:
+  // |xs| and |ys| are the coordinates in |Grid::vertices_in_cell_order|.
+  CellRanges(const Grid&, const float* xs, const float* ys,
+             float squared_radius, uint8_t num_threads,
+             const numa::Topology* topo = nullptr);
+  // Valid once the cursor of |tid| is gone.
+  [[nodiscard]] uint64_t num_local(const uint8_t tid) const {
+    return num_local_[tid];
+  }
+  [[nodiscard]] uint64_t num_remote(const uint8_t tid) const {
+    return num_remote_[tid];
+  }
+  // Whether thread |tid| was pinned to its node; true without a topology.
+  [[nodiscard]] bool pinned(const uint8_t tid) const { return pinned_[tid]; }
+
+  class Cursor {
+   public:
+    Cursor(const CellRanges&, uint8_t tid, uint8_t num_threads);
+    ~Cursor();
+    Cursor(const Cursor&) = delete;
+    Cursor& operator=(const Cursor&) = delete;
+    bool Next(uint64_t& pos) {
+      if (next_ >= end_) return false;
+      pos = next_++;
+      return true;
+    }
+
+   private:
+    friend class CellRanges;
+    const CellRanges& finder_;
+    uint8_t tid_;
+    uint64_t next_, end_, node_begin_, node_end_;
+    uint64_t num_local_ = 0, num_remote_ = 0;
+  };
+
+  template <class Kernel, class Store>
+  uint64_t Visit(Cursor& cursor, const uint64_t pos, Store& store) const {
+    const float ux = xs_[pos], uy = ys_[pos];
+    const auto ranges = grid_.GetNeighbouringRanges(ux, uy);
+    Graph::WordSpans spans;
+    uint64_t num_candidates = 0;
+    for (uint8_t r = 0; r < 3; ++r) {
+      const auto [begin, end] = ranges[r];
+      spans[r] = {begin / 64, (end + 63) / 64};
+      num_candidates += end - begin;
+      const uint64_t first = std::max(begin, cursor.node_begin_);
+      const uint64_t local =
+          std::max(std::min(end, cursor.node_end_), first) - first;
+      cursor.num_local_ += local;
+      cursor.num_remote_ += end - begin - local;
+    }
+    // its own position is in its strip, so on its node.
+    --cursor.num_local_;
+    const typename Kernel::Probe probe(ux, uy, squared_radius_);
+    store.Begin(order_[pos], spans);
+    uint64_t idx = 0;
+    for (uint8_t r = 0; r < 3; ++r) {
+      const auto [begin, end] = ranges[r];
+      for (uint64_t word = spans[r].first; word < spans[r].second;
+           ++word, ++idx) {
+        const uint64_t base = 64 * word;
+        uint64_t p = std::max(begin, base);
+        const uint64_t last = std::min(end, base + 64);
+        uint64_t bits = 0;
+        for (; p + Kernel::kLanes <= last; p += Kernel::kLanes)
+          bits |= Kernel::Within(probe, xs_ + p, ys_ + p) << (p - base);
+        // pad the tail rather than finishing it in scalar code, so that
+        // distances on the boundary round the same as |GridCells|.
+        if (p < last) {
+          float tail_x[Kernel::kLanes], tail_y[Kernel::kLanes];
+          std::fill(tail_x, tail_x + Kernel::kLanes, kernels::kPadding);
+          std::fill(tail_y, tail_y + Kernel::kLanes, kernels::kPadding);
+          std::copy(xs_ + p, xs_ + last, tail_x);
+          std::copy(ys_ + p, ys_ + last, tail_y);
+          bits |= Kernel::Within(probe, tail_x, tail_y) << (p - base);
+        }
+        if (word == pos / 64) bits &= ~(1llu << (pos % 64));
+        store.AddWord(order_ + base, idx, bits);
+      }
+    }
+    store.End();
+    // not its own candidate
+    return num_candidates - 1;
+  }
+
+ private:
+  const Grid& grid_;
+  const uint64_t* order_;
+  const float *xs_, *ys_;
+  float squared_radius_;
+  uint8_t num_threads_;
+  const numa::Topology* topo_;
+  std::vector<uint64_t> bounds_;
+  // positions of the strips of each thread's node.
+  std::vector<std::pair<uint64_t, uint64_t>> node_span_;
+  // written by each cursor as it goes.
+  mutable std::vector<uint64_t> num_local_, num_remote_;
+  mutable std::vector<uint8_t> pinned_;
+};
+
+/*
+ * Leaf by leaf, the fixed-radius queries of a |KdTree|, see
+ * |KdTree::QueryLeaf|; Euclidean only. Leaves differ in cost as much as the
+ * density does, so they are handed out one at a time, each once: a finder
+ * serves one InsertEdges.
+ */
+class KdLeaves {
+ public:
+  KdLeaves(const KdTree& tree, const float squared_radius)
+      : tree_(tree), squared_radius_(squared_radius) {}
+
+  class Cursor {
+   public:
+    Cursor(const KdLeaves& finder, uint8_t, uint8_t) : finder_(finder) {}
+    bool Next(uint64_t& leaf) {
+      leaf = finder_.next_leaf_++;
+      return leaf < finder_.tree_.num_leaves();
+    }
+
+   private:
+    friend class KdLeaves;
+    const KdLeaves& finder_;
+    KdTree::Batch batch_;
+  };
+
+  template <class Kernel, class Store>
+  uint64_t Visit(Cursor& cursor, const uint64_t leaf, Store& store) const {
+    auto& batch = cursor.batch_;
+    const uint64_t num_tested =
+        tree_.template QueryLeaf<Kernel>(leaf, squared_radius_, batch);
+    for (uint64_t i = 0; i < batch.vertices.size(); ++i) {
+      store.Row(batch.vertices[i], batch.neighbours[i].data(),
+                batch.neighbours[i].size());
+    }
+    return num_tested;
+  }
+
+ private:
+  const KdTree& tree_;
+  float squared_radius_;
+  mutable std::atomic<uint64_t> next_leaf_{0};
+};
+
+/*
+ * Every pair of vertices, for the full bitmap; Euclidean only. The vertices
+ * are cut into tiles and every unordered pair of tiles is handed out once,
+ * to one thread, so each bitmap word has a single writer and a finder serves
+ * one InsertEdges.
+ */
+class TilePairs {
+ public:
+  /*
+   * Vertices per tile: the coordinates of two tiles and the bitmap words
+   * between them (2 x kTile^2/64 words) stay in L1.
+   */
+  static constexpr uint64_t kTile = 256;
+  TilePairs(const input_type::TwoDimPoints&, float squared_radius);
+
+  class Cursor {
+   public:
+    Cursor(const TilePairs& finder, uint8_t, uint8_t) : finder_(finder) {}
+    bool Next(uint64_t& k) {
+      k = finder_.next_pair_++;
+      return k < finder_.pairs_.size();
+    }
+
+   private:
+    friend class TilePairs;
+    const TilePairs& finder_;
+    // coordinates of both tiles, padded past the last vertex so that the
+    // padding never matches; then the words of the u rows over the v tile
+    // and of the v rows over the u tile.
+    alignas(32) float u_xs_[kTile], u_ys_[kTile], v_xs_[kTile], v_ys_[kTile];
+    uint64_t u_rows_[kTile][kTile / 64], v_rows_[kTile][kTile / 64];
+  };
+
+  template <class Kernel, class Store>
+  uint64_t Visit(Cursor& c, const uint64_t k, Store& store) const {
+    const auto [tu, tv] = pairs_[k];
+    const uint64_t num_u = Load_(tu, c.u_xs_, c.u_ys_);
+    const uint64_t num_v = Load_(tv, c.v_xs_, c.v_ys_);
+    std::fill(&c.u_rows_[0][0], &c.u_rows_[0][0] + kTile * kTile / 64, 0u);
+    std::fill(&c.v_rows_[0][0], &c.v_rows_[0][0] + kTile * kTile / 64, 0u);
+    const bool diagonal = tu == tv;
+    for (uint64_t i = 0; i < num_u; ++i) {
+      const typename Kernel::Probe probe(c.u_xs_[i], c.u_ys_[i],
+                                         squared_radius_);
+      // the diagonal tile only evaluates its upper triangle.
+      for (uint64_t w = diagonal ? i / 64 : 0; w * 64 < num_v; ++w) {
+        // a whole word is built in a register before it is stored.
+        uint64_t word = 0;
+        for (uint64_t j = w * 64; j < w * 64 + 64; j += Kernel::kLanes)
+          word |= Kernel::Within(probe, c.v_xs_ + j, c.v_ys_ + j) << (j % 64);
+        if (diagonal && w == i / 64) word &= ~((2llu << (i % 64)) - 1);
+        c.u_rows_[i][w] = word;
+        // the same comparison is the transposed edge.
+        while (word) {
+          c.v_rows_[w * 64 + __builtin_ctzll(word)][i / 64] |= 1llu
+                                                               << (i % 64);
+          word &= word - 1;
+        }
+      }
+    }
+    for (uint64_t i = 0; i < num_u; ++i) {
+      for (uint64_t w = 0; w < kTile / 64; ++w) {
+        if (c.u_rows_[i][w])
+          store.Set(tu * kTile + i, tv * kTile / 64 + w, c.u_rows_[i][w]);
+      }
+    }
+    for (uint64_t j = 0; j < num_v; ++j) {
+      for (uint64_t w = 0; w < kTile / 64; ++w) {
+        if (c.v_rows_[j][w])
+          store.Set(tv * kTile + j, tu * kTile / 64 + w, c.v_rows_[j][w]);
+      }
+    }
+    // a pair is tested once for both of its edges.
+    return diagonal ? num_u * (num_u ? num_u - 1 : 0) : 2 * num_u * num_v;
+  }
+
+ private:
+  const float *xs_, *ys_;
+  uint64_t num_vtx_;
+  float squared_radius_;
+  std::vector<std::pair<uint64_t, uint64_t>> pairs_;
+  mutable std::atomic<uint64_t> next_pair_{0};
+  // The coordinates of |tile| into |xs| and |ys|, padded; returns how many.
+  uint64_t Load_(uint64_t tile, float* xs, float* ys) const;
+};
+}  // namespace finders
+}  // namespace DBSCAN
+
+#endif  // DBSCAN_INCLUDE_FINDERS_H_
@@ -0,0 +1,121 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#include "generator.h"
+
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "threads.h"
+
+namespace {
+// a multiple of |kDuplicates|, so no group of copies spans two chunks.
+constexpr uint64_t kChunkSize = 1u << 16u;
+// "<id> <x> <y>\n"; any float fits in 47 chars with 6 decimals.
+constexpr uint64_t kMaxLine = 20 + 1 + 47 + 1 + 47 + 1;
+
+uint64_t SplitMix_(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30u)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27u)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31u);
+}
+}  // namespace
+
+DBSCAN::generator::Shape DBSCAN::generator::ParseShape(
+    const std::string& shape) {
+  if (shape == "uniform") return Shape::Uniform;
+  if (shape == "gaussian") return Shape::Gaussian;
+  if (shape == "skew") return Shape::Skew;
+  if (shape == "duplicates") return Shape::Duplicates;
+  throw std::runtime_error("unknown shape " + shape);
+}
+
+std::unique_ptr<DBSCAN::input_type::TwoDimPoints> DBSCAN::generator::Generate(
+    const Options& options, const uint8_t num_threads) {
+  if (options.num_blobs == 0) throw std::runtime_error("need at least a blob!");
+  auto points =
+      std::make_unique<DBSCAN::input_type::TwoDimPoints>(options.num_vtx);
+  std::vector<std::pair<float, float>> centers(options.num_blobs);
+  {
+    std::mt19937_64 gen(SplitMix_(options.seed));
+    std::uniform_real_distribution<float> coord(-1.f, 1.f);
+    for (auto& [x, y] : centers) {
+      x = coord(gen);
+      y = coord(gen);
+    }
+  }
+  std::vector<double> weights(options.num_blobs, 1.0);
+  if (options.shape == Shape::Skew) {
+    for (uint32_t k = 0; k < options.num_blobs; ++k)
+      weights[k] = 1.0 / ((k + 1.0) * (k + 1.0));
+  }
+
+  const uint64_t num_chunks = (options.num_vtx + kChunkSize - 1) / kChunkSize;
+  DBSCAN::utils::run_threads(num_threads, [&](const uint8_t tid) {
+    std::uniform_real_distribution<float> coord(-1.f, 1.f);
+    std::normal_distribution<float> offset(0.f, options.spread);
+    std::discrete_distribution<uint32_t> blob(weights.cbegin(), weights.cend());
+    for (uint64_t chunk = tid; chunk < num_chunks; chunk += num_threads) {
+      std::mt19937_64 gen(SplitMix_(options.seed ^ SplitMix_(chunk + 1)));
+      const uint64_t begin = chunk * kChunkSize;
+      const uint64_t end = std::min(begin + kChunkSize, options.num_vtx);
+      for (uint64_t vtx = begin; vtx < end; ++vtx) {
+        float x, y;
+        if (options.shape == Shape::Uniform) {
+          x = coord(gen);
+          y = coord(gen);
+        } else if (options.shape == Shape::Duplicates &&
+                   vtx % kDuplicates != 0) {
+          x = points->d1[vtx - 1];
+          y = points->d2[vtx - 1];
+        } else {
+          const auto& [cx, cy] = centers[blob(gen)];
+          x = cx + offset(gen);
+          y = cy + offset(gen);
+        }
+        points->d1[vtx] = x;
+        points->d2[vtx] = y;
+      }
+    }
+  });
+  return points;
+}
+
+void DBSCAN::generator::Write(const std::string& path,
+                              const DBSCAN::input_type::TwoDimPoints& points,
+                              const uint8_t num_threads) {
+  std::ofstream ofs(path, std::ios::binary);
+  if (!ofs) throw std::runtime_error("cannot open " + path);
+  const uint64_t num_vtx = points.d1.size();
+  ofs << num_vtx << '\n';
+  std::vector<std::string> chunks(num_threads);
+  for (uint64_t round = 0; round < num_vtx; round += kChunkSize * num_threads) {
+    DBSCAN::utils::run_threads(num_threads, [&](const uint8_t tid) {
+      const uint64_t begin = std::min(round + tid * kChunkSize, num_vtx);
+      const uint64_t end = std::min(begin + kChunkSize, num_vtx);
+      auto& chunk = chunks[tid];
+      chunk.resize((end - begin) * kMaxLine);
+      char *p = chunk.data(), *last = p + chunk.size();
+      for (uint64_t vtx = begin; vtx < end; ++vtx) {
+        p = std::to_chars(p, last, vtx).ptr;
+        *p++ = ' ';
+        p = std::to_chars(p, last, points.d1[vtx], std::chars_format::fixed, 6)
+                .ptr;
+        *p++ = ' ';
+        p = std::to_chars(p, last, points.d2[vtx], std::chars_format::fixed, 6)
+                .ptr;
+        *p++ = '\n';
+      }
+      chunk.resize(p - chunk.data());
+    });
+    for (const auto& chunk : chunks) ofs.write(chunk.data(), chunk.size());
+  }
+  ofs.flush();
+  if (!ofs) throw std::runtime_error("failed writing " + path);
+}
@@ -0,0 +1,53 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#ifndef DBSCAN_INCLUDE_GENERATOR_H_
+#define DBSCAN_INCLUDE_GENERATOR_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "dataset.h"
+
+namespace DBSCAN {
+namespace generator {
+enum class Shape {
+  // uniform over [-1, 1]^2
+  Uniform,
+  // equally sized Gaussian blobs
+  Gaussian,
+  // Gaussian blobs whose sizes fall off as 1/k^2
+  Skew,
+  // Gaussian blobs where every distinct point appears |kDuplicates| times
+  Duplicates,
+};
+constexpr uint64_t kDuplicates = 16;
+// "uniform", "gaussian", "skew" or "duplicates".
+Shape ParseShape(const std::string&);
+
+struct Options {
+  Shape shape = Shape::Gaussian;
+  uint64_t num_vtx = 0;
+  // blob centres are uniform over [-1, 1]^2
+  uint32_t num_blobs = 20;
+  float spread = 0.1;
+  uint64_t seed = 42;
+};
+
+/*
+ * Synthetic points, a native replacement for generate_dateset.py that scales
+ * to hundreds of millions of points. The points are generated in fixed-size
+ * chunks, each from its own seed, so the output only depends on the options
+ * and not on |num_threads|.
+ */
+std::unique_ptr<DBSCAN::input_type::TwoDimPoints> Generate(const Options&,
+                                                           uint8_t);
+// Writes "<num_vtx>\n<id> <x> <y>\n..." as read by |TwoDimPoints::Read|.
+void Write(const std::string&, const DBSCAN::input_type::TwoDimPoints&,
+           uint8_t);
+}  // namespace generator
+}  // namespace DBSCAN
+
+#endif  // DBSCAN_INCLUDE_GENERATOR_H_
@@ -8,36 +8,86 @@
 
 #include <vector>
 
-#include "DBSCAN/utils.h"
+#include "threads.h"
 
 // ctor
-#if defined(BIT_ADJ)
-DBSCAN::Graph::Graph(const uint64_t num_vtx, const uint8_t num_threads)
-    : num_nbs(num_vtx, 0),
-      start_pos(num_vtx, 0),
-      // -1 as unvisited/un-clustered.
-      num_vtx_(num_vtx),
-      num_threads_(num_threads) {
-  SetLogger_();
-  uint64_t num_uint64 = std::ceil(num_vtx_ / 64.0f);
-  temp_adj_.resize(num_vtx_, std::vector<uint64_t>(num_uint64, 0u));
-}
-#else
-DBSCAN::Graph::Graph(const uint64_t num_vtx, const uint8_t num_threads)
-    : num_nbs(num_vtx, 0),
-      start_pos(num_vtx, 0),
-      num_vtx_(num_vtx),
+DBSCAN::Graph::Graph(const uint64_t num_vtx, const uint8_t num_threads,
+                     DBSCAN::utils::Arena* arena, const Adjacency adjacency,
+                     DBSCAN::utils::Arena* scratch)
+    : adjacency_(adjacency),
       num_threads_(num_threads),
-      temp_adj_(num_vtx, std::vector<uint64_t>()) {
+      arena_(arena),
+      scratch_(arena == nullptr ? nullptr : scratch) {
   SetLogger_();
+  Reset(num_vtx);
+}
+
+void DBSCAN::Graph::Reset(const uint64_t num_vtx) {
+  immutable_ = false;
+  num_vtx_ = num_vtx;
+  const DBSCAN::utils::ArenaAllocator<uint64_t> alloc(scratch_);
+  if (arena_ != nullptr) {
+    const DBSCAN::utils::ArenaAllocator<uint64_t> final_alloc(arena_);
+    num_nbs = Buffer<uint64_t>(final_alloc);
+    start_pos = Buffer<uint64_t>(final_alloc);
+    neighbours =
+        decltype(neighbours)(decltype(neighbours)::allocator_type(arena_));
+    temp_adj_ = decltype(temp_adj_)(alloc);
+    spans_ = Buffer<WordSpans>(
+        DBSCAN::utils::ArenaAllocator<WordSpans>(scratch_));
+  }
+  // assign() keeps the capacity of a previous run.
+  num_nbs.assign(num_vtx_, 0);
+  start_pos.assign(num_vtx_, 0);
+  neighbours.clear();
+  if (adjacency_ == Adjacency::Implicit) {
+    // no edges to count or keep.
+    num_nbs.clear();
+    start_pos.clear();
+    temp_adj_.clear();
+    return;
+  }
+  if (adjacency_ == Adjacency::Bitmap) {
+    uint64_t num_uint64 = std::ceil(num_vtx_ / 64.0f);
+    temp_adj_.assign(num_vtx_, Buffer<uint64_t>(num_uint64, 0u, alloc));
+  } else {
+    temp_adj_.assign(num_vtx_, Buffer<uint64_t>(alloc));
+  }
+  if (adjacency_ == Adjacency::BlockedBitmap) spans_.assign(num_vtx_, {});
+}
+
+void DBSCAN::Graph::StartRow(const uint64_t u, const WordSpans& spans) {
+  AssertMutable_();
+  if (adjacency_ != Adjacency::BlockedBitmap || u >= num_vtx_)
+    throw std::runtime_error("not a blocked bitmap row!");
+  uint64_t num_words = 0;
+  for (const auto& [first, last] : spans) num_words += last - first;
+  spans_[u] = spans;
+  temp_adj_[u].assign(num_words, 0u);
+}
+
+DBSCAN::Graph::CsrWriter DBSCAN::Graph::WriteCsr() {
+  AssertMutable_();
+  if (adjacency_ != Adjacency::Csr)
+    throw std::runtime_error("not an adjacency-list graph!");
+  return CsrWriter(temp_adj_.data());
+}
+
+DBSCAN::Graph::BitmapWriter DBSCAN::Graph::WriteBitmap() {
+  AssertMutable_();
+  if (adjacency_ != Adjacency::Bitmap &&
+      adjacency_ != Adjacency::BlockedBitmap)
+    throw std::runtime_error("not a bitmap graph!");
+  return BitmapWriter(temp_adj_.data(), spans_.data());
 }
-#endif
 
 // insert edge
-#if defined(BIT_ADJ)
 void DBSCAN::Graph::InsertEdge(const uint64_t u, const uint64_t idx,
                                const uint64_t mask) {
   AssertMutable_();
+  if (adjacency_ != Adjacency::Bitmap &&
+      adjacency_ != Adjacency::BlockedBitmap)
+    throw std::runtime_error("not a bitmap graph!");
   if (u >= num_vtx_ || idx >= temp_adj_[u].size()) {
     std::ostringstream oss;
     oss << "u=" << u << " or idx=" << idx << " is out of bound!";
@@ -47,9 +97,11 @@ void DBSCAN::Graph::InsertEdge(const uint64_t u, const uint64_t idx,
   // __builtin_clzll(mask), u);
   temp_adj_[u][idx] |= mask;
 }
-#else
+
 void DBSCAN::Graph::InsertEdge(const uint64_t u, const uint64_t v) {
   AssertMutable_();
+  if (adjacency_ != Adjacency::Csr)
+    throw std::runtime_error("not an adjacency-list graph!");
   if (u >= num_vtx_ || v >= num_vtx_) {
     std::ostringstream oss;
     oss << "u=" << u << " or v=" << v << " is out of bound!";
@@ -58,12 +110,37 @@ void DBSCAN::Graph::InsertEdge(const uint64_t u, const uint64_t v) {
   // logger_->trace("push {} as a neighbour of {}", v, u);
   temp_adj_[u].push_back(v);
 }
-#endif
 
-#if defined(BIT_ADJ)
+void DBSCAN::Graph::InsertEdges(const uint64_t u, const uint64_t* const vs,
+                                const uint64_t n) {
+  AssertMutable_();
+  if (adjacency_ != Adjacency::Csr)
+    throw std::runtime_error("not an adjacency-list graph!");
+  if (u >= num_vtx_) {
+    std::ostringstream oss;
+    oss << "u=" << u << " is out of bound!";
+    throw std::runtime_error(oss.str());
+  }
+  temp_adj_[u].assign(vs, vs + n);
+}
+
 void DBSCAN::Graph::Finalize() {
-  logger_->info("finalize - BIT_ADJ");
+  if (adjacency_ == Adjacency::Implicit) {
+    AssertMutable_();
+    ReleaseScratch_();
+  } else if (adjacency_ != Adjacency::Csr) {
+    FinalizeBitmap_();
+  } else {
+    FinalizeCsr_();
+  }
+}
+
+void DBSCAN::Graph::FinalizeBitmap_() {
+  logger_->info(adjacency_ == Adjacency::Bitmap ? "finalize - BIT_ADJ"
+                                                : "finalize - blocked");
   AssertMutable_();
+  if (adjacency_ == Adjacency::BlockedBitmap && order_ == nullptr && num_vtx_)
+    throw std::runtime_error("blocked bitmap without a cell order!");
 
   using namespace std::chrono;
   auto t0 = high_resolution_clock::now();
@@ -83,12 +160,10 @@ void DBSCAN::Graph::Finalize() {
   auto d1 = duration_cast<duration<double>>(t1 - t0);
   logger_->info("\tconstructing num_nbs takes {} seconds", d1.count());
 
-  const uint64_t sz = num_nbs.back() + start_pos.back();
+  const uint64_t sz = num_vtx_ == 0 ? 0 : num_nbs.back() + start_pos.back();
   // return if the graph has no edges.
   if (sz == 0u) {
-    temp_adj_.clear();
-    temp_adj_.shrink_to_fit();
-    immutable_ = true;
+    ReleaseScratch_();
     return;
   }
 
@@ -98,48 +173,48 @@ void DBSCAN::Graph::Finalize() {
   auto d2 = duration_cast<duration<double>>(t2 - t1);
   logger_->info("\tInit neighbours takes {} seconds", d2.count());
 
-  std::vector<std::thread> threads(num_threads_);
-  for (uint8_t tid = 0; tid < num_threads_; ++tid) {
-    // logger_->debug("\tspawning thread {}", tid);
-    threads[tid] = std::thread(
-        [this](const uint8_t tid) {
-          auto p_t0 = high_resolution_clock::now();
-          for (uint64_t u = tid; u < num_vtx_; u += num_threads_) {
-            const std::vector<uint64_t>& nbs = temp_adj_[u];
-            auto it = std::next(neighbours.begin(), start_pos[u]);
-            for (uint64_t i = 0; i < nbs.size(); ++i) {
-              uint64_t val = nbs[i];
-              while (val) {
-                uint8_t k = __builtin_ffsll(val) - 1;
-                *it = 64 * i + k;
-                // logger_->trace("k={}, *it={}", k, *it);
-                ++it;
-                val &= (val - 1);
-              }
+  DBSCAN::utils::run_threads(num_threads_, [this](const uint8_t tid) {
+    for (uint64_t u = tid; u < num_vtx_; u += num_threads_) {
+      const auto& nbs = temp_adj_[u];
+      auto it = std::next(neighbours.begin(), start_pos[u]);
+      if (adjacency_ == Adjacency::BlockedBitmap) {
+        uint64_t i = 0;
+        for (const auto& [first, last] : spans_[u]) {
+          for (uint64_t word = first; word < last; ++word, ++i) {
+            uint64_t val = nbs[i];
+            while (val) {
+              *it++ = order_[64 * word + __builtin_ctzll(val)];
+              val &= val - 1;
             }
-            // assert(static_cast<uint64_t>(std::distance(
-            //        neighbours.begin(), it)) == num_nbs[u] + start_pos[u] &&
-            //        "iterator steps != num_nbs[u]+start_pos[u]");
           }
-          auto p_t1 = high_resolution_clock::now();
-          logger_->info("\t\tThread {} takes {} seconds", tid,
-                        duration_cast<duration<double>>(p_t1 - p_t0).count());
-        } /* lambda */,
-        tid);
-  }
-  for (auto& tr : threads) tr.join();
+        }
+        continue;
+      }
+      for (uint64_t i = 0; i < nbs.size(); ++i) {
+        uint64_t val = nbs[i];
+        while (val) {
+          uint8_t k = __builtin_ffsll(val) - 1;
+          *it = 64 * i + k;
+          // logger_->trace("k={}, *it={}", k, *it);
+          ++it;
+          val &= (val - 1);
+        }
+      }
+      // assert(static_cast<uint64_t>(std::distance(
+      //        neighbours.begin(), it)) == num_nbs[u] + start_pos[u] &&
+      //        "iterator steps != num_nbs[u]+start_pos[u]");
+    }
+  });
   // logger_->debug("\tjoined all threads");
 
   auto t3 = high_resolution_clock::now();
   auto d3 = duration_cast<duration<double>>(t3 - t2);
   logger_->info("\tCalc neighbours takes {} seconds", d3.count());
 
-  temp_adj_.clear();
-  temp_adj_.shrink_to_fit();
-  immutable_ = true;
+  ReleaseScratch_();
 }
-#else
-void DBSCAN::Graph::Finalize() {
+
+void DBSCAN::Graph::FinalizeCsr_() {
   logger_->info("Finalize - DEFAULT");
   AssertMutable_();
 
@@ -161,12 +236,10 @@ void DBSCAN::Graph::Finalize() {
   auto d1 = duration_cast<duration<double>>(t1 - t0);
   logger_->info("\tCalc num_nbs takes {} seconds", d1.count());
 
-  const uint64_t sz = num_nbs.back() + start_pos.back();
+  const uint64_t sz = num_vtx_ == 0 ? 0 : num_nbs.back() + start_pos.back();
   // return if the graph has no edges.
   if (sz == 0u) {
-    temp_adj_.clear();
-    temp_adj_.shrink_to_fit();
-    immutable_ = true;
+    ReleaseScratch_();
     return;
   }
 
@@ -176,34 +249,28 @@ void DBSCAN::Graph::Finalize() {
   auto d2 = duration_cast<duration<double>>(t2 - t1);
   logger_->info("\tInit neighbours takes {} seconds", d2.count());
 
-  std::vector<std::thread> threads(num_threads_);
-  for (uint8_t tid = 0; tid < num_threads_; ++tid) {
-    // logger_->debug("\tspawning thread {}", tid);
-    threads[tid] = std::thread(
-        [this](const uint8_t tid) {
-          auto p_t0 = high_resolution_clock::now();
-          for (uint64_t u = tid; u < num_vtx_; u += num_threads_) {
-            const auto& nbs = temp_adj_[u];
-            // logger_->trace("\twriting vtx {} with # nbs {}", u, nbs.size());
-            assert(nbs.size() == num_nbs[u] && "nbs.size!=num_nbs[u]");
-            std::copy(nbs.cbegin(), nbs.cend(),
-                      neighbours.begin() + start_pos[u]);
-          }
-          auto p_t1 = high_resolution_clock::now();
-          logger_->info("\t\tThread {} takes {} seconds", tid,
-                        duration_cast<duration<double>>(p_t1 - p_t0).count());
-        }, /* lambda */
-        tid /* args to lambda */);
-  }
-  for (auto& tr : threads) tr.join();
+  DBSCAN::utils::run_threads(num_threads_, [this](const uint8_t tid) {
+    for (uint64_t u = tid; u < num_vtx_; u += num_threads_) {
+      const auto& nbs = temp_adj_[u];
+      // logger_->trace("\twriting vtx {} with # nbs {}", u, nbs.size());
+      assert(nbs.size() == num_nbs[u] && "nbs.size!=num_nbs[u]");
+      std::copy(nbs.cbegin(), nbs.cend(), neighbours.begin() + start_pos[u]);
+    }
+  });
   // logger_->debug("\tjoined all threads");
 
   auto t3 = high_resolution_clock::now();
   auto d3 = duration_cast<duration<double>>(t3 - t2);
   logger_->info("\tCalc neighbours takes {} seconds", d3.count());
 
-  temp_adj_.clear();
-  temp_adj_.shrink_to_fit();
+  ReleaseScratch_();
+}
+
+void DBSCAN::Graph::ReleaseScratch_() {
+  decltype(temp_adj_)(temp_adj_.get_allocator()).swap(temp_adj_);
+  decltype(spans_)(spans_.get_allocator()).swap(spans_);
+  // nothing points into the scratch arena any more; its blocks stay for the
+  // next graph.
+  if (scratch_ != nullptr) scratch_->Reset();
   immutable_ = true;
 }
-#endif
\ No newline at end of file
@@ -7,44 +7,153 @@
 
 #include <spdlog/spdlog.h>
 
+#include <array>
+#include <memory>
+#include <utility>
 #include <vector>
 
 #include "DBSCAN/membership.h"
 #include "DBSCAN/utils.h"
+#include "arena.h"
 
 namespace DBSCAN {
 
+// How edges are gathered before Finalize; see |planner::Choose|.
+enum class Adjacency : uint8_t {
+  // a packed NxN/64 bit matrix, filled by testing every pair of vertices.
+  Bitmap,
+  // one adjacency list per vertex, filled from the grid candidates.
+  Csr,
+  // bitmap rows that only cover the grid candidates, with the vertices in
+  // cell order.
+  BlockedBitmap,
+  // no edges at all: the label loops search the grid for the neighbours of
+  // a vertex each time they read them.
+  Implicit
+};
+// The representation a graph without a plan uses.
+constexpr Adjacency kDefaultAdjacency = Adjacency::Csr;
+
 class Graph {
  public:
-  std::vector<uint64_t> num_nbs;
-  std::vector<uint64_t> start_pos;
-  std::vector<uint64_t, DBSCAN::utils::NonConstructAllocator<uint64_t>>
+  template <class T>
+  using Buffer = std::vector<T, DBSCAN::utils::ArenaAllocator<T>>;
+  Buffer<uint64_t> num_nbs;
+  Buffer<uint64_t> start_pos;
+  std::vector<uint64_t, DBSCAN::utils::ArenaAllocator<uint64_t, false>>
       neighbours;
-  // ctor
-  explicit Graph(uint64_t, uint8_t);
-  // insert edge
-#if defined(BIT_ADJ)
+  /*
+   * ctor; the finalized buffers come from |arena| when one is given. The
+   * adjacency being built then lives in |scratch| (on the heap without one),
+   * which Finalize rewinds but keeps, so that the owner's next graph reuses
+   * its blocks.
+   */
+  explicit Graph(uint64_t, uint8_t, DBSCAN::utils::Arena* arena = nullptr,
+                 Adjacency adjacency = kDefaultAdjacency,
+                 DBSCAN::utils::Arena* scratch = nullptr);
+  /*
+   * Make the graph empty and mutable again for |num_vtx| vertices. Without an
+   * arena its buffers are reused; with one, the owner must have reset both
+   * arenas first.
+   */
+  void Reset(uint64_t);
+  [[nodiscard]] Adjacency adjacency() const { return adjacency_; }
+  /*
+   * BlockedBitmap: the bits of a row stand for positions in |order| (vertices
+   * sorted by cell, see |Grid::vertices_in_cell_order|), which must outlive
+   * Finalize. The row of |u| holds the words [first, last) of each span,
+   * words 64 * first..64 * last - 1 of that order, back to back.
+   */
+  using WordSpans = std::array<std::pair<uint64_t, uint64_t>, 3>;
+  void set_cell_order(const uint64_t* const order) { order_ = order; }
+  void StartRow(uint64_t, const WordSpans&);
+  // (Blocked)Bitmap: set the bits |mask| of word |idx| in the row of |u|.
   void InsertEdge(uint64_t, uint64_t, uint64_t);
-#else
-  void StartInsert(const uint64_t u) { temp_adj_[u].reserve(num_vtx_); }
+  // Csr: add one neighbour to the list of |u|.
   void InsertEdge(uint64_t, uint64_t);
-  void FinishInsert(const uint64_t u) { temp_adj_[u].shrink_to_fit(); }
-#endif
+  /*
+   * Csr: all |n| neighbours of |u| at once, into a list of exactly that size.
+   * The insert loops gather them first, so the scratch arena holds one slot
+   * per edge rather than one per candidate.
+   */
+  void InsertEdges(uint64_t u, const uint64_t* vs, uint64_t n);
+  /*
+   * Unchecked writers for the insert loops of loops.h: the representation and
+   * mutability are checked once, when a writer is handed out, rather than per
+   * edge. A row must have one writer at a time, and a writer must not outlive
+   * Finalize or Reset.
+   */
+  class CsrWriter {
+   public:
+    // as InsertEdges.
+    void Assign(const uint64_t u, const uint64_t* const vs,
+                const uint64_t n) const {
+      rows_[u].assign(vs, vs + n);
+    }
+
+   private:
+    friend class Graph;
+    explicit CsrWriter(Buffer<uint64_t>* const rows) : rows_(rows) {}
+    Buffer<uint64_t>* rows_;
+  };
+  class BitmapWriter {
+   public:
+    // as StartRow; a blocked bitmap only.
+    void StartRow(const uint64_t u, const WordSpans& spans) const {
+      uint64_t num_words = 0;
+      for (const auto& [first, last] : spans) num_words += last - first;
+      spans_[u] = spans;
+      rows_[u].assign(num_words, 0u);
+    }
+    // as InsertEdge(u, idx, mask).
+    void Set(const uint64_t u, const uint64_t idx, const uint64_t mask) const {
+      rows_[u][idx] |= mask;
+    }
+
+   private:
+    friend class Graph;
+    BitmapWriter(Buffer<uint64_t>* const rows, WordSpans* const spans)
+        : rows_(rows), spans_(spans) {}
+    Buffer<uint64_t>* rows_;
+    WordSpans* spans_;
+  };
+  // Throw unless the graph is mutable and holds adjacency lists.
+  [[nodiscard]] CsrWriter WriteCsr();
+  // Throw unless the graph is mutable and a (blocked) bitmap.
+  [[nodiscard]] BitmapWriter WriteBitmap();
   // construct num_nbs and neighbours.
   void Finalize();
+  // Bytes the adjacency being built holds in the scratch arena; 0 without an
+  // arena or once finalized.
+  [[nodiscard]] size_t scratch_bytes() const {
+    return scratch_ == nullptr || immutable_ ? 0 : scratch_->capacity();
+  }
 
  private:
   bool immutable_ = false;
+  Adjacency adjacency_;
+  // BlockedBitmap only
+  const uint64_t* order_ = nullptr;
+  Buffer<WordSpans> spans_;
   uint64_t num_vtx_;
   uint8_t num_threads_;
+  DBSCAN::utils::Arena* arena_;
+  // |temp_adj_| and |spans_| when |arena_| is set; the owner's.
+  DBSCAN::utils::Arena* scratch_;
   std::shared_ptr<spdlog::logger> logger_ = nullptr;
-  std::vector<std::vector<uint64_t>> temp_adj_;
+  std::vector<Buffer<uint64_t>, DBSCAN::utils::ArenaAllocator<Buffer<uint64_t>>>
+      temp_adj_;
 
   void constexpr AssertMutable_() const {
     if (immutable_) {
       throw std::runtime_error("Graph is immutable!");
     }
   }
+  void FinalizeBitmap_();
+  void FinalizeCsr_();
+  // Drop the adjacency being built, rewind the scratch arena and make the
+  // graph immutable.
+  void ReleaseScratch_();
   void SetLogger_() {
     logger_ = spdlog::get("console");
     if (logger_ == nullptr) {
@@ -0,0 +1,166 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#include "graph_cache.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "threads.h"
+
+namespace {
+const char kMagic[8] = {'D', 'B', 'S', 'C', 'A', 'N', 'G', '1'};
+// magic, hash, number of vertices and of edges
+constexpr uint64_t kHeaderWords = 4;
+
+// the finalizer of splitmix64
+uint64_t Mix_(uint64_t h) {
+  h ^= h >> 30u;
+  h *= 0xbf58476d1ce4e5b9llu;
+  h ^= h >> 27u;
+  h *= 0x94d049bb133111ebllu;
+  return h ^ (h >> 31u);
+}
+
+// 32-bit words of |xs|, two at a time.
+uint64_t HashFloats_(const float* const xs, const uint64_t begin,
+                     const uint64_t end, uint64_t h) {
+  for (uint64_t i = begin; i < end; i += 2) {
+    uint64_t word = 0;
+    std::memcpy(&word, xs + i, (i + 1 < end ? 2 : 1) * sizeof(float));
+    h = Mix_(h ^ word);
+  }
+  return h;
+}
+}  // namespace
+
+uint64_t DBSCAN::graph_cache::Hash(
+    const DBSCAN::input_type::TwoDimPoints& dataset, const float eps,
+    const metric::Metric metric, const uint8_t num_threads) {
+  const uint64_t n = dataset.d1.size();
+  // one hash per contiguous chunk, combined in order, so the result does not
+  // depend on |num_threads|.
+  constexpr uint64_t kChunk = 1u << 20u;
+  const uint64_t num_chunks = (n + kChunk - 1) / kChunk;
+  std::vector<uint64_t> chunks(num_chunks);
+  DBSCAN::utils::run_threads(num_threads, [&](const uint8_t tid) {
+    for (uint64_t c = tid; c < num_chunks; c += num_threads) {
+      const uint64_t begin = c * kChunk, end = std::min(n, begin + kChunk);
+      uint64_t h = Mix_(c);
+      h = HashFloats_(dataset.d1.data(), begin, end, h);
+      chunks[c] = HashFloats_(dataset.d2.data(), begin, end, h);
+    }
+  });
+  uint32_t eps_bits;
+  std::memcpy(&eps_bits, &eps, sizeof(eps));
+  uint64_t h = Mix_(n ^ (static_cast<uint64_t>(eps_bits) << 8u) ^
+                    static_cast<uint64_t>(metric));
+  for (const uint64_t chunk : chunks) h = Mix_(h ^ chunk);
+  return h;
+}
+
+void DBSCAN::graph_cache::Save(const std::string& path, const uint64_t hash,
+                               const uint64_t num_vtx,
+                               const uint64_t* const num_nbs,
+                               const uint64_t* const start_pos,
+                               const uint64_t* const neighbours,
+                               const uint64_t num_edges) {
+  // unique per process and call, so concurrent writers of one path do not
+  // share a temporary file; the last rename wins.
+  static std::atomic<uint64_t> num_saves{0};
+  const std::string temp = path + ".tmp." + std::to_string(getpid()) + "." +
+                           std::to_string(num_saves++);
+  {
+    std::ofstream ofs(temp, std::ios::binary);
+    if (!ofs) throw std::runtime_error("cannot open " + temp);
+    ofs.write(kMagic, sizeof(kMagic));
+    ofs.write(reinterpret_cast<const char*>(&hash), sizeof(hash));
+    ofs.write(reinterpret_cast<const char*>(&num_vtx), sizeof(num_vtx));
+    ofs.write(reinterpret_cast<const char*>(&num_edges), sizeof(num_edges));
+    ofs.write(reinterpret_cast<const char*>(num_nbs),
+              num_vtx * sizeof(uint64_t));
+    ofs.write(reinterpret_cast<const char*>(start_pos),
+              num_vtx * sizeof(uint64_t));
+    ofs.write(reinterpret_cast<const char*>(neighbours),
+              num_edges * sizeof(uint64_t));
+    if (!ofs) {
+      std::remove(temp.c_str());
+      throw std::runtime_error("failed to write " + temp);
+    }
+  }
+  if (std::rename(temp.c_str(), path.c_str()) != 0) {
+    std::remove(temp.c_str());
+    throw std::runtime_error("failed to rename " + temp + " to " + path);
+  }
+}
+
+DBSCAN::graph_cache::MappedGraph::MappedGraph(const std::string& path,
+                                              const uint64_t hash,
+                                              const uint64_t num_vtx) {
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) throw std::runtime_error("cannot open " + path);
+  struct stat st {};
+  if (fstat(fd, &st) != 0 ||
+      static_cast<uint64_t>(st.st_size) < kHeaderWords * sizeof(uint64_t)) {
+    close(fd);
+    throw std::runtime_error(path + " is not a DBSCAN graph cache!");
+  }
+  size_ = st.st_size;
+  data_ = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data_ == MAP_FAILED) {
+    data_ = nullptr;
+    throw std::runtime_error("cannot map " + path);
+  }
+  const auto* const words = static_cast<const uint64_t*>(data_);
+  if (std::memcmp(words, kMagic, sizeof(kMagic)) != 0) {
+    munmap(data_, size_);
+    throw std::runtime_error(path + " is not a DBSCAN graph cache!");
+  }
+  num_edges_ = words[3];
+  if (words[1] != hash || words[2] != num_vtx) return;
+  // the first test keeps the second from overflowing.
+  if (num_edges_ > size_ / sizeof(uint64_t) ||
+      size_ != (kHeaderWords + 2 * num_vtx + num_edges_) * sizeof(uint64_t)) {
+    munmap(data_, size_);
+    throw std::runtime_error(path + " is truncated!");
+  }
+  num_nbs_ = words + kHeaderWords;
+  start_pos_ = num_nbs_ + num_vtx;
+  neighbours_ = start_pos_ + num_vtx;
+  // the label stages index by these without checking: start_pos must be
+  // the prefix sums of num_nbs, ending at num_edges, and every neighbour a
+  // vertex.
+  uint64_t pos = 0;
+  bool intact = true;
+  for (uint64_t u = 0; u < num_vtx && intact; ++u) {
+    intact = start_pos_[u] == pos && num_nbs_[u] <= num_edges_ - pos;
+    pos += num_nbs_[u];
+  }
+  intact = intact && pos == num_edges_;
+  for (uint64_t e = 0; e < num_edges_ && intact; ++e)
+    intact = neighbours_[e] < num_vtx;
+  if (!intact) {
+    munmap(data_, size_);
+    throw std::runtime_error(path + " is corrupt!");
+  }
+  // ClassifyNoises reads all of num_nbs and the BFS most of the rest.
+  madvise(data_, size_, MADV_WILLNEED);
+  valid_ = true;
+}
+
+DBSCAN::graph_cache::MappedGraph::~MappedGraph() {
+  if (data_ != nullptr) munmap(data_, size_);
+}
@@ -0,0 +1,65 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#ifndef DBSCAN_INCLUDE_GRAPH_CACHE_H_
+#define DBSCAN_INCLUDE_GRAPH_CACHE_H_
+
+#include <cstdint>
+#include <string>
+
+#include "dataset.h"
+#include "metric.h"
+
+namespace DBSCAN {
+namespace graph_cache {
+/*
+ * Identifies the graph of a dataset: 64-bit hash of the coordinates (bit for
+ * bit), the vertex count, eps and the metric. min_pts is left out on purpose,
+ * as the graph does not depend on it.
+ */
+uint64_t Hash(const DBSCAN::input_type::TwoDimPoints&, float, metric::Metric,
+              uint8_t);
+
+/*
+ * Binary layout, native endianness: 8-byte magic, uint64 hash, number of
+ * vertices and number of edges, then the num_nbs, start_pos and neighbours
+ * arrays as uint64. Written to a temporary file named after the process and
+ * call, then renamed, so a reader never maps a partial cache and concurrent
+ * writers never share one.
+ */
+void Save(const std::string&, uint64_t hash, uint64_t num_vtx,
+          const uint64_t* num_nbs, const uint64_t* start_pos,
+          const uint64_t* neighbours, uint64_t num_edges);
+
+// A cache mapped read-only; the arrays point into the mapping.
+class MappedGraph {
+ public:
+  /*
+   * Throws if |path| cannot be mapped or is not a graph cache, or if its
+   * arrays are inconsistent: start_pos not the prefix sums of num_nbs, or a
+   * neighbour past the last vertex. A cache of another dataset or eps
+   * (|hash|, |num_vtx|) is not an error, see |valid|.
+   */
+  MappedGraph(const std::string& path, uint64_t hash, uint64_t num_vtx);
+  ~MappedGraph();
+  MappedGraph(const MappedGraph&) = delete;
+  MappedGraph& operator=(const MappedGraph&) = delete;
+  [[nodiscard]] bool valid() const { return valid_; }
+  [[nodiscard]] uint64_t num_edges() const { return num_edges_; }
+  [[nodiscard]] const uint64_t* num_nbs() const { return num_nbs_; }
+  [[nodiscard]] const uint64_t* start_pos() const { return start_pos_; }
+  [[nodiscard]] const uint64_t* neighbours() const { return neighbours_; }
+
+ private:
+  void* data_ = nullptr;
+  uint64_t size_ = 0;
+  bool valid_ = false;
+  uint64_t num_edges_ = 0;
+  const uint64_t *num_nbs_ = nullptr, *start_pos_ = nullptr,
+                 *neighbours_ = nullptr;
+};
+}  // namespace graph_cache
+}  // namespace DBSCAN
+
+#endif  // DBSCAN_INCLUDE_GRAPH_CACHE_H_
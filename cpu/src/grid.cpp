@@ -6,86 +6,90 @@
 #include <cassert>
 #endif
 
+#include <algorithm>
 #include <cmath>
 
 #include "grid.h"
 #include "spdlog/spdlog.h"
+#include "threads.h"
 
 DBSCAN::Grid::Grid(const float max_x, const float max_y, const float min_x,
                    const float min_y, const float radius,
-                   const uint64_t num_vtx, const uint8_t num_threads)
-    : radius_(radius),
-      num_vtx_(num_vtx),
-      max_x_(max_x),
-      max_y_(max_y),
-      min_x_(min_x),
-      min_y_(min_y),
-      num_threads_(num_threads) {
+                   const uint64_t num_vtx, const uint8_t num_threads,
+                   DBSCAN::utils::Arena* arena)
+    : num_threads_(num_threads), arena_(arena) {
   logger_ = spdlog::get("console");
   if (logger_ == nullptr) {
     throw std::runtime_error("logger not created!");
   }
+  Reset(max_x, max_y, min_x, min_y, radius, num_vtx);
+}
+
+void DBSCAN::Grid::Reset(const float max_x, const float max_y,
+                         const float min_x, const float min_y,
+                         const float radius, const uint64_t num_vtx) {
+  radius_ = radius;
+  num_vtx_ = num_vtx;
+  max_x_ = max_x;
+  max_y_ = max_y;
+  min_x_ = min_x;
+  min_y_ = min_y;
   // "1+" prepends an empty col/row to the grid. The empty row/col includes
   // points {x in [-INF, min_x_), y in [-INF, min_y_)}.
   // "+1" appends an empty rol/col. The last row/col includes points
   // {x in [max_x_, INF), y in [max_y_, INF)}.
   grid_rows_ = 1 + std::ceil((max_y_ - min_y_) / radius) + 1;
   grid_cols_ = 1 + std::ceil((max_x_ - min_x_) / radius) + 1;
-  grid_vtx_counter_.resize(grid_rows_ * grid_cols_);
-  grid_.resize(num_vtx_);
+  if (arena_ != nullptr) {
+    const DBSCAN::utils::ArenaAllocator<uint64_t> alloc(arena_);
+    grid_vtx_counter_ = Buffer(alloc);
+    grid_start_pos_ = Buffer(alloc);
+    grid_ = Buffer(alloc);
+  }
+  // assign() keeps the capacity of a previous run.
+  grid_vtx_counter_.assign(grid_rows_ * grid_cols_, 0);
+  grid_start_pos_.assign(grid_rows_ * grid_cols_, 0);
+  grid_.assign(num_vtx_, 0);
 }
 
-void DBSCAN::Grid::Construct(
-    const std::vector<float, DBSCAN::utils::AlignedAllocator<float, 32>>& xs,
-    const std::vector<float, DBSCAN::utils::AlignedAllocator<float, 32>>& ys) {
-  using namespace std::chrono;
-  high_resolution_clock::time_point start = high_resolution_clock::now();
-
+void DBSCAN::Grid::Construct(const input_type::Column& xs,
+                             const input_type::Column& ys) {
   // TODO: when GCC-10 is ready, use std::exclusive_scan with parallel exec.
-  std::vector<std::thread> threads(num_threads_);
-  for (uint8_t tid = 0; tid < num_threads_; ++tid) {
-    threads[tid] = std::thread(
-        [this, &xs, &ys](const uint8_t tid) {
-          for (uint64_t vtx = tid; vtx < num_vtx_; vtx += num_threads_) {
-            const auto id = CalcCellId_(xs[vtx], ys[vtx]);
-            // https://gcc.gnu.org/onlinedocs/gcc/_005f_005fsync-Builtins.html#g_t_005f_005fsync-Builtins
-            __sync_fetch_and_add(grid_vtx_counter_.data() + id, 1);
-          }
-        },
-        tid);
-  }
-  for (auto& tr : threads) tr.join();
+  DBSCAN::utils::run_threads(
+      num_threads_, [this, &xs, &ys](const uint8_t tid) {
+        for (uint64_t vtx = tid; vtx < num_vtx_; vtx += num_threads_) {
+          const auto id = CalcCellId_(xs[vtx], ys[vtx]);
+          // https://gcc.gnu.org/onlinedocs/gcc/_005f_005fsync-Builtins.html#g_t_005f_005fsync-Builtins
+          __sync_fetch_and_add(grid_vtx_counter_.data() + id, 1);
+        }
+      });
 
-  logger_->debug(
-      DBSCAN::utils::print_vector("grid_vtx_counter_", grid_vtx_counter_));
-  grid_start_pos_.resize(grid_vtx_counter_.size(), 0);
+  // print_vector formats the whole vector, so only build it when it's logged.
+  if (logger_->should_log(spdlog::level::debug))
+    logger_->debug(
+        DBSCAN::utils::print_vector("grid_vtx_counter_", grid_vtx_counter_));
   // TODO: exclusive_scan with GCC-10
   for (uint64_t i = 0; i < grid_vtx_counter_.size() - 1; ++i) {
     grid_start_pos_[i + 1] = grid_start_pos_[i] + grid_vtx_counter_[i];
   }
-  logger_->debug(
-      DBSCAN::utils::print_vector("grid_start_pos_", grid_start_pos_));
+  if (logger_->should_log(spdlog::level::debug))
+    logger_->debug(
+        DBSCAN::utils::print_vector("grid_start_pos_", grid_start_pos_));
 
   // make a local copy to record the write position.
-  std::vector<uint64_t> temp(grid_start_pos_);
+  Buffer temp(grid_start_pos_);
 
-  for (uint8_t tid = 0; tid < num_threads_; ++tid) {
-    threads[tid] = std::thread(
-        [this, &xs, &ys, &temp](const uint8_t tid) {
-          for (uint64_t vtx = tid; vtx < num_vtx_; vtx += num_threads_) {
-            const auto id = CalcCellId_(xs[vtx], ys[vtx]);
-            const auto pos = __sync_fetch_and_add(temp.data() + id, 1);
-            // https://gcc.gnu.org/onlinedocs/gcc/_005f_005fsync-Builtins.html#g_t_005f_005fsync-Builtins
-            __sync_val_compare_and_swap(grid_.data() + pos, 0, vtx);
-          }
-        },
-        tid);
-  }
-  for (auto& tr : threads) tr.join();
-  logger_->debug(DBSCAN::utils::print_vector("grid", grid_));
-  duration<double> time_spent =
-      duration_cast<duration<double>>(high_resolution_clock::now() - start);
-  logger_->info("Construct takes {} seconds", time_spent.count());
+  DBSCAN::utils::run_threads(
+      num_threads_, [this, &xs, &ys, &temp](const uint8_t tid) {
+        for (uint64_t vtx = tid; vtx < num_vtx_; vtx += num_threads_) {
+          const auto id = CalcCellId_(xs[vtx], ys[vtx]);
+          const auto pos = __sync_fetch_and_add(temp.data() + id, 1);
+          // https://gcc.gnu.org/onlinedocs/gcc/_005f_005fsync-Builtins.html#g_t_005f_005fsync-Builtins
+          __sync_val_compare_and_swap(grid_.data() + pos, 0, vtx);
+        }
+      });
+  if (logger_->should_log(spdlog::level::debug))
+    logger_->debug(DBSCAN::utils::print_vector("grid", grid_));
 }
 
 uint64_t DBSCAN::Grid::CalcCellId_(const float x, const float y) const {
@@ -111,10 +115,18 @@ uint64_t DBSCAN::Grid::CalcCellId_(const float x, const float y) const {
 std::vector<uint64_t> DBSCAN::Grid::GetNeighbouringVtx(const uint64_t u,
                                                        const float ux,
                                                        const float uy) const {
+  std::vector<uint64_t> nbs;
+  GetNeighbouringVtx(u, ux, uy, nbs);
+  return nbs;
+}
+
+void DBSCAN::Grid::GetNeighbouringVtx(const uint64_t u, const float ux,
+                                      const float uy,
+                                      std::vector<uint64_t>& nbs) const {
   const uint64_t cell_id = CalcCellId_(ux, uy);
   const uint64_t btm_left = cell_id + grid_cols_ - 1, left = cell_id - 1,
                  right = cell_id + 1, top_left = cell_id - grid_cols_ - 1;
-  std::vector<uint64_t> nbs;
+  nbs.clear();
   nbs.reserve(grid_vtx_counter_[top_left] + grid_vtx_counter_[top_left + 1] +
               grid_vtx_counter_[top_left + 2] + /* top row */
               grid_vtx_counter_[left] + grid_vtx_counter_[cell_id] +
@@ -143,5 +155,58 @@ std::vector<uint64_t> DBSCAN::Grid::GetNeighbouringVtx(const uint64_t u,
                grid_.cbegin() + grid_start_pos_[btm_left + col] +
                    grid_vtx_counter_[btm_left + col]);
   }
-  return nbs;
+}
+
+void DBSCAN::Grid::AppendVtxInRows(const uint64_t u, const float x0,
+                                   const float x1, const float y,
+                                   std::vector<uint64_t>& nbs) const {
+  const auto col = [this](const float x) {
+    const float idx = std::floor((x - min_x_) / radius_) + 1;
+    return static_cast<uint64_t>(
+        std::clamp<float>(idx, 0, static_cast<float>(grid_cols_ - 1)));
+  };
+  // same as in CalcCellId_; rows 0 and grid_rows_ - 1 are empty.
+  const uint64_t row = std::floor((y - min_y_) / radius_) + 1;
+  const uint64_t first = col(x0), last = col(x1);
+  for (uint64_t r = row - 1; r <= row + 1; ++r) {
+    const uint64_t begin = grid_start_pos_[r * grid_cols_ + first];
+    const uint64_t end = grid_start_pos_[r * grid_cols_ + last] +
+                         grid_vtx_counter_[r * grid_cols_ + last];
+    for (uint64_t pos = begin; pos < end; ++pos) {
+      if (grid_[pos] != u) nbs.push_back(grid_[pos]);
+    }
+  }
+}
+
+void DBSCAN::Grid::AppendVtxInBox(const float x0, const float x1,
+                                  const float y0, const float y1,
+                                  std::vector<uint64_t>& vtx) const {
+  const auto index = [this](const float v, const float min,
+                            const uint64_t size) {
+    const float idx = std::floor((v - min) / radius_) + 1;
+    return static_cast<uint64_t>(
+        std::clamp<float>(idx, 0, static_cast<float>(size - 1)));
+  };
+  const uint64_t first = index(x0, min_x_, grid_cols_),
+                 last = index(x1, min_x_, grid_cols_);
+  const uint64_t bottom = index(y0, min_y_, grid_rows_),
+                 top = index(y1, min_y_, grid_rows_);
+  for (uint64_t r = bottom; r <= top; ++r) {
+    const uint64_t left = r * grid_cols_ + first, right = r * grid_cols_ + last;
+    vtx.insert(vtx.end(), grid_.cbegin() + grid_start_pos_[left],
+               grid_.cbegin() + grid_start_pos_[right] +
+                   grid_vtx_counter_[right]);
+  }
+}
+
+std::array<std::pair<uint64_t, uint64_t>, 3>
+DBSCAN::Grid::GetNeighbouringRanges(const float x, const float y) const {
+  const uint64_t top_left = CalcCellId_(x, y) - grid_cols_ - 1;
+  std::array<std::pair<uint64_t, uint64_t>, 3> ranges;
+  for (uint64_t row = 0; row < 3; ++row) {
+    const uint64_t left = top_left + row * grid_cols_;
+    ranges[row] = {grid_start_pos_[left],
+                   grid_start_pos_[left + 2] + grid_vtx_counter_[left + 2]};
+  }
+  return ranges;
 }
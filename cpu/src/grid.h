@@ -7,21 +7,60 @@
 
 #include <DBSCAN/utils.h>
 
+#include <array>
 #include <cstdint>
 #include <limits>
+#include <utility>
 #include <vector>
 
+#include "arena.h"
+#include "dataset.h"
 #include "spdlog/spdlog.h"
 
 namespace DBSCAN {
 class Grid {
  public:
-  Grid(float, float, float, float, float, uint64_t, uint8_t);
-  void Construct(
-      const std::vector<float, DBSCAN::utils::AlignedAllocator<float, 32>>&,
-      const std::vector<float, DBSCAN::utils::AlignedAllocator<float, 32>>&);
+  using Buffer = std::vector<uint64_t, DBSCAN::utils::ArenaAllocator<uint64_t>>;
+  // The cell arrays are allocated from |arena| when one is given.
+  Grid(float, float, float, float, float, uint64_t, uint8_t,
+       DBSCAN::utils::Arena* arena = nullptr);
+  /*
+   * Re-target the grid to new bounds/vertices. Without an arena the buffers of
+   * the previous run are reused; with one, fresh buffers are carved out of it,
+   * so the owner must have reset the arena first.
+   */
+  void Reset(float, float, float, float, float, uint64_t);
+  void Construct(const input_type::Column&, const input_type::Column&);
   [[nodiscard]] std::vector<uint64_t> GetNeighbouringVtx(uint64_t, float,
                                                          float) const;
+  // Same as above but fills a caller-owned buffer, so a hot loop does not
+  // allocate a vector per vertex.
+  void GetNeighbouringVtx(uint64_t, float, float, std::vector<uint64_t>&) const;
+  [[nodiscard]] uint64_t num_cells() const { return grid_rows_ * grid_cols_; }
+  [[nodiscard]] uint64_t num_rows() const { return grid_rows_; }
+  [[nodiscard]] uint64_t num_cols() const { return grid_cols_; }
+  [[nodiscard]] float radius() const { return radius_; }
+  // Number of vertices in each cell, row-major. Valid after Construct.
+  [[nodiscard]] const Buffer& cell_sizes() const { return grid_vtx_counter_; }
+  // Vertices sorted by cell, cells in row-major order. Valid after Construct.
+  [[nodiscard]] const Buffer& vertices_in_cell_order() const { return grid_; }
+  /*
+   * The 3x3 cells around (x, y) as three [begin, end) ranges of positions in
+   * |vertices_in_cell_order|, one per row: the three cells of a row are
+   * adjacent in row-major order.
+   */
+  [[nodiscard]] std::array<std::pair<uint64_t, uint64_t>, 3>
+  GetNeighbouringRanges(float, float) const;
+  /*
+   * Append to |nbs| the vertices, but |u|, of the cells the 3 rows around |y|
+   * have over [x0, x1], for metrics whose eps-ball is wider than 3 cells.
+   * x0 and x1 may lie outside of the grid.
+   */
+  void AppendVtxInRows(uint64_t u, float x0, float x1, float y,
+                       std::vector<uint64_t>& nbs) const;
+  // Append to |vtx| the vertices of the cells [x0, x1] x [y0, y1] overlaps.
+  void AppendVtxInBox(float x0, float x1, float y0, float y1,
+                      std::vector<uint64_t>& vtx) const;
 
  private:
   float radius_;
@@ -30,7 +69,8 @@ class Grid {
   float max_x_, max_y_, min_x_, min_y_;
   uint8_t num_threads_;
   uint64_t grid_rows_, grid_cols_;
-  std::vector<uint64_t> grid_vtx_counter_, grid_start_pos_, grid_;
+  DBSCAN::utils::Arena* arena_;
+  Buffer grid_vtx_counter_, grid_start_pos_, grid_;
   std::shared_ptr<spdlog::logger> logger_ = nullptr;
   [[nodiscard]] uint64_t CalcCellId_(float, float) const;
 };
@@ -0,0 +1,247 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#include "incremental.h"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <limits>
+#include <unordered_set>
+
+#include "dataset.h"
+
+// ctor
+DBSCAN::IncrementalSolver::IncrementalSolver(const uint64_t min_pts,
+                                             const float radius)
+    : min_pts_(min_pts), radius_(radius), squared_radius_(radius * radius) {
+  logger_ = spdlog::get("console");
+  if (logger_ == nullptr) {
+    throw std::runtime_error("logger not created!");
+  }
+}
+
+uint64_t DBSCAN::IncrementalSolver::Insert(const float x, const float y) {
+  uint64_t vtx;
+  if (free_ids_.empty()) {
+    vtx = xs_.size();
+    xs_.push_back(x);
+    ys_.push_back(y);
+    alive_.push_back(true);
+    num_nbs_.push_back(0);
+    cell_pos_.push_back(0);
+    comp_.push_back(0);
+  } else {
+    vtx = free_ids_.back();
+    free_ids_.pop_back();
+    xs_[vtx] = x;
+    ys_[vtx] = y;
+    alive_[vtx] = true;
+    num_nbs_[vtx] = 0;
+  }
+  auto& cell = cells_[CellKey_(x, y)];
+  cell_pos_[vtx] = cell.size();
+  cell.push_back(vtx);
+  ++num_alive_;
+
+  const std::vector<uint64_t> nbs = Neighbours_(vtx);
+  num_nbs_[vtx] = nbs.size();
+  // vertices promoted to Core by this insertion, including |vtx| itself.
+  std::vector<uint64_t> new_cores;
+  for (const auto v : nbs) {
+    if (++num_nbs_[v] == min_pts_) new_cores.push_back(v);
+  }
+  if (IsCore_(vtx)) new_cores.push_back(vtx);
+  // an insertion only adds edges to the core graph, so clusters can merge but
+  // never split.
+  for (const auto c : new_cores) comp_[c] = NewComponent_();
+  for (const auto c : new_cores) {
+    for (const auto w : c == vtx ? nbs : Neighbours_(c)) {
+      if (IsCore_(w)) Union_(comp_[c], comp_[w]);
+    }
+  }
+  logger_->trace("inserted {} with {} neighbours, {} new cores", vtx,
+                 nbs.size(), new_cores.size());
+  MaybeCompact_();
+  return vtx;
+}
+
+void DBSCAN::IncrementalSolver::Erase(const uint64_t vtx) {
+  if (!IsAlive(vtx)) {
+    std::ostringstream oss;
+    oss << "vtx=" << vtx << " is not alive!";
+    throw std::runtime_error(oss.str());
+  }
+  const std::vector<uint64_t> nbs = Neighbours_(vtx);
+  const bool was_core = IsCore_(vtx);
+
+  // swap-remove from its cell.
+  const auto it = cells_.find(CellKey_(xs_[vtx], ys_[vtx]));
+  auto& cell = it->second;
+  const uint64_t last = cell.back();
+  cell[cell_pos_[vtx]] = last;
+  cell_pos_[last] = cell_pos_[vtx];
+  cell.pop_back();
+  if (cell.empty()) cells_.erase(it);
+  alive_[vtx] = false;
+  --num_alive_;
+  free_ids_.push_back(vtx);
+
+  // core neighbours of every vertex that stops being Core. The clusters that
+  // lost a core vertex are exactly the ones reachable from these seeds.
+  std::vector<uint64_t> seeds;
+  if (was_core) {
+    for (const auto v : nbs) {
+      if (IsCore_(v)) seeds.push_back(v);
+    }
+  }
+  bool lost_core = was_core;
+  for (const auto v : nbs) {
+    if (num_nbs_[v]-- == min_pts_) {
+      lost_core = true;
+      for (const auto w : Neighbours_(v)) {
+        if (IsCore_(w)) seeds.push_back(w);
+      }
+    }
+  }
+  logger_->trace("erased {} with {} neighbours", vtx, nbs.size());
+  if (!lost_core) return;
+  std::sort(seeds.begin(), seeds.end());
+  seeds.erase(std::unique(seeds.begin(), seeds.end()), seeds.end());
+  Reexpand_(seeds);
+  MaybeCompact_();
+}
+
+bool DBSCAN::IncrementalSolver::IsAlive(const uint64_t vtx) const {
+  return vtx < xs_.size() && alive_[vtx];
+}
+
+DBSCAN::membership DBSCAN::IncrementalSolver::Membership(
+    const uint64_t vtx) const {
+  if (vtx >= xs_.size()) {
+    std::ostringstream oss;
+    oss << "vtx=" << vtx << " is out of bound!";
+    throw std::runtime_error(oss.str());
+  }
+  if (!alive_[vtx]) return Noise;
+  if (IsCore_(vtx)) return Core;
+  for (const auto w : Neighbours_(vtx)) {
+    if (IsCore_(w)) return Border;
+  }
+  return Noise;
+}
+
+void DBSCAN::IncrementalSolver::Labels(
+    std::vector<int>& cluster_ids,
+    std::vector<DBSCAN::membership>& memberships) const {
+  const uint64_t n = xs_.size();
+  cluster_ids.assign(n, -1);
+  memberships.assign(n, Noise);
+  std::unordered_map<uint64_t, int> dense;
+  for (uint64_t vtx = 0; vtx < n; ++vtx) {
+    if (!IsCore_(vtx)) continue;
+    const auto root = Find_(comp_[vtx]);
+    const auto it = dense.emplace(root, static_cast<int>(dense.size())).first;
+    cluster_ids[vtx] = it->second;
+    memberships[vtx] = Core;
+  }
+  for (uint64_t vtx = 0; vtx < n; ++vtx) {
+    if (!alive_[vtx] || IsCore_(vtx)) continue;
+    for (const auto w : Neighbours_(vtx)) {
+      if (IsCore_(w) &&
+          (cluster_ids[vtx] == -1 || cluster_ids[w] < cluster_ids[vtx]))
+        cluster_ids[vtx] = cluster_ids[w];
+    }
+    if (cluster_ids[vtx] != -1) memberships[vtx] = Border;
+  }
+}
+
+uint64_t DBSCAN::IncrementalSolver::CellKey_(const float x,
+                                             const float y) const {
+  const auto col = static_cast<int32_t>(std::floor(x / radius_));
+  const auto row = static_cast<int32_t>(std::floor(y / radius_));
+  return static_cast<uint64_t>(static_cast<uint32_t>(row)) << 32u |
+         static_cast<uint32_t>(col);
+}
+
+std::vector<uint64_t> DBSCAN::IncrementalSolver::Neighbours_(
+    const uint64_t vtx) const {
+  const float ux = xs_[vtx], uy = ys_[vtx];
+  const auto col = static_cast<int32_t>(std::floor(ux / radius_));
+  const auto row = static_cast<int32_t>(std::floor(uy / radius_));
+  const auto dist = input_type::TwoDimPoints::euclidean_distance_square;
+  std::vector<uint64_t> nbs;
+  for (int32_t r = row - 1; r <= row + 1; ++r) {
+    for (int32_t c = col - 1; c <= col + 1; ++c) {
+      const auto it = cells_.find(
+          static_cast<uint64_t>(static_cast<uint32_t>(r)) << 32u |
+          static_cast<uint32_t>(c));
+      if (it == cells_.cend()) continue;
+      for (const auto v : it->second) {
+        if (v != vtx && dist(ux, uy, xs_[v], ys_[v]) <= squared_radius_)
+          nbs.push_back(v);
+      }
+    }
+  }
+  return nbs;
+}
+
+uint64_t DBSCAN::IncrementalSolver::NewComponent_() {
+  parent_.push_back(parent_.size());
+  return parent_.size() - 1;
+}
+
+uint64_t DBSCAN::IncrementalSolver::Find_(uint64_t c) const {
+  // path halving
+  while (parent_[c] != c) {
+    parent_[c] = parent_[parent_[c]];
+    c = parent_[c];
+  }
+  return c;
+}
+
+void DBSCAN::IncrementalSolver::Union_(const uint64_t a, const uint64_t b) {
+  const uint64_t ra = Find_(a), rb = Find_(b);
+  if (ra == rb) return;
+  parent_[std::max(ra, rb)] = std::min(ra, rb);
+}
+
+void DBSCAN::IncrementalSolver::Reexpand_(const std::vector<uint64_t>& seeds) {
+  std::unordered_set<uint64_t> visited;
+  std::deque<uint64_t> queue;
+  uint64_t num_components = 0, num_visited = 0;
+  for (const auto seed : seeds) {
+    if (!IsCore_(seed) || !visited.insert(seed).second) continue;
+    const uint64_t comp = NewComponent_();
+    ++num_components;
+    queue.push_back(seed);
+    while (!queue.empty()) {
+      const uint64_t u = queue.front();
+      queue.pop_front();
+      comp_[u] = comp;
+      ++num_visited;
+      for (const auto w : Neighbours_(u)) {
+        if (IsCore_(w) && visited.insert(w).second) queue.push_back(w);
+      }
+    }
+  }
+  logger_->debug("re-expanded {} core vertices into {} components",
+                 num_visited, num_components);
+}
+
+void DBSCAN::IncrementalSolver::MaybeCompact_() {
+  if (parent_.size() < 2 * num_alive_ + 1024) return;
+  std::vector<uint64_t> remap(parent_.size(),
+                              std::numeric_limits<uint64_t>::max());
+  uint64_t num_components = 0;
+  for (uint64_t vtx = 0; vtx < xs_.size(); ++vtx) {
+    if (!IsCore_(vtx)) continue;
+    const auto root = Find_(comp_[vtx]);
+    if (remap[root] == std::numeric_limits<uint64_t>::max())
+      remap[root] = num_components++;
+    comp_[vtx] = remap[root];
+  }
+  parent_.resize(num_components);
+  for (uint64_t c = 0; c < num_components; ++c) parent_[c] = c;
+}
@@ -0,0 +1,86 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#ifndef DBSCAN_INCLUDE_INCREMENTAL_H_
+#define DBSCAN_INCLUDE_INCREMENTAL_H_
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "DBSCAN/membership.h"
+#include "spdlog/spdlog.h"
+
+namespace DBSCAN {
+
+/*
+ * Maintains a DBSCAN clustering while points are inserted and erased.
+ *
+ * Points live in an unbounded grid of |radius| x |radius| cells (same cell
+ * layout as |Grid|, keyed by cell coordinates instead of a dense array) and
+ * each point keeps its number of neighbours within |radius|. An update only
+ * touches the 3x3 cells around the point, re-evaluates the core status of the
+ * affected neighbours, merges clusters through a disjoint-set over component
+ * ids and re-expands the touched clusters when a core vertex disappears.
+ *
+ * Vertex ids returned by |Insert| are stable until erased; erased ids are
+ * recycled by later insertions. Not thread-safe.
+ */
+class IncrementalSolver {
+ public:
+  explicit IncrementalSolver(uint64_t, float);
+  // Returns the vertex id of the new point.
+  uint64_t Insert(float, float);
+  void Erase(uint64_t);
+  [[nodiscard]] bool IsAlive(uint64_t) const;
+  [[nodiscard]] uint64_t num_alive() const { return num_alive_; }
+  // One past the largest vertex id handed out so far.
+  [[nodiscard]] uint64_t capacity() const { return xs_.size(); }
+  [[nodiscard]] DBSCAN::membership Membership(uint64_t) const;
+  /*
+   * Dense cluster ids and memberships indexed by vertex id, numbered the same
+   * way |Solver::IdentifyClusters| does with one thread: clusters are ordered
+   * by their smallest core vertex and a Border vertex goes to the smallest
+   * adjacent cluster. Erased slots are reported as Noise with id -1.
+   */
+  void Labels(std::vector<int>&, std::vector<DBSCAN::membership>&) const;
+
+ private:
+  uint64_t min_pts_;
+  float radius_, squared_radius_;
+  uint64_t num_alive_ = 0;
+  std::shared_ptr<spdlog::logger> logger_ = nullptr;
+  // per vertex
+  std::vector<float> xs_, ys_;
+  std::vector<bool> alive_;
+  std::vector<uint64_t> num_nbs_, cell_pos_;
+  // component id of a core vertex; meaningless for non-core vertices.
+  std::vector<uint64_t> comp_;
+  std::vector<uint64_t> free_ids_;
+  // cell key -> vertices in the cell.
+  std::unordered_map<uint64_t, std::vector<uint64_t>> cells_;
+  // disjoint-set over component ids.
+  mutable std::vector<uint64_t> parent_;
+
+  [[nodiscard]] bool IsCore_(const uint64_t vtx) const {
+    return alive_[vtx] && num_nbs_[vtx] >= min_pts_;
+  }
+  [[nodiscard]] uint64_t CellKey_(float, float) const;
+  // alive vertices within |radius_| of |vtx|, excluding |vtx| itself.
+  [[nodiscard]] std::vector<uint64_t> Neighbours_(uint64_t) const;
+  uint64_t NewComponent_();
+  uint64_t Find_(uint64_t) const;
+  void Union_(uint64_t, uint64_t);
+  /*
+   * Re-label every core vertex reachable from |seeds| with fresh component
+   * ids; seeds that turn out to be connected share one id.
+   */
+  void Reexpand_(const std::vector<uint64_t>&);
+  // Drop dead component ids once they outnumber the live vertices.
+  void MaybeCompact_();
+};
+}  // namespace DBSCAN
+
+#endif  // DBSCAN_INCLUDE_INCREMENTAL_H_
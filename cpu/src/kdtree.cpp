@@ -0,0 +1,106 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#include "kdtree.h"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+#include "dataset.h"
+#include "threads.h"
+
+namespace {
+// depth of |node| in the heap layout
+uint64_t Depth_(const uint64_t node) {
+  return 63 - __builtin_clzll(node + 1);
+}
+}  // namespace
+
+DBSCAN::KdTree::KdTree(const Coords& d1, const Coords& d2,
+                       const uint8_t num_threads)
+    : num_vtx_(d1.size()), num_leaves_(1), num_threads_(num_threads) {
+  while (num_leaves_ * kLeafSize < num_vtx_) num_leaves_ *= 2;
+  ids_.resize(num_vtx_);
+  std::iota(ids_.begin(), ids_.end(), 0);
+  const uint64_t first_leaf = num_leaves_ - 1;
+  // one level at a time; the nodes of a level are disjoint ranges.
+  for (uint64_t level = 0; level < first_leaf; level = 2 * level + 1) {
+    const uint64_t end_level = 2 * level + 1;
+    DBSCAN::utils::run_threads(num_threads_, [&](const uint8_t tid) {
+      for (uint64_t node = level + tid; node < end_level;
+           node += num_threads_) {
+        const auto [begin, end] = Range(node);
+        if (begin == end) continue;
+        float lo_x = std::numeric_limits<float>::max(), hi_x = -lo_x,
+              lo_y = lo_x, hi_y = -lo_x;
+        for (uint64_t pos = begin; pos < end; ++pos) {
+          lo_x = std::min(lo_x, d1[ids_[pos]]);
+          hi_x = std::max(hi_x, d1[ids_[pos]]);
+          lo_y = std::min(lo_y, d2[ids_[pos]]);
+          hi_y = std::max(hi_y, d2[ids_[pos]]);
+        }
+        const Coords& axis = hi_x - lo_x >= hi_y - lo_y ? d1 : d2;
+        std::nth_element(ids_.begin() + begin,
+                         ids_.begin() + Range(2 * node + 1).second,
+                         ids_.begin() + end,
+                         [&axis](const uint64_t a, const uint64_t b) {
+                           return axis[a] < axis[b];
+                         });
+      }
+    });
+  }
+
+  xs_.assign(num_vtx_ + kernels::kMaxLanes, kernels::kPadding);
+  ys_.assign(num_vtx_ + kernels::kMaxLanes, kernels::kPadding);
+  min_x_.assign(num_nodes(), std::numeric_limits<float>::max());
+  min_y_.assign(num_nodes(), std::numeric_limits<float>::max());
+  max_x_.assign(num_nodes(), std::numeric_limits<float>::lowest());
+  max_y_.assign(num_nodes(), std::numeric_limits<float>::lowest());
+  DBSCAN::utils::run_threads(num_threads_, [&](const uint8_t tid) {
+    for (uint64_t leaf = tid; leaf < num_leaves_; leaf += num_threads_) {
+      const uint64_t node = first_leaf + leaf;
+      const auto [begin, end] = Range(node);
+      for (uint64_t pos = begin; pos < end; ++pos) {
+        xs_[pos] = d1[ids_[pos]];
+        ys_[pos] = d2[ids_[pos]];
+        min_x_[node] = std::min(min_x_[node], xs_[pos]);
+        max_x_[node] = std::max(max_x_[node], xs_[pos]);
+        min_y_[node] = std::min(min_y_[node], ys_[pos]);
+        max_y_[node] = std::max(max_y_[node], ys_[pos]);
+      }
+    }
+  });
+  // the boxes of inner nodes are the union of their children's.
+  for (uint64_t node = first_leaf; node-- > 0;) Fit_(node);
+}
+
+std::pair<uint64_t, uint64_t> DBSCAN::KdTree::Range(
+    const uint64_t node) const {
+  const uint64_t depth = Depth_(node);
+  const uint64_t k = node + 1 - (1llu << depth);
+  return {(k * num_vtx_) >> depth, ((k + 1) * num_vtx_) >> depth};
+}
+
+void DBSCAN::KdTree::Fit_(const uint64_t node) {
+  const uint64_t l = 2 * node + 1, r = l + 1;
+  min_x_[node] = std::min(min_x_[l], min_x_[r]);
+  min_y_[node] = std::min(min_y_[l], min_y_[r]);
+  max_x_[node] = std::max(max_x_[l], max_x_[r]);
+  max_y_[node] = std::max(max_y_[l], max_y_[r]);
+}
+
+float DBSCAN::KdTree::MinDist_(const uint64_t a, const uint64_t b) const {
+  const float dx =
+      std::max({0.f, min_x_[b] - max_x_[a], min_x_[a] - max_x_[b]});
+  const float dy =
+      std::max({0.f, min_y_[b] - max_y_[a], min_y_[a] - max_y_[b]});
+  return dx * dx + dy * dy;
+}
+
+float DBSCAN::KdTree::MaxDist_(const uint64_t a, const uint64_t b) const {
+  const float dx = std::max(max_x_[a] - min_x_[b], max_x_[b] - min_x_[a]);
+  const float dy = std::max(max_y_[a] - min_y_[b], max_y_[b] - min_y_[a]);
+  return dx * dx + dy * dy;
+}
@@ -0,0 +1,166 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#ifndef DBSCAN_INCLUDE_KDTREE_H_
+#define DBSCAN_INCLUDE_KDTREE_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "DBSCAN/utils.h"
+#include "dataset.h"
+#include "kernels.h"
+
+namespace DBSCAN {
+
+// Where the adjacency lists of InsertEdges get their candidates from.
+enum class Index : uint8_t {
+  // the 3x3 cells of the eps-grid around each vertex.
+  Grid,
+  // fixed-radius queries against a |KdTree|, for densities the grid cannot
+  // follow.
+  KdTree
+};
+
+/*
+ * An implicit k-d tree: node i has children 2i+1 and 2i+2, and the |L| leaves
+ * (a power of two) are nodes L-1..2L-2. Node k of a level of 2^d nodes holds
+ * the tree-order positions [k * N / 2^d, (k + 1) * N / 2^d), so no ranges or
+ * pointers are stored, only a bounding box per node. Each range is split at
+ * its median along the wider side of its box. The coordinates are copied in
+ * tree order, so every leaf bucket is a contiguous run of x and of y.
+ */
+class KdTree {
+ public:
+  using Coords = input_type::Column;
+  // vertices per leaf bucket, at most.
+  static constexpr uint64_t kLeafSize = 32;
+
+  KdTree(const Coords&, const Coords&, uint8_t);
+  [[nodiscard]] uint64_t num_leaves() const { return num_leaves_; }
+  [[nodiscard]] uint64_t num_nodes() const { return 2 * num_leaves_ - 1; }
+  // Tree-order positions [begin, end) of |node|.
+  [[nodiscard]] std::pair<uint64_t, uint64_t> Range(uint64_t node) const;
+  // Vertex at each tree-order position.
+  [[nodiscard]] const std::vector<uint64_t>& ids() const { return ids_; }
+
+  // Reused across the queries of one thread.
+  struct Batch {
+    // the vertices of the queried leaf and the neighbours of each.
+    std::vector<uint64_t> vertices;
+    std::vector<std::vector<uint64_t>> neighbours;
+    // nodes entirely within the radius of the whole leaf, and leaves only
+    // partly so.
+    std::vector<uint64_t> inside, partial, stack;
+  };
+  /*
+   * Every vertex of |leaf| against the tree at once: a node is pruned when
+   * its box is farther than the radius from the leaf's box, and taken whole
+   * when the farthest corners are within it; only the leaves in between are
+   * tested point by point, as many at a time as |Kernel| has lanes, see
+   * |finders::KdLeaves|. A vertex is not its own neighbour. Returns the
+   * number of pairs whose distance was tested.
+   */
+  template <class Kernel>
+  uint64_t QueryLeaf(uint64_t leaf, float sq_radius, Batch&) const;
+
+ private:
+  uint64_t num_vtx_, num_leaves_;
+  uint8_t num_threads_;
+  std::vector<uint64_t> ids_;
+  // in tree order, padded by |kernels::kMaxLanes| past the last vertex.
+  Coords xs_, ys_;
+  // bounding box of each node.
+  std::vector<float> min_x_, min_y_, max_x_, max_y_;
+  // squared distance between the nearest/farthest points of two boxes.
+  [[nodiscard]] float MinDist_(uint64_t, uint64_t) const;
+  [[nodiscard]] float MaxDist_(uint64_t, uint64_t) const;
+  void Fit_(uint64_t node);
+};
+
+template <class Kernel>
+uint64_t KdTree::QueryLeaf(const uint64_t leaf, const float sq_radius,
+                           Batch& batch) const {
+  const uint64_t first_leaf = num_leaves_ - 1, q = first_leaf + leaf;
+  const auto [q_begin, q_end] = Range(q);
+  batch.vertices.assign(ids_.begin() + q_begin, ids_.begin() + q_end);
+  if (batch.neighbours.size() < batch.vertices.size())
+    batch.neighbours.resize(batch.vertices.size());
+  for (auto& nbs : batch.neighbours) nbs.clear();
+  if (q_begin == q_end) return 0;
+  // the shortcuts keep a few ulps off the radius, so that a box never decides
+  // a pair the distance kernels would round the other way (e.g. with FMA).
+  constexpr float kEpsilon = std::numeric_limits<float>::epsilon();
+  const float near = sq_radius * (1 + 4 * kEpsilon);
+  const float far = sq_radius * (1 - 4 * kEpsilon);
+
+  batch.inside.clear();
+  batch.partial.clear();
+  batch.stack.assign(1, 0);
+  while (!batch.stack.empty()) {
+    const uint64_t node = batch.stack.back();
+    batch.stack.pop_back();
+    const auto [begin, end] = Range(node);
+    if (begin == end || MinDist_(q, node) > near) continue;
+    if (MaxDist_(q, node) <= far) {
+      batch.inside.push_back(node);
+    } else if (node >= first_leaf) {
+      batch.partial.push_back(node);
+    } else {
+      batch.stack.push_back(2 * node + 2);
+      batch.stack.push_back(2 * node + 1);
+    }
+  }
+
+  uint64_t num_tested = 0;
+  for (uint64_t u = q_begin; u < q_end; ++u) {
+    auto& nbs = batch.neighbours[u - q_begin];
+    const auto take = [this, u, &nbs](const uint64_t begin,
+                                      const uint64_t end) {
+      for (uint64_t pos = begin; pos < end; ++pos) {
+        if (pos != u) nbs.push_back(ids_[pos]);
+      }
+    };
+    for (const uint64_t node : batch.inside) {
+      const auto [begin, end] = Range(node);
+      take(begin, end);
+    }
+    const float ux = xs_[u], uy = ys_[u];
+    const typename Kernel::Probe probe(ux, uy, sq_radius);
+    for (const uint64_t node : batch.partial) {
+      // the same shortcuts for this vertex alone.
+      const float near_x =
+          std::max({0.f, min_x_[node] - ux, ux - max_x_[node]});
+      const float near_y =
+          std::max({0.f, min_y_[node] - uy, uy - max_y_[node]});
+      if (near_x * near_x + near_y * near_y > near) continue;
+      const float far_x = std::max(max_x_[node] - ux, ux - min_x_[node]);
+      const float far_y = std::max(max_y_[node] - uy, uy - min_y_[node]);
+      const auto [begin, end] = Range(node);
+      if (far_x * far_x + far_y * far_y <= far) {
+        take(begin, end);
+        continue;
+      }
+      num_tested += end - begin - (begin <= u && u < end);
+      for (uint64_t pos = begin; pos < end; pos += Kernel::kLanes) {
+        // lanes past |end| belong to the next leaf or the padding.
+        uint64_t cmp =
+            Kernel::Within(probe, xs_.data() + pos, ys_.data() + pos);
+        if (end - pos < Kernel::kLanes) cmp &= (1llu << (end - pos)) - 1;
+        while (cmp) {
+          const uint64_t v = pos + __builtin_ctzll(cmp);
+          if (v != u) nbs.push_back(ids_[v]);
+          cmp &= cmp - 1;
+        }
+      }
+    }
+  }
+  return num_tested;
+}
+}  // namespace DBSCAN
+
+#endif  // DBSCAN_INCLUDE_KDTREE_H_
@@ -0,0 +1,9 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+// The loops of the AVX kernel. Built for the baseline like every other TU;
+// only the |kernels::Avx| functions they call target AVX.
+#include "loops_impl.h"
+
+template struct DBSCAN::loops::Loops<DBSCAN::kernels::Kernel::Avx>;
@@ -0,0 +1,9 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+// The loops of the AVX-512 kernel. Built for the baseline like every other TU;
+// only the |kernels::Avx512| functions they call target AVX-512.
+#include "loops_impl.h"
+
+template struct DBSCAN::loops::Loops<DBSCAN::kernels::Kernel::Avx512>;
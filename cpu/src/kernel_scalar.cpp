@@ -0,0 +1,8 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+// The loops of the scalar kernel, built for the baseline instruction set.
+#include "loops_impl.h"
+
+template struct DBSCAN::loops::Loops<DBSCAN::kernels::Kernel::Scalar>;
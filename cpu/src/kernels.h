@@ -0,0 +1,231 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#ifndef DBSCAN_INCLUDE_KERNELS_H_
+#define DBSCAN_INCLUDE_KERNELS_H_
+
+#include <immintrin.h>
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "metric.h"
+
+namespace DBSCAN {
+namespace kernels {
+// Distance tests of InsertEdges; see |planner::Choose|.
+enum class Kernel : uint8_t { Scalar, Avx, Avx512 };
+
+// Only the kernel functions are built for AVX, see metric.h; the host running
+// them may still lack it.
+inline bool AvxSupported() { return __builtin_cpu_supports("avx"); }
+// Whether this host runs |kernel|; every kernel is compiled in.
+inline bool Supported(const Kernel kernel) {
+  switch (kernel) {
+    case Kernel::Scalar:
+      return true;
+    case Kernel::Avx:
+      return AvxSupported();
+    case Kernel::Avx512:
+      return __builtin_cpu_supports("avx512f");
+  }
+  return false;
+}
+// The kernels this host runs, narrowest first.
+inline std::vector<Kernel> Available() {
+  std::vector<Kernel> available;
+  for (const auto kernel : {Kernel::Scalar, Kernel::Avx, Kernel::Avx512}) {
+    if (Supported(kernel)) available.push_back(kernel);
+  }
+  return available;
+}
+// The widest of them; the kernel a plan defaults to.
+inline Kernel Widest() { return Available().back(); }
+
+// Candidates |kernel| tests at a time.
+constexpr uint64_t Lanes(const Kernel kernel) {
+  return kernel == Kernel::Avx512 ? 16 : kernel == Kernel::Avx ? 8 : 1;
+}
+// The widest kernel reads this many floats past a candidate.
+constexpr uint64_t kMaxLanes = Lanes(Kernel::Avx512);
+
+// pads the lanes past the end of a candidate list; its square never compares
+// <= any finite radius.
+const float kPadding = std::sqrt(std::numeric_limits<float>::max()) - 1;
+
+/*
+ * Compares (|u_x8|, |u_y8|) against up to 8 gathered candidates
+ * |nbs[0..n)|. Bit i of the result is set if |nbs[i]| lies within the radius,
+ * i.e. the key of |Metric| (the squared distance by default) is <= |sq_rad8|,
+ * the metric's threshold. Lanes past |n| never match.
+ */
+template <class Metric = metric::Euclidean>
+DBSCAN_TARGET_AVX
+inline int WithinRadius8(const __m256 u_x8, const __m256 u_y8,
+                         const __m256 sq_rad8, const float* const xs,
+                         const float* const ys, const uint64_t* const nbs,
+                         const uint64_t n) {
+  const __m256 v_x_8 = _mm256_set_ps(
+      n > 7 ? xs[nbs[7]] : kPadding, n > 6 ? xs[nbs[6]] : kPadding,
+      n > 5 ? xs[nbs[5]] : kPadding, n > 4 ? xs[nbs[4]] : kPadding,
+      n > 3 ? xs[nbs[3]] : kPadding, n > 2 ? xs[nbs[2]] : kPadding,
+      n > 1 ? xs[nbs[1]] : kPadding, xs[nbs[0]]);
+  const __m256 v_y_8 = _mm256_set_ps(
+      n > 7 ? ys[nbs[7]] : kPadding, n > 6 ? ys[nbs[6]] : kPadding,
+      n > 5 ? ys[nbs[5]] : kPadding, n > 4 ? ys[nbs[4]] : kPadding,
+      n > 3 ? ys[nbs[3]] : kPadding, n > 2 ? ys[nbs[2]] : kPadding,
+      n > 1 ? ys[nbs[1]] : kPadding, ys[nbs[0]]);
+  const __m256 key = Metric::Key8(u_x8, u_y8, v_x_8, v_y_8);
+  const int cmp = _mm256_movemask_ps(_mm256_cmp_ps(key, sq_rad8, _CMP_LE_OS));
+  // the padding is far for every metric but the haversine, which wraps it.
+  if constexpr (Metric::kMetric == metric::Metric::Haversine)
+    return n < 8 ? cmp & ((1 << n) - 1) : cmp;
+  return cmp;
+}
+
+/*
+ * Same as |WithinRadius8| for 8 candidates stored next to each other, e.g.
+ * coordinates laid out in cell order: bit i is set if (xs[i], ys[i]) lies
+ * within the radius.
+ */
+template <class Metric = metric::Euclidean>
+DBSCAN_TARGET_AVX
+inline int WithinRadius8(const __m256 u_x8, const __m256 u_y8,
+                         const __m256 sq_rad8, const float* const xs,
+                         const float* const ys) {
+  const __m256 key =
+      Metric::Key8(u_x8, u_y8, _mm256_loadu_ps(xs), _mm256_loadu_ps(ys));
+  return _mm256_movemask_ps(_mm256_cmp_ps(key, sq_rad8, _CMP_LE_OS));
+}
+
+/*
+ * A kernel policy tests a vertex against |kLanes| candidates at a time. Its
+ * |Probe| holds the vertex and the metric's threshold, broadcast once per
+ * vertex. |Within| returns a bit per candidate whose key is <= the threshold:
+ * of the candidates gathered through |nbs[0..n)| (lanes past |n| never
+ * match), or of |kLanes| candidates stored next to each other. Loops written
+ * against the policy are compiled once per kernel, for the baseline; only
+ * the functions of |Avx| and |Avx512| are built for their instruction set.
+ */
+struct Scalar {
+  static constexpr Kernel kKernel = Kernel::Scalar;
+  static constexpr uint64_t kLanes = 1;
+  struct Probe {
+    Probe(const float x, const float y, const float threshold)
+        : x(x), y(y), threshold(threshold) {}
+    float x, y, threshold;
+  };
+  template <class Metric = metric::Euclidean>
+  static uint64_t Within(const Probe& u, const float* const xs,
+                         const float* const ys, const uint64_t* const nbs,
+                         uint64_t) {
+    return Metric::Key(u.x, u.y, xs[nbs[0]], ys[nbs[0]]) <= u.threshold;
+  }
+  template <class Metric = metric::Euclidean>
+  static uint64_t Within(const Probe& u, const float* const xs,
+                         const float* const ys) {
+    return Metric::Key(u.x, u.y, xs[0], ys[0]) <= u.threshold;
+  }
+};
+
+struct Avx {
+  static constexpr Kernel kKernel = Kernel::Avx;
+  static constexpr uint64_t kLanes = 8;
+  struct Probe {
+    DBSCAN_TARGET_AVX
+    Probe(const float x, const float y, const float threshold)
+        : x(_mm256_set1_ps(x)),
+          y(_mm256_set1_ps(y)),
+          threshold(_mm256_set1_ps(threshold)) {}
+    __m256 x, y, threshold;
+  };
+  template <class Metric = metric::Euclidean>
+  DBSCAN_TARGET_AVX
+  static uint64_t Within(const Probe& u, const float* const xs,
+                         const float* const ys, const uint64_t* const nbs,
+                         const uint64_t n) {
+    return WithinRadius8<Metric>(u.x, u.y, u.threshold, xs, ys, nbs, n);
+  }
+  template <class Metric = metric::Euclidean>
+  DBSCAN_TARGET_AVX
+  static uint64_t Within(const Probe& u, const float* const xs,
+                         const float* const ys) {
+    return WithinRadius8<Metric>(u.x, u.y, u.threshold, xs, ys);
+  }
+};
+
+struct Avx512 {
+  static constexpr Kernel kKernel = Kernel::Avx512;
+  static constexpr uint64_t kLanes = 16;
+  struct Probe {
+    DBSCAN_TARGET_AVX512
+    Probe(const float x, const float y, const float threshold)
+        : x(_mm512_set1_ps(x)),
+          y(_mm512_set1_ps(y)),
+          threshold(_mm512_set1_ps(threshold)) {}
+    __m512 x, y, threshold;
+  };
+  template <class Metric = metric::Euclidean>
+  DBSCAN_TARGET_AVX512
+  static uint64_t Within(const Probe& u, const float* const xs,
+                         const float* const ys, const uint64_t* const nbs,
+                         const uint64_t n) {
+    alignas(64) float v_xs[kLanes], v_ys[kLanes];
+    for (uint64_t k = 0; k < kLanes; ++k) {
+      v_xs[k] = k < n ? xs[nbs[k]] : kPadding;
+      v_ys[k] = k < n ? ys[nbs[k]] : kPadding;
+    }
+    const uint64_t cmp = Within<Metric>(u, v_xs, v_ys);
+    // the haversine wraps the padding around.
+    return n < kLanes ? cmp & ((1u << n) - 1) : cmp;
+  }
+  template <class Metric = metric::Euclidean>
+  DBSCAN_TARGET_AVX512
+  static uint64_t Within(const Probe& u, const float* const xs,
+                         const float* const ys) {
+    const __m512 key =
+        Metric::Key16(u.x, u.y, _mm512_loadu_ps(xs), _mm512_loadu_ps(ys));
+    return _mm512_cmp_ps_mask(key, u.threshold, _CMP_LE_OS);
+  }
+};
+
+// The policy of each kernel.
+template <Kernel K>
+struct Policy;
+template <>
+struct Policy<Kernel::Scalar> {
+  using type = Scalar;
+};
+template <>
+struct Policy<Kernel::Avx> {
+  using type = Avx;
+};
+template <>
+struct Policy<Kernel::Avx512> {
+  using type = Avx512;
+};
+template <Kernel K>
+using PolicyOf = typename Policy<K>::type;
+
+/*
+ * Calls |f| with |std::integral_constant<Kernel, kernel>|, so that the code
+ * inside is compiled once per kernel and picks it once per call rather than
+ * per candidate. The loops it reaches are compiled in the TU of each kernel,
+ * see |loops::Loops|.
+ */
+template <class F>
+decltype(auto) Dispatch(const Kernel kernel, F&& f) {
+  if (kernel == Kernel::Avx512)
+    return f(std::integral_constant<Kernel, Kernel::Avx512>());
+  if (kernel == Kernel::Avx)
+    return f(std::integral_constant<Kernel, Kernel::Avx>());
+  return f(std::integral_constant<Kernel, Kernel::Scalar>());
+}
+}  // namespace kernels
+}  // namespace DBSCAN
+
+#endif  // DBSCAN_INCLUDE_KERNELS_H_
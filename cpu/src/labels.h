@@ -0,0 +1,272 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#ifndef DBSCAN_INCLUDE_LABELS_H_
+#define DBSCAN_INCLUDE_LABELS_H_
+
+#include <atomic>
+#include <cstdint>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include "DBSCAN/membership.h"
+#include "dataset.h"
+#include "finders.h"
+#include "grid.h"
+#include "metric.h"
+#include "stores.h"
+#include "threads.h"
+
+namespace DBSCAN {
+namespace labels {
+// The neighbours of a vertex, valid until the cursor that read them reads
+// again.
+class Span {
+ public:
+  Span(const uint64_t* const first, const uint64_t* const last)
+      : first_(first), last_(last) {}
+  [[nodiscard]] const uint64_t* begin() const { return first_; }
+  [[nodiscard]] const uint64_t* end() const { return last_; }
+  [[nodiscard]] uint64_t size() const { return last_ - first_; }
+
+ private:
+  const uint64_t *first_, *last_;
+};
+
+/*
+ * A graph the label loops read: every thread opens a |Cursor| and asks it
+ * for the |Neighbours| of a vertex. This one reads the finalized adjacency
+ * lists, or those of a mapped graph cache.
+ */
+class CsrGraph {
+ public:
+  CsrGraph(const uint64_t num_vtx, const uint64_t* const num_nbs,
+           const uint64_t* const start_pos, const uint64_t* const neighbours)
+      : num_vtx_(num_vtx),
+        num_nbs_(num_nbs),
+        start_pos_(start_pos),
+        neighbours_(neighbours) {}
+  [[nodiscard]] uint64_t num_vtx() const { return num_vtx_; }
+
+  class Cursor {
+   public:
+    explicit Cursor(const CsrGraph& graph) : graph_(graph) {}
+    [[nodiscard]] Span Neighbours(const uint64_t u) const {
+      const uint64_t* const first = graph_.neighbours_ + graph_.start_pos_[u];
+      return {first, first + graph_.num_nbs_[u]};
+    }
+
+   private:
+    const CsrGraph& graph_;
+  };
+
+ private:
+  uint64_t num_vtx_;
+  const uint64_t *num_nbs_, *start_pos_, *neighbours_;
+};
+
+/*
+ * The implicit store: no edges are kept, the neighbours of a vertex are
+ * searched in the eps-grid, with |Kernel|, each time they are read. A label
+ * stage then costs about as much as InsertEdges, but the graph takes no
+ * memory beyond the grid.
+ */
+template <class Kernel, class Metric = metric::Euclidean>
+class ImplicitGraph {
+ public:
+  explicit ImplicitGraph(const finders::GridCells<Metric>& finder)
+      : finder_(finder) {}
+  [[nodiscard]] uint64_t num_vtx() const { return finder_.num_vtx(); }
+
+  class Cursor {
+   public:
+    explicit Cursor(const ImplicitGraph& graph)
+        : finder_(graph.finder_), cursor_(graph.finder_, 0, 1) {}
+    [[nodiscard]] Span Neighbours(const uint64_t u) {
+      finder_.template Visit<Kernel>(cursor_, u, list_);
+      const auto& edges = list_.edges();
+      return {edges.data(), edges.data() + edges.size()};
+    }
+
+   private:
+    const finders::GridCells<Metric>& finder_;
+    typename finders::GridCells<Metric>::Cursor cursor_;
+    stores::List list_;
+  };
+
+ private:
+  const finders::GridCells<Metric>& finder_;
+};
+
+/*
+ * ClassifyNoises: Core if a vertex has min_pts neighbours, else Noise. With
+ * |weights| (see |dedup::Collapse|), every copy of a vertex sees the other
+ * copies and all of its neighbours'. Returns the number of cores.
+ */
+template <class G>
+uint64_t Classify(const G& graph, const uint64_t min_pts,
+                  const std::vector<uint64_t>& weights,
+                  std::vector<membership>& memberships,
+                  const uint8_t num_threads) {
+  const uint64_t num_vtx = graph.num_vtx();
+  std::vector<uint64_t> num_cores(num_threads);
+  utils::run_threads(num_threads, [&](const uint8_t tid) {
+    typename G::Cursor cursor(graph);
+    uint64_t cores = 0;
+    for (uint64_t u = tid; u < num_vtx; u += num_threads) {
+      const Span nbs = cursor.Neighbours(u);
+      uint64_t degree = nbs.size();
+      if (!weights.empty()) {
+        degree = weights[u] - 1;
+        for (auto it = nbs.begin(); it != nbs.end() && degree < min_pts; ++it)
+          degree += weights[*it];
+      }
+      memberships[u] = degree >= min_pts ? Core : Noise;
+      cores += degree >= min_pts;
+    }
+    num_cores[tid] = cores;
+  });
+  return std::accumulate(num_cores.cbegin(), num_cores.cend(), 0ull);
+}
+
+/*
+ * The labellers of IdentifyClusters; |Run| labels every vertex of a graph
+ * classified by |Classify| and returns the number of clusters. Both number
+ * the clusters by their lowest core and give a border the cluster with the
+ * lowest number.
+ */
+
+// One BFS per cluster from each unlabelled core, level by level across the
+// threads; a reachable Noise vertex is relabelled Border and not expanded.
+class Bfs {
+ public:
+  template <class G>
+  int Run(const G& graph, std::vector<int>& cluster_ids,
+          std::vector<membership>& memberships, const uint8_t num_threads) {
+    std::vector<typename G::Cursor> cursors(num_threads,
+                                            typename G::Cursor(graph));
+    next_level_.resize(num_threads);
+    int cluster = 0;
+    for (uint64_t vertex = 0; vertex < graph.num_vtx(); ++vertex) {
+      if (cluster_ids[vertex] != -1 || memberships[vertex] != Core) continue;
+      cluster_ids[vertex] = cluster;
+      curr_level_.assign(1, vertex);
+      while (!curr_level_.empty()) {
+        utils::run_threads(num_threads, [&](const uint8_t tid) {
+          auto& next = next_level_[tid];
+          for (uint64_t i = tid; i < curr_level_.size(); i += num_threads) {
+            const uint64_t u = curr_level_[i];
+            if (memberships[u] == Noise) {
+              memberships[u] = Border;
+              continue;
+            }
+            for (const uint64_t nb : cursors[tid].Neighbours(u)) {
+              if (cluster_ids[nb] == -1) {
+                cluster_ids[nb] = cluster;
+                next.push_back(nb);
+              }
+            }
+          }
+        });
+        // sync barrier: the partial frontiers are the next level.
+        curr_level_.clear();
+        for (auto& level : next_level_) {
+          curr_level_.insert(curr_level_.end(), level.cbegin(), level.cend());
+          level.clear();
+        }
+      }
+      ++cluster;
+    }
+    return cluster;
+  }
+
+ private:
+  // kept across clusters and runs for their capacity; one partial frontier
+  // per thread.
+  std::vector<uint64_t> curr_level_;
+  std::vector<std::vector<uint64_t>> next_level_;
+};
+
+// A concurrent union-find over the core-core edges, then one pass over the
+// vertices.
+class UnionFind {
+ public:
+  template <class G>
+  int Run(const G& graph, std::vector<int>& cluster_ids,
+          std::vector<membership>& memberships, const uint8_t num_threads) {
+    const uint64_t num_vtx = graph.num_vtx();
+    // a root is the lowest core of its tree: a link always goes from the
+    // higher root to the lower one.
+    std::vector<std::atomic<uint64_t>> parent(num_vtx);
+    utils::run_threads(num_threads, [&](const uint8_t tid) {
+      for (uint64_t u = tid; u < num_vtx; u += num_threads)
+        parent[u].store(u, std::memory_order_relaxed);
+    });
+    // with path halving; a stale parent is still an ancestor.
+    const auto find = [&parent](uint64_t u) {
+      uint64_t p = parent[u].load(std::memory_order_relaxed);
+      while (p != u) {
+        const uint64_t grandparent = parent[p].load(std::memory_order_relaxed);
+        parent[u].compare_exchange_weak(p, grandparent,
+                                        std::memory_order_relaxed);
+        u = grandparent;
+        p = parent[u].load(std::memory_order_relaxed);
+      }
+      return u;
+    };
+    utils::run_threads(num_threads, [&](const uint8_t tid) {
+      typename G::Cursor cursor(graph);
+      for (uint64_t u = tid; u < num_vtx; u += num_threads) {
+        if (memberships[u] != Core) continue;
+        for (const uint64_t v : cursor.Neighbours(u)) {
+          uint64_t a = u, b = v;
+          // each edge is listed both ways.
+          if (b > a || memberships[b] != Core) continue;
+          while (true) {
+            a = find(a);
+            b = find(b);
+            if (a == b) break;
+            if (a < b) std::swap(a, b);
+            uint64_t expected = a;
+            if (parent[a].compare_exchange_strong(expected, b,
+                                                  std::memory_order_relaxed))
+              break;
+          }
+        }
+      }
+    });
+    // the roots in vertex order are the cores a BFS would start from.
+    int num_clusters = 0;
+    for (uint64_t u = 0; u < num_vtx; ++u) {
+      if (memberships[u] == Core && find(u) == u)
+        cluster_ids[u] = num_clusters++;
+    }
+    utils::run_threads(num_threads, [&](const uint8_t tid) {
+      typename G::Cursor cursor(graph);
+      for (uint64_t u = tid; u < num_vtx; u += num_threads) {
+        if (memberships[u] == Core) {
+          const uint64_t root = find(u);
+          if (root != u) cluster_ids[u] = cluster_ids[root];
+          continue;
+        }
+        // the BFS of the lowest cluster around a border reaches it first.
+        int cluster = -1;
+        for (const uint64_t v : cursor.Neighbours(u)) {
+          if (memberships[v] != Core) continue;
+          const int c = cluster_ids[find(v)];
+          if (cluster == -1 || c < cluster) cluster = c;
+        }
+        if (cluster == -1) continue;
+        cluster_ids[u] = cluster;
+        memberships[u] = Border;
+      }
+    });
+    return num_clusters;
+  }
+};
+}  // namespace labels
+}  // namespace DBSCAN
+
+#endif  // DBSCAN_INCLUDE_LABELS_H_
@@ -0,0 +1,82 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#ifndef DBSCAN_INCLUDE_LOOPS_H_
+#define DBSCAN_INCLUDE_LOOPS_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "DBSCAN/membership.h"
+#include "dataset.h"
+#include "finders.h"
+#include "graph.h"
+#include "kernels.h"
+#include "labels.h"
+#include "metric.h"
+
+namespace DBSCAN {
+class FittedModel;
+
+namespace loops {
+/*
+ * The hot loops of kernel |K|. They are written once, in loops_impl.h,
+ * against a neighbour finder of finders.h, a graph store of stores.h and a
+ * labeller of labels.h, and compiled in kernel_<K>.cpp for the baseline
+ * instruction set like the rest of the library; only the distance tests of
+ * the kernel policy are built for AVX or AVX-512, so a host without them runs
+ * the scalar loops. Callers pick
+ * |K| once per stage with |kernels::Dispatch|. Each Insert returns the number
+ * of candidate pairs it tested.
+ */
+template <kernels::Kernel K>
+struct Loops {
+  // The grid candidates of each metric into adjacency lists.
+  static uint64_t Insert(const finders::GridCells<metric::Euclidean>&,
+                         Graph::CsrWriter, uint8_t num_threads);
+  static uint64_t Insert(const finders::GridCells<metric::Manhattan>&,
+                         Graph::CsrWriter, uint8_t num_threads);
+  static uint64_t Insert(const finders::GridCells<metric::Chebyshev>&,
+                         Graph::CsrWriter, uint8_t num_threads);
+  static uint64_t Insert(const finders::GridCells<metric::Haversine>&,
+                         Graph::CsrWriter, uint8_t num_threads);
+  // The cell-order runs into adjacency lists (the NUMA-aware mode) or a
+  // blocked bitmap.
+  static uint64_t Insert(const finders::CellRanges&, Graph::CsrWriter,
+                         uint8_t num_threads);
+  static uint64_t Insert(const finders::CellRanges&, Graph::BitmapWriter,
+                         uint8_t num_threads);
+  static uint64_t Insert(const finders::KdLeaves&, Graph::CsrWriter,
+                         uint8_t num_threads);
+  static uint64_t Insert(const finders::TilePairs&, Graph::BitmapWriter,
+                         uint8_t num_threads);
+  // ClassifyNoises and IdentifyClusters on the implicit store, see
+  // |labels::ImplicitGraph|.
+  static uint64_t Classify(const finders::GridCells<metric::Euclidean>&,
+                           uint64_t min_pts,
+                           const std::vector<uint64_t>& weights,
+                           std::vector<membership>&, uint8_t num_threads);
+  static int Label(labels::Bfs&, const finders::GridCells<metric::Euclidean>&,
+                   std::vector<int>&, std::vector<membership>&,
+                   uint8_t num_threads);
+  static int Label(labels::UnionFind&,
+                   const finders::GridCells<metric::Euclidean>&,
+                   std::vector<int>&, std::vector<membership>&,
+                   uint8_t num_threads);
+  // |FittedModel::Predict| of the queries [begin, end) into |labels|.
+  static void Predict(const FittedModel&, const input_type::TwoDimPoints&,
+                      uint64_t begin, uint64_t end, int* labels);
+  /*
+   * The policy's |Within| for |metric|, of the candidates gathered through
+   * |nbs[0..n)| against (x, y); lets code built for the baseline, e.g. the
+   * tests, reach every kernel.
+   */
+  static uint64_t Within(metric::Metric, float x, float y, float threshold,
+                         const float* xs, const float* ys,
+                         const uint64_t* nbs, uint64_t n);
+};
+}  // namespace loops
+}  // namespace DBSCAN
+
+#endif  // DBSCAN_INCLUDE_LOOPS_H_
@@ -0,0 +1,167 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#ifndef DBSCAN_INCLUDE_LOOPS_IMPL_H_
+#define DBSCAN_INCLUDE_LOOPS_IMPL_H_
+
+// Only included by the kernel TUs, each built for its own instruction set.
+
+#include <numeric>
+#include <vector>
+
+#include "finders.h"
+#include "labels.h"
+#include "loops.h"
+#include "model.h"
+#include "stores.h"
+#include "threads.h"
+
+namespace DBSCAN {
+namespace loops {
+namespace internal {
+// The one insert loop: every thread walks the units its cursor hands out and
+// reports what |Kernel| finds in them to a |Store| of its own.
+template <class Kernel, class Store, class Finder, class Writer>
+uint64_t Insert(const Finder& finder, const Writer writer,
+                const uint8_t num_threads) {
+  std::vector<uint64_t> num_candidates(num_threads);
+  utils::run_threads(num_threads, [&](const uint8_t tid) {
+    typename Finder::Cursor cursor(finder, tid, num_threads);
+    Store store(writer);
+    uint64_t unit, candidates = 0;
+    while (cursor.Next(unit))
+      candidates += finder.template Visit<Kernel>(cursor, unit, store);
+    num_candidates[tid] = candidates;
+  });
+  return std::accumulate(num_candidates.cbegin(), num_candidates.cend(), 0ull);
+}
+}  // namespace internal
+
+template <kernels::Kernel K>
+uint64_t Loops<K>::Insert(const finders::GridCells<metric::Euclidean>& finder,
+                          const Graph::CsrWriter writer,
+                          const uint8_t num_threads) {
+  return internal::Insert<kernels::PolicyOf<K>, stores::Csr>(finder, writer,
+                                                             num_threads);
+}
+
+template <kernels::Kernel K>
+uint64_t Loops<K>::Insert(const finders::GridCells<metric::Manhattan>& finder,
+                          const Graph::CsrWriter writer,
+                          const uint8_t num_threads) {
+  return internal::Insert<kernels::PolicyOf<K>, stores::Csr>(finder, writer,
+                                                             num_threads);
+}
+
+template <kernels::Kernel K>
+uint64_t Loops<K>::Insert(const finders::GridCells<metric::Chebyshev>& finder,
+                          const Graph::CsrWriter writer,
+                          const uint8_t num_threads) {
+  return internal::Insert<kernels::PolicyOf<K>, stores::Csr>(finder, writer,
+                                                             num_threads);
+}
+
+template <kernels::Kernel K>
+uint64_t Loops<K>::Insert(const finders::GridCells<metric::Haversine>& finder,
+                          const Graph::CsrWriter writer,
+                          const uint8_t num_threads) {
+  return internal::Insert<kernels::PolicyOf<K>, stores::Csr>(finder, writer,
+                                                             num_threads);
+}
+
+template <kernels::Kernel K>
+uint64_t Loops<K>::Insert(const finders::CellRanges& finder,
+                          const Graph::CsrWriter writer,
+                          const uint8_t num_threads) {
+  return internal::Insert<kernels::PolicyOf<K>, stores::Csr>(finder, writer,
+                                                             num_threads);
+}
+
+template <kernels::Kernel K>
+uint64_t Loops<K>::Insert(const finders::CellRanges& finder,
+                          const Graph::BitmapWriter writer,
+                          const uint8_t num_threads) {
+  return internal::Insert<kernels::PolicyOf<K>, stores::Blocked>(
+      finder, writer, num_threads);
+}
+
+template <kernels::Kernel K>
+uint64_t Loops<K>::Insert(const finders::KdLeaves& finder,
+                          const Graph::CsrWriter writer,
+                          const uint8_t num_threads) {
+  return internal::Insert<kernels::PolicyOf<K>, stores::Csr>(finder, writer,
+                                                             num_threads);
+}
+
+template <kernels::Kernel K>
+uint64_t Loops<K>::Insert(const finders::TilePairs& finder,
+                          const Graph::BitmapWriter writer,
+                          const uint8_t num_threads) {
+  return internal::Insert<kernels::PolicyOf<K>, stores::Bitmap>(
+      finder, writer, num_threads);
+}
+
+template <kernels::Kernel K>
+uint64_t Loops<K>::Classify(
+    const finders::GridCells<metric::Euclidean>& finder, const uint64_t min_pts,
+    const std::vector<uint64_t>& weights, std::vector<membership>& memberships,
+    const uint8_t num_threads) {
+  const labels::ImplicitGraph<kernels::PolicyOf<K>> graph(finder);
+  return labels::Classify(graph, min_pts, weights, memberships, num_threads);
+}
+
+template <kernels::Kernel K>
+int Loops<K>::Label(labels::Bfs& bfs,
+                    const finders::GridCells<metric::Euclidean>& finder,
+                    std::vector<int>& cluster_ids,
+                    std::vector<membership>& memberships,
+                    const uint8_t num_threads) {
+  const labels::ImplicitGraph<kernels::PolicyOf<K>> graph(finder);
+  return bfs.Run(graph, cluster_ids, memberships, num_threads);
+}
+
+template <kernels::Kernel K>
+int Loops<K>::Label(labels::UnionFind& union_find,
+                    const finders::GridCells<metric::Euclidean>& finder,
+                    std::vector<int>& cluster_ids,
+                    std::vector<membership>& memberships,
+                    const uint8_t num_threads) {
+  const labels::ImplicitGraph<kernels::PolicyOf<K>> graph(finder);
+  return union_find.Run(graph, cluster_ids, memberships, num_threads);
+}
+
+template <kernels::Kernel K>
+void Loops<K>::Predict(const FittedModel& model,
+                       const input_type::TwoDimPoints& queries,
+                       const uint64_t begin, const uint64_t end,
+                       int* const labels) {
+  std::vector<uint64_t> nbs;
+  for (uint64_t q = begin; q < end; ++q) {
+    labels[q] = model.PredictOne_<kernels::PolicyOf<K>>(queries.d1[q],
+                                                        queries.d2[q], nbs);
+  }
+}
+
+template <kernels::Kernel K>
+uint64_t Loops<K>::Within(const metric::Metric m, const float x, const float y,
+                          const float threshold, const float* const xs,
+                          const float* const ys, const uint64_t* const nbs,
+                          const uint64_t n) {
+  using Kernel = kernels::PolicyOf<K>;
+  const typename Kernel::Probe probe(x, y, threshold);
+  switch (m) {
+    case metric::Metric::Manhattan:
+      return Kernel::template Within<metric::Manhattan>(probe, xs, ys, nbs, n);
+    case metric::Metric::Chebyshev:
+      return Kernel::template Within<metric::Chebyshev>(probe, xs, ys, nbs, n);
+    case metric::Metric::Haversine:
+      return Kernel::template Within<metric::Haversine>(probe, xs, ys, nbs, n);
+    default:
+      return Kernel::template Within<metric::Euclidean>(probe, xs, ys, nbs, n);
+  }
+}
+}  // namespace loops
+}  // namespace DBSCAN
+
+#endif  // DBSCAN_INCLUDE_LOOPS_IMPL_H_
@@ -0,0 +1,75 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#include "metric.h"
+
+#include <limits>
+#include <stdexcept>
+
+#include "grid.h"
+
+std::string DBSCAN::metric::ToString(const Metric metric) {
+  switch (metric) {
+    case Metric::Euclidean:
+      return "euclidean";
+    case Metric::Manhattan:
+      return "manhattan";
+    case Metric::Chebyshev:
+      return "chebyshev";
+    case Metric::Haversine:
+      return "haversine";
+  }
+  return "";
+}
+
+DBSCAN::metric::Metric DBSCAN::metric::ParseMetric(const std::string& name) {
+  if (name == "euclidean") return Metric::Euclidean;
+  if (name == "manhattan") return Metric::Manhattan;
+  if (name == "chebyshev") return Metric::Chebyshev;
+  if (name == "haversine") return Metric::Haversine;
+  throw std::runtime_error("unknown metric " + name);
+}
+
+void DBSCAN::metric::Euclidean::Candidates(const Grid& grid, const uint64_t u,
+                                           const float x, const float y,
+                                           const float,
+                                           std::vector<uint64_t>& nbs) {
+  grid.GetNeighbouringVtx(u, x, y, nbs);
+}
+
+float DBSCAN::metric::Haversine::Threshold(const float eps) {
+  if (eps >= 180) return 1;
+  const double s = std::sin(eps * M_PI / 360);
+  return static_cast<float>(s * s);
+}
+
+void DBSCAN::metric::Haversine::Candidates(const Grid& grid, const uint64_t u,
+                                           const float x, const float y,
+                                           const float eps,
+                                           std::vector<uint64_t>& nbs) {
+  constexpr float kLowest = std::numeric_limits<float>::lowest(),
+                  kMax = std::numeric_limits<float>::max();
+  nbs.clear();
+  // |dlat| <= eps, so the 3 rows hold the cap; a cap over a pole spans every
+  // longitude.
+  const double lat = std::fabs(y) * M_PI / 180, angle = eps * M_PI / 180;
+  if (lat + angle >= M_PI / 2) {
+    grid.AppendVtxInRows(u, kLowest, kMax, y, nbs);
+    return;
+  }
+  // widened a little so that rounding never loses a candidate; the distance
+  // test has the last word.
+  const float span = std::asin(std::sin(angle) / std::cos(lat)) * 180 / M_PI *
+                         (1 + 1e-4) +
+                     1e-4f;
+  if (span >= 180 - eps) {
+    grid.AppendVtxInRows(u, kLowest, kMax, y, nbs);
+    return;
+  }
+  grid.AppendVtxInRows(u, x - span, x + span, y, nbs);
+  // the part of the cap across the antimeridian; disjoint from the above as
+  // both ends are more than 2 cells apart.
+  if (x - span < -180) grid.AppendVtxInRows(u, x - span + 360, kMax, y, nbs);
+  if (x + span > 180) grid.AppendVtxInRows(u, kLowest, x + span - 360, y, nbs);
+}
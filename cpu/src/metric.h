@@ -0,0 +1,243 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#ifndef DBSCAN_INCLUDE_METRIC_H_
+#define DBSCAN_INCLUDE_METRIC_H_
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "dataset.h"
+
+/*
+ * The AVX and AVX-512 code of the kernels is compiled for its instruction set
+ * function by function rather than with -mavx on a whole TU: an inline
+ * function a TU shares with the rest of the library, e.g. of std::vector, is
+ * then always emitted for the baseline, whichever copy the linker keeps.
+ */
+#define DBSCAN_TARGET_AVX __attribute__((target("avx")))
+#define DBSCAN_TARGET_AVX512 __attribute__((target("avx,avx512f")))
+
+namespace DBSCAN {
+class Grid;
+
+namespace metric {
+enum class Metric : uint8_t { Euclidean, Manhattan, Chebyshev, Haversine };
+// "euclidean"/"manhattan"/"chebyshev"/"haversine" and back; throws on
+// anything else.
+std::string ToString(Metric);
+Metric ParseMetric(const std::string&);
+
+/*
+ * A metric policy compares a |Key| of two points against the |Threshold| of
+ * eps, a monotone stand-in for the distance that avoids square roots and
+ * inverse trigonometry. |Key8| and |Key16| are the AVX and AVX-512 versions
+ * of |Key| and round the same, lane by lane; only the kernel of that
+ * instruction set calls them.
+ * |Candidates| fills |nbs| with every vertex that may be within eps of |u| at
+ * (x, y), |u| excluded, from a grid of eps-wide cells.
+ */
+struct Euclidean {
+  static constexpr Metric kMetric = Metric::Euclidean;
+  static float Threshold(const float eps) { return eps * eps; }
+  static float Key(const float px, const float py, const float qx,
+                   const float qy) {
+    return input_type::TwoDimPoints::euclidean_distance_square(px, py, qx, qy);
+  }
+  DBSCAN_TARGET_AVX
+  static __m256 Key8(const __m256 px, const __m256 py, const __m256 qx,
+                     const __m256 qy) {
+    const __m256 x_diff_8 = _mm256_sub_ps(px, qx);
+    const __m256 y_diff_8 = _mm256_sub_ps(py, qy);
+    return _mm256_add_ps(_mm256_mul_ps(x_diff_8, x_diff_8),
+                         _mm256_mul_ps(y_diff_8, y_diff_8));
+  }
+  DBSCAN_TARGET_AVX512
+  static __m512 Key16(const __m512 px, const __m512 py, const __m512 qx,
+                      const __m512 qy) {
+    const __m512 x_diff_16 = _mm512_sub_ps(px, qx);
+    const __m512 y_diff_16 = _mm512_sub_ps(py, qy);
+    return _mm512_add_ps(_mm512_mul_ps(x_diff_16, x_diff_16),
+                         _mm512_mul_ps(y_diff_16, y_diff_16));
+  }
+  // the eps-ball fits in the 3x3 cells around a vertex.
+  static void Candidates(const Grid&, uint64_t u, float x, float y, float eps,
+                         std::vector<uint64_t>& nbs);
+};
+
+namespace internal {
+DBSCAN_TARGET_AVX
+inline __m256 Abs8(const __m256 v) {
+  return _mm256_andnot_ps(_mm256_set1_ps(-0.f), v);
+}
+}  // namespace internal
+
+struct Manhattan {
+  static constexpr Metric kMetric = Metric::Manhattan;
+  static float Threshold(const float eps) { return eps; }
+  static float Key(const float px, const float py, const float qx,
+                   const float qy) {
+    return std::fabs(px - qx) + std::fabs(py - qy);
+  }
+  DBSCAN_TARGET_AVX
+  static __m256 Key8(const __m256 px, const __m256 py, const __m256 qx,
+                     const __m256 qy) {
+    return _mm256_add_ps(internal::Abs8(_mm256_sub_ps(px, qx)),
+                         internal::Abs8(_mm256_sub_ps(py, qy)));
+  }
+  DBSCAN_TARGET_AVX512
+  static __m512 Key16(const __m512 px, const __m512 py, const __m512 qx,
+                      const __m512 qy) {
+    return _mm512_add_ps(_mm512_abs_ps(_mm512_sub_ps(px, qx)),
+                         _mm512_abs_ps(_mm512_sub_ps(py, qy)));
+  }
+  static void Candidates(const Grid& grid, const uint64_t u, const float x,
+                         const float y, const float eps,
+                         std::vector<uint64_t>& nbs) {
+    Euclidean::Candidates(grid, u, x, y, eps, nbs);
+  }
+};
+
+struct Chebyshev {
+  static constexpr Metric kMetric = Metric::Chebyshev;
+  static float Threshold(const float eps) { return eps; }
+  static float Key(const float px, const float py, const float qx,
+                   const float qy) {
+    return std::max(std::fabs(px - qx), std::fabs(py - qy));
+  }
+  DBSCAN_TARGET_AVX
+  static __m256 Key8(const __m256 px, const __m256 py, const __m256 qx,
+                     const __m256 qy) {
+    return _mm256_max_ps(internal::Abs8(_mm256_sub_ps(px, qx)),
+                         internal::Abs8(_mm256_sub_ps(py, qy)));
+  }
+  DBSCAN_TARGET_AVX512
+  static __m512 Key16(const __m512 px, const __m512 py, const __m512 qx,
+                      const __m512 qy) {
+    // the unmasked max trips -Wmaybe-uninitialized in GCC 12's headers.
+    return _mm512_maskz_max_ps(0xffff, _mm512_abs_ps(_mm512_sub_ps(px, qx)),
+                               _mm512_abs_ps(_mm512_sub_ps(py, qy)));
+  }
+  static void Candidates(const Grid& grid, const uint64_t u, const float x,
+                         const float y, const float eps,
+                         std::vector<uint64_t>& nbs) {
+    Euclidean::Candidates(grid, u, x, y, eps, nbs);
+  }
+};
+
+/*
+ * Great-circle distance between (longitude, latitude) pairs in degrees, with
+ * longitudes in [-180, 180]; eps is the central angle in degrees (kilometres
+ * / 111.195 on the mean Earth radius). The key is the haversine
+ *   sin^2(dlat / 2) + cos(lat1) cos(lat2) sin^2(dlon / 2),
+ * with the sines from one polynomial in both kernels, so that they agree.
+ */
+struct Haversine {
+  static constexpr Metric kMetric = Metric::Haversine;
+  static float Threshold(float eps);
+  static float Key(const float px, const float py, const float qx,
+                   const float qy) {
+    float dlon = qx - px;
+    dlon -= 360 * std::nearbyint(dlon / 360);
+    const float s_lat = Sin_((qy - py) * kHalfRadian);
+    const float s_lon = Sin_(dlon * kHalfRadian);
+    const float cos_p = Sin_(kHalfPi - std::fabs(py) * kRadian);
+    const float cos_q = Sin_(kHalfPi - std::fabs(qy) * kRadian);
+    return s_lat * s_lat + cos_p * cos_q * (s_lon * s_lon);
+  }
+  DBSCAN_TARGET_AVX
+  static __m256 Key8(const __m256 px, const __m256 py, const __m256 qx,
+                     const __m256 qy) {
+    const __m256 full = _mm256_set1_ps(360);
+    __m256 dlon = _mm256_sub_ps(qx, px);
+    dlon = _mm256_sub_ps(
+        dlon, _mm256_mul_ps(full, _mm256_round_ps(
+                                      _mm256_div_ps(dlon, full),
+                                      _MM_FROUND_TO_NEAREST_INT |
+                                          _MM_FROUND_NO_EXC)));
+    const __m256 half_radian = _mm256_set1_ps(kHalfRadian);
+    const __m256 radian = _mm256_set1_ps(kRadian);
+    const __m256 half_pi = _mm256_set1_ps(kHalfPi);
+    const __m256 s_lat =
+        Sin8_(_mm256_mul_ps(_mm256_sub_ps(qy, py), half_radian));
+    const __m256 s_lon = Sin8_(_mm256_mul_ps(dlon, half_radian));
+    const __m256 cos_p = Sin8_(_mm256_sub_ps(
+        half_pi, _mm256_mul_ps(internal::Abs8(py), radian)));
+    const __m256 cos_q = Sin8_(_mm256_sub_ps(
+        half_pi, _mm256_mul_ps(internal::Abs8(qy), radian)));
+    return _mm256_add_ps(_mm256_mul_ps(s_lat, s_lat),
+                         _mm256_mul_ps(_mm256_mul_ps(cos_p, cos_q),
+                                       _mm256_mul_ps(s_lon, s_lon)));
+  }
+  DBSCAN_TARGET_AVX512
+  static __m512 Key16(const __m512 px, const __m512 py, const __m512 qx,
+                      const __m512 qy) {
+    const __m512 full = _mm512_set1_ps(360);
+    __m512 dlon = _mm512_sub_ps(qx, px);
+    dlon = _mm512_sub_ps(
+        dlon, _mm512_mul_ps(full, _mm512_maskz_roundscale_ps(
+                                      0xffff, _mm512_div_ps(dlon, full),
+                                      _MM_FROUND_TO_NEAREST_INT |
+                                          _MM_FROUND_NO_EXC)));
+    const __m512 half_radian = _mm512_set1_ps(kHalfRadian);
+    const __m512 radian = _mm512_set1_ps(kRadian);
+    const __m512 half_pi = _mm512_set1_ps(kHalfPi);
+    const __m512 s_lat =
+        Sin16_(_mm512_mul_ps(_mm512_sub_ps(qy, py), half_radian));
+    const __m512 s_lon = Sin16_(_mm512_mul_ps(dlon, half_radian));
+    const __m512 cos_p = Sin16_(_mm512_sub_ps(
+        half_pi, _mm512_mul_ps(_mm512_abs_ps(py), radian)));
+    const __m512 cos_q = Sin16_(_mm512_sub_ps(
+        half_pi, _mm512_mul_ps(_mm512_abs_ps(qy), radian)));
+    return _mm512_add_ps(_mm512_mul_ps(s_lat, s_lat),
+                         _mm512_mul_ps(_mm512_mul_ps(cos_p, cos_q),
+                                       _mm512_mul_ps(s_lon, s_lon)));
+  }
+  /*
+   * The 3 rows of eps-high cells around |y|, over the longitudes the
+   * eps-cap around |u| spans: asin(sin(eps) / cos(lat)) either way, wrapped
+   * around +-180, or all of them once the cap holds a pole.
+   */
+  static void Candidates(const Grid&, uint64_t u, float x, float y, float eps,
+                         std::vector<uint64_t>& nbs);
+
+ private:
+  static constexpr float kRadian = M_PI / 180;
+  static constexpr float kHalfRadian = M_PI / 360;
+  static constexpr float kHalfPi = M_PI / 2;
+  // Taylor series to x^11 on [-pi/2, pi/2], within 6e-8 of sin.
+  static constexpr float kSin[5] = {-1.f / 6, 1.f / 120, -1.f / 5040,
+                                    1.f / 362880, -1.f / 39916800};
+  static float Sin_(const float x) {
+    const float x2 = x * x;
+    float p = kSin[4];
+    for (int i = 3; i >= 0; --i) p = p * x2 + kSin[i];
+    return x + x * (x2 * p);
+  }
+  DBSCAN_TARGET_AVX
+  static __m256 Sin8_(const __m256 x) {
+    const __m256 x2 = _mm256_mul_ps(x, x);
+    __m256 p = _mm256_set1_ps(kSin[4]);
+    for (int i = 3; i >= 0; --i)
+      p = _mm256_add_ps(_mm256_mul_ps(p, x2), _mm256_set1_ps(kSin[i]));
+    return _mm256_add_ps(x, _mm256_mul_ps(x, _mm256_mul_ps(x2, p)));
+  }
+  DBSCAN_TARGET_AVX512
+  static __m512 Sin16_(const __m512 x) {
+    const __m512 x2 = _mm512_mul_ps(x, x);
+    __m512 p = _mm512_set1_ps(kSin[4]);
+    for (int i = 3; i >= 0; --i)
+      p = _mm512_add_ps(_mm512_mul_ps(p, x2), _mm512_set1_ps(kSin[i]));
+    return _mm512_add_ps(x, _mm512_mul_ps(x, _mm512_mul_ps(x2, p)));
+  }
+};
+}  // namespace metric
+}  // namespace DBSCAN
+
+#endif  // DBSCAN_INCLUDE_METRIC_H_
@@ -0,0 +1,163 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#include "metrics.h"
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+
+#include "spdlog/fmt/fmt.h"
+#include "spdlog/spdlog.h"
+#include "threads.h"
+
+namespace {
+// {"cycles": .., "instructions": .., ..} with the valid events only.
+std::string CountersJson_(const DBSCAN::perf::Counters& counters) {
+  std::string json = "{";
+  for (uint8_t e = 0; e < DBSCAN::perf::kNumEvents; ++e) {
+    if (!counters.valid[e]) continue;
+    json += fmt::format("{}\"{}\": {}", json.size() > 1 ? ", " : "",
+                        DBSCAN::perf::kEventNames[e], counters.values[e]);
+  }
+  return json + "}";
+}
+}  // namespace
+
+double DBSCAN::metrics::Stage::imbalance() const {
+  if (thread_busy_seconds.empty()) return 1;
+  const double total = std::accumulate(thread_busy_seconds.cbegin(),
+                                       thread_busy_seconds.cend(), 0.0);
+  if (total <= 0) return 1;
+  const double max = *std::max_element(thread_busy_seconds.cbegin(),
+                                       thread_busy_seconds.cend());
+  return max * thread_busy_seconds.size() / total;
+}
+
+void DBSCAN::metrics::Stage::Count(const std::string& key,
+                                   const uint64_t value) {
+  for (auto& [k, v] : counts) {
+    if (k == key) {
+      v = value;
+      return;
+    }
+  }
+  counts.emplace_back(key, value);
+}
+
+uint64_t DBSCAN::metrics::Stage::count(const std::string& key) const {
+  for (const auto& [k, v] : counts) {
+    if (k == key) return v;
+  }
+  return 0;
+}
+
+const DBSCAN::metrics::Stage* DBSCAN::metrics::Run::Find(
+    const std::string& name) const {
+  for (auto it = stages.crbegin(); it != stages.crend(); ++it) {
+    if (it->name == name) return &*it;
+  }
+  return nullptr;
+}
+
+double DBSCAN::metrics::Run::wall_seconds() const {
+  double total = 0;
+  for (const auto& stage : stages) total += stage.wall_seconds;
+  return total;
+}
+
+std::string DBSCAN::metrics::Run::ToJson() const {
+  // stage and count names are identifiers, so nothing needs escaping.
+  std::string json = fmt::format(
+      "{{\"num_vtx\": {}, \"min_pts\": {}, \"radius\": {}, "
+      "\"num_threads\": {}, \"wall_seconds\": {}, \"stages\": [",
+      num_vtx, min_pts, radius, num_threads, wall_seconds());
+  for (size_t i = 0; i < stages.size(); ++i) {
+    const auto& stage = stages[i];
+    json += fmt::format(
+        "{}{{\"name\": \"{}\", \"wall_seconds\": {}, "
+        "\"thread_busy_seconds\": [",
+        i ? ", " : "", stage.name, stage.wall_seconds);
+    for (size_t t = 0; t < stage.thread_busy_seconds.size(); ++t)
+      json += fmt::format("{}{}", t ? ", " : "", stage.thread_busy_seconds[t]);
+    json += fmt::format(
+        "], \"imbalance\": {}, \"peak_rss_delta_kb\": {}, \"counts\": {{",
+        stage.imbalance(), stage.peak_rss_delta_kb);
+    for (size_t c = 0; c < stage.counts.size(); ++c) {
+      json += fmt::format("{}\"{}\": {}", c ? ", " : "", stage.counts[c].first,
+                          stage.counts[c].second);
+    }
+    json += "}";
+    if (stage.counters.any())
+      json += ", \"counters\": " + CountersJson_(stage.counters);
+    json += "}";
+  }
+  json += "]}\n";
+  return json;
+}
+
+void DBSCAN::metrics::Run::Write(const std::string& path) const {
+  std::ofstream ofs(path);
+  if (!ofs) throw std::runtime_error("cannot open " + path);
+  ofs << ToJson();
+  if (!ofs) throw std::runtime_error("failed writing " + path);
+}
+
+int64_t DBSCAN::metrics::PeakRssKb() {
+  rusage usage{};
+  if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+  // kilobytes on Linux
+  return usage.ru_maxrss;
+}
+
+DBSCAN::metrics::StageScope::StageScope(Run& run, std::string name)
+    : run_(run),
+      index_(run.stages.size()),
+      start_(std::chrono::steady_clock::now()),
+      peak_rss_kb_(PeakRssKb()),
+      prev_sink_(DBSCAN::utils::thread_busy_sink) {
+  run_.stages.emplace_back();
+  run_.stages.back().name = std::move(name);
+  DBSCAN::utils::thread_busy_sink = &busy_;
+  // opened last, so that the bookkeeping above is not counted.
+  if (run_.profile && perf::Available())
+    counters_ = std::make_unique<perf::GroupCounters>();
+}
+
+DBSCAN::metrics::StageScope::~StageScope() {
+  if (dropped_) {
+    DBSCAN::utils::thread_busy_sink = prev_sink_;
+    run_.stages.erase(run_.stages.begin() + index_);
+    return;
+  }
+  auto& stage = run_.stages[index_];
+  if (counters_ != nullptr) stage.counters = counters_->Read();
+  DBSCAN::utils::thread_busy_sink = prev_sink_;
+  stage.wall_seconds = std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - start_)
+                           .count();
+  stage.peak_rss_delta_kb = PeakRssKb() - peak_rss_kb_;
+  stage.thread_busy_seconds =
+      busy_.empty() ? std::vector<double>{stage.wall_seconds} : busy_;
+  auto logger = spdlog::get("console");
+  if (logger == nullptr) return;
+  std::string line;
+  for (const auto& [key, value] : stage.counts)
+    line += fmt::format(" {}={}", key, value);
+  if (stage.thread_busy_seconds.size() > 1)
+    line += fmt::format(" imbalance={:.2f}", stage.imbalance());
+  logger->info("{} takes {} seconds{}", stage.name, stage.wall_seconds, line);
+  if (!stage.counters.any()) return;
+  line.clear();
+  for (uint8_t e = 0; e < perf::kNumEvents; ++e) {
+    if (!stage.counters.valid[e]) continue;
+    line += fmt::format(" {}={}", perf::kEventNames[e],
+                        stage.counters.values[e]);
+  }
+  logger->info("{} counters:{} ipc={:.2f}", stage.name, line,
+               stage.counters.ipc());
+}
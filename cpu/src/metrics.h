@@ -0,0 +1,104 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#ifndef DBSCAN_INCLUDE_METRICS_H_
+#define DBSCAN_INCLUDE_METRICS_H_
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "perf.h"
+
+namespace DBSCAN {
+namespace metrics {
+struct Stage {
+  std::string name;
+  double wall_seconds = 0;
+  // summed over the |run_threads| calls of the stage; a stage that never
+  // calls it reports its wall time on thread 0.
+  std::vector<double> thread_busy_seconds;
+  // growth of the peak resident set size during the stage
+  int64_t peak_rss_delta_kb = 0;
+  // in the order they were recorded, e.g. {"cores", 123}
+  std::vector<std::pair<std::string, uint64_t>> counts;
+  // hardware counters of the calling thread and the threads it started,
+  // serial parts included; none valid unless the run was profiled.
+  perf::Counters counters;
+
+  // Busiest thread over the mean busy time; 1 when perfectly balanced.
+  [[nodiscard]] double imbalance() const;
+  void Count(const std::string&, uint64_t);
+  // 0 if |name| was not counted.
+  [[nodiscard]] uint64_t count(const std::string&) const;
+};
+
+struct Run {
+  uint64_t num_vtx = 0, min_pts = 0;
+  float radius = 0;
+  uint32_t num_threads = 0;
+  // Collect hardware counters too; ignored where |perf::Available| is false.
+  bool profile = false;
+  std::vector<Stage> stages;
+
+  void Clear() { stages.clear(); }
+  // The last stage called |name|, or nullptr.
+  [[nodiscard]] const Stage* Find(const std::string&) const;
+  [[nodiscard]] double wall_seconds() const;
+  /*
+   * {"num_vtx": .., "min_pts": .., "radius": .., "num_threads": ..,
+   *  "wall_seconds": .., "stages": [{"name": .., "wall_seconds": ..,
+   *  "thread_busy_seconds": [..], "imbalance": .., "peak_rss_delta_kb": ..,
+   *  "counts": {..}, "counters": {"cycles": .., ..}}, ..]}
+   * "counters" holds only the events that could be counted; it is left out of
+   * stages that were not profiled.
+   */
+  [[nodiscard]] std::string ToJson() const;
+  void Write(const std::string&) const;
+};
+
+// Peak resident set size of the process so far.
+int64_t PeakRssKb();
+
+/*
+ * Records one stage into a |Run| from construction to destruction: wall time,
+ * peak RSS growth and, through |utils::thread_busy_sink|, the busy time of
+ * every thread that |run_threads| spawns meanwhile. A profiled run also opens
+ * a |perf::GroupCounters| for the whole scope, so the serial parts and every
+ * thread started meanwhile are counted. The stage is logged
+ * on destruction as "<name> takes <seconds> seconds" with its counts and,
+ * when it ran several threads, their imbalance; stages do not time
+ * themselves. A stage that turns out not to have happened, e.g. a cache
+ * that could not be loaded, is |Drop|ped instead.
+ */
+class StageScope {
+ public:
+  StageScope(Run&, std::string);
+  ~StageScope();
+  StageScope(const StageScope&) = delete;
+  StageScope& operator=(const StageScope&) = delete;
+  void Count(const std::string& name, const uint64_t value) {
+    run_.stages[index_].Count(name, value);
+  }
+  // Neither record nor log the stage; the last scope opened only.
+  void Drop() { dropped_ = true; }
+
+ private:
+  Run& run_;
+  size_t index_;
+  bool dropped_ = false;
+  std::chrono::steady_clock::time_point start_;
+  int64_t peak_rss_kb_;
+  std::vector<double> busy_;
+  std::vector<double>* prev_sink_;
+  // only while profiling
+  std::unique_ptr<perf::GroupCounters> counters_;
+};
+}  // namespace metrics
+}  // namespace DBSCAN
+
+#endif  // DBSCAN_INCLUDE_METRICS_H_
@@ -0,0 +1,151 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#include "model.h"
+
+#include <chrono>
+#include <fstream>
+#include <limits>
+
+#include "kernels.h"
+#include "loops.h"
+#include "threads.h"
+
+namespace {
+const char kMagic[8] = {'D', 'B', 'S', 'C', 'A', 'N', 'M', '1'};
+
+DBSCAN::input_type::TwoDimPoints CollectCores(const DBSCAN::Solver& solver) {
+  const auto& dataset = solver.dataset();
+  uint64_t num_cores = 0;
+  for (const auto m : solver.memberships) num_cores += m == DBSCAN::Core;
+  DBSCAN::input_type::TwoDimPoints cores(num_cores);
+  uint64_t i = 0;
+  for (uint64_t vtx = 0; vtx < solver.memberships.size(); ++vtx) {
+    if (solver.memberships[vtx] != DBSCAN::Core) continue;
+    cores.d1[i] = dataset.d1[vtx];
+    cores.d2[i] = dataset.d2[vtx];
+    ++i;
+  }
+  return cores;
+}
+
+std::vector<int> CollectCoreIds(const DBSCAN::Solver& solver) {
+  std::vector<int> ids;
+  for (uint64_t vtx = 0; vtx < solver.memberships.size(); ++vtx) {
+    if (solver.memberships[vtx] == DBSCAN::Core)
+      ids.push_back(solver.cluster_ids[vtx]);
+  }
+  return ids;
+}
+}  // namespace
+
+// ctor
+DBSCAN::FittedModel::FittedModel(const Solver& solver,
+                                 const uint8_t num_threads)
+    : FittedModel(CollectCores(solver), CollectCoreIds(solver),
+                  solver.radius(), num_threads) {}
+
+DBSCAN::FittedModel::FittedModel(DBSCAN::input_type::TwoDimPoints cores,
+                                 std::vector<int> cluster_ids,
+                                 const float radius, const uint8_t num_threads)
+    : radius_(radius),
+      squared_radius_(radius * radius),
+      num_threads_(num_threads),
+      cores_(std::move(cores)),
+      cluster_ids_(std::move(cluster_ids)) {
+  logger_ = spdlog::get("console");
+  if (logger_ == nullptr) {
+    throw std::runtime_error("logger not created!");
+  }
+  if (cores_.d1.size() != cluster_ids_.size()) {
+    throw std::runtime_error("every core needs a cluster id!");
+  }
+  if (cluster_ids_.empty()) return;
+  max_x_ = max_y_ = std::numeric_limits<float>::lowest();
+  min_x_ = min_y_ = std::numeric_limits<float>::max();
+  for (uint64_t i = 0; i < cluster_ids_.size(); ++i) {
+    max_x_ = std::max(max_x_, cores_.d1[i]);
+    min_x_ = std::min(min_x_, cores_.d1[i]);
+    max_y_ = std::max(max_y_, cores_.d2[i]);
+    min_y_ = std::min(min_y_, cores_.d2[i]);
+  }
+  // on top of the usual radius/2 offset, widen the grid by one radius so every
+  // query within reach of a core falls strictly inside it.
+  max_x_ += 1.5f * radius_;
+  min_x_ -= 1.5f * radius_;
+  max_y_ += 1.5f * radius_;
+  min_y_ -= 1.5f * radius_;
+  grid_ = std::make_unique<Grid>(max_x_, max_y_, min_x_, min_y_, radius_,
+                                 cluster_ids_.size(), num_threads_);
+  grid_->Construct(cores_.d1, cores_.d2);
+}
+
+void DBSCAN::FittedModel::Save(const std::string& output) const {
+  std::ofstream ofs(output, std::ios::binary);
+  if (!ofs) throw std::runtime_error("cannot open " + output);
+  const uint64_t n = cluster_ids_.size();
+  ofs.write(kMagic, sizeof(kMagic));
+  ofs.write(reinterpret_cast<const char*>(&n), sizeof(n));
+  ofs.write(reinterpret_cast<const char*>(&radius_), sizeof(radius_));
+  ofs.write(reinterpret_cast<const char*>(cores_.d1.data()), n * sizeof(float));
+  ofs.write(reinterpret_cast<const char*>(cores_.d2.data()), n * sizeof(float));
+  ofs.write(reinterpret_cast<const char*>(cluster_ids_.data()),
+            n * sizeof(int));
+  if (!ofs) throw std::runtime_error("failed to write " + output);
+}
+
+std::unique_ptr<DBSCAN::FittedModel> DBSCAN::FittedModel::Load(
+    const std::string& input, const uint8_t num_threads) {
+  std::ifstream ifs(input, std::ios::binary);
+  if (!ifs) throw std::runtime_error("cannot open " + input);
+  char magic[sizeof(kMagic)];
+  uint64_t n = 0;
+  float radius = 0;
+  ifs.read(magic, sizeof(magic));
+  ifs.read(reinterpret_cast<char*>(&n), sizeof(n));
+  ifs.read(reinterpret_cast<char*>(&radius), sizeof(radius));
+  if (!ifs || !std::equal(magic, magic + sizeof(magic), kMagic)) {
+    throw std::runtime_error(input + " is not a DBSCAN model!");
+  }
+  // check |n| against what is left of the file before allocating for it.
+  const std::streampos body = ifs.tellg();
+  ifs.seekg(0, std::ios::end);
+  const uint64_t remaining = static_cast<uint64_t>(ifs.tellg() - body);
+  ifs.seekg(body);
+  constexpr uint64_t kRowBytes = 2 * sizeof(float) + sizeof(int);
+  if (!ifs || n > remaining / kRowBytes) {
+    throw std::runtime_error(input + " is truncated!");
+  }
+  DBSCAN::input_type::TwoDimPoints cores(n);
+  std::vector<int> cluster_ids(n);
+  ifs.read(reinterpret_cast<char*>(cores.d1.data()), n * sizeof(float));
+  ifs.read(reinterpret_cast<char*>(cores.d2.data()), n * sizeof(float));
+  ifs.read(reinterpret_cast<char*>(cluster_ids.data()), n * sizeof(int));
+  if (!ifs) throw std::runtime_error(input + " is truncated!");
+  return std::make_unique<FittedModel>(std::move(cores), std::move(cluster_ids),
+                                       radius, num_threads);
+}
+
+std::vector<int> DBSCAN::FittedModel::Predict(
+    const DBSCAN::input_type::TwoDimPoints& queries) const {
+  using namespace std::chrono;
+  high_resolution_clock::time_point start = high_resolution_clock::now();
+
+  const uint64_t n = queries.d1.size();
+  std::vector<int> labels(n, -1);
+  if (grid_ == nullptr) return labels;
+  // contiguous ranges so that threads do not share cache lines of |labels|.
+  kernels::Dispatch(kernels::Widest(), [&](auto kernel) {
+    using Loops = loops::Loops<decltype(kernel)::value>;
+    DBSCAN::utils::run_threads(num_threads_, [&](const uint8_t tid) {
+      Loops::Predict(*this, queries, n * tid / num_threads_,
+                     n * (tid + 1) / num_threads_, labels.data());
+    });
+  });
+
+  duration<double> time_spent =
+      duration_cast<duration<double>>(high_resolution_clock::now() - start);
+  logger_->info("Predict {} points takes {} seconds", n, time_spent.count());
+  return labels;
+}
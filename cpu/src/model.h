@@ -0,0 +1,91 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#ifndef DBSCAN_INCLUDE_MODEL_H_
+#define DBSCAN_INCLUDE_MODEL_H_
+
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "dataset.h"
+#include "grid.h"
+#include "kernels.h"
+#include "solver.h"
+#include "spdlog/spdlog.h"
+
+namespace DBSCAN {
+namespace loops {
+template <kernels::Kernel>
+struct Loops;
+}  // namespace loops
+
+/*
+ * A fitted clustering that labels new points without re-running DBSCAN. Only
+ * the Core vertices and their cluster ids are kept, indexed by a |Grid|; a
+ * query joins the cluster of a core vertex within the radius (the smallest
+ * cluster id if there are several, matching how |Solver| assigns Border
+ * vertices) or is Noise (-1).
+ */
+class FittedModel {
+ public:
+  // Keep the Core vertices of a solver that has run |IdentifyClusters|.
+  explicit FittedModel(const Solver&, uint8_t);
+  // Core vertices and their cluster ids.
+  FittedModel(DBSCAN::input_type::TwoDimPoints, std::vector<int>, float,
+              uint8_t);
+  /*
+   * Binary layout: 8-byte magic, uint64 number of cores, float radius, then
+   * the x, y (float) and cluster id (int32) arrays.
+   */
+  void Save(const std::string&) const;
+  static std::unique_ptr<FittedModel> Load(const std::string&, uint8_t);
+  [[nodiscard]] std::vector<int> Predict(
+      const DBSCAN::input_type::TwoDimPoints&) const;
+  [[nodiscard]] uint64_t num_cores() const { return cluster_ids_.size(); }
+  [[nodiscard]] float radius() const { return radius_; }
+
+ private:
+  float radius_, squared_radius_;
+  uint8_t num_threads_;
+  DBSCAN::input_type::TwoDimPoints cores_;
+  std::vector<int> cluster_ids_;
+  float max_x_, max_y_, min_x_, min_y_;
+  std::unique_ptr<Grid> grid_ = nullptr;
+  std::shared_ptr<spdlog::logger> logger_ = nullptr;
+  // no vertex of the model has this id, so GetNeighbouringVtx keeps them all.
+  static constexpr uint64_t kQuery = std::numeric_limits<uint64_t>::max();
+
+  // compiled per kernel in its own TU, see |loops::Loops::Predict|.
+  template <kernels::Kernel>
+  friend struct loops::Loops;
+  // |nbs| is scratch for the grid lookup, reused across the queries of a
+  // thread.
+  template <class Kernel>
+  [[nodiscard]] int PredictOne_(float, float, std::vector<uint64_t>&) const;
+};
+
+template <class Kernel>
+int FittedModel::PredictOne_(const float x, const float y,
+                              std::vector<uint64_t>& nbs) const {
+  // also rejects NaN.
+  if (!(min_x_ < x && x < max_x_ && min_y_ < y && y < max_y_)) return -1;
+  grid_->GetNeighbouringVtx(kQuery, x, y, nbs);
+  int label = -1;
+  const typename Kernel::Probe probe(x, y, squared_radius_);
+  for (uint64_t i = 0; i < nbs.size(); i += Kernel::kLanes) {
+    uint64_t cmp = Kernel::Within(probe, cores_.d1.data(), cores_.d2.data(),
+                                  nbs.data() + i, nbs.size() - i);
+    while (cmp) {
+      const int c = cluster_ids_[nbs[i + __builtin_ctzll(cmp)]];
+      if (label == -1 || c < label) label = c;
+      cmp &= cmp - 1;
+    }
+  }
+  return label;
+}
+}  // namespace DBSCAN
+
+#endif  // DBSCAN_INCLUDE_MODEL_H_
@@ -0,0 +1,69 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#include "numa.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+std::vector<int> DBSCAN::numa::ParseCpuList(const std::string& list) {
+  std::vector<int> cpus;
+  std::istringstream iss(list);
+  std::string range;
+  while (std::getline(iss, range, ',')) {
+    if (range.empty()) continue;
+    const auto dash = range.find('-');
+    const int lo = std::stoi(range.substr(0, dash));
+    const int hi =
+        dash == std::string::npos ? lo : std::stoi(range.substr(dash + 1));
+    for (int cpu = lo; cpu <= hi; ++cpu) cpus.push_back(cpu);
+  }
+  return cpus;
+}
+
+DBSCAN::numa::Topology DBSCAN::numa::Topology::Detect() {
+  const std::string sysfs = "/sys/devices/system/node/";
+  Topology topo;
+  std::ifstream online(sysfs + "online");
+  std::string nodes;
+  if (online && std::getline(online, nodes)) {
+    // node ids may have holes.
+    for (const auto node : ParseCpuList(nodes)) {
+      std::ifstream ifs(sysfs + "node" + std::to_string(node) + "/cpulist");
+      std::string list;
+      if (ifs && std::getline(ifs, list))
+        topo.cpus_of_node.push_back(ParseCpuList(list));
+    }
+  }
+  if (topo.cpus_of_node.empty()) {
+    const int num_cpus = std::max(1u, std::thread::hardware_concurrency());
+    topo.cpus_of_node.emplace_back();
+    for (int cpu = 0; cpu < num_cpus; ++cpu)
+      topo.cpus_of_node.back().push_back(cpu);
+  }
+  return topo;
+}
+
+bool DBSCAN::numa::PinToNode(const Topology& topo, const uint32_t node) {
+  if (node >= topo.num_nodes() || topo.cpus_of_node[node].empty())
+    return false;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (const auto cpu : topo.cpus_of_node[node]) CPU_SET(cpu, &set);
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+DBSCAN::numa::AffinityGuard::AffinityGuard() {
+  CPU_ZERO(&set_);
+  saved_ = pthread_getaffinity_np(pthread_self(), sizeof(set_), &set_) == 0;
+}
+
+DBSCAN::numa::AffinityGuard::~AffinityGuard() {
+  if (saved_) pthread_setaffinity_np(pthread_self(), sizeof(set_), &set_);
+}
@@ -0,0 +1,58 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#ifndef DBSCAN_INCLUDE_NUMA_H_
+#define DBSCAN_INCLUDE_NUMA_H_
+
+#include <sched.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace DBSCAN {
+namespace numa {
+// Parses a sysfs cpu list such as "0-3,8,10-11".
+std::vector<int> ParseCpuList(const std::string&);
+
+/*
+ * CPUs of every NUMA node, read from /sys/devices/system/node. Hosts without
+ * that directory are reported as one node holding every CPU.
+ */
+struct Topology {
+  std::vector<std::vector<int>> cpus_of_node;
+
+  static Topology Detect();
+  [[nodiscard]] uint32_t num_nodes() const { return cpus_of_node.size(); }
+  // Threads are spread over the nodes in consecutive blocks.
+  [[nodiscard]] uint32_t NodeOfThread(const uint8_t tid,
+                                      const uint8_t num_threads) const {
+    return static_cast<uint32_t>(tid) * num_nodes() / num_threads;
+  }
+};
+
+// Restricts the calling thread to the CPUs of |node|. Returns false if the
+// affinity could not be set.
+bool PinToNode(const Topology&, uint32_t);
+
+/*
+ * Saves the affinity of the constructing thread and restores it on
+ * destruction. run_threads runs a single thread on the caller, so a stage
+ * that pins its workers guards the caller with this.
+ */
+class AffinityGuard {
+ public:
+  AffinityGuard();
+  ~AffinityGuard();
+  AffinityGuard(const AffinityGuard&) = delete;
+  AffinityGuard& operator=(const AffinityGuard&) = delete;
+
+ private:
+  cpu_set_t set_;
+  bool saved_;
+};
+}  // namespace numa
+}  // namespace DBSCAN
+
+#endif  // DBSCAN_INCLUDE_NUMA_H_
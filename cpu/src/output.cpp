@@ -0,0 +1,124 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#include "output.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+#include "threads.h"
+
+namespace {
+// vertices formatted by one thread before the chunks are written out.
+constexpr uint64_t kChunkSize = 1u << 18u;
+// "-2147483648 border\n"
+constexpr uint64_t kMaxLine = 19;
+constexpr const char* kNames[] = {"core", "border", "noise"};
+}  // namespace
+
+DBSCAN::output::Format DBSCAN::output::ParseFormat(const std::string& format) {
+  if (format == "text") return Format::Text;
+  if (format == "binary") return Format::Binary;
+  throw std::runtime_error("unknown output format " + format);
+}
+
+void DBSCAN::output::WriteText(
+    std::ostream& os, const std::vector<int>& cluster_ids,
+    const std::vector<DBSCAN::membership>* memberships,
+    const uint8_t num_threads) {
+  const uint64_t num_vtx = cluster_ids.size();
+  if (memberships != nullptr && memberships->size() != num_vtx)
+    throw std::runtime_error("cluster ids and memberships differ in size!");
+  std::vector<std::string> chunks(num_threads);
+  for (uint64_t round = 0; round < num_vtx; round += kChunkSize * num_threads) {
+    DBSCAN::utils::run_threads(num_threads, [&](const uint8_t tid) {
+      const uint64_t begin = std::min(round + tid * kChunkSize, num_vtx);
+      const uint64_t end = std::min(begin + kChunkSize, num_vtx);
+      auto& chunk = chunks[tid];
+      chunk.resize((end - begin) * kMaxLine);
+      char* p = chunk.data();
+      for (uint64_t vtx = begin; vtx < end; ++vtx) {
+        p = std::to_chars(p, p + kMaxLine, cluster_ids[vtx]).ptr;
+        if (memberships != nullptr) {
+          const char* name = kNames[(*memberships)[vtx]];
+          *p++ = ' ';
+          const auto len = std::strlen(name);
+          std::memcpy(p, name, len);
+          p += len;
+        }
+        *p++ = '\n';
+      }
+      chunk.resize(p - chunk.data());
+    });
+    for (const auto& chunk : chunks) os.write(chunk.data(), chunk.size());
+  }
+}
+
+void DBSCAN::output::WriteBinary(
+    std::ostream& os, const std::vector<int>& cluster_ids,
+    const std::vector<DBSCAN::membership>* memberships) {
+  static_assert(sizeof(int) == sizeof(int32_t), "labels are written as int32");
+  if (memberships != nullptr && memberships->size() != cluster_ids.size())
+    throw std::runtime_error("cluster ids and memberships differ in size!");
+  os.write(reinterpret_cast<const char*>(cluster_ids.data()),
+           cluster_ids.size() * sizeof(int32_t));
+  if (memberships != nullptr) {
+    std::vector<uint8_t> column(memberships->cbegin(), memberships->cend());
+    os.write(reinterpret_cast<const char*>(column.data()), column.size());
+  }
+}
+
+void DBSCAN::output::Write(const std::string& path, const Format format,
+                           const std::vector<int>& cluster_ids,
+                           const std::vector<DBSCAN::membership>* memberships,
+                           const uint8_t num_threads) {
+  std::ofstream ofs;
+  if (path != "-") {
+    ofs.open(path, std::ios::binary);
+    if (!ofs) throw std::runtime_error("cannot open " + path);
+  }
+  std::ostream& os = path == "-" ? std::cout : ofs;
+  if (format == Format::Text) {
+    WriteText(os, cluster_ids, memberships, num_threads);
+  } else {
+    WriteBinary(os, cluster_ids, memberships);
+  }
+  os.flush();
+  if (!os) throw std::runtime_error("failed writing " + path);
+}
+
+void DBSCAN::output::WriteRegion(const std::string& path,
+                                 const region::Result& result,
+                                 const bool memberships) {
+  std::ofstream ofs;
+  if (path != "-") {
+    ofs.open(path, std::ios::binary);
+    if (!ofs) throw std::runtime_error("cannot open " + path);
+  }
+  std::ostream& os = path == "-" ? std::cout : ofs;
+  // "18446744073709551615 -9223372036854775808 border\n"
+  constexpr uint64_t kMaxRegionLine = 49;
+  std::string text(result.vertices.size() * kMaxRegionLine, '\0');
+  char* p = text.data();
+  for (uint64_t i = 0; i < result.vertices.size(); ++i) {
+    p = std::to_chars(p, p + kMaxRegionLine, result.vertices[i]).ptr;
+    *p++ = ' ';
+    p = std::to_chars(p, p + kMaxRegionLine, result.clusters[i]).ptr;
+    if (memberships) {
+      const char* name = kNames[result.memberships[i]];
+      *p++ = ' ';
+      const auto len = std::strlen(name);
+      std::memcpy(p, name, len);
+      p += len;
+    }
+    *p++ = '\n';
+  }
+  os.write(text.data(), p - text.data());
+  os.flush();
+  if (!os) throw std::runtime_error("failed writing " + path);
+}
@@ -0,0 +1,50 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#ifndef DBSCAN_INCLUDE_OUTPUT_H_
+#define DBSCAN_INCLUDE_OUTPUT_H_
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "DBSCAN/membership.h"
+#include "region.h"
+
+namespace DBSCAN {
+namespace output {
+enum class Format { Text, Binary };
+// "text" or "binary".
+Format ParseFormat(const std::string&);
+
+/*
+ * One line per vertex: the cluster id, followed by " core", " border" or
+ * " noise" if |memberships| is given. The lines are formatted with to_chars
+ * by |num_threads| threads into per-thread chunks which are then written in
+ * vertex order, so nothing is flushed per line.
+ */
+void WriteText(std::ostream&, const std::vector<int>&,
+               const std::vector<DBSCAN::membership>*, uint8_t);
+/*
+ * The cluster ids as a raw int32 array in host byte order, followed by one
+ * uint8 per vertex (0 core, 1 border, 2 noise) if |memberships| is given.
+ * There is no header: the number of vertices is the one of the input.
+ */
+void WriteBinary(std::ostream&, const std::vector<int>&,
+                 const std::vector<DBSCAN::membership>*);
+/*
+ * One line per vertex of a |Solver::QueryRegion|: the vertex id and the id
+ * of its cluster's lowest core (-1 for noise), followed by the membership
+ * as in |WriteText| if |memberships| is set. Writes to |path| or stdout
+ * like |Write|.
+ */
+void WriteRegion(const std::string&, const region::Result&, bool memberships);
+// Writes to |path|, or to stdout if it is "-".
+void Write(const std::string&, Format, const std::vector<int>&,
+           const std::vector<DBSCAN::membership>*, uint8_t);
+}  // namespace output
+}  // namespace DBSCAN
+
+#endif  // DBSCAN_INCLUDE_OUTPUT_H_
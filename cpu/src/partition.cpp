@@ -0,0 +1,233 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#include "partition.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+
+#include "solver.h"
+
+std::vector<DBSCAN::partition::Part> DBSCAN::partition::KdSplit(
+    const DBSCAN::input_type::TwoDimPoints& dataset, const float radius,
+    const uint32_t num_parts) {
+  if (num_parts == 0) throw std::runtime_error("need at least one part!");
+  const uint64_t num_vtx = dataset.d1.size();
+  float min_x = std::numeric_limits<float>::max(),
+        min_y = std::numeric_limits<float>::max();
+  for (uint64_t vtx = 0; vtx < num_vtx; ++vtx) {
+    min_x = std::min(min_x, dataset.d1[vtx]);
+    min_y = std::min(min_y, dataset.d2[vtx]);
+  }
+  std::vector<int64_t> cols(num_vtx), rows(num_vtx);
+  for (uint64_t vtx = 0; vtx < num_vtx; ++vtx) {
+    cols[vtx] = std::floor((dataset.d1[vtx] - min_x) / radius);
+    rows[vtx] = std::floor((dataset.d2[vtx] - min_y) / radius);
+  }
+
+  std::vector<uint64_t> ids(num_vtx);
+  std::iota(ids.begin(), ids.end(), 0);
+  std::vector<Part> parts;
+  parts.reserve(num_parts);
+  std::function<void(uint64_t, uint64_t, uint32_t)> split =
+      [&](const uint64_t begin, const uint64_t end, const uint32_t k) {
+        if (k == 1) {
+          Part part;
+          part.owned.assign(ids.cbegin() + begin, ids.cbegin() + end);
+          std::sort(part.owned.begin(), part.owned.end());
+          parts.push_back(std::move(part));
+          return;
+        }
+        int64_t col_lo = INT64_MAX, col_hi = INT64_MIN, row_lo = INT64_MAX,
+                row_hi = INT64_MIN;
+        for (uint64_t i = begin; i < end; ++i) {
+          col_lo = std::min(col_lo, cols[ids[i]]);
+          col_hi = std::max(col_hi, cols[ids[i]]);
+          row_lo = std::min(row_lo, rows[ids[i]]);
+          row_hi = std::max(row_hi, rows[ids[i]]);
+        }
+        const auto& axis = col_hi - col_lo >= row_hi - row_lo ? cols : rows;
+        const uint32_t k_left = k / 2;
+        auto mid = ids.begin() + begin + (end - begin) * k_left / k;
+        if (mid != ids.begin() + end) {
+          std::nth_element(ids.begin() + begin, mid, ids.begin() + end,
+                           [&axis](const uint64_t a, const uint64_t b) {
+                             return axis[a] < axis[b];
+                           });
+          // the whole median cell goes right so the cut is a cell border.
+          const int64_t cut = axis[*mid];
+          mid = std::partition(
+              ids.begin() + begin, ids.begin() + end,
+              [&axis, cut](const uint64_t v) { return axis[v] < cut; });
+        }
+        const uint64_t m = std::distance(ids.begin(), mid);
+        split(begin, m, k_left);
+        split(m, end, k - k_left);
+      };
+  split(0, num_vtx, num_parts);
+
+  std::vector<uint32_t> owner(num_vtx);
+  for (uint32_t p = 0; p < num_parts; ++p) {
+    for (const auto vtx : parts[p].owned) owner[vtx] = p;
+  }
+  for (uint32_t p = 0; p < num_parts; ++p) {
+    auto& part = parts[p];
+    if (part.owned.empty()) continue;
+    int64_t col_lo = INT64_MAX, col_hi = INT64_MIN, row_lo = INT64_MAX,
+            row_hi = INT64_MIN;
+    for (const auto vtx : part.owned) {
+      col_lo = std::min(col_lo, cols[vtx]);
+      col_hi = std::max(col_hi, cols[vtx]);
+      row_lo = std::min(row_lo, rows[vtx]);
+      row_hi = std::max(row_hi, rows[vtx]);
+    }
+    // a neighbour of an owned vertex is at most one cell away from it.
+    for (uint64_t vtx = 0; vtx < num_vtx; ++vtx) {
+      if (owner[vtx] != p && col_lo - 1 <= cols[vtx] &&
+          cols[vtx] <= col_hi + 1 && row_lo - 1 <= rows[vtx] &&
+          rows[vtx] <= row_hi + 1)
+        part.halo.push_back(vtx);
+    }
+  }
+  return parts;
+}
+
+DBSCAN::partition::PartResult DBSCAN::partition::ClusterPart(
+    const std::vector<uint64_t>& ids, const uint64_t num_owned,
+    std::unique_ptr<DBSCAN::input_type::TwoDimPoints> points,
+    const uint64_t min_pts, const float radius, const uint8_t num_threads) {
+  if (points == nullptr || points->d1.size() != ids.size() ||
+      num_owned > ids.size())
+    throw std::runtime_error("malformed part!");
+  DBSCAN::Solver solver(std::move(points), min_pts, radius, num_threads);
+  solver.ConstructGrid();
+  solver.InsertEdges();
+  solver.FinalizeGraph();
+  solver.ClassifyNoises();
+  solver.IdentifyClusters();
+
+  const auto& graph = solver.graph();
+  PartResult result;
+  for (const auto id : solver.cluster_ids) {
+    result.num_clusters =
+        std::max<uint64_t>(result.num_clusters, std::max(id + 1, 0));
+  }
+  result.is_core.resize(num_owned);
+  result.local_clusters.resize(num_owned);
+  // one link per (local cluster, halo vertex) is enough to merge.
+  std::vector<std::pair<int32_t, uint64_t>> links;
+  for (uint64_t u = 0; u < num_owned; ++u) {
+    const bool is_core = solver.memberships[u] == DBSCAN::membership::Core;
+    result.is_core[u] = is_core;
+    result.local_clusters[u] = solver.cluster_ids[u];
+    const uint64_t begin = graph.start_pos[u];
+    const uint64_t end = begin + graph.num_nbs[u];
+    for (uint64_t i = begin; i < end; ++i) {
+      const uint64_t v = graph.neighbours[i];
+      if (!is_core) {
+        result.cand_vtx.push_back(ids[u]);
+        result.cand_nbs.push_back(ids[v]);
+      } else if (v >= num_owned) {
+        links.emplace_back(solver.cluster_ids[u], ids[v]);
+      }
+    }
+  }
+  std::sort(links.begin(), links.end());
+  links.erase(std::unique(links.begin(), links.end()), links.end());
+  result.link_clusters.reserve(links.size());
+  result.link_vtx.reserve(links.size());
+  for (const auto& [cluster, vtx] : links) {
+    result.link_clusters.push_back(cluster);
+    result.link_vtx.push_back(vtx);
+  }
+  return result;
+}
+
+// ctor
+DBSCAN::partition::Merger::Merger(const uint64_t num_vtx)
+    : comp_of_(num_vtx, kNotCore) {}
+
+uint64_t DBSCAN::partition::Merger::AddPart(const uint64_t num_clusters) {
+  const uint64_t first = parent_.size();
+  parent_.resize(first + num_clusters);
+  std::iota(parent_.begin() + first, parent_.end(), first);
+  return first;
+}
+
+void DBSCAN::partition::Merger::SetCore(const uint64_t vtx,
+                                        const uint64_t comp) {
+  if (vtx >= comp_of_.size() || comp >= parent_.size()) {
+    std::ostringstream oss;
+    oss << "vtx=" << vtx << " or comp=" << comp << " is out of bound!";
+    throw std::runtime_error(oss.str());
+  }
+  comp_of_[vtx] = comp;
+}
+
+void DBSCAN::partition::Merger::Link(const uint64_t comp, const uint64_t vtx) {
+  links_.emplace_back(comp, vtx);
+}
+
+void DBSCAN::partition::Merger::AddBorderCandidate(const uint64_t vtx,
+                                                   const uint64_t nb) {
+  candidates_.emplace_back(vtx, nb);
+}
+
+void DBSCAN::partition::Merger::Add(const std::vector<uint64_t>& owned,
+                                    const PartResult& result) {
+  if (result.is_core.size() != owned.size() ||
+      result.local_clusters.size() != owned.size() ||
+      result.link_clusters.size() != result.link_vtx.size() ||
+      result.cand_vtx.size() != result.cand_nbs.size())
+    throw std::runtime_error("malformed part result!");
+  const uint64_t first = AddPart(result.num_clusters);
+  for (uint64_t i = 0; i < owned.size(); ++i) {
+    if (result.is_core[i]) SetCore(owned[i], first + result.local_clusters[i]);
+  }
+  for (uint64_t i = 0; i < result.link_vtx.size(); ++i)
+    Link(first + result.link_clusters[i], result.link_vtx[i]);
+  for (uint64_t i = 0; i < result.cand_vtx.size(); ++i)
+    AddBorderCandidate(result.cand_vtx[i], result.cand_nbs[i]);
+}
+
+void DBSCAN::partition::Merger::Finish(
+    std::vector<int>& cluster_ids,
+    std::vector<DBSCAN::membership>& memberships) {
+  for (const auto& [comp, vtx] : links_) {
+    if (comp_of_[vtx] == kNotCore) continue;
+    const uint64_t a = Find_(comp), b = Find_(comp_of_[vtx]);
+    if (a != b) parent_[std::max(a, b)] = std::min(a, b);
+  }
+  const uint64_t num_vtx = comp_of_.size();
+  cluster_ids.assign(num_vtx, -1);
+  memberships.assign(num_vtx, DBSCAN::membership::Noise);
+  std::vector<int> dense(parent_.size(), -1);
+  int num_clusters = 0;
+  for (uint64_t vtx = 0; vtx < num_vtx; ++vtx) {
+    if (comp_of_[vtx] == kNotCore) continue;
+    int& id = dense[Find_(comp_of_[vtx])];
+    if (id == -1) id = num_clusters++;
+    cluster_ids[vtx] = id;
+    memberships[vtx] = DBSCAN::membership::Core;
+  }
+  for (const auto& [vtx, nb] : candidates_) {
+    if (comp_of_[vtx] != kNotCore || comp_of_[nb] == kNotCore) continue;
+    if (cluster_ids[vtx] == -1 || cluster_ids[nb] < cluster_ids[vtx])
+      cluster_ids[vtx] = cluster_ids[nb];
+    memberships[vtx] = DBSCAN::membership::Border;
+  }
+}
+
+uint64_t DBSCAN::partition::Merger::Find_(uint64_t c) {
+  // path halving
+  while (parent_[c] != c) {
+    parent_[c] = parent_[parent_[c]];
+    c = parent_[c];
+  }
+  return c;
+}
@@ -0,0 +1,100 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#ifndef DBSCAN_INCLUDE_PARTITION_H_
+#define DBSCAN_INCLUDE_PARTITION_H_
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "DBSCAN/membership.h"
+#include "dataset.h"
+
+namespace DBSCAN {
+namespace partition {
+/*
+ * The vertices owned by a spatial part, ascending, and its halo: the vertices
+ * owned by other parts in the ring of cells around the part, i.e. everything
+ * that can be within the radius of an owned vertex.
+ */
+struct Part {
+  std::vector<uint64_t> owned, halo;
+};
+
+/*
+ * Splits the |radius| x |radius| cells of |dataset| into |num_parts| parts
+ * with a k-d split: each step cuts the longer side of a part at the median
+ * cell coordinate of its vertices, so parts own about the same number of
+ * vertices and every cut falls on a cell border.
+ */
+std::vector<Part> KdSplit(const DBSCAN::input_type::TwoDimPoints&, float,
+                          uint32_t);
+
+/*
+ * What clustering one part yields for |Merger|, indexed like the owned
+ * vertices of the part unless noted.
+ */
+struct PartResult {
+  uint64_t num_clusters = 0;
+  std::vector<uint8_t> is_core;
+  std::vector<int32_t> local_clusters;
+  // pairs (local cluster, halo vertex): one per cluster touching the vertex.
+  std::vector<int32_t> link_clusters;
+  std::vector<uint64_t> link_vtx;
+  // pairs (non-core owned vertex, neighbour), as global ids.
+  std::vector<uint64_t> cand_vtx, cand_nbs;
+};
+
+/*
+ * Runs the CPU pipeline on one part. |points| holds the coordinates of
+ * |ids|, the owned vertices first (|num_owned| of them) and then the halo.
+ */
+PartResult ClusterPart(const std::vector<uint64_t>& ids, uint64_t num_owned,
+                       std::unique_ptr<DBSCAN::input_type::TwoDimPoints>,
+                       uint64_t, float, uint8_t);
+
+/*
+ * Stitches clusters computed independently on spatial parts into global
+ * clusters. For the vertices it owns, a part reports whether they are Core
+ * and their local cluster; it also reports which of its local clusters touch
+ * a vertex owned elsewhere, and the neighbours of its non-core vertices.
+ *
+ * Local clusters are merged with a union-find over all parts' local clusters.
+ * The global numbering then matches |Solver| with one thread: clusters are
+ * ordered by their smallest core vertex and a Border vertex goes to the
+ * smallest adjacent cluster.
+ */
+class Merger {
+ public:
+  explicit Merger(uint64_t);
+  // Reserves ids for the |num_clusters| local clusters of a part and returns
+  // the id of its local cluster 0.
+  uint64_t AddPart(uint64_t);
+  // |vtx| is Core and in cluster |comp|, an id handed out by |AddPart|.
+  void SetCore(uint64_t vtx, uint64_t comp);
+  // A core vertex of |comp| is within the radius of |vtx|; the clusters are
+  // merged if |vtx| turns out to be Core.
+  void Link(uint64_t comp, uint64_t vtx);
+  // Non-core |vtx| is within the radius of |nb|.
+  void AddBorderCandidate(uint64_t vtx, uint64_t nb);
+  // All of the above for a part owning |owned|.
+  void Add(const std::vector<uint64_t>& owned, const PartResult&);
+  void Finish(std::vector<int>&, std::vector<DBSCAN::membership>&);
+
+ private:
+  static constexpr uint64_t kNotCore = std::numeric_limits<uint64_t>::max();
+  // cluster of each core vertex, |kNotCore| otherwise.
+  std::vector<uint64_t> comp_of_;
+  std::vector<uint64_t> parent_;
+  std::vector<std::pair<uint64_t, uint64_t>> links_, candidates_;
+
+  uint64_t Find_(uint64_t);
+};
+}  // namespace partition
+}  // namespace DBSCAN
+
+#endif  // DBSCAN_INCLUDE_PARTITION_H_
@@ -0,0 +1,126 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#include "perf.h"
+
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <vector>
+
+namespace {
+struct EventConfig {
+  uint32_t type;
+  uint64_t config;
+};
+
+constexpr uint64_t CacheMiss_(const uint64_t cache) {
+  return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8u) |
+         (PERF_COUNT_HW_CACHE_RESULT_MISS << 16u);
+}
+
+// in |perf::Event| order
+constexpr EventConfig kConfigs[DBSCAN::perf::kNumEvents] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HW_CACHE, CacheMiss_(PERF_COUNT_HW_CACHE_L1D)},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {PERF_TYPE_HW_CACHE, CacheMiss_(PERF_COUNT_HW_CACHE_DTLB)}};
+
+// Opens |event| for the calling thread on any cpu, in the group of
+// |group_fd| unless that is -1.
+int Open_(const EventConfig& event, const int group_fd) {
+  perf_event_attr attr{};
+  attr.size = sizeof(attr);
+  attr.type = event.type;
+  attr.config = event.config;
+  // allowed up to perf_event_paranoid == 2
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  // threads started later count into this group as well.
+  attr.inherit = 1;
+  attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                     PERF_FORMAT_TOTAL_TIME_RUNNING;
+  return static_cast<int>(
+      syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0));
+}
+}  // namespace
+
+const char* const DBSCAN::perf::kEventNames[kNumEvents] = {
+    "cycles",     "instructions",  "l1d_misses",
+    "llc_misses", "branch_misses", "dtlb_misses"};
+
+DBSCAN::perf::Counters& DBSCAN::perf::Counters::operator+=(
+    const Counters& other) {
+  for (uint8_t e = 0; e < kNumEvents; ++e) {
+    values[e] += other.values[e];
+    valid[e] = valid[e] || other.valid[e];
+  }
+  return *this;
+}
+
+bool DBSCAN::perf::Counters::any() const {
+  for (const bool v : valid) {
+    if (v) return true;
+  }
+  return false;
+}
+
+double DBSCAN::perf::Counters::ipc() const {
+  if (!valid[kCycles] || !valid[kInstructions] || values[kCycles] == 0)
+    return 0;
+  return static_cast<double>(values[kInstructions]) / values[kCycles];
+}
+
+DBSCAN::perf::GroupCounters::GroupCounters() {
+  for (uint8_t e = 0; e < kNumEvents; ++e) {
+    const int fd = Open_(kConfigs[e], fds_.empty() ? -1 : fds_.front());
+    if (fd < 0) continue;
+    fds_.push_back(fd);
+    events_.push_back(static_cast<Event>(e));
+  }
+}
+
+DBSCAN::perf::GroupCounters::~GroupCounters() {
+  // members before the leader
+  for (auto it = fds_.crbegin(); it != fds_.crend(); ++it) close(*it);
+}
+
+DBSCAN::perf::Counters DBSCAN::perf::GroupCounters::Read() const {
+  Counters counters;
+  if (fds_.empty()) return counters;
+  // number of members, time enabled, time running, then one value each
+  std::vector<uint64_t> buf(3 + fds_.size());
+  const auto bytes = static_cast<ssize_t>(buf.size() * sizeof(uint64_t));
+  if (read(fds_.front(), buf.data(), bytes) != bytes) return counters;
+  const uint64_t enabled = buf[1], running = buf[2];
+  // never scheduled on the PMU
+  if (buf[0] != fds_.size() || running == 0) return counters;
+  for (size_t i = 0; i < events_.size(); ++i) {
+    const uint64_t value = buf[3 + i];
+    counters.values[events_[i]] =
+        running < enabled
+            ? static_cast<uint64_t>(static_cast<double>(value) * enabled /
+                                    running)
+            : value;
+    counters.valid[events_[i]] = true;
+  }
+  return counters;
+}
+
+bool DBSCAN::perf::Available() {
+  static const bool available = [] {
+    for (const auto& config : kConfigs) {
+      const int fd = Open_(config, -1);
+      if (fd >= 0) {
+        close(fd);
+        return true;
+      }
+    }
+    return false;
+  }();
+  return available;
+}
@@ -0,0 +1,65 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#ifndef DBSCAN_INCLUDE_PERF_H_
+#define DBSCAN_INCLUDE_PERF_H_
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace DBSCAN {
+namespace perf {
+enum Event : uint8_t {
+  kCycles,
+  kInstructions,
+  kL1dMisses,
+  kLlcMisses,
+  kBranchMisses,
+  kDtlbMisses,
+  kNumEvents
+};
+// "cycles", "instructions", "l1d_misses", ...
+extern const char* const kEventNames[kNumEvents];
+
+struct Counters {
+  std::array<uint64_t, kNumEvents> values{};
+  // false for events the kernel or the hardware would not count.
+  std::array<bool, kNumEvents> valid{};
+
+  Counters& operator+=(const Counters&);
+  [[nodiscard]] bool any() const;
+  // instructions per cycle; 0 if either is unknown.
+  [[nodiscard]] double ipc() const;
+};
+
+/*
+ * perf_event_open counters of the calling thread and of every thread it starts
+ * while they are open, user space only, from construction to |Read|. The
+ * events form one group, so the PMU schedules them together and |Read| takes
+ * them in a single PERF_FORMAT_GROUP read; a multiplexed group is scaled up by
+ * its one enabled/running ratio. Events that cannot be opened are left out of
+ * the group.
+ */
+class GroupCounters {
+ public:
+  GroupCounters();
+  ~GroupCounters();
+  GroupCounters(const GroupCounters&) = delete;
+  GroupCounters& operator=(const GroupCounters&) = delete;
+  [[nodiscard]] Counters Read() const;
+
+ private:
+  // members in the order they joined; the first one leads.
+  std::vector<int> fds_;
+  std::vector<Event> events_;
+};
+
+// Whether this process may count at least one event; probed once. Containers,
+// VMs without a virtual PMU and perf_event_paranoid > 2 usually say no.
+bool Available();
+}  // namespace perf
+}  // namespace DBSCAN
+
+#endif  // DBSCAN_INCLUDE_PERF_H_
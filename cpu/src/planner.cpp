@@ -0,0 +1,182 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#include "planner.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+uint64_t DBSCAN::planner::Estimate::Bytes(const Adjacency adjacency) const {
+  switch (adjacency) {
+    case Adjacency::Bitmap:
+      return grid_bytes + graph_bytes + bitmap_bytes;
+    case Adjacency::Csr:
+      return grid_bytes + graph_bytes + csr_bytes;
+    case Adjacency::BlockedBitmap:
+      return grid_bytes + graph_bytes + blocked_bytes;
+    case Adjacency::Implicit:
+      return grid_bytes;
+  }
+  return 0;
+}
+
+DBSCAN::planner::Estimate DBSCAN::planner::EstimateCosts(
+    const Grid& grid, const input_type::TwoDimPoints& points,
+    const uint64_t max_cells, const uint64_t max_tests) {
+  const uint64_t num_vtx = points.d1.size();
+  const auto& sizes = grid.cell_sizes();
+  const uint64_t cols = grid.num_cols();
+  std::vector<uint64_t> non_empty;
+  for (uint64_t cell = 0; cell < sizes.size(); ++cell) {
+    if (sizes[cell] != 0) non_empty.push_back(cell);
+  }
+  const uint64_t sample = std::max<uint64_t>(1, max_cells);
+  const uint64_t stride =
+      std::max<uint64_t>(1, (non_empty.size() + sample - 1) / sample);
+  // the first/last row and col are always empty, so every non-empty cell has
+  // all of its 3x3 block inside the grid.
+  double sampled_vtx = 0, sampled_candidates = 0;
+  for (uint64_t i = 0; i < non_empty.size(); i += stride) {
+    const uint64_t cell = non_empty[i];
+    uint64_t block = 0;
+    for (const uint64_t row : {cell - cols, cell, cell + cols})
+      block += sizes[row - 1] + sizes[row] + sizes[row + 1];
+    sampled_vtx += sizes[cell];
+    // a vertex is not its own candidate.
+    sampled_candidates += static_cast<double>(sizes[cell]) * (block - 1);
+  }
+
+  Estimate estimate;
+  if (sampled_vtx > 0) {
+    const double candidates_per_vtx = sampled_candidates / sampled_vtx;
+    estimate.num_candidates = std::llround(candidates_per_vtx * num_vtx);
+    const uint64_t num_samples = std::clamp<uint64_t>(
+        max_tests / std::max(1.0, candidates_per_vtx), 1, num_vtx);
+    const auto& order = grid.vertices_in_cell_order();
+    const float squared_radius = grid.radius() * grid.radius();
+    const auto dist = input_type::TwoDimPoints::euclidean_distance_square;
+    uint64_t sampled_nbs = 0;
+    for (uint64_t i = 0; i < num_samples; ++i) {
+      const uint64_t u = i * num_vtx / num_samples;
+      const float ux = points.d1[u], uy = points.d2[u];
+      for (const auto& [begin, end] : grid.GetNeighbouringRanges(ux, uy)) {
+        for (uint64_t p = begin; p < end; ++p) {
+          const uint64_t v = order[p];
+          sampled_nbs += v != u && dist(ux, uy, points.d1[v], points.d2[v]) <=
+                                       squared_radius;
+        }
+      }
+    }
+    estimate.avg_degree = static_cast<double>(sampled_nbs) / num_samples;
+    estimate.num_edges = std::llround(estimate.avg_degree * num_vtx);
+  }
+  // cell counters and start positions, plus the vertices in cell order.
+  estimate.grid_bytes = 2 * sizes.size() * sizeof(uint64_t) +
+                        num_vtx * sizeof(uint64_t);
+  // one vector per vertex; a list is assigned its neighbours only, see
+  // |Graph::InsertEdges|.
+  const uint64_t rows = num_vtx * sizeof(std::vector<uint64_t>);
+  estimate.bitmap_bytes =
+      rows + num_vtx * ((num_vtx + 63) / 64) * sizeof(uint64_t);
+  estimate.csr_bytes = rows + estimate.num_edges * sizeof(uint64_t);
+  // each of the 3 runs of candidates adds at most 2 partial words; the
+  // coordinates are copied in cell order.
+  estimate.blocked_bytes =
+      rows + num_vtx * sizeof(Graph::WordSpans) +
+      (estimate.num_candidates / 64 + 6 * num_vtx) * sizeof(uint64_t) +
+      2 * num_vtx * sizeof(float);
+  estimate.graph_bytes = (2 * num_vtx + estimate.num_edges) * sizeof(uint64_t);
+  return estimate;
+}
+
+DBSCAN::planner::Plan DBSCAN::planner::Choose(const Estimate& estimate,
+                                              const uint64_t num_vtx,
+                                              const uint64_t memory_limit) {
+  Plan plan;
+  plan.estimate = estimate;
+  plan.kernel = kernels::Widest();
+  const double candidates =
+      num_vtx == 0 ? 0 : static_cast<double>(estimate.num_candidates) / num_vtx;
+  std::array<Adjacency, 3> ranked;
+  if (candidates * 2 > num_vtx && estimate.avg_degree * 64 > num_vtx) {
+    ranked = {Adjacency::Bitmap, Adjacency::BlockedBitmap, Adjacency::Csr};
+  } else if (candidates >= 64) {
+    ranked = {Adjacency::BlockedBitmap, Adjacency::Csr, Adjacency::Bitmap};
+  } else {
+    ranked = {Adjacency::Csr, Adjacency::BlockedBitmap, Adjacency::Bitmap};
+  }
+  plan.adjacency = ranked.front();
+  for (const auto adjacency : ranked) {
+    if (memory_limit == 0 || estimate.Bytes(adjacency) <= memory_limit) {
+      plan.adjacency = adjacency;
+      return plan;
+    }
+  }
+  plan.adjacency = Adjacency::Implicit;
+  return plan;
+}
+
+std::string DBSCAN::planner::ToString(const Adjacency adjacency) {
+  switch (adjacency) {
+    case Adjacency::Bitmap:
+      return "bitmap";
+    case Adjacency::Csr:
+      return "csr";
+    case Adjacency::BlockedBitmap:
+      return "blocked";
+    case Adjacency::Implicit:
+      return "implicit";
+  }
+  return "";
+}
+
+DBSCAN::Adjacency DBSCAN::planner::ParseAdjacency(const std::string& name) {
+  if (name == "bitmap") return Adjacency::Bitmap;
+  if (name == "csr") return Adjacency::Csr;
+  if (name == "blocked") return Adjacency::BlockedBitmap;
+  if (name == "implicit") return Adjacency::Implicit;
+  throw std::runtime_error("unknown adjacency " + name);
+}
+
+std::string DBSCAN::planner::ToString(const kernels::Kernel kernel) {
+  switch (kernel) {
+    case kernels::Kernel::Scalar:
+      return "scalar";
+    case kernels::Kernel::Avx:
+      return "avx";
+    case kernels::Kernel::Avx512:
+      return "avx512";
+  }
+  return "";
+}
+
+DBSCAN::kernels::Kernel DBSCAN::planner::ParseKernel(const std::string& name) {
+  if (name == "avx512") return kernels::Kernel::Avx512;
+  if (name == "avx") return kernels::Kernel::Avx;
+  if (name == "scalar") return kernels::Kernel::Scalar;
+  throw std::runtime_error("unknown kernel " + name);
+}
+
+std::string DBSCAN::planner::ToString(const Index index) {
+  return index == Index::KdTree ? "kdtree" : "grid";
+}
+
+DBSCAN::Index DBSCAN::planner::ParseIndex(const std::string& name) {
+  if (name == "grid") return Index::Grid;
+  if (name == "kdtree") return Index::KdTree;
+  throw std::runtime_error("unknown index " + name);
+}
+
+std::string DBSCAN::planner::ToString(const Labeller labeller) {
+  return labeller == Labeller::UnionFind ? "union-find" : "bfs";
+}
+
+DBSCAN::Labeller DBSCAN::planner::ParseLabeller(const std::string& name) {
+  if (name == "bfs") return Labeller::Bfs;
+  if (name == "union-find") return Labeller::UnionFind;
+  throw std::runtime_error("unknown labeller " + name);
+}
@@ -0,0 +1,98 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#ifndef DBSCAN_INCLUDE_PLANNER_H_
+#define DBSCAN_INCLUDE_PLANNER_H_
+
+#include <cstdint>
+#include <string>
+
+#include "dataset.h"
+#include "graph.h"
+#include "grid.h"
+#include "kdtree.h"
+#include "kernels.h"
+
+namespace DBSCAN {
+// How IdentifyClusters labels the finalized graph.
+enum class Labeller : uint8_t {
+  // one BFS per cluster, level by level across the threads.
+  Bfs,
+  // a concurrent union-find over the core-core edges, then one pass over
+  // the vertices; the same labels as the BFS.
+  UnionFind
+};
+
+namespace planner {
+// cells whose sizes are sampled for the candidate estimate.
+constexpr uint64_t kSampleCells = 1u << 14u;
+// distance tests spent on the sampled degree estimate, about.
+constexpr uint64_t kSampleTests = 1u << 22u;
+
+struct Estimate {
+  double avg_degree = 0;
+  uint64_t num_candidates = 0, num_edges = 0;
+  // bytes held by the grid, by each adjacency until Finalize, and by the
+  // finalized graph (num_nbs, start_pos and neighbours).
+  uint64_t grid_bytes = 0, bitmap_bytes = 0, csr_bytes = 0, blocked_bytes = 0,
+           graph_bytes = 0;
+
+  // Peak of a run: the grid, the adjacency and the graph it is finalized to
+  // are all alive during FinalizeGraph; only the grid for the implicit store.
+  [[nodiscard]] uint64_t Bytes(Adjacency) const;
+};
+
+struct Plan {
+  Adjacency adjacency = kDefaultAdjacency;
+  kernels::Kernel kernel = kernels::Widest();
+  // all zero unless the plan came from |Choose|.
+  Estimate estimate;
+  // only used by the adjacency lists; |Choose| keeps the grid.
+  Index index = Index::Grid;
+  // |Choose| keeps the BFS.
+  Labeller labeller = Labeller::Bfs;
+};
+
+/*
+ * Estimate the costs from a constructed grid of |points|. The candidates of a
+ * vertex are the vertices of the 3x3 cells around its own; at most
+ * |max_cells| non-empty cells are sampled, evenly spread over the grid. The
+ * degree is counted exactly, with the Euclidean distance, for vertices
+ * sampled evenly over the input, as many as |max_tests| distance tests allow
+ * at the average candidate count. A fixed fraction of the candidates, as a
+ * uniform density would give, underestimates clustered data.
+ */
+Estimate EstimateCosts(const Grid&, const input_type::TwoDimPoints& points,
+                       uint64_t max_cells = kSampleCells,
+                       uint64_t max_tests = kSampleTests);
+
+/*
+ * Ranks the adjacencies by speed and takes the first that fits |memory_limit|
+ * bytes (0 for no limit), else the implicit store, which keeps no edges and
+ * searches the grid again in each label stage instead. The full bitmap tests
+ * all N^2 pairs without branching on candidates, which only pays off when the
+ * grid prunes little: the candidates of a vertex are over N/2 and it averages
+ * more than N/64 neighbours, an edge per bitmap word. Otherwise the blocked
+ * bitmap comes first once the candidates fill a word (>= 64), as it sets bits
+ * where the lists push back ids; below that its partial words cost more than
+ * the lists. The widest kernel the CPU has is used.
+ */
+Plan Choose(const Estimate&, uint64_t num_vtx, uint64_t memory_limit);
+
+// "bitmap"/"csr"/"blocked"/"implicit" and back; throws on anything else.
+std::string ToString(Adjacency);
+Adjacency ParseAdjacency(const std::string&);
+// "scalar"/"avx"/"avx512" and back; throws on anything else.
+std::string ToString(kernels::Kernel);
+kernels::Kernel ParseKernel(const std::string&);
+// "grid"/"kdtree" and back; throws on anything else.
+std::string ToString(Index);
+Index ParseIndex(const std::string&);
+// "bfs"/"union-find" and back; throws on anything else.
+std::string ToString(Labeller);
+Labeller ParseLabeller(const std::string&);
+}  // namespace planner
+}  // namespace DBSCAN
+
+#endif  // DBSCAN_INCLUDE_PLANNER_H_
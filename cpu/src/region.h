@@ -0,0 +1,40 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#ifndef DBSCAN_INCLUDE_REGION_H_
+#define DBSCAN_INCLUDE_REGION_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "DBSCAN/membership.h"
+
+namespace DBSCAN {
+namespace region {
+// Closed on every side.
+struct Box {
+  float min_x, min_y, max_x, max_y;
+  [[nodiscard]] bool Contains(const float x, const float y) const {
+    return min_x <= x && x <= max_x && min_y <= y && y <= max_y;
+  }
+};
+
+struct Result {
+  // the vertices inside the box, ascending.
+  std::vector<uint64_t> vertices;
+  /*
+   * The lowest core vertex of each one's cluster, -1 for noise. A full run
+   * numbers its clusters in the order of exactly these vertices, so the
+   * clusters, their order and |memberships| are those of the full run.
+   */
+  std::vector<int64_t> clusters;
+  std::vector<DBSCAN::membership> memberships;
+  // vertices whose eps-neighbourhood was searched: the box, its eps-halo and
+  // the cores of the clusters that reach into the box.
+  uint64_t num_visited = 0;
+};
+}  // namespace region
+}  // namespace DBSCAN
+
+#endif  // DBSCAN_INCLUDE_REGION_H_
@@ -0,0 +1,371 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#include "server.h"
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "spdlog/spdlog.h"
+
+namespace {
+sockaddr_un Address_(const std::string& path) {
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr.sun_path))
+    throw std::runtime_error("socket path too long: " + path);
+  std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+  return addr;
+}
+
+void PutQuery_(DBSCAN::transport::Message& msg,
+               const DBSCAN::server::Query& query) {
+  msg.Put(query.dataset);
+  msg.Put(query.eps);
+  msg.Put(query.min_pts);
+  msg.Put<uint8_t>(query.has_region);
+  msg.Put(query.box);
+}
+
+DBSCAN::server::Query GetQuery_(DBSCAN::transport::Message& msg) {
+  DBSCAN::server::Query query;
+  query.dataset = msg.GetString();
+  query.eps = msg.Get<float>();
+  query.min_pts = msg.Get<uint64_t>();
+  query.has_region = msg.Get<uint8_t>();
+  query.box = msg.Get<DBSCAN::region::Box>();
+  return query;
+}
+}  // namespace
+
+DBSCAN::server::Server::Server(const uint32_t num_workers,
+                               const uint8_t num_threads,
+                               const uint64_t cache_entries,
+                               const bool keep_graphs,
+                               const uint32_t solvers_per_dataset,
+                               const uint32_t idle_timeout_ms)
+    : num_workers_(num_workers),
+      num_threads_(num_threads),
+      cache_entries_(cache_entries),
+      keep_graphs_(keep_graphs),
+      solvers_per_dataset_(solvers_per_dataset),
+      idle_timeout_ms_(idle_timeout_ms) {
+  if (num_workers_ == 0 || num_threads_ == 0)
+    throw std::runtime_error("a server needs workers and threads!");
+  if (solvers_per_dataset_ == 0)
+    throw std::runtime_error("a server needs a solver per dataset!");
+}
+
+void DBSCAN::server::Server::Serve(const std::string& path) {
+  const sockaddr_un addr = Address_(path);
+  const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) throw std::runtime_error("socket failed!");
+  unlink(path.c_str());
+  if (bind(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0 ||
+      listen(fd, SOMAXCONN) != 0) {
+    close(fd);
+    throw std::runtime_error("cannot listen on " + path);
+  }
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    listen_fd_ = fd;
+    stopping_ = shutdown_requested_ = false;
+  }
+  std::vector<std::thread> workers;
+  for (uint32_t w = 0; w < num_workers_; ++w)
+    workers.emplace_back(&Server::Work_, this);
+  if (auto logger = spdlog::get("console"))
+    logger->info("serving on {} with {} workers", path, num_workers_);
+
+  while (true) {
+    const int conn = accept(fd, nullptr, nullptr);
+    const int error = errno;
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    // a Shutdown request shuts the socket down, which fails the accept.
+    if (stopping_) {
+      if (conn >= 0) close(conn);
+      break;
+    }
+    if (conn < 0) {
+      lock.unlock();
+      if (error == EINTR) continue;
+      // e.g. out of descriptors or an aborted connection: clients that
+      // hang up free them again.
+      if (auto logger = spdlog::get("console"))
+        logger->warn("accept failed: {}; retrying", std::strerror(error));
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      continue;
+    }
+    if (idle_timeout_ms_ > 0) {
+      // a read or write that waits this long fails and hangs up.
+      timeval timeout{};
+      timeout.tv_sec = idle_timeout_ms_ / 1000;
+      timeout.tv_usec = idle_timeout_ms_ % 1000 * 1000;
+      setsockopt(conn, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+      setsockopt(conn, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    }
+    connections_.push(conn);
+    queue_cv_.notify_one();
+  }
+  queue_cv_.notify_all();
+  for (auto& worker : workers) worker.join();
+  std::lock_guard<std::mutex> lock(queue_mutex_);
+  for (; !connections_.empty(); connections_.pop())
+    close(connections_.front());
+  close(fd);
+  listen_fd_ = -1;
+  unlink(path.c_str());
+}
+
+void DBSCAN::server::Server::Work_() {
+  while (true) {
+    int conn;
+    {
+      std::unique_lock<std::mutex> lock(queue_mutex_);
+      queue_cv_.wait(lock,
+                     [this] { return stopping_ || !connections_.empty(); });
+      if (stopping_) return;
+      conn = connections_.front();
+      connections_.pop();
+      active_.insert(conn);
+    }
+    bool stop = false;
+    {
+      transport::SocketChannel channel(conn, kMaxRequestBytes);
+      // one request after another until the client hangs up or idles.
+      try {
+        while (!stop) {
+          auto request = channel.Receive();
+          channel.Send(Handle(request));
+          std::lock_guard<std::mutex> lock(queue_mutex_);
+          stop = shutdown_requested_;
+        }
+      } catch (const std::exception&) {
+        // a client that hangs up, idles or sends garbage loses its
+        // connection, never the server.
+      }
+      // before the channel closes it, so that Stop_ never sees a reused fd.
+      std::lock_guard<std::mutex> lock(queue_mutex_);
+      active_.erase(conn);
+    }
+    // only now that the Shutdown reply is out.
+    if (stop) Stop_();
+  }
+}
+
+void DBSCAN::server::Server::Stop_() {
+  std::lock_guard<std::mutex> lock(queue_mutex_);
+  stopping_ = true;
+  if (listen_fd_ >= 0) shutdown(listen_fd_, SHUT_RDWR);
+  // wakes the workers waiting on a client.
+  for (const int conn : active_) shutdown(conn, SHUT_RDWR);
+  queue_cv_.notify_all();
+}
+
+DBSCAN::transport::Message DBSCAN::server::Server::Handle(
+    transport::Message& request) {
+  transport::Message reply;
+  try {
+    const auto op = request.Get<Op>();
+    transport::Message payload;
+    if (op == Op::Load) {
+      const auto name = request.GetString();
+      payload.Put(Load_(name, request.GetString()));
+    } else if (op == Op::Cluster) {
+      const auto result = Cluster_(GetQuery_(request));
+      payload.Put<uint8_t>(result.cached);
+      payload.Put(result.labels.vertices);
+      payload.Put(result.labels.clusters);
+      payload.Put(result.labels.memberships);
+      payload.Put(result.labels.num_visited);
+    } else if (op == Op::Shutdown) {
+      std::lock_guard<std::mutex> lock(queue_mutex_);
+      shutdown_requested_ = true;
+    } else {
+      throw std::runtime_error("unknown request");
+    }
+    reply.Put<uint8_t>(0);
+    reply.bytes.insert(reply.bytes.end(), payload.bytes.cbegin(),
+                       payload.bytes.cend());
+  } catch (const std::exception& e) {
+    reply = transport::Message();
+    reply.Put<uint8_t>(1);
+    reply.Put(std::string(e.what()));
+  }
+  return reply;
+}
+
+uint64_t DBSCAN::server::Server::Load_(const std::string& name,
+                                       const std::string& path) {
+  // parsed outside the lock; the requests on other datasets carry on.
+  std::shared_ptr<const input_type::TwoDimPoints> points =
+      input_type::TwoDimPoints::Read(path);
+  std::lock_guard<std::mutex> lock(mutex_);
+  // a reload replaces the solvers and results of the previous points.
+  datasets_[name] = Resident{points, {}};
+  for (auto it = lru_.begin(); it != lru_.end();) {
+    if (std::get<0>(it->first) != name) {
+      ++it;
+      continue;
+    }
+    cache_.erase(it->first);
+    it = lru_.erase(it);
+  }
+  return points->d1.size();
+}
+
+DBSCAN::server::Reply DBSCAN::server::Server::Cluster_(const Query& query) {
+  const region::Box box = query.has_region ? query.box : region::Box{};
+  const Key key{query.dataset, query.eps,   query.min_pts, query.has_region,
+                box.min_x,     box.min_y,   box.max_x,     box.max_y};
+  std::shared_ptr<Entry> entry;
+  std::shared_ptr<const input_type::TwoDimPoints> points;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto cached = cache_.find(key);
+    if (cached != cache_.end()) {
+      lru_.splice(lru_.begin(), lru_, cached->second);
+      return {true, *cached->second->second};
+    }
+    const auto resident = datasets_.find(query.dataset);
+    if (resident == datasets_.end())
+      throw std::runtime_error("no dataset " + query.dataset);
+    points = resident->second.points;
+    auto& entries = resident->second.entries;
+    // nothing of this request would stay resident.
+    const bool resident_solver = query.has_region || keep_graphs_;
+    auto it = std::find_if(entries.begin(), entries.end(),
+                           [&query](const auto& e) {
+                             return e.first == query.eps;
+                           });
+    if (it == entries.end() && resident_solver) {
+      entries.emplace_front(query.eps, std::make_shared<Entry>());
+      if (entries.size() > solvers_per_dataset_) entries.pop_back();
+      entry = entries.front().second;
+    } else if (it != entries.end()) {
+      entries.splice(entries.begin(), entries, it);
+      entry = entries.front().second;
+    }
+  }
+
+  auto labels = std::make_shared<const region::Result>(
+      Label_(entry.get(), points, query));
+  std::lock_guard<std::mutex> lock(mutex_);
+  // a concurrent request may have cached the same query meanwhile, or a
+  // reload replaced the points.
+  const auto resident = datasets_.find(query.dataset);
+  if (cache_entries_ > 0 && cache_.count(key) == 0 &&
+      resident != datasets_.end() && resident->second.points == points) {
+    lru_.emplace_front(key, labels);
+    cache_[key] = lru_.begin();
+    if (lru_.size() > cache_entries_) {
+      cache_.erase(lru_.back().first);
+      lru_.pop_back();
+    }
+  }
+  return {false, *labels};
+}
+
+DBSCAN::region::Result DBSCAN::server::Server::Label_(
+    Entry* const entry,
+    const std::shared_ptr<const input_type::TwoDimPoints>& points,
+    const Query& query) const {
+  region::Result labels;
+  const auto copy_labels = [&labels](const Solver& solver) {
+    labels.clusters.assign(solver.cluster_ids.cbegin(),
+                           solver.cluster_ids.cend());
+    labels.memberships = solver.memberships;
+  };
+  if (!query.has_region && !keep_graphs_) {
+    // the grid and graph go with this solver, whether or not a region
+    // request made a resident one for this eps.
+    Solver solver(points, query.min_pts, query.eps, num_threads_);
+    solver.PlanGraph();
+    solver.InsertEdges();
+    solver.FinalizeGraph();
+    solver.ClassifyNoises();
+    solver.IdentifyClusters();
+    copy_labels(solver);
+    return labels;
+  }
+
+  std::lock_guard<std::mutex> lock(entry->mutex);
+  if (entry->solver == nullptr) {
+    entry->solver = std::make_unique<Solver>(points, query.min_pts, query.eps,
+                                             num_threads_);
+    entry->solver->ConstructGrid();
+  }
+  auto& solver = *entry->solver;
+  solver.set_min_pts(query.min_pts);
+  if (query.has_region) return solver.QueryRegion(query.box);
+  if (!entry->graph_built) {
+    solver.PlanGraph();
+    solver.InsertEdges();
+    solver.FinalizeGraph();
+    entry->graph_built = true;
+  }
+  solver.ClassifyNoises();
+  solver.IdentifyClusters();
+  copy_labels(solver);
+  return labels;
+}
+
+DBSCAN::server::Client::Client(const std::string& path) {
+  const sockaddr_un addr = Address_(path);
+  const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) throw std::runtime_error("socket failed!");
+  if (connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) !=
+      0) {
+    close(fd);
+    throw std::runtime_error("cannot connect to " + path);
+  }
+  channel_ = std::make_unique<transport::SocketChannel>(fd);
+}
+
+DBSCAN::transport::Message DBSCAN::server::Client::Call_(
+    const transport::Message& request) {
+  channel_->Send(request);
+  auto reply = channel_->Receive();
+  if (reply.Get<uint8_t>() != 0) throw std::runtime_error(reply.GetString());
+  return reply;
+}
+
+uint64_t DBSCAN::server::Client::Load(const std::string& name,
+                                      const std::string& path) {
+  transport::Message request;
+  request.Put(Op::Load);
+  request.Put(name);
+  request.Put(path);
+  return Call_(request).Get<uint64_t>();
+}
+
+DBSCAN::server::Reply DBSCAN::server::Client::Cluster(const Query& query) {
+  transport::Message request;
+  request.Put(Op::Cluster);
+  PutQuery_(request, query);
+  auto reply = Call_(request);
+  Reply result;
+  result.cached = reply.Get<uint8_t>();
+  result.labels.vertices = reply.GetVector<uint64_t>();
+  result.labels.clusters = reply.GetVector<int64_t>();
+  result.labels.memberships = reply.GetVector<DBSCAN::membership>();
+  result.labels.num_visited = reply.Get<uint64_t>();
+  return result;
+}
+
+void DBSCAN::server::Client::Shutdown() {
+  transport::Message request;
+  request.Put(Op::Shutdown);
+  Call_(request);
+}
@@ -0,0 +1,153 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#ifndef DBSCAN_INCLUDE_SERVER_H_
+#define DBSCAN_INCLUDE_SERVER_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <set>
+#include <string>
+#include <tuple>
+
+#include "dataset.h"
+#include "region.h"
+#include "solver.h"
+#include "transport.h"
+
+namespace DBSCAN {
+namespace server {
+/*
+ * Every message is a |transport::Message| on a |transport::SocketChannel|.
+ * A request starts with an |Op|:
+ *   Load:     name, path                          -> number of points
+ *   Cluster:  name, eps, min_pts, has_region, Box -> |Reply|
+ *   Shutdown:                                     -> nothing
+ * A reply starts with a uint8 status: 0 and the payload above, or 1 and an
+ * error message.
+ */
+enum class Op : uint8_t { Load, Cluster, Shutdown };
+
+struct Query {
+  std::string dataset;
+  float eps = 0;
+  uint64_t min_pts = 0;
+  // only the points inside |box|, see |Solver::QueryRegion|.
+  bool has_region = false;
+  region::Box box{};
+};
+
+struct Reply {
+  // served from the result cache.
+  bool cached = false;
+  /*
+   * For a region, as |Solver::QueryRegion| returns it. For a whole dataset
+   * |vertices| is empty and |clusters| and |memberships| are indexed by
+   * point, with the cluster ids of a |Solver| run.
+   */
+  region::Result labels;
+};
+
+/*
+ * Keeps named datasets resident and clusters them on request. Each dataset
+ * has one |Solver| per eps that keeps its grid and graph, so another min_pts
+ * or a region only pays for the labelling. Without |keep_graphs| only
+ * regions are served from a resident solver; a whole dataset is clustered
+ * by a solver of its own, which frees its grid and graph right after. The solvers share the resident points, and only the
+ * |solvers_per_dataset| most recently used eps keep theirs. Requests on the
+ * same dataset and eps take turns on that solver; all others run
+ * concurrently, one connection per worker thread. A connection idle for
+ * |idle_timeout_ms| (0 for never) is hung up on to free its worker. Results
+ * are cached per query, the least recently used |cache_entries| of them.
+ * A failed accept is logged and retried; only a Shutdown request stops the
+ * server.
+ */
+class Server {
+ public:
+  Server(uint32_t num_workers, uint8_t num_threads, uint64_t cache_entries,
+         bool keep_graphs, uint32_t solvers_per_dataset = 4,
+         uint32_t idle_timeout_ms = 60000);
+  // Listen on the Unix socket |path| until a Shutdown request arrives.
+  void Serve(const std::string& path);
+  // The reply to one request; never throws, errors go into the reply.
+  transport::Message Handle(transport::Message&);
+
+ private:
+  // one dataset at one eps
+  struct Entry {
+    std::mutex mutex;
+    std::unique_ptr<Solver> solver;
+    bool graph_built = false;
+  };
+  struct Resident {
+    std::shared_ptr<const input_type::TwoDimPoints> points;
+    // by eps, most recently used first; an evicted entry lives on until its
+    // requests are done.
+    std::list<std::pair<float, std::shared_ptr<Entry>>> entries;
+  };
+  using Key = std::tuple<std::string, float, uint64_t, bool, float, float,
+                         float, float>;
+
+  uint32_t num_workers_;
+  uint8_t num_threads_;
+  uint64_t cache_entries_;
+  bool keep_graphs_;
+  uint32_t solvers_per_dataset_;
+  uint32_t idle_timeout_ms_;
+  // guards |datasets_| and the cache.
+  std::mutex mutex_;
+  // most recently used first.
+  std::list<std::pair<Key, std::shared_ptr<const region::Result>>> lru_;
+  std::map<Key, decltype(lru_)::iterator> cache_;
+  // accepted connections waiting for a worker.
+  std::mutex queue_mutex_;
+  std::condition_variable queue_cv_;
+  std::queue<int> connections_;
+  // connections a worker is serving.
+  std::set<int> active_;
+  bool stopping_ = false, shutdown_requested_ = false;
+  int listen_fd_ = -1;
+  // a request is a name, a path or a query: a longer one is hung up on.
+  static constexpr uint64_t kMaxRequestBytes = 1 << 16;
+
+  uint64_t Load_(const std::string& name, const std::string& path);
+  Reply Cluster_(const Query&);
+  // |entry| is null for a whole dataset without |keep_graphs_|.
+  region::Result Label_(Entry* entry,
+                        const std::shared_ptr<const input_type::TwoDimPoints>&,
+                        const Query&) const;
+  // Stop accepting and hang up on every client.
+  void Stop_();
+  void Work_();
+
+#if defined(DBSCAN_TESTING)
+ public:
+#else
+ private:
+#endif
+  std::map<std::string, Resident> datasets_;
+};
+
+// A connection to a |Server|; a failed request throws its error message.
+class Client {
+ public:
+  explicit Client(const std::string& path);
+  // Number of points of the dataset now resident as |name|.
+  uint64_t Load(const std::string& name, const std::string& path);
+  Reply Cluster(const Query&);
+  void Shutdown();
+
+ private:
+  std::unique_ptr<transport::SocketChannel> channel_;
+  transport::Message Call_(const transport::Message&);
+};
+}  // namespace server
+}  // namespace DBSCAN
+
+#endif  // DBSCAN_INCLUDE_SERVER_H_
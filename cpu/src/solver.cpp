@@ -4,48 +4,102 @@
 
 #include "solver.h"
 
-#if defined(AVX)
 #include <nmmintrin.h>
-#endif
+#include <unistd.h>
 
+#include <atomic>
 #include <cmath>
 #include <limits>
 #include <memory>
+#include <numeric>
+#include <optional>
 #include <thread>
+#include <type_traits>
+#include <unordered_map>
 
 #include "dataset.h"
+#include "finders.h"
 #include "graph.h"
+#include "kernels.h"
+#include "labels.h"
+#include "loops.h"
+#include "numa.h"
 #include "spdlog/spdlog.h"
+#include "threads.h"
 
 // ctor
 DBSCAN::Solver::Solver(const std::string& input, const uint64_t min_pts,
-                       const float radius, const uint8_t num_threads)
-    : min_pts_(min_pts),
-      squared_radius_(radius * radius),
-      num_threads_(num_threads) {
+                       const float radius, const uint8_t num_threads,
+                       const bool huge_pages)
+    : num_threads_(num_threads),
+      arena_(std::make_unique<DBSCAN::utils::Arena>(huge_pages)),
+      scratch_(std::make_unique<DBSCAN::utils::Arena>(huge_pages)) {
   logger_ = spdlog::get("console");
   if (logger_ == nullptr) {
     throw std::runtime_error("logger not created!");
   }
-#if defined(AVX)
-  sq_rad8_ = _mm256_set1_ps(squared_radius_);
-#endif
   using namespace std::chrono;
   high_resolution_clock::time_point start = high_resolution_clock::now();
+  auto dataset = DBSCAN::input_type::TwoDimPoints::Read(input);
+  duration<double> time_spent =
+      duration_cast<duration<double>>(high_resolution_clock::now() - start);
+  logger_->info("reading vertices takes {} seconds", time_spent.count());
+  Reset(std::move(dataset), min_pts, radius);
+}
+
+DBSCAN::Solver::Solver(
+    std::shared_ptr<const DBSCAN::input_type::TwoDimPoints> dataset,
+    const uint64_t min_pts, const float radius, const uint8_t num_threads,
+    const bool huge_pages)
+    : num_threads_(num_threads),
+      arena_(std::make_unique<DBSCAN::utils::Arena>(huge_pages)),
+      scratch_(std::make_unique<DBSCAN::utils::Arena>(huge_pages)) {
+  logger_ = spdlog::get("console");
+  if (logger_ == nullptr) {
+    throw std::runtime_error("logger not created!");
+  }
+  Reset(std::move(dataset), min_pts, radius);
+}
+
+void DBSCAN::Solver::Reset(
+    std::shared_ptr<const DBSCAN::input_type::TwoDimPoints> dataset,
+    const uint64_t min_pts, const float radius) {
+  if (dataset == nullptr || dataset->d1.size() != dataset->d2.size()) {
+    throw std::runtime_error("dataset is missing or malformed!");
+  }
+  min_pts_ = min_pts;
+  radius_ = radius;
+  squared_radius_ = radius * radius;
+  dataset_ = std::move(dataset);
+  input_.reset();
+  weights_.clear();
+  vertex_of_.clear();
+  metrics_.Clear();
+  Prepare_();
+}
+
+void DBSCAN::Solver::set_min_pts(const uint64_t min_pts) {
+  if (!vertex_of_.empty()) {
+    throw std::runtime_error("set_min_pts after CollapseDuplicates!");
+  }
+  min_pts_ = min_pts;
+  metrics_.Clear();
+  metrics_.min_pts = min_pts_;
+  cluster_ids.assign(num_vtx_, -1);
+  memberships.assign(num_vtx_, DBSCAN::membership::Noise);
+}
+
+void DBSCAN::Solver::Prepare_() {
+  num_vtx_ = dataset_->d1.size();
+  const float radius = radius_;
 
-  auto ifs = std::ifstream(input);
-  ifs >> num_vtx_;
-  dataset_ = std::make_unique<DBSCAN::input_type::TwoDimPoints>(num_vtx_);
-  uint64_t n;
-  float x, y;
   // grid
-  float max_x = std::numeric_limits<float>::min(),
-        max_y = std::numeric_limits<float>::min(),
+  float max_x = std::numeric_limits<float>::lowest(),
+        max_y = std::numeric_limits<float>::lowest(),
         min_x = std::numeric_limits<float>::max(),
         min_y = std::numeric_limits<float>::max();
-  while (ifs >> n >> x >> y) {
-    dataset_->d1[n] = x;
-    dataset_->d2[n] = y;
+  for (uint64_t vtx = 0; vtx < num_vtx_; ++vtx) {
+    const float x = dataset_->d1[vtx], y = dataset_->d2[vtx];
     // manually offset by radius/2 such the min/max values fall within
     // second/second last cell.
     max_x = std::max(max_x, x + radius / 2);
@@ -53,317 +107,508 @@ DBSCAN::Solver::Solver(const std::string& input, const uint64_t min_pts,
     max_y = std::max(max_y, y + radius / 2);
     min_y = std::min(min_y, y - radius / 2);
   }
+  if (num_vtx_ == 0) {
+    max_x = max_y = radius;
+    min_x = min_y = 0;
+  }
 
-  duration<double> time_spent =
-      duration_cast<duration<double>>(high_resolution_clock::now() - start);
-  logger_->info("reading vertices takes {} seconds", time_spent.count());
+  metrics_.num_vtx = num_vtx_;
+  metrics_.min_pts = min_pts_;
+  metrics_.radius = radius_;
+  metrics_.num_threads = num_threads_;
 
-  cluster_ids.resize(num_vtx_, -1);
-  memberships.resize(num_vtx_, DBSCAN::membership::Noise);
-  grid_ = std::make_unique<Grid>(max_x, max_y, min_x, min_y, radius, num_vtx_,
-                                 num_threads_);
+  grid_constructed_ = false;
+  // assign() keeps the capacity of a previous run.
+  cluster_ids.assign(num_vtx_, -1);
+  memberships.assign(num_vtx_, DBSCAN::membership::Noise);
+  // the previous grid and graph live in the arena; rewind it before anything
+  // is carved out of it again.
+  graph_.reset();
+  kdtree_.reset();
+  num_nbs_ = start_pos_ = neighbours_ = nullptr;
+  graph_ready_ = graph_mapped_ = false;
+  mapped_graph_.reset();
+  arena_->Reset();
+  if (grid_ == nullptr) {
+    grid_ = std::make_unique<Grid>(max_x, max_y, min_x, min_y, radius,
+                                   num_vtx_, num_threads_, arena_.get());
+  } else {
+    grid_->Reset(max_x, max_y, min_x, min_y, radius, num_vtx_);
+  }
+}
+
+void DBSCAN::Solver::CollapseDuplicates(const float tolerance) {
+  if (grid_constructed_ || graph_ != nullptr || kdtree_ != nullptr ||
+      graph_ready_ || !vertex_of_.empty()) {
+    throw std::runtime_error(
+        "Call CollapseDuplicates once, before the grid or graph!");
+  }
+  metrics::StageScope scope(metrics_, "CollapseDuplicates");
+  auto collapsed = dedup::Collapse(*dataset_, tolerance, num_threads_);
+  scope.Count("vertices", collapsed.weights.size());
+  input_ = std::move(dataset_);
+  dataset_ = std::move(collapsed.points);
+  weights_ = std::move(collapsed.weights);
+  vertex_of_ = std::move(collapsed.vertex_of);
+  Prepare_();
+}
+
+void DBSCAN::Solver::set_profiling(const bool profiling) {
+  if (profiling && !perf::Available()) {
+    logger_->warn(
+        "hardware counters are unavailable (see perf_event_paranoid); "
+        "profiling only records timings");
+  }
+  metrics_.profile = profiling;
+}
+
+void DBSCAN::Solver::ConstructGrid() {
+  metrics::StageScope scope(metrics_, "ConstructGrid");
+  grid_->Construct(dataset_->d1, dataset_->d2);
+  grid_constructed_ = true;
+  scope.Count("cells", grid_->num_cells());
+}
+
+void DBSCAN::Solver::ConstructKdTree() {
+  metrics::StageScope scope(metrics_, "ConstructKdTree");
+  kdtree_ = std::make_unique<KdTree>(dataset_->d1, dataset_->d2, num_threads_);
+  scope.Count("leaves", kdtree_->num_leaves());
+}
+
+const DBSCAN::planner::Plan& DBSCAN::Solver::PlanGraph(
+    const uint64_t memory_limit) {
+  if (!grid_constructed_) ConstructGrid();
+  metrics::StageScope scope(metrics_, "PlanGraph");
+  plan_ = planner::Choose(planner::EstimateCosts(*grid_, *dataset_), num_vtx_,
+                          memory_limit);
+  const auto& estimate = plan_.estimate;
+  const auto mb = [](const uint64_t bytes) { return bytes / 1048576.0; };
+  logger_->info("estimated average degree {:.1f} ({} candidate pairs)",
+                estimate.avg_degree, estimate.num_candidates);
+  logger_->info("grid needs: {:.2f} MB", mb(estimate.grid_bytes));
+  logger_->info("bitmap adjacency needs: {:.2f} MB",
+                mb(estimate.bitmap_bytes));
+  logger_->info("csr adjacency needs: {:.2f} MB", mb(estimate.csr_bytes));
+  logger_->info("blocked bitmap adjacency needs: {:.2f} MB",
+                mb(estimate.blocked_bytes));
+  logger_->info("finalized graph needs: {:.2f} MB",
+                mb(estimate.graph_bytes));
+  const uint64_t bytes = estimate.Bytes(plan_.adjacency);
+  if (memory_limit != 0 && bytes > memory_limit) {
+    logger_->warn("nothing fits in {:.2f} MB; {} needs {:.2f} MB",
+                  mb(memory_limit), planner::ToString(plan_.adjacency),
+                  mb(bytes));
+  }
+  logger_->info("plan: {} adjacency, {} kernel, {} labeller, {:.2f} MB in "
+                "total",
+                planner::ToString(plan_.adjacency),
+                planner::ToString(plan_.kernel),
+                planner::ToString(plan_.labeller), mb(bytes));
+  scope.Count("estimated_edges", estimate.num_edges);
+  scope.Count("estimated_bytes", bytes);
+  return plan_;
 }
 
 void DBSCAN::Solver::InsertEdges() {
-  using namespace std::chrono;
-  high_resolution_clock::time_point start = high_resolution_clock::now();
 
   if (dataset_ == nullptr) {
     throw std::runtime_error("Call prepare_dataset to generate the dataset!");
   }
+  // only the adjacency lists of the grid path are specialised per metric.
+  if (metric_ != metric::Metric::Euclidean &&
+      (plan_.adjacency != Adjacency::Csr || plan_.index != Index::Grid ||
+       numa_aware_)) {
+    logger_->warn("the {} metric runs on adjacency lists from the grid only",
+                  metric::ToString(metric_));
+    plan_.adjacency = Adjacency::Csr;
+    plan_.index = Index::Grid;
+  }
+  if (!kernels::Supported(plan_.kernel)) {
+    logger_->warn("the {} kernel is not supported here; using {}",
+                  planner::ToString(plan_.kernel),
+                  planner::ToString(kernels::Widest()));
+    plan_.kernel = kernels::Widest();
+  }
+  const bool kdtree =
+      plan_.adjacency == Adjacency::Csr && plan_.index == Index::KdTree;
+  if (kdtree && kdtree_ == nullptr) ConstructKdTree();
+  if (plan_.adjacency != Adjacency::Bitmap && !kdtree && !grid_constructed_)
+    ConstructGrid();
+  metrics::StageScope scope(metrics_, "InsertEdges");
 
-  graph_ = std::make_unique<Graph>(num_vtx_, num_threads_);
+  // the previous graph may not have been finalized.
+  graph_.reset();
+  scratch_->Reset();
+  graph_ = std::make_unique<Graph>(num_vtx_, num_threads_, arena_.get(),
+                                   plan_.adjacency, scratch_.get());
+  if (plan_.adjacency != Adjacency::Csr && numa_aware_)
+    logger_->warn("NUMA-aware mode needs adjacency lists; ignored");
+  if (plan_.adjacency != Adjacency::Csr && plan_.index == Index::KdTree)
+    logger_->warn("the k-d tree only feeds adjacency lists; ignored");
+  if (kdtree && numa_aware_)
+    logger_->warn("NUMA-aware mode needs the grid; ignored");
+  if (plan_.adjacency == Adjacency::Implicit) {
+    logger_->info("InsertEdges - implicit: the label stages search the grid");
+    scope.Count("candidate_pairs", 0);
+    return;
+  }
+  const bool numa = numa_aware_ && plan_.adjacency == Adjacency::Csr &&
+                    !kdtree && metric_ == metric::Metric::Euclidean;
+  logger_->info("InsertEdges - {} from {} ({}, {})",
+                planner::ToString(plan_.adjacency),
+                plan_.adjacency == Adjacency::Bitmap ? "every pair"
+                : kdtree                             ? "the k-d tree"
+                : numa                               ? "NUMA strips"
+                                                     : "the grid",
+                metric::ToString(metric_), planner::ToString(plan_.kernel));
 
-  std::vector<std::thread> threads(num_threads_);
-#if defined(BIT_ADJ)
-  logger_->info("InsertEdges - BIT_ADJ");
-  const uint64_t N = std::ceil(num_vtx_ / 64.f);
-  for (uint8_t tid = 0; tid < num_threads_; ++tid) {
-    threads[tid] = std::thread(
-        [this, N](const uint8_t tid) {
-          auto t0 = high_resolution_clock::now();
-          for (uint64_t u = tid; u < num_vtx_; u += num_threads_) {
-            const float &ux = dataset_->d1[u], uy = dataset_->d2[u];
-#if defined(AVX)
-            const __m256 u_x8 = _mm256_set1_ps(ux);
-            const __m256 u_y8 = _mm256_set1_ps(uy);
-            for (uint64_t outer = 0; outer < N; ++outer) {
-              for (uint64_t inner = 0; inner < 64; inner += 8) {
-                const uint64_t v0 = outer * 64llu + inner;
-                const uint64_t v1 = v0 + 1;
-                const uint64_t v2 = v0 + 2;
-                const uint64_t v3 = v0 + 3;
-                const uint64_t v4 = v0 + 4;
-                const uint64_t v5 = v0 + 5;
-                const uint64_t v6 = v0 + 6;
-                const uint64_t v7 = v0 + 7;
-                // TODO: if num_vtx_ is not a multiple of 8
-                // logger_->trace("vertex {} (num_vtx_ {}); outer{}; inner
-                // {}", u, num_vtx_, outer, inner);
-
-                const float* const v_x_ptr = &(dataset_->d1.front());
-                const __m256 v_x_8 = _mm256_load_ps(v_x_ptr + v0);
-                const float* const v_y_ptr = &(dataset_->d2.front());
-                const __m256 v_y_8 = _mm256_load_ps(v_y_ptr + v0);
-                const __m256 x_diff_8 = _mm256_sub_ps(u_x8, v_x_8);
-                const __m256 x_diff_sq_8 = _mm256_mul_ps(x_diff_8, x_diff_8);
-                const __m256 y_diff_8 = _mm256_sub_ps(u_y8, v_y_8);
-                const __m256 y_diff_sq_8 = _mm256_mul_ps(y_diff_8, y_diff_8);
-                const __m256 sum = _mm256_add_ps(x_diff_sq_8, y_diff_sq_8);
-
-                // const auto temp = reinterpret_cast<float const*>(&sum);
-                // logger_->trace("summation of X^2 and Y^2 (sum):");
-                // for (uint64_t i = 0; i < 8; ++i)
-                //   logger_->trace("\t{}", temp[i]);
-
-                const int cmp = _mm256_movemask_ps(
-                    _mm256_cmp_ps(sum, sq_rad8_, _CMP_LE_OS));
-                // logger_->trace(
-                //     "comparison of X^2+Y^2 against radius^2 (cmp): {}",
-                //     cmp);
-
-                if (u != v0 && v0 < num_vtx_ && (cmp & 1 << 0))
-                  graph_->InsertEdge(u, outer, 1llu << inner);
-                if (u != v1 && v1 < num_vtx_ && (cmp & 1 << 1))
-                  graph_->InsertEdge(u, outer, 1llu << (inner + 1));
-                if (u != v2 && v2 < num_vtx_ && (cmp & 1 << 2))
-                  graph_->InsertEdge(u, outer, 1llu << (inner + 2));
-                if (u != v3 && v3 < num_vtx_ && (cmp & 1 << 3))
-                  graph_->InsertEdge(u, outer, 1llu << (inner + 3));
-                if (u != v4 && v4 < num_vtx_ && (cmp & 1 << 4))
-                  graph_->InsertEdge(u, outer, 1llu << (inner + 4));
-                if (u != v5 && v5 < num_vtx_ && (cmp & 1 << 5))
-                  graph_->InsertEdge(u, outer, 1llu << (inner + 5));
-                if (u != v6 && v6 < num_vtx_ && (cmp & 1 << 6))
-                  graph_->InsertEdge(u, outer, 1llu << (inner + 6));
-                if (u != v7 && v7 < num_vtx_ && (cmp & 1 << 7))
-                  graph_->InsertEdge(u, outer, 1llu << (inner + 7));
-              }
-            }
-#else
-            const auto dist =
-                input_type::TwoDimPoints::euclidean_distance_square;
-            for (uint64_t outer = 0; outer < N; outer += 4) {
-              for (uint64_t inner = 0; inner < 64; ++inner) {
-                const uint64_t v1 = outer * 64llu + inner;
-                const uint64_t v2 = v1 + 64;
-                const uint64_t v3 = v2 + 64;
-                const uint64_t v4 = v3 + 64;
-                const uint64_t msk = 1llu << inner;
-                if (u != v1 && v1 < num_vtx_ &&
-                    dist(ux, uy, dataset_->d1[v1], dataset_->d2[v1]) <=
-                        squared_radius_)
-                  graph_->InsertEdge(u, outer, msk);
-                if (u != v2 && v2 < num_vtx_ &&
-                    dist(ux, uy, dataset_->d1[v2], dataset_->d2[v2]) <=
-                        squared_radius_)
-                  graph_->InsertEdge(u, outer + 1, msk);
-                if (u != v3 && v3 < num_vtx_ &&
-                    dist(ux, uy, dataset_->d1[v3], dataset_->d2[v3]) <=
-                        squared_radius_)
-                  graph_->InsertEdge(u, outer + 2, msk);
-                if (u != v4 && v4 < num_vtx_ &&
-                    dist(ux, uy, dataset_->d1[v4], dataset_->d2[v4]) <=
-                        squared_radius_)
-                  graph_->InsertEdge(u, outer + 3, msk);
-              }
-            }
-#endif
-          }
-          auto t1 = high_resolution_clock::now();
-          logger_->info("\tThread {} takes {} seconds", tid,
-                        duration_cast<duration<double>>(t1 - t0).count());
-        }, /* lambda */
-        tid /* args to lambda */);
+  // coordinates in cell order, for the finders that read the runs of the
+  // grid straight; not initialized here so that each strip is first-touched
+  // by the thread that owns it. Only these copies are placed per node: the
+  // adjacency lists stay on the node that allocates them.
+  const DBSCAN::utils::ArenaAllocator<float, false> alloc(arena_.get());
+  std::vector<float, DBSCAN::utils::ArenaAllocator<float, false>> xs(alloc),
+      ys(alloc);
+  std::unique_ptr<numa::Topology> topo;
+  // a single thread runs on the caller; do not leave it pinned.
+  std::optional<numa::AffinityGuard> affinity;
+  if (numa || plan_.adjacency == Adjacency::BlockedBitmap) {
+    if (numa) {
+      topo = std::make_unique<numa::Topology>(numa::Topology::Detect());
+      affinity.emplace();
+    }
+    const auto& order = grid_->vertices_in_cell_order();
+    const auto bounds = finders::Strips(num_vtx_, num_threads_);
+    xs.resize(num_vtx_);
+    ys.resize(num_vtx_);
+    DBSCAN::utils::run_threads(num_threads_, [&](const uint8_t tid) {
+      if (topo != nullptr)
+        numa::PinToNode(*topo, topo->NodeOfThread(tid, num_threads_));
+      for (uint64_t pos = bounds[tid]; pos < bounds[tid + 1]; ++pos) {
+        xs[pos] = dataset_->d1[order[pos]];
+        ys[pos] = dataset_->d2[order[pos]];
+      }
+    });
+    graph_->set_cell_order(order.data());
   }
-#else
-  logger_->info("InsertEdges - default");
-  const auto dist = input_type::TwoDimPoints::euclidean_distance_square;
+
+  // the plan picks the finder, store and kernel here, once; the loop of each
+  // pairing is compiled per kernel, see |loops::Loops|.
+  const auto insert = [&](auto kernel) -> uint64_t {
+    using Loops = loops::Loops<decltype(kernel)::value>;
+    if (plan_.adjacency == Adjacency::Bitmap) {
+      return Loops::Insert(finders::TilePairs(*dataset_, squared_radius_),
+                           graph_->WriteBitmap(), num_threads_);
+    }
+    if (plan_.adjacency == Adjacency::BlockedBitmap) {
+      return Loops::Insert(finders::CellRanges(*grid_, xs.data(), ys.data(),
+                                               squared_radius_, num_threads_),
+                           graph_->WriteBitmap(), num_threads_);
+    }
+    if (kdtree) {
+      return Loops::Insert(finders::KdLeaves(*kdtree_, squared_radius_),
+                           graph_->WriteCsr(), num_threads_);
+    }
+    if (numa) {
+      const finders::CellRanges finder(*grid_, xs.data(), ys.data(),
+                                       squared_radius_, num_threads_,
+                                       topo.get());
+      const uint64_t num_candidates =
+          Loops::Insert(finder, graph_->WriteCsr(), num_threads_);
+      ReportNuma_(finder, *topo, scope);
+      return num_candidates;
+    }
+    switch (metric_) {
+      case metric::Metric::Manhattan:
+        return Loops::Insert(
+            finders::GridCells<metric::Manhattan>(*grid_, *dataset_, radius_),
+            graph_->WriteCsr(), num_threads_);
+      case metric::Metric::Chebyshev:
+        return Loops::Insert(
+            finders::GridCells<metric::Chebyshev>(*grid_, *dataset_, radius_),
+            graph_->WriteCsr(), num_threads_);
+      case metric::Metric::Haversine:
+        return Loops::Insert(
+            finders::GridCells<metric::Haversine>(*grid_, *dataset_, radius_),
+            graph_->WriteCsr(), num_threads_);
+      default:
+        return Loops::Insert(
+            finders::GridCells<metric::Euclidean>(*grid_, *dataset_, radius_),
+            graph_->WriteCsr(), num_threads_);
+    }
+  };
+  scope.Count("candidate_pairs", kernels::Dispatch(plan_.kernel, insert));
+
+  logger_->debug("arena holds {} bytes in {} blocks", arena_->capacity(),
+                 arena_->num_blocks());
+}
+
+void DBSCAN::Solver::ReportNuma_(const finders::CellRanges& finder,
+                                 const numa::Topology& topo,
+                                 metrics::StageScope& scope) const {
+  std::vector<uint64_t> node_local(topo.num_nodes()),
+      node_remote(topo.num_nodes());
   for (uint8_t tid = 0; tid < num_threads_; ++tid) {
-    threads[tid] = std::thread(
-        [this, &dist](const uint8_t tid) {
-          auto t0 = high_resolution_clock::now();
-#if defined(AVX)
-          // each float is 4 bytes; a 256bit register is 32 bytes. Hence 8
-          // float at-a-time.
-          for (uint64_t u = tid; u < num_vtx_; u += num_threads_) {
-            graph_->StartInsert(u);
-            const float &ux = dataset_->d1[u], uy = dataset_->d2[u];
-            const __m256 u_x8 = _mm256_set1_ps(ux);
-            const __m256 u_y8 = _mm256_set1_ps(uy);
-            const std::vector<uint64_t> nbs =
-                grid_->GetNeighbouringVtx(u, ux, uy);
-            for (uint64_t i = 0; i < nbs.size(); i += 8) {
-              const __m256 v_x_8 = _mm256_set_ps(
-                  dataset_->d1[nbs[i]],
-                  i + 1 < nbs.size() ? dataset_->d1[nbs[i + 1]] : max_radius_,
-                  i + 2 < nbs.size() ? dataset_->d1[nbs[i + 2]] : max_radius_,
-                  i + 3 < nbs.size() ? dataset_->d1[nbs[i + 3]] : max_radius_,
-                  i + 4 < nbs.size() ? dataset_->d1[nbs[i + 4]] : max_radius_,
-                  i + 5 < nbs.size() ? dataset_->d1[nbs[i + 5]] : max_radius_,
-                  i + 6 < nbs.size() ? dataset_->d1[nbs[i + 6]] : max_radius_,
-                  i + 7 < nbs.size() ? dataset_->d1[nbs[i + 7]] : max_radius_);
-              const __m256 v_y_8 = _mm256_set_ps(
-                  dataset_->d2[nbs[i]],
-                  i + 1 < nbs.size() ? dataset_->d2[nbs[i + 1]] : max_radius_,
-                  i + 2 < nbs.size() ? dataset_->d2[nbs[i + 2]] : max_radius_,
-                  i + 3 < nbs.size() ? dataset_->d2[nbs[i + 3]] : max_radius_,
-                  i + 4 < nbs.size() ? dataset_->d2[nbs[i + 4]] : max_radius_,
-                  i + 5 < nbs.size() ? dataset_->d2[nbs[i + 5]] : max_radius_,
-                  i + 6 < nbs.size() ? dataset_->d2[nbs[i + 6]] : max_radius_,
-                  i + 7 < nbs.size() ? dataset_->d2[nbs[i + 7]] : max_radius_);
-
-              const __m256 x_diff_8 = _mm256_sub_ps(u_x8, v_x_8);
-              const __m256 x_diff_sq_8 = _mm256_mul_ps(x_diff_8, x_diff_8);
-              const __m256 y_diff_8 = _mm256_sub_ps(u_y8, v_y_8);
-              const __m256 y_diff_sq_8 = _mm256_mul_ps(y_diff_8, y_diff_8);
-
-              const __m256 sum = _mm256_add_ps(x_diff_sq_8, y_diff_sq_8);
-
-              const int cmp =
-                  _mm256_movemask_ps(_mm256_cmp_ps(sum, sq_rad8_, _CMP_LE_OS));
-              if (cmp & 1 << 7) graph_->InsertEdge(u, nbs[i]);
-              if (cmp & 1 << 6) graph_->InsertEdge(u, nbs[i + 1]);
-              if (cmp & 1 << 5) graph_->InsertEdge(u, nbs[i + 2]);
-              if (cmp & 1 << 4) graph_->InsertEdge(u, nbs[i + 3]);
-              if (cmp & 1 << 3) graph_->InsertEdge(u, nbs[i + 4]);
-              if (cmp & 1 << 2) graph_->InsertEdge(u, nbs[i + 5]);
-              if (cmp & 1 << 1) graph_->InsertEdge(u, nbs[i + 6]);
-              if (cmp & 1 << 0) graph_->InsertEdge(u, nbs[i + 7]);
-            }
-            graph_->FinishInsert(u);
-          }
-#else
-          for (uint64_t u = tid; u < num_vtx_; u += num_threads_) {
-            graph_->StartInsert(u);
-            const float &ux = dataset_->d1[u], uy = dataset_->d2[u];
-            const std::vector<uint64_t> nbs =
-                grid_->GetNeighbouringVtx(u, ux, uy);
-            // logger_->debug("possible nbs of {}: {}", u,
-            //                DBSCAN::utils::print_vector("", nbs));
-            for (const auto v : nbs) {
-              if (dist(ux, uy, dataset_->d1[v], dataset_->d2[v]) <=
-                  squared_radius_)
-                graph_->InsertEdge(u, v);
-            }
-            graph_->FinishInsert(u);
-          }
-#endif
-          auto t1 = high_resolution_clock::now();
-          logger_->info("\tThread {} takes {} seconds", tid,
-                        duration_cast<duration<double>>(t1 - t0).count());
-        }, /* lambda */
-        tid /* args to lambda */);
+    const uint32_t node = topo.NodeOfThread(tid, num_threads_);
+    if (!finder.pinned(tid))
+      logger_->debug("\tcannot pin thread {} to node {}", tid, node);
+    node_local[node] += finder.num_local(tid);
+    node_remote[node] += finder.num_remote(tid);
+  }
+  for (uint32_t node = 0; node < topo.num_nodes(); ++node) {
+    if (node_local[node] + node_remote[node] == 0) continue;
+    logger_->info(
+        "\tnode {}: ~{} local / ~{} remote candidate reads (estimated from "
+        "the grid ranges)",
+        node, node_local[node], node_remote[node]);
   }
-#endif
-  for (auto& tr : threads) tr.join();
-  threads.clear();
+  scope.Count("estimated_local_reads",
+              std::accumulate(node_local.cbegin(), node_local.cend(), 0ull));
+  scope.Count("estimated_remote_reads",
+              std::accumulate(node_remote.cbegin(), node_remote.cend(), 0ull));
+}
 
-  high_resolution_clock::time_point end = high_resolution_clock::now();
-  duration<double> time_spent = duration_cast<duration<double>>(end - start);
-  logger_->info("InsertEdges takes {} seconds", time_spent.count());
+void DBSCAN::Solver::FinalizeGraph() {
+  metrics::StageScope scope(metrics_, "FinalizeGraph");
+  graph_->Finalize();
+  num_nbs_ = graph_->num_nbs.data();
+  start_pos_ = graph_->start_pos.data();
+  neighbours_ = graph_->neighbours.data();
+  graph_ready_ = true;
+  scope.Count("edges", graph_->neighbours.size());
+}
+
+void DBSCAN::Solver::SaveGraph(const std::string& output) {
+  if (!graph_ready_ || graph_mapped_) {
+    throw std::runtime_error("Call FinalizeGraph to generate the graph!");
+  }
+  if (Implicit_()) {
+    throw std::runtime_error("an implicit graph keeps no edges to save!");
+  }
+  metrics::StageScope scope(metrics_, "SaveGraph");
+  graph_cache::Save(
+      output, graph_cache::Hash(*dataset_, radius_, metric_, num_threads_),
+      num_vtx_, num_nbs_, start_pos_, neighbours_, graph_->neighbours.size());
+  scope.Count("edges", graph_->neighbours.size());
+}
+
+bool DBSCAN::Solver::LoadGraph(const std::string& input) {
+  if (access(input.c_str(), F_OK) != 0) {
+    logger_->info("no graph cache at {}", input);
+    return false;
+  }
+  // the hash and the mapping are most of the work; a graph that is not
+  // loaded after all is not recorded as a stage.
+  metrics::StageScope scope(metrics_, "LoadGraph");
+  std::unique_ptr<graph_cache::MappedGraph> mapped;
+  try {
+    mapped = std::make_unique<graph_cache::MappedGraph>(
+        input, graph_cache::Hash(*dataset_, radius_, metric_, num_threads_),
+        num_vtx_);
+  } catch (const std::runtime_error& e) {
+    logger_->warn("cannot load the graph cache: {}", e.what());
+    scope.Drop();
+    return false;
+  }
+  if (!mapped->valid()) {
+    logger_->warn("{} holds the graph of another dataset, eps or metric",
+                  input);
+    scope.Drop();
+    return false;
+  }
+  mapped_graph_ = std::move(mapped);
+  num_nbs_ = mapped_graph_->num_nbs();
+  start_pos_ = mapped_graph_->start_pos();
+  neighbours_ = mapped_graph_->neighbours();
+  graph_ready_ = graph_mapped_ = true;
+  scope.Count("edges", mapped_graph_->num_edges());
+  return true;
 }
 
 void DBSCAN::Solver::ClassifyNoises() {
-  using namespace std::chrono;
-  high_resolution_clock::time_point start = high_resolution_clock::now();
-  if (graph_ == nullptr) {
-    throw std::runtime_error("Call InsertEdges to generate the graph!");
+  if (!graph_ready_) {
+    throw std::runtime_error("Call FinalizeGraph or LoadGraph first!");
   }
-  for (uint64_t vertex = 0; vertex < num_vtx_; ++vertex) {
-    // logger_->trace("{} has {} neighbours within {}", vertex,
-    //                graph_->num_nbs[vertex], squared_radius_);
-    // logger_->trace("{} >= {}: {}", graph_->num_nbs[vertex], min_pts_,
-    //                graph_->num_nbs[vertex] >= min_pts_ ? "true" :
-    //                "false");
-    if (graph_->num_nbs[vertex] >= min_pts_) {
-      // logger_->trace("{} to Core", vertex);
-      memberships[vertex] = Core;
-    } else {
-      // logger_->trace("{} to Noise", vertex);
-      memberships[vertex] = Noise;
-    }
+  metrics::StageScope scope(metrics_, "ClassifyNoises");
+  uint64_t num_cores;
+  if (Implicit_()) {
+    const finders::GridCells<metric::Euclidean> cells(*grid_, *dataset_,
+                                                      radius_);
+    num_cores = kernels::Dispatch(plan_.kernel, [&](auto kernel) {
+      return loops::Loops<decltype(kernel)::value>::Classify(
+          cells, min_pts_, weights_, memberships, num_threads_);
+    });
+  } else {
+    num_cores = labels::Classify(
+        labels::CsrGraph(num_vtx_, num_nbs_, start_pos_, neighbours_),
+        min_pts_, weights_, memberships, num_threads_);
   }
-  duration<double> time_spent =
-      duration_cast<duration<double>>(high_resolution_clock::now() - start);
-  logger_->info("ClassifyNoises takes {} seconds", time_spent.count());
+  scope.Count("cores", num_cores);
+  scope.Count("noise", num_vtx_ - num_cores);
 }
 
 void DBSCAN::Solver::IdentifyClusters() {
-  using namespace std::chrono;
-  high_resolution_clock::time_point start = high_resolution_clock::now();
-  int cluster = 0;
-  for (uint64_t vertex = 0; vertex < num_vtx_; ++vertex) {
-    if (cluster_ids[vertex] == -1 && memberships[vertex] == Core) {
-      cluster_ids[vertex] = cluster;
-      // logger_->debug("start bfs on vertex {} with cluster {}", vertex,
-      // cluster);
-      BFS_(vertex, cluster);
-      ++cluster;
+  metrics::StageScope scope(metrics_, "IdentifyClusters");
+  // the labeller reads the finalized lists, or has the plan's kernel search
+  // the grid for the edges of an implicit graph.
+  const auto label = [this](auto& labeller) -> int {
+    if (!Implicit_()) {
+      return labeller.Run(
+          labels::CsrGraph(num_vtx_, num_nbs_, start_pos_, neighbours_),
+          cluster_ids, memberships, num_threads_);
     }
+    const finders::GridCells<metric::Euclidean> cells(*grid_, *dataset_,
+                                                      radius_);
+    return kernels::Dispatch(plan_.kernel, [&](auto kernel) {
+      return loops::Loops<decltype(kernel)::value>::Label(
+          labeller, cells, cluster_ids, memberships, num_threads_);
+    });
+  };
+  int cluster;
+  if (plan_.labeller == Labeller::UnionFind) {
+    logger_->info("IdentifyClusters - union-find");
+    labels::UnionFind union_find;
+    cluster = label(union_find);
+  } else {
+    cluster = label(bfs_);
+  }
+  if (!vertex_of_.empty()) {
+    // back to the input points, which |dataset()| returns from now on.
+    dedup::Expand(vertex_of_, cluster_ids, memberships, num_threads_);
+    std::swap(dataset_, input_);
   }
+  uint64_t counts[3] = {0, 0, 0};
+  for (const auto m : memberships) ++counts[m];
+  scope.Count("clusters", cluster);
+  scope.Count("cores", counts[Core]);
+  scope.Count("borders", counts[Border]);
+  scope.Count("noise", counts[Noise]);
+}
+
+DBSCAN::summary::Summary DBSCAN::Solver::Summarize() const {
+  using namespace std::chrono;
+  high_resolution_clock::time_point start = high_resolution_clock::now();
+  auto summary =
+      summary::Summarize(*dataset_, cluster_ids, memberships, num_threads_);
   duration<double> time_spent =
       duration_cast<duration<double>>(high_resolution_clock::now() - start);
-  logger_->info("IdentifyClusters takes {} seconds", time_spent.count());
+  logger_->info("Summarize takes {} seconds", time_spent.count());
+  return summary;
 }
 
-void DBSCAN::Solver::BFS_(const uint64_t start_vertex, const int cluster) {
-  std::vector<uint64_t> curr_level{start_vertex};
-  // each thread has its own partial frontier.
-  std::vector<std::vector<uint64_t>> next_level(num_threads_,
-                                                std::vector<uint64_t>());
-
-  std::vector<std::thread> threads(num_threads_);
-  // uint64_t lvl_cnt = 0;
-  while (!curr_level.empty()) {
-    // logger_->info("\tBFS level {}", lvl_cnt);
-    for (uint8_t tid = 0u; tid < num_threads_; ++tid) {
-      threads[tid] = std::thread(
-          [this, &curr_level, &next_level, cluster](const uint8_t tid) {
-            // using namespace std::chrono;
-            // auto p_t0 = high_resolution_clock::now();
-            for (uint64_t curr_vertex_idx = tid;
-                 curr_vertex_idx < curr_level.size();
-                 curr_vertex_idx += num_threads_) {
-              uint64_t vertex = curr_level[curr_vertex_idx];
-              // logger_->trace("visiting vertex {}", vertex);
-              // Relabel a reachable Noise vertex, but do not keep exploring.
-              if (memberships[vertex] == Noise) {
-                // logger_->trace("\tvertex {} is relabeled from Noise to
-                // Border", vertex);
-                memberships[vertex] = Border;
-                continue;
-              }
-              const uint64_t start_pos = graph_->start_pos[vertex];
-              const uint64_t num_neighbours = graph_->num_nbs[vertex];
-              for (uint64_t i = 0; i < num_neighbours; ++i) {
-                uint64_t nb = graph_->neighbours[start_pos + i];
-                if (cluster_ids[nb] == -1) {
-                  // cluster the vertex
-                  // logger_->trace("\tvertex {} is clustered to {}", nb,
-                  // cluster);
-                  cluster_ids[nb] = cluster;
-                  // logger_->trace("\tneighbour {} of vertex {} is queued", nb,
-                  // vertex);
-                  next_level[tid].emplace_back(nb);
-                }
-              }
-            }
-            // auto p_t1 = high_resolution_clock::now();
-            // logger_->info(
-            //     "\t\tThread {} takes {} seconds", tid,
-            //     duration_cast<duration<double>>(p_t1 - p_t0).count());
-          } /* lambda */,
-          tid /* args to lambda */);
+DBSCAN::region::Result DBSCAN::Solver::QueryRegion(
+    const region::Box& box) {
+  if (!vertex_of_.empty()) {
+    throw std::runtime_error("QueryRegion runs on the input points only!");
+  }
+  if (!grid_constructed_) ConstructGrid();
+  metrics::StageScope scope(metrics_, "QueryRegion");
+  region::Result result;
+  switch (metric_) {
+    case metric::Metric::Manhattan:
+      result = QueryRegion_<metric::Manhattan>(box);
+      break;
+    case metric::Metric::Chebyshev:
+      result = QueryRegion_<metric::Chebyshev>(box);
+      break;
+    case metric::Metric::Haversine:
+      result = QueryRegion_<metric::Haversine>(box);
+      break;
+    default:
+      result = QueryRegion_<metric::Euclidean>(box);
+  }
+  scope.Count("vertices", result.vertices.size());
+  scope.Count("visited", result.num_visited);
+  return result;
+}
+
+template <class Metric>
+DBSCAN::region::Result DBSCAN::Solver::QueryRegion_(const region::Box& box) {
+  // the neighbours are searched as the implicit store does; scalar, as only
+  // the clusters around the box are.
+  using ImplicitGraph = labels::ImplicitGraph<kernels::Scalar, Metric>;
+  const finders::GridCells<Metric> cells(*grid_, *dataset_, radius_);
+  const ImplicitGraph graph(cells);
+  const auto& xs = dataset_->d1;
+  const auto& ys = dataset_->d2;
+
+  region::Result result;
+  grid_->AppendVtxInBox(box.min_x, box.max_x, box.min_y, box.max_y,
+                        result.vertices);
+  result.vertices.erase(
+      std::remove_if(result.vertices.begin(), result.vertices.end(),
+                     [&box, &xs, &ys](const uint64_t u) {
+                       return !box.Contains(xs[u], ys[u]);
+                     }),
+      result.vertices.end());
+  std::sort(result.vertices.begin(), result.vertices.end());
+  const uint64_t n = result.vertices.size();
+
+  // the box in parallel: whether each vertex is a core, and the neighbours
+  // of the others, whose cores decide between Border and Noise.
+  std::vector<uint8_t> is_core(n);
+  std::vector<std::vector<uint64_t>> border_nbs(n);
+  DBSCAN::utils::run_threads(num_threads_, [&](const uint8_t tid) {
+    typename ImplicitGraph::Cursor cursor(graph);
+    for (uint64_t i = tid; i < n; i += num_threads_) {
+      const labels::Span nbs = cursor.Neighbours(result.vertices[i]);
+      is_core[i] = nbs.size() >= min_pts_;
+      if (!is_core[i]) border_nbs[i].assign(nbs.begin(), nbs.end());
+    }
+  });
+
+  // whether a vertex is a core, for every vertex searched so far.
+  std::unordered_map<uint64_t, bool> core;
+  for (uint64_t i = 0; i < n; ++i) core[result.vertices[i]] = is_core[i];
+  // one cursor follows the clusters, the other tells their cores apart.
+  typename ImplicitGraph::Cursor walk(graph), probe(graph);
+  const auto is_core_vtx = [&](const uint64_t u) {
+    const auto it = core.find(u);
+    if (it != core.end()) return it->second;
+    return core[u] = probe.Neighbours(u).size() >= min_pts_;
+  };
+  // cluster of every core reached, and the lowest core of each cluster.
+  std::unordered_map<uint64_t, uint64_t> cluster_of;
+  std::vector<uint64_t> lowest_core, frontier;
+  const auto follow = [&](const uint64_t seed) {
+    if (cluster_of.count(seed)) return;
+    const uint64_t cluster = lowest_core.size();
+    lowest_core.push_back(seed);
+    cluster_of[seed] = cluster;
+    frontier.assign(1, seed);
+    while (!frontier.empty()) {
+      const uint64_t u = frontier.back();
+      frontier.pop_back();
+      for (const uint64_t v : walk.Neighbours(u)) {
+        if (cluster_of.count(v) || !is_core_vtx(v)) continue;
+        cluster_of[v] = cluster;
+        lowest_core[cluster] = std::min(lowest_core[cluster], v);
+        frontier.push_back(v);
+      }
+    }
+  };
+
+  result.clusters.assign(n, -1);
+  result.memberships.assign(n, Noise);
+  for (uint64_t i = 0; i < n; ++i) {
+    if (!is_core[i]) continue;
+    follow(result.vertices[i]);
+    result.clusters[i] = lowest_core[cluster_of[result.vertices[i]]];
+    result.memberships[i] = Core;
+  }
+  // the full run's BFS starts from the lowest cores first, so a border
+  // joins the adjacent cluster with the lowest one.
+  for (uint64_t i = 0; i < n; ++i) {
+    if (is_core[i]) continue;
+    for (const uint64_t v : border_nbs[i]) {
+      if (!is_core_vtx(v)) continue;
+      follow(v);
+      const auto lowest = static_cast<int64_t>(lowest_core[cluster_of[v]]);
+      if (result.clusters[i] == -1 || lowest < result.clusters[i])
+        result.clusters[i] = lowest;
+      result.memberships[i] = Border;
     }
-    for (auto& tr : threads) tr.join();
-    curr_level.clear();
-    // sync barrier
-    // flatten next_level and save to curr_level
-    for (const auto& lvl : next_level)
-      curr_level.insert(curr_level.end(), lvl.cbegin(), lvl.cend());
-    // clear next_level
-    for (auto& lvl : next_level) lvl.clear();
-    // ++lvl_cnt;
   }
+  result.num_visited = core.size();
+  return result;
 }
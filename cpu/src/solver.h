@@ -5,7 +5,6 @@
 #ifndef DBSCAN_INCLUDE_SOLVER_H_
 #define DBSCAN_INCLUDE_SOLVER_H_
 
-#include <immintrin.h>
 #include <nmmintrin.h>
 
 #include <fstream>
@@ -13,8 +12,19 @@
 #include <thread>
 
 #include "dataset.h"
+#include "dedup.h"
 #include "graph.h"
+#include "graph_cache.h"
 #include "grid.h"
+#include "finders.h"
+#include "kdtree.h"
+#include "labels.h"
+#include "metric.h"
+#include "metrics.h"
+#include "numa.h"
+#include "planner.h"
+#include "region.h"
+#include "summary.h"
 #include "spdlog/spdlog.h"
 
 namespace DBSCAN {
@@ -23,61 +33,208 @@ class Solver {
  public:
   std::vector<int> cluster_ids;
   std::vector<DBSCAN::membership> memberships;
-  explicit Solver(const std::string&, uint64_t, float, uint8_t);
+  /*
+   * The grid and finalized graph of a run live in an arena owned by the
+   * solver; the adjacency being built lives in a second one, the scratch
+   * arena, which FinalizeGraph rewinds for the next run. |huge_pages| backs
+   * both with (transparent) huge pages.
+   */
+  explicit Solver(const std::string&, uint64_t, float, uint8_t,
+                  bool huge_pages = false);
+  // Cluster a dataset that is already in memory. The points are only read,
+  // so several solvers may share them.
+  Solver(std::shared_ptr<const DBSCAN::input_type::TwoDimPoints>, uint64_t,
+         float, uint8_t, bool huge_pages = false);
+  /*
+   * Start over on another dataset and parameters. The arena is rewound, so
+   * the grid and graph of the previous run are gone, but its blocks and the
+   * label buffers are reused rather than reallocated.
+   */
+  void Reset(std::shared_ptr<const DBSCAN::input_type::TwoDimPoints>,
+             uint64_t, float);
+  /*
+   * Label the same grid and graph again with another min_pts: the labels and
+   * metrics are cleared, ClassifyNoises and IdentifyClusters (or QueryRegion)
+   * can follow.
+   */
+  void set_min_pts(uint64_t);
   /*
    * Construct the search grid. Each cell has range {[x0, x0+eps),[y0, y0+eps)}.
    * The number of vtx of each grid is stored in |grid_vtx_counter_|; the vtx
    * indices reside within each cell is stored in |grid_|.
    */
-  inline void ConstructGrid() { grid_->Construct(dataset_->d1, dataset_->d2); }
+  void ConstructGrid();
+  /*
+   * Build the k-d tree a plan with |Index::KdTree| queries instead of the
+   * grid, see |KdTree|. InsertEdges builds it if that has not happened yet.
+   */
+  void ConstructKdTree();
+  /*
+   * NUMA-aware mode for the grid path of InsertEdges: each thread takes a
+   * horizontal strip of the grid (a contiguous range of vertices in cell
+   * order) and threads are pinned to NUMA nodes in consecutive blocks. Only
+   * the cell-ordered copies of the coordinates are first-touched by the
+   * thread that owns each strip; the adjacency lists stay on the node that
+   * allocates them. The calling thread's affinity is restored afterwards.
+   * The per-node split of local/remote candidate reads, estimated from the
+   * grid ranges rather than measured, is logged and recorded as the
+   * "estimated_local_reads" and "estimated_remote_reads" counts of the
+   * InsertEdges stage. Ignored by a bitmap plan.
+   */
+  void set_numa_aware(const bool numa_aware) { numa_aware_ = numa_aware; }
+  /*
+   * Record cycles, instructions, L1d/LLC/dTLB misses and branch misses of
+   * every thread in each stage's |metrics()|, and log them after the stage.
+   * Where perf_event_open is not permitted it only warns and carries on.
+   */
+  void set_profiling(bool);
+  /*
+   * Replace the dataset by one weighted vertex per group of duplicates, see
+   * |dedup::Collapse|, before the grid or graph is built. ClassifyNoises then
+   * counts the weights of a vertex's neighbours plus its own copies against
+   * min_pts, and IdentifyClusters hands the labels back per input point.
+   */
+  void CollapseDuplicates(float tolerance = 0);
+  /*
+   * Distance used by InsertEdges, see |metric::Euclidean| and the others;
+   * Euclidean by default and kept across Reset. Any other metric always runs
+   * on adjacency lists from the grid, whatever the plan says.
+   */
+  void set_metric(const metric::Metric metric) { metric_ = metric; }
+  /*
+   * Estimate the average degree and the memory of both adjacency
+   * representations from the grid's cell sizes, log what each needs and keep
+   * the fastest that fits |memory_limit| bytes (0 for no limit), see
+   * |planner::Choose|. Constructs the grid if that has not happened yet.
+   */
+  const planner::Plan& PlanGraph(uint64_t memory_limit = 0);
+  // Force a representation, kernel and labeller instead. Kept across Reset.
+  void set_plan(const planner::Plan& plan) { plan_ = plan; }
+  // Adjacency lists, the widest kernel and the BFS until PlanGraph or
+  // set_plan.
+  [[nodiscard]] const planner::Plan& plan() const { return plan_; }
   /*
    * For each two vertices, if the distance is <= |squared_radius_|, insert them
-   * into the graph (|temp_adj_|).
+   * into the graph (|temp_adj_|): every pair into a bitmap, or the grid
+   * candidates into adjacency lists or a blocked bitmap, as the plan says.
+   * The latter two construct the grid first if needed. The adjacency lists
+   * may take their candidates from a k-d tree instead (|planner::Plan::index|).
+   * An implicit plan inserts nothing: ClassifyNoises and IdentifyClusters
+   * search the grid for the edges instead.
    */
   void InsertEdges();
   /*
    * Construct |num_nbs| and |neighbours| from |temp_adj|.
    */
-  void FinalizeGraph() const {
-    using namespace std::chrono;
-    high_resolution_clock::time_point start = high_resolution_clock::now();
-    graph_->Finalize();
-    duration<double> time_spent =
-        duration_cast<duration<double>>(high_resolution_clock::now() - start);
-    logger_->info("FinalizeGraph takes {} seconds", time_spent.count());
-  }
+  void FinalizeGraph();
+  /*
+   * Write the finalized graph with the hash of the dataset, eps and metric,
+   * see |graph_cache::Save|, for a later run with another min_pts. Throws for
+   * an implicit graph, which has no edges to write.
+   */
+  void SaveGraph(const std::string&);
+  /*
+   * Map the graph saved by |SaveGraph| back instead of running ConstructGrid,
+   * InsertEdges and FinalizeGraph; ClassifyNoises can follow right away.
+   * Returns false, and leaves the solver as it was, if there is no such file,
+   * it is not a complete graph cache, or it holds the graph of another
+   * dataset, eps or metric. Only a successful load, hashing included, is
+   * recorded in |metrics()|.
+   */
+  bool LoadGraph(const std::string&);
   /*
    * Classify vertices to Core or Noise; the Border vertices are classified in
    * the BFS stage.
    */
   void ClassifyNoises();
   /*
-   * Initiate a BFS on each un-clustered vertex.
+   * Initiate a BFS on each un-clustered vertex, or join the cores with a
+   * union-find if the plan says so; both number the clusters by their lowest
+   * core and give a border the cluster with the lowest number.
    */
   void IdentifyClusters();
+  /*
+   * Per-cluster size, core count, centroid and bounding box in one parallel
+   * pass over the labels and |dataset_|. Run after IdentifyClusters.
+   */
+  [[nodiscard]] summary::Summary Summarize() const;
+  /*
+   * Labels of the vertices inside |box| as a full run would give them, see
+   * |region::Result|, without the graph: the neighbourhoods of the box and
+   * its eps-halo are searched through the grid, and each cluster that
+   * reaches into the box is followed through its cores to its lowest one.
+   * The cost grows with the box and those clusters rather than with N.
+   * Constructs the grid if that has not happened yet; throws after
+   * CollapseDuplicates.
+   */
+  [[nodiscard]] region::Result QueryRegion(const region::Box&);
+  // The collapsed points from CollapseDuplicates to IdentifyClusters.
+  [[nodiscard]] const DBSCAN::input_type::TwoDimPoints& dataset() const {
+    return *dataset_;
+  }
+  [[nodiscard]] float radius() const { return radius_; }
+  [[nodiscard]] const DBSCAN::utils::Arena& arena() const { return *arena_; }
+  [[nodiscard]] const DBSCAN::utils::Arena& scratch() const {
+    return *scratch_;
+  }
+  // Valid once ConstructGrid has run.
+  [[nodiscard]] const Grid& grid() const { return *grid_; }
+  // Valid once FinalizeGraph has run; not after LoadGraph.
+  [[nodiscard]] const Graph& graph() const { return *graph_; }
+  /*
+   * Wall time, per-thread busy time, peak RSS growth and counts (cells,
+   * candidate pairs, edges, cores, borders, noise, clusters) of every stage
+   * run since the last Reset.
+   */
+  [[nodiscard]] const metrics::Run& metrics() const { return metrics_; }
 
  private:
   uint64_t num_vtx_{}, min_pts_;
-  float squared_radius_;
+  float radius_, squared_radius_;
   uint8_t num_threads_;
+  bool numa_aware_ = false;
+  bool grid_constructed_ = false;
+  metric::Metric metric_ = metric::Metric::Euclidean;
+  planner::Plan plan_;
+  metrics::Run metrics_;
+  // declared before |grid_| and |graph_| so that they outlive them.
+  std::unique_ptr<DBSCAN::utils::Arena> arena_, scratch_;
   std::unique_ptr<Grid> grid_ = nullptr;
+  std::unique_ptr<KdTree> kdtree_ = nullptr;
   std::shared_ptr<spdlog::logger> logger_ = nullptr;
-  /*
-   * Start from |vertex| and visit all the reachable neighbours. If a neighbour
-   * is Noise, relabel it to Border.
-   */
-  void BFS_(uint64_t, int);
+  // The arrays ClassifyNoises and the BFS read: the finalized graph's, or
+  // those of |mapped_graph_|; |graph_ready_| once set by either.
+  const uint64_t *num_nbs_ = nullptr, *start_pos_ = nullptr,
+                 *neighbours_ = nullptr;
+  bool graph_ready_ = false, graph_mapped_ = false;
+  std::unique_ptr<graph_cache::MappedGraph> mapped_graph_ = nullptr;
+  // After CollapseDuplicates: the input points (until IdentifyClusters swaps
+  // them back into |dataset_|), the copies behind each vertex and the vertex
+  // of each input point.
+  std::shared_ptr<const DBSCAN::input_type::TwoDimPoints> input_ = nullptr;
+  std::vector<uint64_t> weights_, vertex_of_;
+  // kept across clusters and runs for the capacity of its frontiers.
+  labels::Bfs bfs_;
+  // The grid bounds, label buffers and metrics header of |dataset_|.
+  void Prepare_();
+  // Whether the label stages search the grid for the edges, see
+  // |Adjacency::Implicit|.
+  [[nodiscard]] bool Implicit_() const {
+    return !graph_mapped_ && graph_ != nullptr &&
+           graph_->adjacency() == Adjacency::Implicit;
+  }
+  // Log and count the local/remote reads of the NUMA-aware mode.
+  void ReportNuma_(const finders::CellRanges&, const numa::Topology&,
+                   metrics::StageScope&) const;
+  template <class Metric>
+  region::Result QueryRegion_(const region::Box&);
 
-#if defined(AVX)
-  const float max_radius_ = std::sqrt(std::numeric_limits<float>::max()) - 1;
-  __m256 sq_rad8_;
-#endif
 #if defined(DBSCAN_TESTING)
  public:
 #else
  private:
 #endif
-  std::unique_ptr<DBSCAN::input_type::TwoDimPoints> dataset_ = nullptr;
+  std::shared_ptr<const DBSCAN::input_type::TwoDimPoints> dataset_ = nullptr;
   std::unique_ptr<Graph> graph_ = nullptr;
 };
 }  // namespace DBSCAN
@@ -0,0 +1,95 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#ifndef DBSCAN_INCLUDE_STORES_H_
+#define DBSCAN_INCLUDE_STORES_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "graph.h"
+
+namespace DBSCAN {
+namespace stores {
+/*
+ * A graph store takes the neighbours a finder of finders.h reports, one
+ * store per insert thread, and writes them through an unchecked writer of
+ * |Graph|. A finder either opens the row of a vertex (|Begin|, with its word
+ * spans in cell order), reports them (|Add|: bit k of |mask| is |ids[k]|;
+ * |AddWord|: the same for word |idx| of the row) and closes it (|End|), or
+ * hands over a whole row (|Row|) or bitmap word (|Set|) at once. Each store
+ * only has the calls it can take.
+ */
+
+// Gathers the neighbours of one row; the implicit store reads them here.
+class List {
+ public:
+  void Begin(const uint64_t u) {
+    u_ = u;
+    edges_.clear();
+  }
+  void Begin(const uint64_t u, const Graph::WordSpans&) { Begin(u); }
+  void Add(const uint64_t* const ids, uint64_t mask) {
+    while (mask) {
+      edges_.push_back(ids[__builtin_ctzll(mask)]);
+      mask &= mask - 1;
+    }
+  }
+  void AddWord(const uint64_t* const ids, uint64_t, const uint64_t mask) {
+    Add(ids, mask);
+  }
+  void End() {}
+  [[nodiscard]] const std::vector<uint64_t>& edges() const { return edges_; }
+
+ protected:
+  uint64_t u_ = 0;
+  std::vector<uint64_t> edges_;
+};
+
+// Adjacency lists: each row is gathered, then written at once.
+class Csr : public List {
+ public:
+  explicit Csr(const Graph::CsrWriter writer) : writer_(writer) {}
+  void End() { writer_.Assign(u_, edges_.data(), edges_.size()); }
+  void Row(const uint64_t u, const uint64_t* const vs, const uint64_t n) {
+    writer_.Assign(u, vs, n);
+  }
+
+ private:
+  Graph::CsrWriter writer_;
+};
+
+// Blocked bitmap rows over the word spans of the cell order.
+class Blocked {
+ public:
+  explicit Blocked(const Graph::BitmapWriter writer) : writer_(writer) {}
+  void Begin(const uint64_t u, const Graph::WordSpans& spans) {
+    u_ = u;
+    writer_.StartRow(u, spans);
+  }
+  void AddWord(const uint64_t*, const uint64_t idx, const uint64_t mask) {
+    if (mask) writer_.Set(u_, idx, mask);
+  }
+  void End() {}
+
+ private:
+  Graph::BitmapWriter writer_;
+  uint64_t u_ = 0;
+};
+
+// Full bitmap rows, a word at a time.
+class Bitmap {
+ public:
+  explicit Bitmap(const Graph::BitmapWriter writer) : writer_(writer) {}
+  void Set(const uint64_t u, const uint64_t idx, const uint64_t mask) {
+    writer_.Set(u, idx, mask);
+  }
+
+ private:
+  Graph::BitmapWriter writer_;
+};
+}  // namespace stores
+}  // namespace DBSCAN
+
+#endif  // DBSCAN_INCLUDE_STORES_H_
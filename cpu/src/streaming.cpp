@@ -0,0 +1,90 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#include "streaming.h"
+
+#include <sstream>
+
+DBSCAN::streaming::ReplaySource::ReplaySource(const std::string& input)
+    : ifs_(input) {
+  if (!ifs_) throw std::runtime_error("cannot open " + input);
+}
+
+bool DBSCAN::streaming::ReplaySource::Next(TimedPoint& p) {
+  return static_cast<bool>(ifs_ >> p.t >> p.x >> p.y);
+}
+
+// ctor
+DBSCAN::streaming::WindowedSolver::WindowedSolver(const uint64_t min_pts,
+                                                  const float radius,
+                                                  const double window,
+                                                  const double cadence,
+                                                  Callback callback)
+    : solver_(min_pts, radius),
+      window_len_(window),
+      cadence_(cadence),
+      now_(0),
+      next_emit_(0),
+      callback_(std::move(callback)) {
+  logger_ = spdlog::get("console");
+  if (logger_ == nullptr) {
+    throw std::runtime_error("logger not created!");
+  }
+  if (window_len_ <= 0 || cadence_ <= 0) {
+    throw std::runtime_error("window and cadence must be positive!");
+  }
+}
+
+void DBSCAN::streaming::WindowedSolver::Push(const TimedPoint& p) {
+  if (!started_) {
+    started_ = true;
+    now_ = p.t;
+    next_emit_ = p.t + cadence_;
+  }
+  if (p.t < now_) {
+    std::ostringstream oss;
+    oss << "t=" << p.t << " arrives after t=" << now_ << "!";
+    throw std::runtime_error(oss.str());
+  }
+  // emit every boundary passed before this point arrives.
+  while (next_emit_ <= p.t) {
+    now_ = next_emit_;
+    Expire_(now_);
+    Emit_();
+    next_emit_ += cadence_;
+  }
+  now_ = p.t;
+  Expire_(now_);
+  window_.emplace_back(p, solver_.Insert(p.x, p.y));
+}
+
+void DBSCAN::streaming::WindowedSolver::Flush() {
+  if (!started_) return;
+  Expire_(now_);
+  Emit_();
+}
+
+void DBSCAN::streaming::WindowedSolver::Expire_(const double now) {
+  while (!window_.empty() && window_.front().first.t <= now - window_len_) {
+    solver_.Erase(window_.front().second);
+    window_.pop_front();
+  }
+}
+
+void DBSCAN::streaming::WindowedSolver::Emit_() {
+  std::vector<int> cluster_ids;
+  std::vector<DBSCAN::membership> memberships;
+  solver_.Labels(cluster_ids, memberships);
+  Snapshot snapshot{now_, {}, {}, {}};
+  snapshot.points.reserve(window_.size());
+  snapshot.cluster_ids.reserve(window_.size());
+  snapshot.memberships.reserve(window_.size());
+  for (const auto& [p, vtx] : window_) {
+    snapshot.points.push_back(p);
+    snapshot.cluster_ids.push_back(cluster_ids[vtx]);
+    snapshot.memberships.push_back(memberships[vtx]);
+  }
+  logger_->debug("t={}: {} points in window", now_, window_.size());
+  callback_(snapshot);
+}
@@ -0,0 +1,81 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#ifndef DBSCAN_INCLUDE_STREAMING_H_
+#define DBSCAN_INCLUDE_STREAMING_H_
+
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "DBSCAN/membership.h"
+#include "incremental.h"
+#include "spdlog/spdlog.h"
+
+namespace DBSCAN {
+namespace streaming {
+struct TimedPoint {
+  double t;
+  float x, y;
+};
+
+/*
+ * Labels of every point inside the window at stream time |time|, oldest point
+ * first.
+ */
+struct Snapshot {
+  double time;
+  std::vector<TimedPoint> points;
+  std::vector<int> cluster_ids;
+  std::vector<DBSCAN::membership> memberships;
+};
+
+/*
+ * Replays a recorded feed. Each line of the file is "<t> <x> <y>" with
+ * non-decreasing timestamps in seconds.
+ */
+class ReplaySource {
+ public:
+  explicit ReplaySource(const std::string&);
+  bool Next(TimedPoint&);
+
+ private:
+  std::ifstream ifs_;
+};
+
+/*
+ * Clusters the points of the last |window| seconds of an ordered stream. Each
+ * pushed point is inserted into an |IncrementalSolver| and points that fall
+ * out of the window are erased from it, so the grid cells and neighbour counts
+ * are kept up to date without re-running the full pipeline. A |Snapshot| is
+ * handed to the callback every |cadence| seconds of stream time.
+ */
+class WindowedSolver {
+ public:
+  using Callback = std::function<void(const Snapshot&)>;
+  WindowedSolver(uint64_t, float, double, double, Callback);
+  void Push(const TimedPoint&);
+  // Emit a snapshot at the time of the last pushed point.
+  void Flush();
+  [[nodiscard]] uint64_t num_points() const { return window_.size(); }
+
+ private:
+  IncrementalSolver solver_;
+  double window_len_, cadence_;
+  double now_, next_emit_;
+  bool started_ = false;
+  Callback callback_;
+  std::shared_ptr<spdlog::logger> logger_ = nullptr;
+  // points in arrival order with their vertex id in |solver_|.
+  std::deque<std::pair<TimedPoint, uint64_t>> window_;
+
+  void Expire_(double);
+  void Emit_();
+};
+}  // namespace streaming
+}  // namespace DBSCAN
+
+#endif  // DBSCAN_INCLUDE_STREAMING_H_
@@ -0,0 +1,141 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#include "summary.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+#include "spdlog/fmt/fmt.h"
+#include "threads.h"
+
+namespace {
+float Fraction_(const DBSCAN::summary::ClusterStats& stats,
+                const DBSCAN::summary::Summary& summary) {
+  return summary.num_vtx ? static_cast<float>(stats.size) / summary.num_vtx : 0;
+}
+}  // namespace
+
+void DBSCAN::summary::ClusterStats::Add(const float x, const float y,
+                                        const bool is_core) {
+  ++size;
+  num_core += is_core;
+  sum_x += x;
+  sum_y += y;
+  min_x = std::min(min_x, x);
+  min_y = std::min(min_y, y);
+  max_x = std::max(max_x, x);
+  max_y = std::max(max_y, y);
+}
+
+void DBSCAN::summary::ClusterStats::Merge(const ClusterStats& other) {
+  size += other.size;
+  num_core += other.num_core;
+  sum_x += other.sum_x;
+  sum_y += other.sum_y;
+  min_x = std::min(min_x, other.min_x);
+  min_y = std::min(min_y, other.min_y);
+  max_x = std::max(max_x, other.max_x);
+  max_y = std::max(max_y, other.max_y);
+}
+
+DBSCAN::summary::Summary DBSCAN::summary::Summarize(
+    const DBSCAN::input_type::TwoDimPoints& dataset,
+    const std::vector<int>& cluster_ids,
+    const std::vector<DBSCAN::membership>& memberships,
+    const uint8_t num_threads) {
+  const uint64_t num_vtx = cluster_ids.size();
+  if (dataset.d1.size() != num_vtx || memberships.size() != num_vtx)
+    throw std::runtime_error("dataset, cluster ids and memberships differ!");
+  std::vector<Summary> partials(num_threads);
+  DBSCAN::utils::run_threads(num_threads, [&](const uint8_t tid) {
+    auto& partial = partials[tid];
+    const uint64_t begin = num_vtx * tid / num_threads;
+    const uint64_t end = num_vtx * (tid + 1) / num_threads;
+    for (uint64_t vtx = begin; vtx < end; ++vtx) {
+      const int id = cluster_ids[vtx];
+      if (id < 0) {
+        partial.noise.Add(dataset.d1[vtx], dataset.d2[vtx], false);
+        continue;
+      }
+      if (static_cast<uint64_t>(id) >= partial.clusters.size())
+        partial.clusters.resize(id + 1);
+      partial.clusters[id].Add(dataset.d1[vtx], dataset.d2[vtx],
+                               memberships[vtx] == DBSCAN::membership::Core);
+    }
+  });
+
+  Summary summary;
+  summary.num_vtx = num_vtx;
+  for (const auto& partial : partials) {
+    if (partial.clusters.size() > summary.clusters.size())
+      summary.clusters.resize(partial.clusters.size());
+    for (uint64_t id = 0; id < partial.clusters.size(); ++id)
+      summary.clusters[id].Merge(partial.clusters[id]);
+    summary.noise.Merge(partial.noise);
+  }
+  return summary;
+}
+
+DBSCAN::summary::Format DBSCAN::summary::ParseFormat(
+    const std::string& format) {
+  if (format == "csv") return Format::Csv;
+  if (format == "binary") return Format::Binary;
+  throw std::runtime_error("unknown summary format " + format);
+}
+
+void DBSCAN::summary::WriteCsv(std::ostream& os, const Summary& summary) {
+  os << "cluster,size,num_core,centroid_x,centroid_y,min_x,min_y,max_x,max_y,"
+        "fraction\n";
+  const auto row = [&os, &summary](const int id, const ClusterStats& s) {
+    os << fmt::format("{},{},{},{},{},{},{},{},{},{}\n", id, s.size,
+                      s.num_core, s.centroid_x(), s.centroid_y(), s.min_x,
+                      s.min_y, s.max_x, s.max_y,
+                      Fraction_(s, summary));
+  };
+  for (uint64_t id = 0; id < summary.clusters.size(); ++id)
+    row(id, summary.clusters[id]);
+  row(-1, summary.noise);
+}
+
+void DBSCAN::summary::WriteBinary(std::ostream& os, const Summary& summary) {
+  const auto row = [&os, &summary](const int32_t id, const ClusterStats& s) {
+    char record[48];
+    const float floats[] = {s.centroid_x(),
+                            s.centroid_y(),
+                            s.min_x,
+                            s.min_y,
+                            s.max_x,
+                            s.max_y,
+                            Fraction_(s, summary)};
+    std::memcpy(record, &id, 4);
+    std::memcpy(record + 4, &s.size, 8);
+    std::memcpy(record + 12, &s.num_core, 8);
+    std::memcpy(record + 20, floats, sizeof(floats));
+    os.write(record, sizeof(record));
+  };
+  for (uint64_t id = 0; id < summary.clusters.size(); ++id)
+    row(id, summary.clusters[id]);
+  row(-1, summary.noise);
+}
+
+void DBSCAN::summary::Write(const std::string& path, const Format format,
+                            const Summary& summary) {
+  std::ofstream ofs;
+  if (path != "-") {
+    ofs.open(path, std::ios::binary);
+    if (!ofs) throw std::runtime_error("cannot open " + path);
+  }
+  std::ostream& os = path == "-" ? std::cout : ofs;
+  if (format == Format::Csv) {
+    WriteCsv(os, summary);
+  } else {
+    WriteBinary(os, summary);
+  }
+  os.flush();
+  if (!os) throw std::runtime_error("failed writing " + path);
+}
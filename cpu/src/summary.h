@@ -0,0 +1,72 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#ifndef DBSCAN_INCLUDE_SUMMARY_H_
+#define DBSCAN_INCLUDE_SUMMARY_H_
+
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "DBSCAN/membership.h"
+#include "dataset.h"
+
+namespace DBSCAN {
+namespace summary {
+struct ClusterStats {
+  uint64_t size = 0, num_core = 0;
+  double sum_x = 0, sum_y = 0;
+  float min_x = std::numeric_limits<float>::max(),
+        min_y = std::numeric_limits<float>::max(),
+        max_x = std::numeric_limits<float>::lowest(),
+        max_y = std::numeric_limits<float>::lowest();
+
+  void Add(float, float, bool);
+  void Merge(const ClusterStats&);
+  [[nodiscard]] float centroid_x() const { return size ? sum_x / size : 0; }
+  [[nodiscard]] float centroid_y() const { return size ? sum_y / size : 0; }
+};
+
+struct Summary {
+  // indexed by cluster id
+  std::vector<ClusterStats> clusters;
+  ClusterStats noise;
+  uint64_t num_vtx = 0;
+  [[nodiscard]] double noise_fraction() const {
+    return num_vtx ? static_cast<double>(noise.size) / num_vtx : 0;
+  }
+};
+
+/*
+ * Size, core count, centroid and bounding box of every cluster, and of the
+ * Noise vertices. Each of |num_threads| threads aggregates a contiguous range
+ * of vertices into its own partials, which are merged at the end.
+ */
+Summary Summarize(const DBSCAN::input_type::TwoDimPoints&,
+                  const std::vector<int>&,
+                  const std::vector<DBSCAN::membership>&, uint8_t);
+
+enum class Format { Csv, Binary };
+// "csv" or "binary".
+Format ParseFormat(const std::string&);
+/*
+ * One row per cluster in id order and a last row for Noise with id -1:
+ * cluster,size,num_core,centroid_x,centroid_y,min_x,min_y,max_x,max_y,fraction
+ * where |fraction| is the share of all vertices in that row.
+ */
+void WriteCsv(std::ostream&, const Summary&);
+/*
+ * The same rows as packed 48-byte records in host byte order: int32 cluster,
+ * uint64 size, uint64 num_core, then float centroid_x, centroid_y, min_x,
+ * min_y, max_x, max_y and fraction. No header.
+ */
+void WriteBinary(std::ostream&, const Summary&);
+// Writes to |path|, or to stdout if it is "-".
+void Write(const std::string&, Format, const Summary&);
+}  // namespace summary
+}  // namespace DBSCAN
+
+#endif  // DBSCAN_INCLUDE_SUMMARY_H_
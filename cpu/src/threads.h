@@ -0,0 +1,52 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#ifndef DBSCAN_INCLUDE_THREADS_H_
+#define DBSCAN_INCLUDE_THREADS_H_
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace DBSCAN {
+namespace utils {
+/*
+ * While set, |run_threads| calls made from this thread add the busy seconds
+ * of each tid to |(*thread_busy_sink)[tid]|, growing it as needed. Worker
+ * threads do not inherit it, so nested calls are not counted twice.
+ */
+inline thread_local std::vector<double>* thread_busy_sink = nullptr;
+
+// Runs |fn(tid)| for every tid in [0, num_threads) on its own thread and joins
+// them. A single-threaded run calls |fn(0)| on the calling thread instead, so
+// small inputs do not pay for a thread spawn per stage.
+template <class F>
+void run_threads(const uint8_t num_threads, F&& fn) {
+  std::vector<double>* const sink = thread_busy_sink;
+  if (sink != nullptr && sink->size() < num_threads) sink->resize(num_threads);
+  const auto timed = [&fn, sink](const uint8_t tid) {
+    if (sink == nullptr) {
+      fn(tid);
+      return;
+    }
+    const auto t0 = std::chrono::steady_clock::now();
+    fn(tid);
+    const auto t1 = std::chrono::steady_clock::now();
+    (*sink)[tid] += std::chrono::duration<double>(t1 - t0).count();
+  };
+  if (num_threads == 1) {
+    timed(0);
+    return;
+  }
+  std::vector<std::thread> threads(num_threads);
+  for (uint8_t tid = 0; tid < num_threads; ++tid) {
+    threads[tid] = std::thread(timed, tid);
+  }
+  for (auto& tr : threads) tr.join();
+}
+}  // namespace utils
+}  // namespace DBSCAN
+
+#endif  // DBSCAN_INCLUDE_THREADS_H_
@@ -0,0 +1,65 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#include "tiled.h"
+
+#include <chrono>
+
+#include "partition.h"
+#include "threads.h"
+
+// ctor
+DBSCAN::TiledSolver::TiledSolver(const uint64_t min_pts, const float radius,
+                                 const uint8_t num_threads)
+    : min_pts_(min_pts), radius_(radius), num_threads_(num_threads) {
+  logger_ = spdlog::get("console");
+  if (logger_ == nullptr) {
+    throw std::runtime_error("logger not created!");
+  }
+  if (num_threads_ == 0) throw std::runtime_error("need at least one thread!");
+}
+
+void DBSCAN::TiledSolver::Run(const DBSCAN::input_type::TwoDimPoints& dataset,
+                              std::vector<int>& cluster_ids,
+                              std::vector<DBSCAN::membership>& memberships) {
+  using namespace std::chrono;
+  auto t0 = high_resolution_clock::now();
+  const auto tiles =
+      DBSCAN::partition::KdSplit(dataset, radius_, num_threads_);
+  auto t1 = high_resolution_clock::now();
+  logger_->info("splitting into {} tiles takes {} seconds", tiles.size(),
+                duration_cast<duration<double>>(t1 - t0).count());
+
+  std::vector<DBSCAN::partition::PartResult> results(tiles.size());
+  DBSCAN::utils::run_threads(num_threads_, [&](const uint8_t tid) {
+    auto p_t0 = high_resolution_clock::now();
+    const auto& tile = tiles[tid];
+    // owned vertices first, then the halo.
+    std::vector<uint64_t> ids(tile.owned);
+    ids.insert(ids.end(), tile.halo.cbegin(), tile.halo.cend());
+    auto points =
+        std::make_unique<DBSCAN::input_type::TwoDimPoints>(ids.size());
+    for (uint64_t i = 0; i < ids.size(); ++i) {
+      points->d1[i] = dataset.d1[ids[i]];
+      points->d2[i] = dataset.d2[ids[i]];
+    }
+    results[tid] = DBSCAN::partition::ClusterPart(
+        ids, tile.owned.size(), std::move(points), min_pts_, radius_, 1u);
+    auto p_t1 = high_resolution_clock::now();
+    logger_->info("\tTile {} ({} owned, {} halo) takes {} seconds", tid,
+                  tile.owned.size(), tile.halo.size(),
+                  duration_cast<duration<double>>(p_t1 - p_t0).count());
+  });
+  auto t2 = high_resolution_clock::now();
+  logger_->info("clustering tiles takes {} seconds",
+                duration_cast<duration<double>>(t2 - t1).count());
+
+  DBSCAN::partition::Merger merger(dataset.d1.size());
+  for (uint64_t t = 0; t < tiles.size(); ++t)
+    merger.Add(tiles[t].owned, results[t]);
+  merger.Finish(cluster_ids, memberships);
+  auto t3 = high_resolution_clock::now();
+  logger_->info("merging tiles takes {} seconds",
+                duration_cast<duration<double>>(t3 - t2).count());
+}
@@ -0,0 +1,40 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#ifndef DBSCAN_INCLUDE_TILED_H_
+#define DBSCAN_INCLUDE_TILED_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "DBSCAN/membership.h"
+#include "dataset.h"
+#include "spdlog/spdlog.h"
+
+namespace DBSCAN {
+/*
+ * Spatial-partition alternative to the vertex-strided pipeline of |Solver|.
+ * The grid is split into one tile per thread with |partition::KdSplit| and
+ * each thread runs an independent single-threaded |Solver| on its tile plus
+ * a one-cell halo, with its own small grid, graph and labels, so nothing is
+ * written across threads while clustering. Clusters that meet across tile
+ * borders are then merged by |partition::Merger|. Unlike the multi-threaded
+ * BFS the labels are deterministic and match a single-threaded |Solver|.
+ */
+class TiledSolver {
+ public:
+  TiledSolver(uint64_t, float, uint8_t);
+  void Run(const DBSCAN::input_type::TwoDimPoints&, std::vector<int>&,
+           std::vector<DBSCAN::membership>&);
+
+ private:
+  uint64_t min_pts_;
+  float radius_;
+  uint8_t num_threads_;
+  std::shared_ptr<spdlog::logger> logger_ = nullptr;
+};
+}  // namespace DBSCAN
+
+#endif  // DBSCAN_INCLUDE_TILED_H_
@@ -0,0 +1,120 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#include "transport.h"
+
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <sstream>
+
+#include "spdlog/spdlog.h"
+
+namespace {
+void WriteAll(const int fd, const char* p, uint64_t n) {
+  while (n > 0) {
+    // a worker that died must not kill the coordinator with SIGPIPE.
+    const ssize_t written = send(fd, p, n, MSG_NOSIGNAL);
+    if (written < 0 && errno == EINTR) continue;
+    if (written <= 0) throw std::runtime_error("channel write failed!");
+    p += written;
+    n -= written;
+  }
+}
+
+void ReadAll(const int fd, char* p, uint64_t n) {
+  while (n > 0) {
+    const ssize_t got = read(fd, p, n);
+    if (got < 0 && errno == EINTR) continue;
+    if (got <= 0) throw std::runtime_error("channel closed by peer!");
+    p += got;
+    n -= got;
+  }
+}
+}  // namespace
+
+DBSCAN::transport::SocketChannel::~SocketChannel() { close(fd_); }
+
+void DBSCAN::transport::SocketChannel::Send(const Message& msg) {
+  const uint64_t n = msg.bytes.size();
+  WriteAll(fd_, reinterpret_cast<const char*>(&n), sizeof(n));
+  WriteAll(fd_, msg.bytes.data(), n);
+}
+
+DBSCAN::transport::Message DBSCAN::transport::SocketChannel::Receive() {
+  uint64_t n;
+  ReadAll(fd_, reinterpret_cast<char*>(&n), sizeof(n));
+  if (n > max_bytes_) {
+    std::ostringstream oss;
+    oss << "message of " << n << " bytes exceeds the limit of " << max_bytes_
+        << "!";
+    throw std::runtime_error(oss.str());
+  }
+  Message msg;
+  msg.bytes.resize(n);
+  ReadAll(fd_, msg.bytes.data(), n);
+  return msg;
+}
+
+DBSCAN::transport::ForkTransport::~ForkTransport() {
+  // reap workers of a run that threw before Join.
+  for (const auto pid : pids_) waitpid(pid, nullptr, 0);
+}
+
+std::vector<std::unique_ptr<DBSCAN::transport::Channel>>
+DBSCAN::transport::ForkTransport::Spawn(const uint32_t num_workers,
+                                        const Worker& worker) {
+  std::vector<std::unique_ptr<Channel>> channels;
+  std::vector<int> parent_fds;
+  for (uint32_t w = 0; w < num_workers; ++w) {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+      throw std::runtime_error("socketpair failed!");
+    // flush so the child does not print the parent's buffered output again.
+    fflush(stdout);
+    fflush(stderr);
+    const pid_t pid = fork();
+    if (pid < 0) throw std::runtime_error("fork failed!");
+    if (pid == 0) {
+      // only keep this worker's end.
+      close(fds[0]);
+      for (const auto fd : parent_fds) close(fd);
+      int status = 0;
+      try {
+        SocketChannel channel(fds[1]);
+        worker(channel);
+      } catch (const std::exception& e) {
+        if (auto logger = spdlog::get("console"))
+          logger->error("worker {} failed: {}", w, e.what());
+        status = 1;
+      }
+      if (auto logger = spdlog::get("console")) logger->flush();
+      _exit(status);
+    }
+    close(fds[1]);
+    parent_fds.push_back(fds[0]);
+    channels.push_back(std::make_unique<SocketChannel>(fds[0]));
+    pids_.push_back(pid);
+  }
+  return channels;
+}
+
+void DBSCAN::transport::ForkTransport::Join() {
+  uint32_t num_failed = 0;
+  for (const auto pid : pids_) {
+    int status;
+    if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) ||
+        WEXITSTATUS(status) != 0)
+      ++num_failed;
+  }
+  pids_.clear();
+  if (num_failed > 0) {
+    std::ostringstream oss;
+    oss << num_failed << " worker(s) failed!";
+    throw std::runtime_error(oss.str());
+  }
+}
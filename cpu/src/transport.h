@@ -0,0 +1,140 @@
+//
+// Created by William Liu on 2026-10-18.
+//
+
+#ifndef DBSCAN_INCLUDE_TRANSPORT_H_
+#define DBSCAN_INCLUDE_TRANSPORT_H_
+
+#include <sys/types.h>
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace DBSCAN {
+namespace transport {
+/*
+ * A flat byte buffer of trivially copyable values and length-prefixed arrays,
+ * read back in the order they were put.
+ */
+class Message {
+ public:
+  std::vector<char> bytes;
+
+  template <class T>
+  void Put(const T& val) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    const auto p = reinterpret_cast<const char*>(&val);
+    bytes.insert(bytes.end(), p, p + sizeof(T));
+  }
+  template <class T, class Alloc>
+  void Put(const std::vector<T, Alloc>& vals) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    Put<uint64_t>(vals.size());
+    const auto p = reinterpret_cast<const char*>(vals.data());
+    bytes.insert(bytes.end(), p, p + vals.size() * sizeof(T));
+  }
+  void Put(const std::string& str) {
+    Put(std::vector<char>(str.cbegin(), str.cend()));
+  }
+  template <class T>
+  T Get() {
+    T val;
+    Read_(&val, sizeof(T));
+    return val;
+  }
+  template <class T>
+  std::vector<T> GetVector() {
+    const auto n = Get<uint64_t>();
+    // before allocating: the count comes off the wire.
+    if (n > (bytes.size() - pos_) / sizeof(T))
+      throw std::runtime_error("message is truncated!");
+    std::vector<T> vals(n);
+    Read_(vals.data(), n * sizeof(T));
+    return vals;
+  }
+  std::string GetString() {
+    const auto chars = GetVector<char>();
+    return {chars.cbegin(), chars.cend()};
+  }
+
+ private:
+  uint64_t pos_ = 0;
+
+  void Read_(void* dst, const uint64_t n) {
+    if (n > bytes.size() - pos_)
+      throw std::runtime_error("message is truncated!");
+    std::memcpy(dst, bytes.data() + pos_, n);
+    pos_ += n;
+  }
+};
+
+// A bidirectional link between the coordinator and one worker.
+class Channel {
+ public:
+  virtual ~Channel() = default;
+  virtual void Send(const Message&) = 0;
+  // Blocks until a whole message arrives; throws if the peer is gone.
+  virtual Message Receive() = 0;
+};
+
+/*
+ * Starts workers and connects them to the coordinator. Backends for other
+ * hosts only need to implement these two calls.
+ */
+class Transport {
+ public:
+  using Worker = std::function<void(Channel&)>;
+  virtual ~Transport() = default;
+  // Starts |num_workers| workers, each running |worker| on its end of a
+  // channel, and returns the coordinator's end of every channel.
+  virtual std::vector<std::unique_ptr<Channel>> Spawn(uint32_t,
+                                                      const Worker&) = 0;
+  // Waits for every worker; throws if any of them failed.
+  virtual void Join() = 0;
+};
+
+/*
+ * Channel over a connected stream socket; messages are length-prefixed.
+ * |Receive| throws on a length over |max_bytes| rather than allocating it.
+ */
+class SocketChannel : public Channel {
+ public:
+  static constexpr uint64_t kMaxBytes = 1ull << 34;
+  explicit SocketChannel(int fd, uint64_t max_bytes = kMaxBytes)
+      : fd_(fd), max_bytes_(max_bytes) {}
+  ~SocketChannel() override;
+  SocketChannel(const SocketChannel&) = delete;
+  SocketChannel& operator=(const SocketChannel&) = delete;
+  void Send(const Message&) override;
+  Message Receive() override;
+  [[nodiscard]] int fd() const { return fd_; }
+
+ private:
+  int fd_;
+  uint64_t max_bytes_;
+};
+
+/*
+ * Runs every worker in a child process forked from the coordinator, talking
+ * over a Unix socket pair, so N workers can be tested on one host.
+ */
+class ForkTransport : public Transport {
+ public:
+  ~ForkTransport() override;
+  std::vector<std::unique_ptr<Channel>> Spawn(uint32_t,
+                                              const Worker&) override;
+  void Join() override;
+
+ private:
+  std::vector<pid_t> pids_;
+};
+}  // namespace transport
+}  // namespace DBSCAN
+
+#endif  // DBSCAN_INCLUDE_TRANSPORT_H_
@@ -5,8 +5,41 @@
 #include <gmock/gmock.h>  // ASSERT_THAT, testing::ElementsAre
 #include <gtest/gtest.h>
 
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <sstream>
+
+#include "approx.h"
+#include "batch.h"
+#include "dedup.h"
+#include "distributed.h"
+#include "generator.h"
 #include "graph.h"
+#include "incremental.h"
+#include "kdtree.h"
+#include "kernels.h"
+#include "loops.h"
+#include "metric.h"
+#include "metrics.h"
+#include "model.h"
+#include "numa.h"
+#include "output.h"
+#include "partition.h"
+#include "server.h"
 #include "solver.h"
+#include "streaming.h"
+#include "summary.h"
+#include "threads.h"
+#include "tiled.h"
 #include "spdlog/sinks/stdout_color_sinks.h"
 
 namespace DBSCAN_TestVariables {
@@ -27,113 +60,129 @@ TEST(Graph, ctor_success) {
   EXPECT_TRUE(g.neighbours.empty());
 }
 
+// The bitmap rows take a word index and a mask; the lists take the vertex.
+const DBSCAN::Adjacency kGraphAdjacencies[] = {DBSCAN::Adjacency::Bitmap,
+                                               DBSCAN::Adjacency::Csr};
+
 TEST(Graph, insert_edge_success) {
-  DBSCAN::Graph g(5, 1);
-#if defined(BIT_ADJ)
-  ASSERT_NO_THROW(g.InsertEdge(2, 0, 1u << 1u));
-  ASSERT_NO_THROW(g.InsertEdge(2, 0, 1u << 4u));
-  ASSERT_NO_THROW(g.InsertEdge(2, 0, 1u << 0u));
-  ASSERT_NO_THROW(g.InsertEdge(0, 0, 1u << 3u));
-#else
-  ASSERT_NO_THROW(g.InsertEdge(2, 1));
-  ASSERT_NO_THROW(g.InsertEdge(2, 4));
-  ASSERT_NO_THROW(g.InsertEdge(2, 0));
-  ASSERT_NO_THROW(g.InsertEdge(0, 3));
-#endif
+  for (const auto adjacency : kGraphAdjacencies) {
+    DBSCAN::Graph g(5, 1, nullptr, adjacency);
+    if (adjacency == DBSCAN::Adjacency::Bitmap) {
+      ASSERT_NO_THROW(g.InsertEdge(2, 0, 1u << 1u));
+      ASSERT_NO_THROW(g.InsertEdge(2, 0, 1u << 4u));
+      ASSERT_NO_THROW(g.InsertEdge(2, 0, 1u << 0u));
+      ASSERT_NO_THROW(g.InsertEdge(0, 0, 1u << 3u));
+    } else {
+      ASSERT_NO_THROW(g.InsertEdge(2, 1));
+      ASSERT_NO_THROW(g.InsertEdge(2, 4));
+      ASSERT_NO_THROW(g.InsertEdge(2, 0));
+      ASSERT_NO_THROW(g.InsertEdge(0, 3));
+    }
+  }
 }
 
 TEST(Graph, insert_edge_failed_oob) {
-  DBSCAN::Graph g(5, 1);
-#if defined(BIT_ADJ)
-  ASSERT_NO_THROW(g.InsertEdge(2, 0, 1u << 1u));
-  ASSERT_THROW(g.InsertEdge(0, 1, 1u << 5u), std::runtime_error);
-  ASSERT_THROW(g.InsertEdge(-1, 0, 1u << 2u), std::runtime_error);
-  ASSERT_THROW(g.InsertEdge(-2, 0, 1u << 9u), std::runtime_error);
-#else
-  ASSERT_NO_THROW(g.InsertEdge(2, 1));
-  ASSERT_THROW(g.InsertEdge(0, 5), std::runtime_error);
-  ASSERT_THROW(g.InsertEdge(-1, 2), std::runtime_error);
-  ASSERT_THROW(g.InsertEdge(-2, 9), std::runtime_error);
-#endif
+  for (const auto adjacency : kGraphAdjacencies) {
+    DBSCAN::Graph g(5, 1, nullptr, adjacency);
+    if (adjacency == DBSCAN::Adjacency::Bitmap) {
+      ASSERT_NO_THROW(g.InsertEdge(2, 0, 1u << 1u));
+      ASSERT_THROW(g.InsertEdge(0, 1, 1u << 5u), std::runtime_error);
+      ASSERT_THROW(g.InsertEdge(-1, 0, 1u << 2u), std::runtime_error);
+      ASSERT_THROW(g.InsertEdge(-2, 0, 1u << 9u), std::runtime_error);
+    } else {
+      ASSERT_NO_THROW(g.InsertEdge(2, 1));
+      ASSERT_THROW(g.InsertEdge(0, 5), std::runtime_error);
+      ASSERT_THROW(g.InsertEdge(-1, 2), std::runtime_error);
+      ASSERT_THROW(g.InsertEdge(-2, 9), std::runtime_error);
+    }
+  }
 }
 
 TEST(Graph, finalize_success) {
-  DBSCAN::Graph g(5, 1);
-#if defined(BIT_ADJ)
-  ASSERT_NO_THROW(g.InsertEdge(2, 0, 1u << 1u));
-  ASSERT_NO_THROW(g.InsertEdge(1, 0, 1u << 2u));
-  ASSERT_NO_THROW(g.InsertEdge(2, 0, 1u << 4u));
-  ASSERT_NO_THROW(g.InsertEdge(4, 0, 1u << 2u));
-  ASSERT_NO_THROW(g.InsertEdge(2, 0, 1u << 0u));
-  ASSERT_NO_THROW(g.InsertEdge(0, 0, 1u << 2u));
-  ASSERT_NO_THROW(g.InsertEdge(0, 0, 1u << 3u));
-  ASSERT_NO_THROW(g.InsertEdge(3, 0, 1u << 0u));
-#else
-  ASSERT_NO_THROW(g.InsertEdge(2, 1));
-  ASSERT_NO_THROW(g.InsertEdge(1, 2));
-  ASSERT_NO_THROW(g.InsertEdge(2, 4));
-  ASSERT_NO_THROW(g.InsertEdge(4, 2));
-  ASSERT_NO_THROW(g.InsertEdge(2, 0));
-  ASSERT_NO_THROW(g.InsertEdge(0, 2));
-  ASSERT_NO_THROW(g.InsertEdge(0, 3));
-  ASSERT_NO_THROW(g.InsertEdge(3, 0));
-#endif
-  ASSERT_NO_THROW(g.Finalize());
+  for (const auto adjacency : kGraphAdjacencies) {
+    DBSCAN::Graph g(5, 1, nullptr, adjacency);
+    const bool bitmap = adjacency == DBSCAN::Adjacency::Bitmap;
+    if (bitmap) {
+      ASSERT_NO_THROW(g.InsertEdge(2, 0, 1u << 1u));
+      ASSERT_NO_THROW(g.InsertEdge(1, 0, 1u << 2u));
+      ASSERT_NO_THROW(g.InsertEdge(2, 0, 1u << 4u));
+      ASSERT_NO_THROW(g.InsertEdge(4, 0, 1u << 2u));
+      ASSERT_NO_THROW(g.InsertEdge(2, 0, 1u << 0u));
+      ASSERT_NO_THROW(g.InsertEdge(0, 0, 1u << 2u));
+      ASSERT_NO_THROW(g.InsertEdge(0, 0, 1u << 3u));
+      ASSERT_NO_THROW(g.InsertEdge(3, 0, 1u << 0u));
+    } else {
+      ASSERT_NO_THROW(g.InsertEdge(2, 1));
+      ASSERT_NO_THROW(g.InsertEdge(1, 2));
+      ASSERT_NO_THROW(g.InsertEdge(2, 4));
+      ASSERT_NO_THROW(g.InsertEdge(4, 2));
+      ASSERT_NO_THROW(g.InsertEdge(2, 0));
+      ASSERT_NO_THROW(g.InsertEdge(0, 2));
+      ASSERT_NO_THROW(g.InsertEdge(0, 3));
+      ASSERT_NO_THROW(g.InsertEdge(3, 0));
+    }
+    ASSERT_NO_THROW(g.Finalize());
 
-  ASSERT_THAT(g.num_nbs, testing::ElementsAre(2, 1, 3, 1, 1));
-  ASSERT_THAT(g.start_pos, testing::ElementsAre(0, 2, 3, 6, 7));
-// if use bit adjacency matrix, the neighbours are ascending order, where
-// as other type of adjacency list respect the insertion order.
-#if defined(BIT_ADJ)
-  ASSERT_THAT(g.neighbours, testing::ElementsAre(2, 3, 2, 0, 1, 4, 0, 2));
-#else
-  ASSERT_THAT(g.neighbours, testing::ElementsAre(2, 3, 2, 1, 4, 0, 0, 2));
-#endif
+    ASSERT_THAT(g.num_nbs, testing::ElementsAre(2, 1, 3, 1, 1));
+    ASSERT_THAT(g.start_pos, testing::ElementsAre(0, 2, 3, 6, 7));
+    // if use bit adjacency matrix, the neighbours are ascending order, where
+    // as other type of adjacency list respect the insertion order.
+    if (bitmap) {
+      ASSERT_THAT(g.neighbours, testing::ElementsAre(2, 3, 2, 0, 1, 4, 0, 2));
+    } else {
+      ASSERT_THAT(g.neighbours, testing::ElementsAre(2, 3, 2, 1, 4, 0, 0, 2));
+    }
+  }
 }
 
 TEST(Graph, finalize_fail_second_finalize) {
-  DBSCAN::Graph g(5, 1);
-#if defined(BIT_ADJ)
-  ASSERT_NO_THROW(g.InsertEdge(2, 0, 1u << 1u));
-  ASSERT_NO_THROW(g.InsertEdge(2, 0, 1u << 4u));
-  ASSERT_NO_THROW(g.InsertEdge(2, 0, 1u << 0u));
-  ASSERT_NO_THROW(g.InsertEdge(0, 0, 1u << 3u));
-#else
-  ASSERT_NO_THROW(g.InsertEdge(2, 1));
-  ASSERT_NO_THROW(g.InsertEdge(2, 4));
-  ASSERT_NO_THROW(g.InsertEdge(2, 0));
-  ASSERT_NO_THROW(g.InsertEdge(0, 3));
-#endif
-  ASSERT_NO_THROW(g.Finalize());
+  for (const auto adjacency : kGraphAdjacencies) {
+    DBSCAN::Graph g(5, 1, nullptr, adjacency);
+    if (adjacency == DBSCAN::Adjacency::Bitmap) {
+      ASSERT_NO_THROW(g.InsertEdge(2, 0, 1u << 1u));
+      ASSERT_NO_THROW(g.InsertEdge(2, 0, 1u << 4u));
+      ASSERT_NO_THROW(g.InsertEdge(2, 0, 1u << 0u));
+      ASSERT_NO_THROW(g.InsertEdge(0, 0, 1u << 3u));
+    } else {
+      ASSERT_NO_THROW(g.InsertEdge(2, 1));
+      ASSERT_NO_THROW(g.InsertEdge(2, 4));
+      ASSERT_NO_THROW(g.InsertEdge(2, 0));
+      ASSERT_NO_THROW(g.InsertEdge(0, 3));
+    }
+    ASSERT_NO_THROW(g.Finalize());
 
-  ASSERT_THROW(g.Finalize(), std::runtime_error);
+    ASSERT_THROW(g.Finalize(), std::runtime_error);
+  }
 }
 
 TEST(Graph, finalize_success_disconnected_graph) {
-  DBSCAN::Graph g(5, 1);
-#if defined(BIT_ADJ)
-  ASSERT_NO_THROW(g.InsertEdge(2, 0, 1u << 1u));
-  ASSERT_NO_THROW(g.InsertEdge(1, 0, 1u << 2u));
-  ASSERT_NO_THROW(g.InsertEdge(2, 0, 1u << 4u));
-  ASSERT_NO_THROW(g.InsertEdge(4, 0, 1u << 2u));
-  ASSERT_NO_THROW(g.InsertEdge(0, 0, 1u << 2u));
-  ASSERT_NO_THROW(g.InsertEdge(2, 0, 1u << 0u));
-#else
-  ASSERT_NO_THROW(g.InsertEdge(2, 1));
-  ASSERT_NO_THROW(g.InsertEdge(1, 2));
-  ASSERT_NO_THROW(g.InsertEdge(2, 4));
-  ASSERT_NO_THROW(g.InsertEdge(4, 2));
-  ASSERT_NO_THROW(g.InsertEdge(0, 2));
-  ASSERT_NO_THROW(g.InsertEdge(2, 0));
-#endif
-  ASSERT_NO_THROW(g.Finalize());
-  ASSERT_THAT(g.num_nbs, testing::ElementsAre(1, 1, 3, 0, 1));
-  ASSERT_THAT(g.start_pos, testing::ElementsAre(0, 1, 2, 5, 5));
-#if defined(BIT_ADJ)
-  ASSERT_THAT(g.neighbours, testing::ElementsAre(2, 2, 0, 1, 4, 2));
-#else
-  ASSERT_THAT(g.neighbours, testing::ElementsAre(2, 2, 1, 4, 0, 2));
-#endif
+  for (const auto adjacency : kGraphAdjacencies) {
+    DBSCAN::Graph g(5, 1, nullptr, adjacency);
+    const bool bitmap = adjacency == DBSCAN::Adjacency::Bitmap;
+    if (bitmap) {
+      ASSERT_NO_THROW(g.InsertEdge(2, 0, 1u << 1u));
+      ASSERT_NO_THROW(g.InsertEdge(1, 0, 1u << 2u));
+      ASSERT_NO_THROW(g.InsertEdge(2, 0, 1u << 4u));
+      ASSERT_NO_THROW(g.InsertEdge(4, 0, 1u << 2u));
+      ASSERT_NO_THROW(g.InsertEdge(0, 0, 1u << 2u));
+      ASSERT_NO_THROW(g.InsertEdge(2, 0, 1u << 0u));
+    } else {
+      ASSERT_NO_THROW(g.InsertEdge(2, 1));
+      ASSERT_NO_THROW(g.InsertEdge(1, 2));
+      ASSERT_NO_THROW(g.InsertEdge(2, 4));
+      ASSERT_NO_THROW(g.InsertEdge(4, 2));
+      ASSERT_NO_THROW(g.InsertEdge(0, 2));
+      ASSERT_NO_THROW(g.InsertEdge(2, 0));
+    }
+    ASSERT_NO_THROW(g.Finalize());
+    ASSERT_THAT(g.num_nbs, testing::ElementsAre(1, 1, 3, 0, 1));
+    ASSERT_THAT(g.start_pos, testing::ElementsAre(0, 1, 2, 5, 5));
+    if (bitmap) {
+      ASSERT_THAT(g.neighbours, testing::ElementsAre(2, 2, 0, 1, 4, 2));
+    } else {
+      ASSERT_THAT(g.neighbours, testing::ElementsAre(2, 2, 1, 4, 0, 2));
+    }
+  }
 }
 
 TEST(Graph, finalize_success_no_edges) {
@@ -156,6 +205,63 @@ TEST(TwoDimPoints, distance_squared) {
                   std::pow(1.0f - 2.5f, 2) + std::pow(2.0f - 3.4f, 2));
 }
 
+TEST(TwoDimPoints, adopted_columns_read_in_place) {
+  using namespace DBSCAN::input_type;
+  std::vector<float> xs{1, 2, 3}, ys{4, 5, 6};
+  {
+    const auto points = TwoDimPoints::View(xs.data(), ys.data(), xs.size());
+    EXPECT_EQ(points->d1.data(), xs.data());
+    EXPECT_EQ(points->d2.data(), ys.data());
+    EXPECT_THAT(points->d1, testing::ElementsAre(1, 2, 3));
+    EXPECT_THAT(points->d2, testing::ElementsAre(4, 5, 6));
+    // a copy owns its columns.
+    TwoDimPoints copy = *points;
+    EXPECT_NE(copy.d1.data(), xs.data());
+    EXPECT_THAT(copy.d1, testing::ElementsAre(1, 2, 3));
+    copy.d2.push_back(7);
+    EXPECT_THAT(copy.d2, testing::ElementsAre(4, 5, 6, 7));
+  }
+  {
+    // the buffer is handed out once: a later allocation of the same size,
+    // here after a shrink_to_fit and a move, gets storage of its own.
+    Column column(xs.size(), ColumnAllocator<float>(xs.data(), xs.size()));
+    EXPECT_EQ(column.data(), xs.data());
+    column.clear();
+    column.shrink_to_fit();
+    Column moved = std::move(column);
+    moved.assign(3, 9.f);
+    EXPECT_NE(moved.data(), xs.data());
+    EXPECT_THAT(moved, testing::ElementsAre(9, 9, 9));
+  }
+  EXPECT_THAT(xs, testing::ElementsAre(1, 2, 3));
+  EXPECT_THAT(ys, testing::ElementsAre(4, 5, 6));
+}
+
+TEST(Solver, adopted_points_match_owned) {
+  using namespace DBSCAN;
+  auto read = input_type::TwoDimPoints::Read(DBSCAN_TestVariables::abs_loc +
+                                             "/test_input_20k.txt");
+  std::vector<float> xs(read->d1.cbegin(), read->d1.cend());
+  std::vector<float> ys(read->d2.cbegin(), read->d2.cend());
+  const std::vector<float> before = xs;
+  const auto run = [](std::unique_ptr<const input_type::TwoDimPoints> points) {
+    Solver solver(std::move(points), 30, 0.15f, 1u);
+    solver.ConstructGrid();
+    solver.PlanGraph();
+    solver.InsertEdges();
+    solver.FinalizeGraph();
+    solver.ClassifyNoises();
+    solver.IdentifyClusters();
+    return std::make_pair(solver.cluster_ids, solver.memberships);
+  };
+  const auto adopted =
+      run(input_type::TwoDimPoints::View(xs.data(), ys.data(), xs.size()));
+  const auto owned = run(std::move(read));
+  EXPECT_EQ(adopted.first, owned.first);
+  EXPECT_EQ(adopted.second, owned.second);
+  EXPECT_EQ(xs, before);
+}
+
 TEST(Solver, prepare_dataset) {
   using namespace DBSCAN;
   Solver solver(DBSCAN_TestVariables::abs_loc + "/test_input1.txt", 2, 3.0f,
@@ -170,9 +276,7 @@ TEST(Solver, make_graph_small_graph) {
   using namespace DBSCAN;
   Solver solver(DBSCAN_TestVariables::abs_loc + "/test_input1.txt", 2, 3.0f,
                 1u);
-#if !defined(BIT_ADJ)
   ASSERT_NO_THROW(solver.ConstructGrid());
-#endif
   ASSERT_NO_THROW(solver.InsertEdges());
   ASSERT_NO_THROW(solver.FinalizeGraph());
   ASSERT_NO_THROW(solver.ClassifyNoises());
@@ -203,9 +307,7 @@ TEST(Solver, test_input1) {
   using namespace DBSCAN;
   Solver solver(DBSCAN_TestVariables::abs_loc + "/test_input1.txt", 2, 3.0f,
                 1u);
-#if !defined(BIT_ADJ)
   ASSERT_NO_THROW(solver.ConstructGrid());
-#endif
   ASSERT_NO_THROW(solver.InsertEdges());
   ASSERT_NO_THROW(solver.FinalizeGraph());
   ASSERT_NO_THROW(solver.ClassifyNoises());
@@ -219,9 +321,7 @@ TEST(Solver, test_input2) {
   using namespace DBSCAN;
   Solver solver(DBSCAN_TestVariables::abs_loc + "/test_input2.txt", 2, 3.0f,
                 1u);
-#if !defined(BIT_ADJ)
   ASSERT_NO_THROW(solver.ConstructGrid());
-#endif
   ASSERT_NO_THROW(solver.InsertEdges());
   ASSERT_NO_THROW(solver.FinalizeGraph());
   ASSERT_NO_THROW(solver.ClassifyNoises());
@@ -256,9 +356,7 @@ TEST(Solver, test_input3) {
   using namespace DBSCAN;
   Solver solver(DBSCAN_TestVariables::abs_loc + "/test_input3.txt", 3, 3.0f,
                 1u);
-#if !defined(BIT_ADJ)
   ASSERT_NO_THROW(solver.ConstructGrid());
-#endif
   ASSERT_NO_THROW(solver.InsertEdges());
   ASSERT_NO_THROW(solver.FinalizeGraph());
   ASSERT_NO_THROW(solver.ClassifyNoises());
@@ -295,9 +393,7 @@ TEST(Solver, test_input_20k) {
   using namespace DBSCAN;
   Solver solver(DBSCAN_TestVariables::abs_loc + "/test_input_20k.txt", 30,
                 0.15f, 1u);
-#if !defined(BIT_ADJ)
   ASSERT_NO_THROW(solver.ConstructGrid());
-#endif
   ASSERT_NO_THROW(solver.InsertEdges());
   ASSERT_NO_THROW(solver.FinalizeGraph());
   ASSERT_NO_THROW(solver.ClassifyNoises());
@@ -318,9 +414,7 @@ TEST(Solver, test_input_20k_four_threads) {
   using namespace DBSCAN;
   Solver solver(DBSCAN_TestVariables::abs_loc + "/test_input_20k.txt", 30,
                 0.15f, 4u);
-#if !defined(BIT_ADJ)
   ASSERT_NO_THROW(solver.ConstructGrid());
-#endif
 
   ASSERT_NO_THROW(solver.InsertEdges());
   ASSERT_NO_THROW(solver.FinalizeGraph());
@@ -334,6 +428,1822 @@ TEST(Solver, test_input_20k_four_threads) {
   EXPECT_THAT(solver.cluster_ids, testing::ElementsAreArray(expected_labels));
 }
 
+TEST(IncrementalSolver, test_input2) {
+  using namespace DBSCAN;
+  IncrementalSolver solver(2, 3.0f);
+  std::ifstream ifs(DBSCAN_TestVariables::abs_loc + "/test_input2.txt");
+  uint64_t num_vtx, n;
+  float x, y;
+  ifs >> num_vtx;
+  while (ifs >> n >> x >> y) ASSERT_EQ(solver.Insert(x, y), n);
+  std::vector<int> cluster_ids;
+  std::vector<membership> memberships;
+  solver.Labels(cluster_ids, memberships);
+  EXPECT_THAT(memberships, testing::ElementsAre(Core, Core, Core, Border,
+                                                Border, Core, Core, Core, Core,
+                                                Noise));
+  EXPECT_THAT(cluster_ids, testing::ElementsAre(0, 0, 0, 0, 1, 1, 1, 1, 1, -1));
+}
+
+TEST(IncrementalSolver, erase_splits_and_insert_merges) {
+  using namespace DBSCAN;
+  IncrementalSolver solver(2, 1.2f);
+  // a 5x2 ladder of cores; vertex 2i is (i, 0) and 2i+1 is (i, 1).
+  for (int i = 0; i < 5; ++i) {
+    solver.Insert(static_cast<float>(i), 0.f);
+    solver.Insert(static_cast<float>(i), 1.f);
+  }
+  std::vector<int> cluster_ids;
+  std::vector<membership> memberships;
+  solver.Labels(cluster_ids, memberships);
+  EXPECT_THAT(cluster_ids, testing::Each(0));
+  // cutting the middle rung splits the ladder in two.
+  solver.Erase(4);
+  solver.Erase(5);
+  EXPECT_FALSE(solver.IsAlive(4));
+  EXPECT_EQ(solver.num_alive(), 8);
+  ASSERT_THROW(solver.Erase(4), std::runtime_error);
+  solver.Labels(cluster_ids, memberships);
+  EXPECT_THAT(cluster_ids,
+              testing::ElementsAre(0, 0, 0, 0, -1, -1, 1, 1, 1, 1));
+  EXPECT_THAT(memberships, testing::ElementsAre(Core, Core, Core, Core, Noise,
+                                                Noise, Core, Core, Core, Core));
+  // an erased id is recycled; the new point bridges both halves again.
+  EXPECT_EQ(solver.Insert(2.f, 0.5f), 5);
+  solver.Labels(cluster_ids, memberships);
+  EXPECT_THAT(cluster_ids,
+              testing::ElementsAre(0, 0, 0, 0, -1, 0, 0, 0, 0, 0));
+}
+
+TEST(IncrementalSolver, random_updates_match_full_run) {
+  using namespace DBSCAN;
+  const uint64_t min_pts = 4;
+  const float radius = 1.f;
+  IncrementalSolver solver(min_pts, radius);
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<float> coord(0.f, 10.f);
+  std::map<uint64_t, std::pair<float, float>> alive;
+  for (int step = 0; step < 1500; ++step) {
+    if (alive.size() > 50 && gen() % 3 == 0) {
+      auto it = std::next(alive.begin(), gen() % alive.size());
+      solver.Erase(it->first);
+      alive.erase(it);
+    } else {
+      const float x = coord(gen), y = coord(gen);
+      alive[solver.Insert(x, y)] = {x, y};
+    }
+  }
+  std::vector<int> cluster_ids;
+  std::vector<membership> memberships;
+  solver.Labels(cluster_ids, memberships);
+  ASSERT_EQ(solver.num_alive(), alive.size());
+
+  // brute-force, single-threaded DBSCAN over the surviving vertices.
+  const uint64_t n = solver.capacity();
+  std::vector<std::vector<uint64_t>> adj(n);
+  for (const auto& [u, pu] : alive) {
+    for (const auto& [v, pv] : alive) {
+      if (u != v && input_type::TwoDimPoints::euclidean_distance_square(
+                        pu.first, pu.second, pv.first, pv.second) <=
+                        radius * radius)
+        adj[u].push_back(v);
+    }
+  }
+  std::vector<int> expected_ids(n, -1);
+  std::vector<membership> expected_memberships(n, Noise);
+  for (const auto& [u, pu] : alive) {
+    if (adj[u].size() >= min_pts) expected_memberships[u] = Core;
+  }
+  int cluster = 0;
+  for (const auto& [u, pu] : alive) {
+    if (expected_ids[u] != -1 || expected_memberships[u] != Core) continue;
+    std::vector<uint64_t> stack{u};
+    expected_ids[u] = cluster;
+    while (!stack.empty()) {
+      const auto v = stack.back();
+      stack.pop_back();
+      if (expected_memberships[v] != Core) {
+        expected_memberships[v] = Border;
+        continue;
+      }
+      for (const auto w : adj[v]) {
+        if (expected_ids[w] == -1) {
+          expected_ids[w] = cluster;
+          stack.push_back(w);
+        }
+      }
+    }
+    ++cluster;
+  }
+  EXPECT_THAT(memberships, testing::ElementsAreArray(expected_memberships));
+  EXPECT_THAT(cluster_ids, testing::ElementsAreArray(expected_ids));
+}
+
+TEST(WindowedSolver, test_stream1) {
+  using namespace DBSCAN;
+  std::vector<streaming::Snapshot> snapshots;
+  streaming::WindowedSolver solver(
+      2, 1.0f, 2.0, 1.0, [&snapshots](const streaming::Snapshot& snapshot) {
+        snapshots.push_back(snapshot);
+      });
+  streaming::ReplaySource source(DBSCAN_TestVariables::abs_loc +
+                                 "/test_stream1.txt");
+  streaming::TimedPoint p{};
+  while (source.Next(p)) ASSERT_NO_THROW(solver.Push(p));
+  solver.Flush();
+  EXPECT_EQ(solver.num_points(), 4);
+  ASSERT_EQ(snapshots.size(), 3);
+  EXPECT_DOUBLE_EQ(snapshots[0].time, 1.0);
+  EXPECT_THAT(snapshots[0].cluster_ids, testing::ElementsAre(0, 0, 0));
+  // the point at t=0.0 has expired, leaving the first blob below min_pts.
+  EXPECT_DOUBLE_EQ(snapshots[1].time, 2.0);
+  EXPECT_THAT(snapshots[1].cluster_ids, testing::ElementsAre(-1, -1, 0, 0, 0));
+  EXPECT_THAT(snapshots[1].memberships,
+              testing::ElementsAre(Noise, Noise, Core, Core, Core));
+  EXPECT_DOUBLE_EQ(snapshots[2].time, 2.5);
+  EXPECT_THAT(snapshots[2].cluster_ids, testing::ElementsAre(0, 0, 0, -1));
+  ASSERT_THROW(solver.Push({1.0, 0.f, 0.f}), std::runtime_error);
+}
+
+TEST(FittedModel, predict_training_set) {
+  using namespace DBSCAN;
+  Solver solver(DBSCAN_TestVariables::abs_loc + "/test_input_20k.txt", 30,
+                0.15f, 1u);
+  ASSERT_NO_THROW(solver.ConstructGrid());
+  ASSERT_NO_THROW(solver.InsertEdges());
+  ASSERT_NO_THROW(solver.FinalizeGraph());
+  ASSERT_NO_THROW(solver.ClassifyNoises());
+  ASSERT_NO_THROW(solver.IdentifyClusters());
+  FittedModel model(solver, 4u);
+  EXPECT_EQ(model.num_cores(), std::count(solver.memberships.cbegin(),
+                                          solver.memberships.cend(), Core));
+  EXPECT_THAT(model.Predict(solver.dataset()),
+              testing::ElementsAreArray(solver.cluster_ids));
+
+  const std::string path = testing::TempDir() + "/test_input_20k.model";
+  ASSERT_NO_THROW(model.Save(path));
+  std::unique_ptr<FittedModel> loaded;
+  ASSERT_NO_THROW(loaded = FittedModel::Load(path, 2u));
+  EXPECT_EQ(loaded->num_cores(), model.num_cores());
+  EXPECT_FLOAT_EQ(loaded->radius(), 0.15f);
+  EXPECT_THAT(loaded->Predict(solver.dataset()),
+              testing::ElementsAreArray(solver.cluster_ids));
+  std::remove(path.c_str());
+}
+
+TEST(FittedModel, predict_far_away_and_empty_model) {
+  using namespace DBSCAN;
+  input_type::TwoDimPoints cores(3);
+  cores.d1 = {0.f, 1.f, 10.f};
+  cores.d2 = {0.f, 0.f, 0.f};
+  FittedModel model(cores, {0, 0, 1}, 1.5f, 1u);
+  input_type::TwoDimPoints queries(5);
+  queries.d1 = {0.5f, -1.4f, 9.f, 5.5f, 1e9f};
+  queries.d2 = {1.f, 0.f, -1.f, 0.f, 0.f};
+  EXPECT_THAT(model.Predict(queries), testing::ElementsAre(0, 0, 1, -1, -1));
+  FittedModel empty(input_type::TwoDimPoints(0), {}, 1.5f, 1u);
+  EXPECT_THAT(empty.Predict(queries), testing::Each(-1));
+  ASSERT_THROW(FittedModel::Load(testing::TempDir() + "/no_such.model", 1u),
+               std::runtime_error);
+
+  // a header claiming more cores than the file holds is rejected before the
+  // arrays are allocated.
+  const std::string path = testing::TempDir() + "/oversized.model";
+  ASSERT_NO_THROW(model.Save(path));
+  for (const uint64_t n : {uint64_t{4}, uint64_t{1} << 60}) {
+    std::fstream fs(path, std::ios::binary | std::ios::in | std::ios::out);
+    fs.seekp(8);
+    fs.write(reinterpret_cast<const char*>(&n), sizeof(n));
+    fs.close();
+    ASSERT_THROW(FittedModel::Load(path, 1u), std::runtime_error);
+  }
+  std::remove(path.c_str());
+}
+
+TEST(Solver, reset_reuses_solver) {
+  using namespace DBSCAN;
+  Solver solver(DBSCAN_TestVariables::abs_loc + "/test_input3.txt", 3, 3.0f,
+                1u);
+  solver.Reset(input_type::TwoDimPoints::Read(DBSCAN_TestVariables::abs_loc +
+                                              "/test_input2.txt"),
+               2, 3.0f);
+  ASSERT_NO_THROW(solver.ConstructGrid());
+  ASSERT_NO_THROW(solver.InsertEdges());
+  ASSERT_NO_THROW(solver.FinalizeGraph());
+  ASSERT_NO_THROW(solver.ClassifyNoises());
+  ASSERT_NO_THROW(solver.IdentifyClusters());
+  EXPECT_THAT(solver.cluster_ids,
+              testing::ElementsAre(0, 0, 0, 0, 1, 1, 1, 1, 1, -1));
+  ASSERT_THROW(input_type::TwoDimPoints::Read(DBSCAN_TestVariables::abs_loc +
+                                              "/no_such_input.txt"),
+               std::runtime_error);
+}
+
+TEST(Arena, allocate_reset_and_reuse) {
+  using namespace DBSCAN;
+  utils::Arena arena(false, 1024);
+  EXPECT_EQ(arena.capacity(), 0);
+  auto* a = static_cast<char*>(arena.Allocate(100, 8));
+  auto* b = static_cast<char*>(arena.Allocate(10, 32));
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(b) % 32, 0);
+  EXPECT_GE(b, a + 100);
+  // larger than a block: gets a block of its own.
+  auto* c = static_cast<char*>(arena.Allocate(4000, 8));
+  std::fill(c, c + 4000, 1);
+  const auto capacity = arena.capacity();
+  const auto num_blocks = arena.num_blocks();
+  EXPECT_GE(capacity, 5024);
+
+  arena.Reset();
+  EXPECT_EQ(arena.Allocate(100, 8), a);
+  ASSERT_NE(arena.Allocate(4000, 8), nullptr);
+  EXPECT_EQ(arena.capacity(), capacity);
+  EXPECT_EQ(arena.num_blocks(), num_blocks);
+  arena.Release();
+  EXPECT_EQ(arena.capacity(), 0);
+  EXPECT_EQ(arena.num_blocks(), 0);
+  EXPECT_NE(arena.Allocate(100, 8), nullptr);
+
+  // containers deallocate into the arena as a no-op.
+  std::vector<uint64_t, utils::ArenaAllocator<uint64_t>> v{
+      utils::ArenaAllocator<uint64_t>(&arena)};
+  for (uint64_t i = 0; i < 1000; ++i) v.push_back(i);
+  EXPECT_EQ(std::accumulate(v.cbegin(), v.cend(), 0llu), 999 * 1000 / 2);
+}
+
+TEST(Arena, concurrent_allocate) {
+  using namespace DBSCAN;
+  utils::Arena arena(false, 4096);
+  const uint8_t num_threads = 4;
+  std::vector<std::vector<uint32_t*>> chunks(num_threads);
+  utils::run_threads(num_threads, [&](const uint8_t tid) {
+    for (uint32_t i = 0; i < 2000; ++i) {
+      auto* p = static_cast<uint32_t*>(arena.Allocate(3 * sizeof(uint32_t), 4));
+      p[0] = p[1] = p[2] = tid * 10000 + i;
+      chunks[tid].push_back(p);
+    }
+  });
+  // no chunk was overwritten by another thread.
+  for (uint8_t tid = 0; tid < num_threads; ++tid) {
+    for (uint32_t i = 0; i < 2000; ++i) {
+      ASSERT_EQ(chunks[tid][i][0], tid * 10000 + i);
+      ASSERT_EQ(chunks[tid][i][2], tid * 10000 + i);
+    }
+  }
+}
+
+TEST(Solver, arena_reaches_steady_state) {
+  using namespace DBSCAN;
+  const auto input = DBSCAN_TestVariables::abs_loc + "/test_input_20k.txt";
+  for (const bool huge_pages : {false, true}) {
+    Solver solver(input, 4, 0.01f, 1u, huge_pages);
+    std::vector<size_t> capacities, scratch;
+    std::vector<std::vector<int>> labels;
+    for (int run = 0; run < 3; ++run) {
+      if (run > 0)
+        solver.Reset(input_type::TwoDimPoints::Read(input), 4, 0.01f);
+      ASSERT_NO_THROW(solver.ConstructGrid());
+      ASSERT_NO_THROW(solver.InsertEdges());
+      ASSERT_NO_THROW(solver.FinalizeGraph());
+      ASSERT_NO_THROW(solver.ClassifyNoises());
+      ASSERT_NO_THROW(solver.IdentifyClusters());
+      capacities.push_back(solver.arena().capacity());
+      scratch.push_back(solver.scratch().capacity());
+      labels.push_back(solver.cluster_ids);
+    }
+    EXPECT_GT(capacities[0], 0);
+    EXPECT_EQ(capacities[1], capacities[0]);
+    EXPECT_EQ(capacities[2], capacities[0]);
+    // the adjacency lists are rebuilt in the blocks of the first run.
+    EXPECT_GT(scratch[0], 0);
+    EXPECT_EQ(scratch[1], scratch[0]);
+    EXPECT_EQ(scratch[2], scratch[0]);
+    EXPECT_EQ(labels[1], labels[0]);
+    EXPECT_EQ(labels[2], labels[0]);
+  }
+}
+
+TEST(Solver, adjacency_scratch_holds_edges_only) {
+  using namespace DBSCAN;
+  const auto input = DBSCAN_TestVariables::abs_loc + "/test_input_20k.txt";
+  Solver solver(input, 30, 0.15f, 2u);
+  solver.set_plan({Adjacency::Csr, kernels::Widest(), {}});
+  ASSERT_NO_THROW(solver.InsertEdges());
+  const uint64_t candidates =
+      solver.metrics().Find("InsertEdges")->count("candidate_pairs");
+  const size_t scratch = solver.graph_->scratch_bytes();
+  ASSERT_NO_THROW(solver.FinalizeGraph());
+  const uint64_t edges = solver.graph().neighbours.size();
+  // a slot per edge, plus the list headers and the tail of each block.
+  EXPECT_GE(scratch, edges * sizeof(uint64_t));
+  EXPECT_LT(scratch, (edges + candidates) / 2 * sizeof(uint64_t));
+  EXPECT_EQ(solver.graph().scratch_bytes(), 0u);
+}
+
+TEST(Batch, run_manifest) {
+  using namespace DBSCAN;
+  const std::string manifest = testing::TempDir() + "/manifest.txt";
+  {
+    std::ofstream ofs(manifest);
+    const auto& loc = DBSCAN_TestVariables::abs_loc;
+    ofs << "# input eps min_pts\n"
+        << loc << "/test_input1.txt 3 2\n\n"
+        << loc << "/test_input2.txt 3 2\n"
+        << loc << "/no_such_input.txt 3 2\n"
+        << loc << "/test_input3.txt 3 3 " << testing::TempDir() << "/o.txt\n";
+  }
+  const auto jobs = batch::ReadManifest(manifest);
+  ASSERT_EQ(jobs.size(), 4);
+  EXPECT_EQ(jobs[1].min_pts, 2);
+  EXPECT_FLOAT_EQ(jobs[1].eps, 3.0f);
+  EXPECT_TRUE(jobs[0].output.empty());
+  EXPECT_EQ(jobs[3].output, testing::TempDir() + "/o.txt");
+
+  std::mutex mtx;
+  std::map<uint64_t, std::vector<int>> labels;
+  const auto num_failed =
+      batch::Run(jobs, 2u, [&](const uint64_t job, const Solver& solver) {
+        std::lock_guard<std::mutex> lock(mtx);
+        labels[job] = solver.cluster_ids;
+      });
+  EXPECT_EQ(num_failed, 1);
+  ASSERT_EQ(labels.size(), 3);
+  EXPECT_THAT(labels[0], testing::ElementsAre(0, 0, 0, -1, -1, -1));
+  EXPECT_THAT(labels[1], testing::ElementsAre(0, 0, 0, 0, 1, 1, 1, 1, 1, -1));
+  EXPECT_THAT(labels[3],
+              testing::ElementsAre(0, 0, 0, 0, 0, -1, 1, 1, 1, 1, 1));
+  std::remove(manifest.c_str());
+}
+
+TEST(Partition, kd_split_owns_every_vertex_once) {
+  using namespace DBSCAN;
+  const float radius = 0.5f;
+  std::mt19937 gen(7);
+  std::uniform_real_distribution<float> coord(0.0f, 20.0f);
+  input_type::TwoDimPoints points(2000);
+  for (uint64_t i = 0; i < 2000; ++i) {
+    points.d1[i] = coord(gen);
+    points.d2[i] = coord(gen);
+  }
+  const auto parts = partition::KdSplit(points, radius, 5);
+  ASSERT_EQ(parts.size(), 5);
+  std::vector<int> owner(2000, -1);
+  for (int p = 0; p < 5; ++p) {
+    EXPECT_GT(parts[p].owned.size(), 300);
+    for (const auto vtx : parts[p].owned) {
+      ASSERT_EQ(owner[vtx], -1);
+      owner[vtx] = p;
+    }
+  }
+  EXPECT_EQ(std::count(owner.cbegin(), owner.cend(), -1), 0);
+  // every neighbour owned elsewhere is in the halo.
+  const auto dist = input_type::TwoDimPoints::euclidean_distance_square;
+  for (int p = 0; p < 5; ++p) {
+    const auto& halo = parts[p].halo;
+    for (const auto u : parts[p].owned) {
+      for (uint64_t v = 0; v < 2000; ++v) {
+        if (owner[v] == p || dist(points.d1[u], points.d2[u], points.d1[v],
+                                  points.d2[v]) > radius * radius)
+          continue;
+        ASSERT_TRUE(std::find(halo.cbegin(), halo.cend(), v) != halo.cend());
+      }
+    }
+  }
+}
+
+TEST(Partition, merger_stitches_parts) {
+  using namespace DBSCAN;
+  // part A owns 0-2 with local clusters {0}, {2}; part B owns 3-5 with local
+  // cluster {4, 5}. 1 is a border of 0, 3 a border of 2 and 4.
+  partition::Merger merger(6);
+  const auto a = merger.AddPart(2);
+  const auto b = merger.AddPart(1);
+  merger.SetCore(0, a);
+  merger.SetCore(2, a + 1);
+  merger.SetCore(4, b);
+  merger.SetCore(5, b);
+  merger.Link(a + 1, 4);  // 2 and 4 are neighbours
+  merger.Link(b, 3);      // 3 is not Core; no merge
+  merger.AddBorderCandidate(1, 0);
+  merger.AddBorderCandidate(3, 4);
+  merger.AddBorderCandidate(3, 2);
+  std::vector<int> cluster_ids;
+  std::vector<membership> memberships;
+  merger.Finish(cluster_ids, memberships);
+  EXPECT_THAT(cluster_ids, testing::ElementsAre(0, 0, 1, 1, 1, 1));
+  EXPECT_THAT(memberships, testing::ElementsAre(Core, Border, Core, Border,
+                                                Core, Core));
+}
+
+TEST(Distributed, matches_solver) {
+  using namespace DBSCAN;
+  const auto input = DBSCAN_TestVariables::abs_loc + "/test_input_20k.txt";
+  Solver solver(input, 30, 0.15f, 1u);
+  ASSERT_NO_THROW(solver.ConstructGrid());
+  ASSERT_NO_THROW(solver.InsertEdges());
+  ASSERT_NO_THROW(solver.FinalizeGraph());
+  ASSERT_NO_THROW(solver.ClassifyNoises());
+  ASSERT_NO_THROW(solver.IdentifyClusters());
+
+  for (const uint32_t num_workers : {1u, 4u}) {
+    distributed::Coordinator coordinator(30, 0.15f, num_workers, 1u);
+    transport::ForkTransport transport;
+    std::vector<int> cluster_ids;
+    std::vector<membership> memberships;
+    ASSERT_NO_THROW(coordinator.Run(solver.dataset(), transport, cluster_ids,
+                                    memberships));
+    EXPECT_EQ(cluster_ids, solver.cluster_ids);
+    EXPECT_EQ(memberships, solver.memberships);
+  }
+}
+
+TEST(Numa, parse_cpu_list_and_detect) {
+  using namespace DBSCAN;
+  EXPECT_THAT(numa::ParseCpuList("0-3,8,10-11"),
+              testing::ElementsAre(0, 1, 2, 3, 8, 10, 11));
+  EXPECT_TRUE(numa::ParseCpuList("").empty());
+  const auto topo = numa::Topology::Detect();
+  ASSERT_GE(topo.num_nodes(), 1);
+  EXPECT_EQ(topo.NodeOfThread(0, 4), 0);
+  EXPECT_LT(topo.NodeOfThread(3, 4), topo.num_nodes());
+}
+
+// compares the graphs: multi-threaded labels depend on the visiting order.
+TEST(Solver, numa_aware_builds_same_graph) {
+  using namespace DBSCAN;
+  const auto input = DBSCAN_TestVariables::abs_loc + "/test_input_20k.txt";
+  std::vector<std::vector<uint64_t>> num_nbs, neighbours;
+  for (const bool numa_aware : {false, true}) {
+    Solver solver(input, 30, 0.15f, 4u);
+    solver.set_numa_aware(numa_aware);
+    ASSERT_NO_THROW(solver.ConstructGrid());
+    ASSERT_NO_THROW(solver.InsertEdges());
+    ASSERT_NO_THROW(solver.FinalizeGraph());
+    num_nbs.emplace_back(solver.graph_->num_nbs.cbegin(),
+                         solver.graph_->num_nbs.cend());
+    neighbours.emplace_back(solver.graph_->neighbours.cbegin(),
+                            solver.graph_->neighbours.cend());
+    // the order within a grid cell depends on the threads of ConstructGrid.
+    auto& nbs = neighbours.back();
+    for (uint64_t u = 0; u < num_nbs.back().size(); ++u) {
+      const auto begin = nbs.begin() + solver.graph_->start_pos[u];
+      std::sort(begin, begin + num_nbs.back()[u]);
+    }
+  }
+  EXPECT_EQ(num_nbs[0], num_nbs[1]);
+  EXPECT_EQ(neighbours[0], neighbours[1]);
+}
+
+// a single thread runs on the caller, which must not stay pinned.
+TEST(Solver, numa_aware_restores_caller_affinity) {
+  using namespace DBSCAN;
+  const auto input = DBSCAN_TestVariables::abs_loc + "/test_input_20k.txt";
+  cpu_set_t before, after;
+  ASSERT_EQ(pthread_getaffinity_np(pthread_self(), sizeof(before), &before),
+            0);
+  Solver solver(input, 30, 0.15f, 1u);
+  solver.set_numa_aware(true);
+  ASSERT_NO_THROW(solver.InsertEdges());
+  ASSERT_EQ(pthread_getaffinity_np(pthread_self(), sizeof(after), &after), 0);
+  EXPECT_TRUE(CPU_EQUAL(&before, &after));
+  const auto* insert = solver.metrics().Find("InsertEdges");
+  EXPECT_EQ(insert->count("estimated_local_reads") +
+                insert->count("estimated_remote_reads"),
+            insert->count("candidate_pairs"));
+}
+
+TEST(TiledSolver, matches_single_threaded_solver) {
+  using namespace DBSCAN;
+  const auto input = DBSCAN_TestVariables::abs_loc + "/test_input_20k.txt";
+  Solver solver(input, 30, 0.15f, 1u);
+  ASSERT_NO_THROW(solver.ConstructGrid());
+  ASSERT_NO_THROW(solver.InsertEdges());
+  ASSERT_NO_THROW(solver.FinalizeGraph());
+  ASSERT_NO_THROW(solver.ClassifyNoises());
+  ASSERT_NO_THROW(solver.IdentifyClusters());
+
+  for (const uint8_t num_threads : {1u, 3u, 8u}) {
+    TiledSolver tiled(30, 0.15f, num_threads);
+    std::vector<int> cluster_ids;
+    std::vector<membership> memberships;
+    ASSERT_NO_THROW(tiled.Run(solver.dataset(), cluster_ids, memberships));
+    EXPECT_EQ(cluster_ids, solver.cluster_ids);
+    EXPECT_EQ(memberships, solver.memberships);
+  }
+}
+
+TEST(TiledSolver, test_input2_more_tiles_than_cells) {
+  using namespace DBSCAN;
+  const auto dataset = input_type::TwoDimPoints::Read(
+      DBSCAN_TestVariables::abs_loc + "/test_input2.txt");
+  TiledSolver tiled(2, 3.0f, 16u);
+  std::vector<int> cluster_ids;
+  std::vector<membership> memberships;
+  ASSERT_NO_THROW(tiled.Run(*dataset, cluster_ids, memberships));
+  EXPECT_THAT(cluster_ids, testing::ElementsAre(0, 0, 0, 0, 1, 1, 1, 1, 1, -1));
+}
+
+TEST(ApproxSolver, rho_zero_matches_solver) {
+  using namespace DBSCAN;
+  const auto input = DBSCAN_TestVariables::abs_loc + "/test_input_20k.txt";
+  Solver solver(input, 30, 0.15f, 1u);
+  ASSERT_NO_THROW(solver.ConstructGrid());
+  ASSERT_NO_THROW(solver.InsertEdges());
+  ASSERT_NO_THROW(solver.FinalizeGraph());
+  ASSERT_NO_THROW(solver.ClassifyNoises());
+  ASSERT_NO_THROW(solver.IdentifyClusters());
+
+  for (const uint8_t num_threads : {1u, 4u}) {
+    ApproxSolver approx(30, 0.15f, 0.f, num_threads);
+    std::vector<int> cluster_ids;
+    std::vector<membership> memberships;
+    ASSERT_NO_THROW(approx.Run(solver.dataset(), cluster_ids, memberships));
+    EXPECT_EQ(cluster_ids, solver.cluster_ids);
+    EXPECT_EQ(memberships, solver.memberships);
+    EXPECT_GT(approx.num_decisions(), 0u);
+    EXPECT_EQ(approx.num_ambiguous(), 0u);
+  }
+}
+
+// the rounded cell of |far| holds |near|, but the pair is beyond the radius.
+TEST(ApproxSolver, rho_zero_same_cell_boundary) {
+  using namespace DBSCAN;
+  const float radius = 0.933231771f, origin = -49.9885635f,
+              near = 119.604324f, far = 120.264221f;
+  ASSERT_GT((far - near) * (far - near) * 2, radius * radius);
+  auto points = std::make_unique<input_type::TwoDimPoints>(4);
+  points->d1 = {origin, near, far, far};
+  points->d2 = {origin, near, far, far};
+  ApproxSolver approx(2, radius, 0.f, 1u);
+  std::vector<int> cluster_ids;
+  std::vector<membership> memberships;
+  ASSERT_NO_THROW(approx.Run(*points, cluster_ids, memberships));
+
+  Solver solver(std::move(points), 2, radius, 1u);
+  solver.InsertEdges();
+  solver.FinalizeGraph();
+  solver.ClassifyNoises();
+  solver.IdentifyClusters();
+  EXPECT_EQ(memberships, solver.memberships);
+  EXPECT_EQ(memberships[1], membership::Noise);
+}
+
+TEST(ApproxSolver, cores_between_radius_and_outer_radius) {
+  using namespace DBSCAN;
+  const auto input = DBSCAN_TestVariables::abs_loc + "/test_input_20k.txt";
+  const float radius = 0.15f, rho = 0.5f;
+  const auto cores_at = [&input](const float r) {
+    Solver solver(input, 30, r, 1u);
+    solver.ConstructGrid();
+    solver.InsertEdges();
+    solver.FinalizeGraph();
+    solver.ClassifyNoises();
+    return solver.memberships;
+  };
+  const auto inner = cores_at(radius), outer = cores_at(radius * (1 + rho));
+
+  const auto dataset = input_type::TwoDimPoints::Read(input);
+  ApproxSolver approx(30, radius, rho, 2u);
+  std::vector<int> cluster_ids;
+  std::vector<membership> memberships;
+  ASSERT_NO_THROW(approx.Run(*dataset, cluster_ids, memberships));
+  for (uint64_t vtx = 0; vtx < memberships.size(); ++vtx) {
+    if (inner[vtx] == membership::Core) {
+      EXPECT_EQ(memberships[vtx], membership::Core) << vtx;
+    }
+    if (memberships[vtx] == membership::Core) {
+      EXPECT_EQ(outer[vtx], membership::Core) << vtx;
+    }
+    EXPECT_EQ(cluster_ids[vtx] == -1, memberships[vtx] == membership::Noise);
+  }
+  EXPECT_GT(approx.num_ambiguous(), 0u);
+  EXPECT_LE(approx.num_ambiguous(), approx.num_decisions());
+  EXPECT_THROW(ApproxSolver(30, radius, -1.f, 1u), std::runtime_error);
+}
+
+TEST(Output, text_matches_stream_output) {
+  using namespace DBSCAN;
+  std::vector<int> cluster_ids(600000);
+  std::vector<membership> memberships(cluster_ids.size());
+  std::mt19937 gen(7);
+  std::uniform_int_distribution<int> dist(-1, 1 << 30);
+  for (uint64_t vtx = 0; vtx < cluster_ids.size(); ++vtx) {
+    cluster_ids[vtx] = dist(gen);
+    memberships[vtx] = cluster_ids[vtx] == -1 ? membership::Noise
+                       : vtx % 2             ? membership::Core
+                                             : membership::Border;
+  }
+  std::ostringstream expected, expected_ms;
+  const char* names[] = {"core", "border", "noise"};
+  for (uint64_t vtx = 0; vtx < cluster_ids.size(); ++vtx) {
+    expected << cluster_ids[vtx] << '\n';
+    expected_ms << cluster_ids[vtx] << ' ' << names[memberships[vtx]] << '\n';
+  }
+  for (const uint8_t num_threads : {1u, 3u}) {
+    std::ostringstream oss, oss_ms;
+    output::WriteText(oss, cluster_ids, nullptr, num_threads);
+    output::WriteText(oss_ms, cluster_ids, &memberships, num_threads);
+    EXPECT_EQ(oss.str(), expected.str());
+    EXPECT_EQ(oss_ms.str(), expected_ms.str());
+  }
+}
+
+TEST(Output, binary_layout) {
+  using namespace DBSCAN;
+  const std::vector<int> cluster_ids{0, -1, 2};
+  const std::vector<membership> memberships{membership::Core, membership::Noise,
+                                            membership::Border};
+  std::ostringstream oss;
+  output::WriteBinary(oss, cluster_ids, &memberships);
+  const auto bytes = oss.str();
+  ASSERT_EQ(bytes.size(), 3 * sizeof(int32_t) + 3);
+  int32_t labels[3];
+  std::memcpy(labels, bytes.data(), sizeof(labels));
+  EXPECT_THAT(labels, testing::ElementsAre(0, -1, 2));
+  EXPECT_THAT(bytes.substr(sizeof(labels)), testing::ElementsAre(0, 2, 1));
+  EXPECT_EQ(output::ParseFormat("binary"), output::Format::Binary);
+  EXPECT_THROW(output::ParseFormat("csv"), std::runtime_error);
+}
+
+TEST(Summary, matches_sequential_aggregation) {
+  using namespace DBSCAN;
+  const auto input = DBSCAN_TestVariables::abs_loc + "/test_input_20k.txt";
+  Solver solver(input, 30, 0.15f, 4u);
+  ASSERT_NO_THROW(solver.ConstructGrid());
+  ASSERT_NO_THROW(solver.InsertEdges());
+  ASSERT_NO_THROW(solver.FinalizeGraph());
+  ASSERT_NO_THROW(solver.ClassifyNoises());
+  ASSERT_NO_THROW(solver.IdentifyClusters());
+  const auto summary = solver.Summarize();
+
+  const auto& dataset = solver.dataset();
+  summary::Summary expected;
+  for (uint64_t vtx = 0; vtx < dataset.d1.size(); ++vtx) {
+    const int id = solver.cluster_ids[vtx];
+    if (id < 0) {
+      expected.noise.Add(dataset.d1[vtx], dataset.d2[vtx], false);
+      continue;
+    }
+    if (static_cast<uint64_t>(id) >= expected.clusters.size())
+      expected.clusters.resize(id + 1);
+    expected.clusters[id].Add(dataset.d1[vtx], dataset.d2[vtx],
+                              solver.memberships[vtx] == membership::Core);
+  }
+  ASSERT_EQ(summary.num_vtx, dataset.d1.size());
+  ASSERT_EQ(summary.clusters.size(), expected.clusters.size());
+  uint64_t total = summary.noise.size;
+  for (uint64_t id = 0; id < summary.clusters.size(); ++id) {
+    const auto &got = summary.clusters[id], &want = expected.clusters[id];
+    EXPECT_EQ(got.size, want.size);
+    EXPECT_EQ(got.num_core, want.num_core);
+    EXPECT_NEAR(got.centroid_x(), want.centroid_x(), 1e-4);
+    EXPECT_NEAR(got.centroid_y(), want.centroid_y(), 1e-4);
+    EXPECT_EQ(got.min_x, want.min_x);
+    EXPECT_EQ(got.max_y, want.max_y);
+    total += got.size;
+  }
+  EXPECT_EQ(total, dataset.d1.size());
+  EXPECT_EQ(summary.noise.size, expected.noise.size);
+  EXPECT_EQ(summary.noise.num_core, 0u);
+}
+
+TEST(Summary, csv_and_binary_rows) {
+  using namespace DBSCAN;
+  input_type::TwoDimPoints dataset(4);
+  dataset.d1 = {0.f, 2.f, 1.f, 5.f};
+  dataset.d2 = {0.f, 2.f, 4.f, 5.f};
+  const std::vector<int> cluster_ids{0, 0, 1, -1};
+  const std::vector<membership> memberships{
+      membership::Core, membership::Border, membership::Core,
+      membership::Noise};
+  const auto summary =
+      summary::Summarize(dataset, cluster_ids, memberships, 3u);
+  std::ostringstream csv;
+  summary::WriteCsv(csv, summary);
+  EXPECT_EQ(csv.str(),
+            "cluster,size,num_core,centroid_x,centroid_y,min_x,min_y,max_x,"
+            "max_y,fraction\n"
+            "0,2,1,1,1,0,0,2,2,0.5\n"
+            "1,1,1,1,4,1,4,1,4,0.25\n"
+            "-1,1,0,5,5,5,5,5,5,0.25\n");
+  std::ostringstream bin;
+  summary::WriteBinary(bin, summary);
+  ASSERT_EQ(bin.str().size(), 3 * 48u);
+  int32_t id;
+  uint64_t size;
+  std::memcpy(&id, bin.str().data() + 2 * 48, sizeof(id));
+  std::memcpy(&size, bin.str().data() + 48 + 4, sizeof(size));
+  EXPECT_EQ(id, -1);
+  EXPECT_EQ(size, 1u);
+  EXPECT_THROW(summary::ParseFormat("json"), std::runtime_error);
+}
+
+TEST(Generator, deterministic_across_threads) {
+  using namespace DBSCAN;
+  for (const auto shape : {"uniform", "gaussian", "skew", "duplicates"}) {
+    generator::Options options;
+    options.shape = generator::ParseShape(shape);
+    options.num_vtx = 200003;
+    const auto one = generator::Generate(options, 1u);
+    const auto four = generator::Generate(options, 4u);
+    EXPECT_EQ(one->d1, four->d1) << shape;
+    EXPECT_EQ(one->d2, four->d2) << shape;
+    options.seed = 7;
+    EXPECT_NE(generator::Generate(options, 2u)->d1, one->d1) << shape;
+  }
+  EXPECT_THROW(generator::ParseShape("ring"), std::runtime_error);
+}
+
+TEST(Generator, duplicates_and_round_trip) {
+  using namespace DBSCAN;
+  generator::Options options;
+  options.shape = generator::Shape::Duplicates;
+  options.num_vtx = 1000;
+  const auto points = generator::Generate(options, 3u);
+  for (uint64_t vtx = 0; vtx < options.num_vtx; ++vtx) {
+    const uint64_t first = vtx - vtx % generator::kDuplicates;
+    EXPECT_EQ(points->d1[vtx], points->d1[first]);
+    EXPECT_EQ(points->d2[vtx], points->d2[first]);
+  }
+  const std::string path = testing::TempDir() + "generated.txt";
+  generator::Write(path, *points, 2u);
+  const auto read = input_type::TwoDimPoints::Read(path);
+  ASSERT_EQ(read->d1.size(), options.num_vtx);
+  for (uint64_t vtx = 0; vtx < options.num_vtx; ++vtx) {
+    EXPECT_NEAR(read->d1[vtx], points->d1[vtx], 1e-6);
+    EXPECT_NEAR(read->d2[vtx], points->d2[vtx], 1e-6);
+  }
+}
+
+TEST(Metrics, solver_records_every_stage) {
+  using namespace DBSCAN;
+  const auto input = DBSCAN_TestVariables::abs_loc + "/test_input_20k.txt";
+  Solver solver(input, 30, 0.15f, 3u);
+  ASSERT_NO_THROW(solver.ConstructGrid());
+  ASSERT_NO_THROW(solver.InsertEdges());
+  ASSERT_NO_THROW(solver.FinalizeGraph());
+  ASSERT_NO_THROW(solver.ClassifyNoises());
+  ASSERT_NO_THROW(solver.IdentifyClusters());
+
+  const auto& run = solver.metrics();
+  EXPECT_EQ(run.num_vtx, 20000u);
+  EXPECT_EQ(run.num_threads, 3u);
+  ASSERT_NE(run.Find("ConstructGrid"), nullptr);
+  EXPECT_GT(run.Find("ConstructGrid")->count("cells"), 0u);
+  const auto* insert = run.Find("InsertEdges");
+  const auto* finalize = run.Find("FinalizeGraph");
+  const auto* identify = run.Find("IdentifyClusters");
+  ASSERT_NE(insert, nullptr);
+  ASSERT_NE(finalize, nullptr);
+  ASSERT_NE(identify, nullptr);
+  EXPECT_EQ(insert->thread_busy_seconds.size(), 3u);
+  EXPECT_GE(insert->imbalance(), 1.0);
+  EXPECT_GE(insert->count("candidate_pairs"), finalize->count("edges"));
+  EXPECT_EQ(finalize->count("edges"), solver.graph().neighbours.size());
+  EXPECT_EQ(identify->count("clusters"), 4u);
+  EXPECT_EQ(identify->count("cores") + identify->count("borders") +
+                identify->count("noise"),
+            20000u);
+  EXPECT_EQ(run.Find("ClassifyNoises")->count("cores"),
+            identify->count("cores"));
+
+  const auto json = run.ToJson();
+  EXPECT_NE(json.find("\"name\": \"IdentifyClusters\""), std::string::npos);
+  EXPECT_NE(json.find("\"clusters\": 4"), std::string::npos);
+  EXPECT_EQ(std::count(json.begin(), json.end(), '{'),
+            std::count(json.begin(), json.end(), '}'));
+
+  // a new run starts with no stages.
+  solver.Reset(std::make_unique<input_type::TwoDimPoints>(solver.dataset()),
+               30, 0.15f);
+  EXPECT_TRUE(solver.metrics().stages.empty());
+}
+
+TEST(Metrics, run_threads_reports_busy_time) {
+  using namespace DBSCAN;
+  metrics::Run run;
+  {
+    metrics::StageScope scope(run, "sleep");
+    utils::run_threads(2, [](const uint8_t tid) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(20 * (tid + 1)));
+    });
+    scope.Count("things", 7);
+  }
+  ASSERT_EQ(run.stages.size(), 1u);
+  const auto& stage = run.stages[0];
+  ASSERT_EQ(stage.thread_busy_seconds.size(), 2u);
+  EXPECT_GE(stage.thread_busy_seconds[1], 0.04);
+  EXPECT_GT(stage.thread_busy_seconds[1], stage.thread_busy_seconds[0]);
+  EXPECT_GT(stage.imbalance(), 1.0);
+  EXPECT_EQ(stage.count("things"), 7u);
+  EXPECT_EQ(utils::thread_busy_sink, nullptr);
+}
+
+TEST(Perf, counters_merge_valid_events) {
+  using namespace DBSCAN::perf;
+  Counters a, b;
+  a.values[kCycles] = 100;
+  a.valid[kCycles] = true;
+  b.values[kCycles] = 50;
+  b.values[kInstructions] = 300;
+  b.valid[kCycles] = b.valid[kInstructions] = true;
+  EXPECT_EQ(a.ipc(), 0);
+  a += b;
+  EXPECT_EQ(a.values[kCycles], 150u);
+  EXPECT_EQ(a.values[kInstructions], 300u);
+  EXPECT_TRUE(a.valid[kInstructions]);
+  EXPECT_FALSE(a.valid[kDtlbMisses]);
+  EXPECT_DOUBLE_EQ(a.ipc(), 2.0);
+  EXPECT_FALSE(Counters{}.any());
+  EXPECT_TRUE(a.any());
+}
+
+TEST(Perf, profiled_solver_degrades_gracefully) {
+  using namespace DBSCAN;
+  const auto input = DBSCAN_TestVariables::abs_loc + "/test_input_20k.txt";
+  Solver plain(input, 30, 0.15f, 2u), profiled(input, 30, 0.15f, 2u);
+  profiled.set_profiling(true);
+  for (auto* solver : {&plain, &profiled}) {
+    ASSERT_NO_THROW(solver->ConstructGrid());
+    ASSERT_NO_THROW(solver->InsertEdges());
+    ASSERT_NO_THROW(solver->FinalizeGraph());
+    ASSERT_NO_THROW(solver->ClassifyNoises());
+    ASSERT_NO_THROW(solver->IdentifyClusters());
+  }
+  EXPECT_EQ(plain.cluster_ids, profiled.cluster_ids);
+
+  const auto* insert = profiled.metrics().Find("InsertEdges");
+  ASSERT_NE(insert, nullptr);
+  EXPECT_FALSE(plain.metrics().Find("InsertEdges")->counters.any());
+  const auto json = profiled.metrics().ToJson();
+  if (!perf::Available()) {
+    // nothing to count here, but the run itself must not suffer.
+    EXPECT_FALSE(insert->counters.any());
+    EXPECT_EQ(json.find("\"counters\""), std::string::npos);
+    return;
+  }
+  EXPECT_TRUE(insert->counters.any());
+  // the serial parts of a stage are counted too.
+  EXPECT_TRUE(profiled.metrics().Find("ClassifyNoises")->counters.any());
+  EXPECT_NE(json.find("\"counters\": {"), std::string::npos);
+}
+
+// the group counts the threads started while it is open.
+TEST(Perf, group_counts_spawned_threads) {
+  using namespace DBSCAN;
+  // nothing to count without perf_event_open.
+  if (!perf::Available()) return;
+  const auto spin = [](const uint8_t num_threads) {
+    perf::GroupCounters group;
+    utils::run_threads(num_threads, [](const uint8_t) {
+      volatile uint64_t sum = 0;
+      for (uint64_t i = 0; i < 20000000; ++i) sum = sum + i;
+    });
+    return group.Read();
+  };
+  const auto one = spin(1), four = spin(4);
+  if (!one.valid[perf::kInstructions]) return;
+  EXPECT_GT(four.values[perf::kInstructions],
+            3 * one.values[perf::kInstructions]);
+}
+
+TEST(Planner, estimate_matches_grid_candidates) {
+  using namespace DBSCAN;
+  const auto input = DBSCAN_TestVariables::abs_loc + "/test_input_20k.txt";
+  Solver solver(input, 30, 0.15f, 2u);
+  solver.set_plan({Adjacency::Csr, kernels::Kernel::Scalar, {}});
+  ASSERT_NO_THROW(solver.ConstructGrid());
+  // few enough cells to sample them all, so the candidates are exact.
+  const auto estimate = planner::EstimateCosts(solver.grid(), solver.dataset());
+  ASSERT_NO_THROW(solver.InsertEdges());
+  const double scratch = solver.graph_->scratch_bytes();
+  ASSERT_NO_THROW(solver.FinalizeGraph());
+  EXPECT_EQ(estimate.num_candidates,
+            solver.metrics().Find("InsertEdges")->count("candidate_pairs"));
+  const double edges = solver.graph().neighbours.size();
+  EXPECT_GT(estimate.num_edges, edges * 0.9);
+  EXPECT_LT(estimate.num_edges, edges * 1.1);
+  // the lists hold their edges only; the scratch arena rounds up to blocks.
+  EXPECT_GT(estimate.csr_bytes, edges * sizeof(uint64_t));
+  EXPECT_LT(estimate.csr_bytes, scratch * 1.1);
+  // sampling a few cells stays in the same ballpark.
+  const auto sampled =
+      planner::EstimateCosts(solver.grid(), solver.dataset(), 50u);
+  EXPECT_GT(sampled.avg_degree, estimate.avg_degree / 2);
+  EXPECT_LT(sampled.avg_degree, estimate.avg_degree * 2);
+}
+
+// blobs much narrower than a cell: nearly every candidate is a neighbour,
+// far more than the pi/9 of them a uniform density would give.
+TEST(Planner, sampled_degree_follows_clustered_data) {
+  using namespace DBSCAN;
+  generator::Options options;
+  options.num_vtx = 10000;
+  options.num_blobs = 50;
+  options.spread = 0.001f;
+  Solver solver(generator::Generate(options, 2u), 30, 0.02f, 2u);
+  solver.set_plan({Adjacency::Csr, kernels::Kernel::Scalar, {}});
+  ASSERT_NO_THROW(solver.ConstructGrid());
+  const auto estimate =
+      planner::EstimateCosts(solver.grid(), solver.dataset(),
+                             planner::kSampleCells, 1u << 18u);
+  ASSERT_NO_THROW(solver.InsertEdges());
+  ASSERT_NO_THROW(solver.FinalizeGraph());
+  const double edges = solver.graph().neighbours.size();
+  EXPECT_LT(estimate.num_candidates * M_PI / 9, edges / 2);
+  EXPECT_GT(estimate.num_edges, edges * 0.8);
+  EXPECT_LT(estimate.num_edges, edges * 1.25);
+}
+
+TEST(Planner, choose_fits_memory_limit) {
+  using namespace DBSCAN;
+  planner::Estimate estimate;
+  estimate.avg_degree = 100;
+  estimate.num_candidates = 600 * 1000;
+  estimate.grid_bytes = 10;
+  estimate.graph_bytes = 100;
+  estimate.bitmap_bytes = 1000;
+  estimate.blocked_bytes = 300;
+  estimate.csr_bytes = 500;
+  // the grid prunes little: the full bitmap is the fastest
+  EXPECT_EQ(planner::Choose(estimate, 1000u, 0u).adjacency, Adjacency::Bitmap);
+  EXPECT_EQ(planner::Choose(estimate, 1000u, 1110u).adjacency,
+            Adjacency::Bitmap);
+  EXPECT_EQ(planner::Choose(estimate, 1000u, 1109u).adjacency,
+            Adjacency::BlockedBitmap);
+  // nothing fits: the grid alone, searched by the label stages
+  EXPECT_EQ(planner::Choose(estimate, 1000u, 1u).adjacency,
+            Adjacency::Implicit);
+  // 60 candidates a vertex: adjacency lists, then the blocked bitmap
+  EXPECT_EQ(planner::Choose(estimate, 10000u, 0u).adjacency, Adjacency::Csr);
+  EXPECT_EQ(planner::Choose(estimate, 10000u, 500u).adjacency,
+            Adjacency::BlockedBitmap);
+  // 100 candidates a vertex: the blocked bitmap, then the lists
+  estimate.blocked_bytes = 800;
+  EXPECT_EQ(planner::Choose(estimate, 6000u, 0u).adjacency,
+            Adjacency::BlockedBitmap);
+  EXPECT_EQ(planner::Choose(estimate, 6000u, 700u).adjacency, Adjacency::Csr);
+  EXPECT_EQ(planner::Choose(estimate, 6000u, 1u).adjacency,
+            Adjacency::Implicit);
+  EXPECT_EQ(planner::Choose(estimate, 6000u, 0u).kernel, kernels::Widest());
+  for (const auto adjacency : {Adjacency::Bitmap, Adjacency::Csr,
+                               Adjacency::BlockedBitmap, Adjacency::Implicit}) {
+    EXPECT_EQ(planner::ParseAdjacency(planner::ToString(adjacency)),
+              adjacency);
+  }
+  EXPECT_THROW(planner::ParseKernel("sse"), std::runtime_error);
+}
+
+TEST(Planner, every_variant_in_one_binary) {
+  using namespace DBSCAN;
+  const auto input = DBSCAN_TestVariables::abs_loc + "/test_input_20k.txt";
+  Solver planned(input, 30, 0.15f, 2u);
+  planned.PlanGraph();
+  // about 300 neighbours out of 875 candidates: the blocked bitmap wins.
+  EXPECT_EQ(planned.plan().adjacency, Adjacency::BlockedBitmap);
+  EXPECT_NE(planned.metrics().Find("PlanGraph"), nullptr);
+  ASSERT_NO_THROW(planned.InsertEdges());
+  ASSERT_NO_THROW(planned.FinalizeGraph());
+  ASSERT_NO_THROW(planned.ClassifyNoises());
+  ASSERT_NO_THROW(planned.IdentifyClusters());
+
+  for (const auto adjacency : {Adjacency::Bitmap, Adjacency::Csr,
+                               Adjacency::BlockedBitmap, Adjacency::Implicit}) {
+    for (const auto kernel : kernels::Available()) {
+      for (const auto labeller : {Labeller::Bfs, Labeller::UnionFind}) {
+        Solver solver(
+            std::make_unique<input_type::TwoDimPoints>(planned.dataset()), 30,
+            0.15f, 2u);
+        solver.set_plan({adjacency, kernel, {}, Index::Grid, labeller});
+        // the grid path constructs the grid on its own.
+        ASSERT_NO_THROW(solver.InsertEdges());
+        ASSERT_NO_THROW(solver.FinalizeGraph());
+        ASSERT_NO_THROW(solver.ClassifyNoises());
+        ASSERT_NO_THROW(solver.IdentifyClusters());
+        EXPECT_EQ(solver.graph().adjacency(), adjacency);
+        EXPECT_EQ(solver.cluster_ids, planned.cluster_ids)
+            << planner::ToString(adjacency) << "/" << planner::ToString(kernel)
+            << "/" << planner::ToString(labeller);
+        EXPECT_EQ(solver.memberships, planned.memberships);
+        if (adjacency == Adjacency::Implicit) {
+          EXPECT_THROW(solver.SaveGraph(testing::TempDir() + "/implicit.graph"),
+                       std::runtime_error);
+        }
+      }
+    }
+  }
+}
+
+TEST(Planner, kernels_dispatch_to_their_policy) {
+  using namespace DBSCAN;
+  const auto available = kernels::Available();
+  ASSERT_FALSE(available.empty());
+  EXPECT_EQ(available.front(), kernels::Kernel::Scalar);
+  EXPECT_EQ(available.back(), kernels::Widest());
+  EXPECT_EQ(Solver(DBSCAN_TestVariables::abs_loc + "/test_input1.txt", 2,
+                   3.0f, 1u)
+                .plan()
+                .kernel,
+            kernels::Widest());
+  for (const auto kernel : available) {
+    EXPECT_TRUE(kernels::Supported(kernel));
+    EXPECT_EQ(kernels::Dispatch(kernel,
+                                [](auto k) { return decltype(k)::value; }),
+              kernel);
+    EXPECT_EQ(planner::ParseKernel(planner::ToString(kernel)), kernel);
+  }
+  // a kernel this host lacks runs as the widest one instead.
+  for (const auto kernel :
+       {kernels::Kernel::Avx, kernels::Kernel::Avx512}) {
+    if (kernels::Supported(kernel)) continue;
+    Solver solver(DBSCAN_TestVariables::abs_loc + "/test_input1.txt", 2, 3.0f,
+                  1u);
+    solver.set_plan({Adjacency::Csr, kernel, {}});
+    ASSERT_NO_THROW(solver.InsertEdges());
+    EXPECT_EQ(solver.plan().kernel, kernels::Widest());
+  }
+  for (const auto labeller : {Labeller::Bfs, Labeller::UnionFind})
+    EXPECT_EQ(planner::ParseLabeller(planner::ToString(labeller)), labeller);
+  EXPECT_THROW(planner::ParseLabeller("dfs"), std::runtime_error);
+}
+
+TEST(Labeller, union_find_matches_bfs_on_skew_and_duplicates) {
+  using namespace DBSCAN;
+  for (const auto shape :
+       {generator::Shape::Skew, generator::Shape::Duplicates}) {
+    generator::Options options;
+    options.num_vtx = 20000;
+    options.shape = shape;
+    const auto points = generator::Generate(options, 2u);
+    const auto run = [&points](const Labeller labeller, const bool collapse) {
+      auto solver = std::make_unique<Solver>(
+          std::make_unique<input_type::TwoDimPoints>(*points), 8, 0.01f, 4u);
+      planner::Plan plan;
+      plan.labeller = labeller;
+      solver->set_plan(plan);
+      if (collapse) solver->CollapseDuplicates();
+      solver->InsertEdges();
+      solver->FinalizeGraph();
+      solver->ClassifyNoises();
+      solver->IdentifyClusters();
+      return solver;
+    };
+    for (const bool collapse : {false, true}) {
+      const auto bfs = run(Labeller::Bfs, collapse);
+      const auto union_find = run(Labeller::UnionFind, collapse);
+      EXPECT_EQ(union_find->cluster_ids, bfs->cluster_ids);
+      EXPECT_EQ(union_find->memberships, bfs->memberships);
+      const auto* stage = bfs->metrics().Find("IdentifyClusters");
+      EXPECT_GT(stage->count("clusters"), 1u);
+      // the duplicate stacks are all cores.
+      if (shape == generator::Shape::Skew) {
+        EXPECT_GT(stage->count("borders"), 0u);
+      }
+      EXPECT_EQ(union_find->metrics().Find("IdentifyClusters")->count(
+                    "clusters"),
+                stage->count("clusters"));
+    }
+  }
+}
+
+TEST(BlockedBitmap, same_neighbours_as_adjacency_lists) {
+  using namespace DBSCAN;
+  const auto input = DBSCAN_TestVariables::abs_loc + "/test_input_20k.txt";
+  Solver csr(input, 30, 0.15f, 3u);
+  csr.set_plan({Adjacency::Csr, kernels::Widest(), {}});
+  Solver blocked(std::make_unique<input_type::TwoDimPoints>(csr.dataset()), 30,
+                 0.15f, 3u);
+  blocked.set_plan({Adjacency::BlockedBitmap, kernels::Widest(), {}});
+  for (auto* solver : {&csr, &blocked}) {
+    ASSERT_NO_THROW(solver->InsertEdges());
+    ASSERT_NO_THROW(solver->FinalizeGraph());
+  }
+  const auto& expected = csr.graph();
+  const auto& actual = blocked.graph();
+  ASSERT_EQ(actual.num_nbs, expected.num_nbs);
+  ASSERT_EQ(actual.start_pos, expected.start_pos);
+  for (uint64_t u = 0; u < 20000u; ++u) {
+    const auto begin = expected.start_pos[u], end = begin + expected.num_nbs[u];
+    std::vector<uint64_t> want(expected.neighbours.begin() + begin,
+                               expected.neighbours.begin() + end),
+        got(actual.neighbours.begin() + begin,
+            actual.neighbours.begin() + end);
+    std::sort(want.begin(), want.end());
+    std::sort(got.begin(), got.end());
+    ASSERT_EQ(got, want) << "vertex " << u;
+  }
+  EXPECT_EQ(blocked.metrics().Find("InsertEdges")->count("candidate_pairs"),
+            csr.metrics().Find("InsertEdges")->count("candidate_pairs"));
+}
+
+TEST(BlockedBitmap, rows_cover_only_their_spans) {
+  using namespace DBSCAN;
+  // 0 and 1 in one cell, 2 in another: positions 0..2 in cell order 2, 0, 1
+  const std::vector<uint64_t> order{2, 0, 1};
+  Graph graph(3, 1, nullptr, Adjacency::BlockedBitmap);
+  graph.set_cell_order(order.data());
+  EXPECT_THROW(graph.InsertEdge(0u, 1u), std::runtime_error);
+  const Graph::WordSpans spans{{{0, 1}, {0, 0}, {0, 0}}};
+  for (uint64_t u = 0; u < 3; ++u) graph.StartRow(u, spans);
+  // 0 <-> 1 are at positions 1 and 2
+  graph.InsertEdge(0, 0, 1u << 2u);
+  graph.InsertEdge(1, 0, 1u << 1u);
+  EXPECT_THROW(graph.InsertEdge(2, 1, 1u), std::runtime_error);
+  graph.Finalize();
+  EXPECT_THAT(graph.num_nbs, testing::ElementsAre(1, 1, 0));
+  EXPECT_THAT(graph.neighbours, testing::ElementsAre(1, 0));
+}
+
+TEST(TiledBitmap, same_neighbours_as_adjacency_lists) {
+  using namespace DBSCAN;
+  // 20000 is not a multiple of the tile, so the last tile is padded.
+  const auto input = DBSCAN_TestVariables::abs_loc + "/test_input_20k.txt";
+  Solver csr(input, 30, 0.15f, 3u);
+  csr.set_plan({Adjacency::Csr, kernels::Widest(), {}});
+  ASSERT_NO_THROW(csr.InsertEdges());
+  ASSERT_NO_THROW(csr.FinalizeGraph());
+  const auto& expected = csr.graph();
+
+  for (const auto kernel : kernels::Available()) {
+    Solver tiled(std::make_unique<input_type::TwoDimPoints>(csr.dataset()), 30,
+                 0.15f, 3u);
+    tiled.set_plan({Adjacency::Bitmap, kernel, {}});
+    ASSERT_NO_THROW(tiled.InsertEdges());
+    ASSERT_NO_THROW(tiled.FinalizeGraph());
+    const auto& actual = tiled.graph();
+    ASSERT_EQ(actual.num_nbs, expected.num_nbs) << planner::ToString(kernel);
+    for (uint64_t u = 0; u < 20000u; ++u) {
+      const auto begin = expected.start_pos[u];
+      const auto end = begin + expected.num_nbs[u];
+      std::vector<uint64_t> want(expected.neighbours.begin() + begin,
+                                 expected.neighbours.begin() + end),
+          got(actual.neighbours.begin() + begin,
+              actual.neighbours.begin() + end);
+      std::sort(want.begin(), want.end());
+      ASSERT_EQ(got, want) << "vertex " << u;
+    }
+    EXPECT_EQ(tiled.metrics().Find("InsertEdges")->count("candidate_pairs"),
+              20000u * 19999u);
+  }
+}
+
+TEST(KdTree, leaves_partition_the_vertices) {
+  using namespace DBSCAN;
+  for (const uint64_t num_vtx : {0u, 5u, 1000u, 4097u}) {
+    input_type::TwoDimPoints points(num_vtx);
+    std::mt19937 gen(num_vtx);
+    std::uniform_real_distribution<float> coord(-1, 1);
+    for (uint64_t vtx = 0; vtx < num_vtx; ++vtx) {
+      points.d1[vtx] = coord(gen);
+      points.d2[vtx] = vtx % 3 ? 0.5f : coord(gen);
+    }
+    const KdTree tree(points.d1, points.d2, 3u);
+    std::vector<uint64_t> ids = tree.ids();
+    std::sort(ids.begin(), ids.end());
+    std::vector<uint64_t> all(num_vtx);
+    std::iota(all.begin(), all.end(), 0);
+    EXPECT_EQ(ids, all);
+    for (uint64_t node = 0; node + 1 < tree.num_leaves(); ++node) {
+      EXPECT_EQ(tree.Range(node).first, tree.Range(2 * node + 1).first);
+      EXPECT_EQ(tree.Range(2 * node + 1).second,
+                tree.Range(2 * node + 2).first);
+      EXPECT_EQ(tree.Range(node).second, tree.Range(2 * node + 2).second);
+    }
+    for (uint64_t leaf = 0; leaf < tree.num_leaves(); ++leaf) {
+      const auto [begin, end] = tree.Range(tree.num_leaves() - 1 + leaf);
+      EXPECT_LE(end - begin, KdTree::kLeafSize) << num_vtx;
+    }
+    EXPECT_EQ(tree.Range(0), std::make_pair(uint64_t{0}, num_vtx));
+  }
+}
+
+TEST(KdTree, same_neighbours_as_grid_on_skewed_density) {
+  using namespace DBSCAN;
+  generator::Options options;
+  options.shape = generator::Shape::Skew;
+  options.num_vtx = 20000;
+  options.spread = 0.02;
+  Solver grid(generator::Generate(options, 1u), 10, 0.01f, 3u);
+  grid.set_plan({Adjacency::Csr, kernels::Widest(), {}});
+  ASSERT_NO_THROW(grid.InsertEdges());
+  ASSERT_NO_THROW(grid.FinalizeGraph());
+  ASSERT_NO_THROW(grid.ClassifyNoises());
+  const auto& expected = grid.graph();
+
+  for (const auto kernel : kernels::Available()) {
+    Solver tree(std::make_unique<input_type::TwoDimPoints>(grid.dataset()), 10,
+                0.01f, 3u);
+    tree.set_plan({Adjacency::Csr, kernel, {}, Index::KdTree});
+    ASSERT_NO_THROW(tree.InsertEdges());
+    ASSERT_NO_THROW(tree.FinalizeGraph());
+    ASSERT_NO_THROW(tree.ClassifyNoises());
+    // the grid is never needed.
+    EXPECT_EQ(tree.metrics().Find("ConstructGrid"), nullptr);
+    ASSERT_NE(tree.metrics().Find("ConstructKdTree"), nullptr);
+    const auto& actual = tree.graph();
+    ASSERT_EQ(actual.num_nbs, expected.num_nbs) << planner::ToString(kernel);
+    for (uint64_t u = 0; u < options.num_vtx; ++u) {
+      const auto begin = expected.start_pos[u];
+      const auto end = begin + expected.num_nbs[u];
+      std::vector<uint64_t> want(expected.neighbours.begin() + begin,
+                                 expected.neighbours.begin() + end),
+          got(actual.neighbours.begin() + begin,
+              actual.neighbours.begin() + end);
+      std::sort(want.begin(), want.end());
+      std::sort(got.begin(), got.end());
+      ASSERT_EQ(got, want) << "vertex " << u;
+    }
+    EXPECT_EQ(tree.memberships, grid.memberships);
+    // whole subtrees are taken without testing their vertices.
+    EXPECT_LT(tree.metrics().Find("InsertEdges")->count("candidate_pairs"),
+              grid.metrics().Find("InsertEdges")->count("candidate_pairs"));
+  }
+}
+
+namespace {
+// (longitude, latitude) in degrees, crowded around the antimeridian and poles.
+std::unique_ptr<DBSCAN::input_type::TwoDimPoints> SpherePoints_(
+    const uint64_t num_vtx) {
+  auto points = std::make_unique<DBSCAN::input_type::TwoDimPoints>(num_vtx);
+  std::mt19937 gen(11);
+  std::uniform_real_distribution<float> lon(-180, 180), lat(-90, 90),
+      edge(170, 180), cap(80, 90);
+  for (uint64_t vtx = 0; vtx < num_vtx; ++vtx) {
+    const bool flip = vtx % 2;
+    points->d1[vtx] = vtx % 3 == 0 ? (flip ? -edge(gen) : edge(gen)) : lon(gen);
+    points->d2[vtx] = vtx % 3 == 1 ? (flip ? -cap(gen) : cap(gen)) : lat(gen);
+  }
+  return points;
+}
+
+template <class Metric>
+void ExpectEveryNeighbour_(std::unique_ptr<DBSCAN::input_type::TwoDimPoints> p,
+                           const float eps, const DBSCAN::kernels::Kernel k) {
+  using namespace DBSCAN;
+  const input_type::TwoDimPoints points(*p);
+  Solver solver(std::move(p), 5, eps, 2u);
+  solver.set_metric(Metric::kMetric);
+  // the metric overrides a plan it cannot run.
+  solver.set_plan({Adjacency::Bitmap, k, {}});
+  ASSERT_NO_THROW(solver.InsertEdges());
+  ASSERT_NO_THROW(solver.FinalizeGraph());
+  const auto& graph = solver.graph();
+  EXPECT_EQ(graph.adjacency(), Metric::kMetric == metric::Metric::Euclidean
+                                  ? Adjacency::Bitmap
+                                  : Adjacency::Csr);
+  const uint64_t n = points.d1.size();
+  uint64_t num_edges = 0;
+  for (uint64_t u = 0; u < n; ++u) {
+    std::vector<uint64_t> want;
+    for (uint64_t v = 0; v < n; ++v) {
+      if (u != v && Metric::Key(points.d1[u], points.d2[u], points.d1[v],
+                                points.d2[v]) <= Metric::Threshold(eps))
+        want.push_back(v);
+    }
+    const auto begin = graph.neighbours.begin() + graph.start_pos[u];
+    std::vector<uint64_t> got(begin, begin + graph.num_nbs[u]);
+    std::sort(got.begin(), got.end());
+    ASSERT_EQ(got, want) << metric::ToString(Metric::kMetric) << " vertex "
+                         << u;
+    num_edges += want.size();
+  }
+  EXPECT_GT(num_edges, n) << metric::ToString(Metric::kMetric);
+}
+}  // namespace
+
+TEST(Metric, vector_keys_match_scalar) {
+  using namespace DBSCAN;
+  const auto points = SpherePoints_(4096);
+  const auto& xs = points->d1;
+  const auto& ys = points->d2;
+  std::vector<uint64_t> nbs(xs.size());
+  std::iota(nbs.begin(), nbs.end(), 0);
+  std::shuffle(nbs.begin(), nbs.end(), std::mt19937(3));
+  // the tests are built for the baseline: the vector keys are reached
+  // through the kernel TUs.
+  const auto check = [&](auto k, auto metric, const float eps) {
+    using Loops = loops::Loops<decltype(k)::value>;
+    using Metric = decltype(metric);
+    const uint64_t lanes = kernels::Lanes(k);
+    const float threshold = Metric::Threshold(eps);
+    for (uint64_t u = 0; u < 64; ++u) {
+      for (uint64_t i = 0; i < nbs.size(); i += lanes) {
+        // every 8th batch is cut short.
+        const uint64_t n = i / lanes % 8 ? lanes : (lanes + 1) / 2;
+        uint64_t expected = 0;
+        for (uint64_t k = 0; k < n; ++k) {
+          if (Metric::Key(xs[u], ys[u], xs[nbs[i + k]], ys[nbs[i + k]]) <=
+              threshold)
+            expected |= 1llu << k;
+        }
+        ASSERT_EQ(Loops::Within(Metric::kMetric, xs[u], ys[u], threshold,
+                                xs.data(), ys.data(), nbs.data() + i, n),
+                  expected)
+            << planner::ToString(k) << "/"
+            << metric::ToString(Metric::kMetric);
+      }
+    }
+  };
+  for (const auto kernel : kernels::Available()) {
+    kernels::Dispatch(kernel, [&](auto k) {
+      check(k, metric::Euclidean(), 20);
+      check(k, metric::Manhattan(), 20);
+      check(k, metric::Chebyshev(), 20);
+      check(k, metric::Haversine(), 20);
+    });
+  }
+  // the polynomial sines stay within float precision of the haversine.
+  for (uint64_t i = 0; i < 1000; ++i) {
+    const double rad = M_PI / 180, x0 = xs[i] * rad, y0 = ys[i] * rad,
+                 x1 = xs[i + 1] * rad, y1 = ys[i + 1] * rad;
+    const double hav = std::pow(std::sin((y1 - y0) / 2), 2) +
+                       std::cos(y0) * std::cos(y1) *
+                           std::pow(std::sin((x1 - x0) / 2), 2);
+    EXPECT_NEAR(metric::Haversine::Key(xs[i], ys[i], xs[i + 1], ys[i + 1]), hav,
+                1e-6);
+  }
+}
+
+TEST(Metric, grid_finds_every_neighbour) {
+  using namespace DBSCAN;
+  for (const auto kernel : kernels::Available()) {
+    const auto plane = [] {
+      generator::Options options;
+      options.num_vtx = 3000;
+      return generator::Generate(options, 1u);
+    };
+    ExpectEveryNeighbour_<metric::Euclidean>(plane(), 0.03f, kernel);
+    ExpectEveryNeighbour_<metric::Manhattan>(plane(), 0.03f, kernel);
+    ExpectEveryNeighbour_<metric::Chebyshev>(plane(), 0.03f, kernel);
+    // wraps around +-180 and spans every longitude near the poles.
+    ExpectEveryNeighbour_<metric::Haversine>(SpherePoints_(3000), 4.f, kernel);
+  }
+}
+
+TEST(GraphCache, reload_skips_the_graph_for_another_min_pts) {
+  using namespace DBSCAN;
+  const auto input = DBSCAN_TestVariables::abs_loc + "/test_input_20k.txt";
+  const std::string path = testing::TempDir() + "/test_input_20k.graph";
+  Solver first(input, 30, 0.15f, 2u);
+  ASSERT_NO_THROW(first.InsertEdges());
+  EXPECT_THROW(first.SaveGraph(path), std::runtime_error);
+  ASSERT_NO_THROW(first.FinalizeGraph());
+  ASSERT_NO_THROW(first.SaveGraph(path));
+  EXPECT_EQ(first.metrics().Find("SaveGraph")->count("edges"),
+            first.graph().neighbours.size());
+  // concurrent writers of one path do not share a temporary file.
+  const auto& graph = first.graph();
+  const uint64_t hash = graph_cache::Hash(first.dataset(), first.radius(),
+                                          metric::Metric::Euclidean, 2u);
+  utils::run_threads(4, [&](const uint8_t) {
+    graph_cache::Save(path, hash, graph.num_nbs.size(), graph.num_nbs.data(),
+                      graph.start_pos.data(), graph.neighbours.data(),
+                      graph.neighbours.size());
+  });
+
+  Solver fresh(std::make_unique<input_type::TwoDimPoints>(first.dataset()), 10,
+               0.15f, 2u);
+  Solver cached(std::make_unique<input_type::TwoDimPoints>(first.dataset()),
+                10, 0.15f, 3u);
+  ASSERT_NO_THROW(fresh.InsertEdges());
+  ASSERT_NO_THROW(fresh.FinalizeGraph());
+  ASSERT_TRUE(cached.LoadGraph(path));
+  for (auto* solver : {&fresh, &cached}) {
+    ASSERT_NO_THROW(solver->ClassifyNoises());
+    ASSERT_NO_THROW(solver->IdentifyClusters());
+  }
+  EXPECT_EQ(cached.metrics().Find("InsertEdges"), nullptr);
+  EXPECT_EQ(cached.metrics().Find("LoadGraph")->count("edges"),
+            fresh.graph().neighbours.size());
+  EXPECT_EQ(cached.cluster_ids, fresh.cluster_ids);
+  EXPECT_EQ(cached.memberships, fresh.memberships);
+  // Reset drops the mapping; the cache still matches the same dataset.
+  cached.Reset(std::make_unique<input_type::TwoDimPoints>(first.dataset()), 20,
+               0.15f);
+  EXPECT_THROW(cached.ClassifyNoises(), std::runtime_error);
+  EXPECT_TRUE(cached.LoadGraph(path));
+  std::remove(path.c_str());
+}
+
+TEST(GraphCache, rejects_other_datasets) {
+  using namespace DBSCAN;
+  const auto input = DBSCAN_TestVariables::abs_loc + "/test_input_20k.txt";
+  const std::string path = testing::TempDir() + "/test_input_20k_eps.graph";
+  Solver solver(input, 30, 0.15f, 1u);
+  EXPECT_FALSE(solver.LoadGraph(path));
+  ASSERT_NO_THROW(solver.InsertEdges());
+  ASSERT_NO_THROW(solver.FinalizeGraph());
+  ASSERT_NO_THROW(solver.SaveGraph(path));
+
+  Solver other_eps(std::make_unique<input_type::TwoDimPoints>(solver.dataset()),
+                   30, 0.1f, 1u);
+  EXPECT_FALSE(other_eps.LoadGraph(path));
+  Solver other_metric(
+      std::make_unique<input_type::TwoDimPoints>(solver.dataset()), 30, 0.15f,
+      1u);
+  other_metric.set_metric(metric::Metric::Chebyshev);
+  EXPECT_FALSE(other_metric.LoadGraph(path));
+  auto moved = std::make_unique<input_type::TwoDimPoints>(solver.dataset());
+  moved->d1[7] += 1e-3f;
+  Solver other_points(std::move(moved), 30, 0.15f, 1u);
+  EXPECT_FALSE(other_points.LoadGraph(path));
+  // the hash does not depend on the number of threads.
+  Solver more_threads(
+      std::make_unique<input_type::TwoDimPoints>(solver.dataset()), 30, 0.15f,
+      4u);
+  EXPECT_TRUE(more_threads.LoadGraph(path));
+
+  // a cache cut short, e.g. by a full disk, and a file of something else.
+  std::string bytes;
+  {
+    std::ifstream ifs(path, std::ios::binary);
+    bytes.assign(std::istreambuf_iterator<char>(ifs), {});
+  }
+  // of the right size, but a row, then a neighbour, out of place.
+  const uint64_t num_vtx = solver.dataset().d1.size();
+  for (const uint64_t word : {4 + num_vtx + 1, 4 + 2 * num_vtx}) {
+    std::string corrupt = bytes;
+    const uint64_t bad = num_vtx + 1;
+    std::memcpy(&corrupt[word * sizeof(uint64_t)], &bad, sizeof(bad));
+    std::ofstream(path, std::ios::binary | std::ios::trunc)
+        .write(corrupt.data(), corrupt.size());
+    Solver corrupted(
+        std::make_unique<input_type::TwoDimPoints>(solver.dataset()), 30,
+        0.15f, 1u);
+    EXPECT_FALSE(corrupted.LoadGraph(path));
+  }
+  std::ofstream(path, std::ios::binary | std::ios::trunc)
+      .write(bytes.data(), bytes.size() / 2);
+  Solver truncated(std::make_unique<input_type::TwoDimPoints>(solver.dataset()),
+                   30, 0.15f, 1u);
+  EXPECT_FALSE(truncated.LoadGraph(path));
+  std::ofstream(path, std::ios::trunc) << "not a graph";
+  EXPECT_FALSE(truncated.LoadGraph(path));
+  EXPECT_EQ(truncated.metrics().Find("LoadGraph"), nullptr);
+  EXPECT_THROW(truncated.ClassifyNoises(), std::runtime_error);
+  std::remove(path.c_str());
+}
+
+TEST(Dedup, groups_in_order_of_first_id) {
+  using namespace DBSCAN;
+  input_type::TwoDimPoints points(7);
+  points.d1 = {1.f, 0.f, 1.f, -0.f, 3.f, 1.f, 0.05f};
+  points.d2 = {2.f, 0.f, 2.f, 0.f, 3.f, 2.f, 0.07f};
+  for (const uint8_t num_threads : {1u, 3u}) {
+    const auto exact = dedup::Collapse(points, 0.f, num_threads);
+    EXPECT_THAT(exact.weights, testing::ElementsAre(3, 2, 1, 1));
+    EXPECT_THAT(exact.vertex_of, testing::ElementsAre(0, 1, 0, 1, 2, 0, 3));
+    EXPECT_THAT(exact.points->d1, testing::ElementsAre(1.f, 0.f, 3.f, 0.05f));
+    EXPECT_THAT(exact.points->d2, testing::ElementsAre(2.f, 0.f, 3.f, 0.07f));
+    // (0.05, 0.07) shares the [0, 0.1) cell with the origin.
+    const auto snapped = dedup::Collapse(points, 0.1f, num_threads);
+    EXPECT_THAT(snapped.weights, testing::ElementsAre(3, 3, 1));
+    EXPECT_THAT(snapped.vertex_of, testing::ElementsAre(0, 1, 0, 1, 2, 0, 1));
+  }
+  EXPECT_THROW(dedup::Collapse(points, 1e-9f, 1u), std::runtime_error);
+}
+
+TEST(Dedup, collapsed_run_labels_every_input_point) {
+  using namespace DBSCAN;
+  const auto base = input_type::TwoDimPoints::Read(
+      DBSCAN_TestVariables::abs_loc + "/test_input_20k.txt");
+  // vertex i comes back i % 4 more times, shuffled after the originals.
+  std::vector<uint64_t> copies(base->d1.size());
+  std::iota(copies.begin(), copies.end(), 0);
+  for (uint64_t i = 0, n = copies.size(); i < n; ++i) {
+    for (uint64_t c = 0; c < i % 4; ++c) copies.push_back(i);
+  }
+  std::shuffle(copies.begin() + base->d1.size(), copies.end(),
+               std::mt19937(7));
+  auto points = std::make_unique<input_type::TwoDimPoints>(copies.size());
+  for (uint64_t i = 0; i < copies.size(); ++i) {
+    points->d1[i] = base->d1[copies[i]];
+    points->d2[i] = base->d2[copies[i]];
+  }
+
+  Solver plain(std::make_unique<input_type::TwoDimPoints>(*points), 40, 0.1f,
+               2u);
+  Solver collapsed(std::make_unique<input_type::TwoDimPoints>(*points), 40,
+                   0.1f, 2u);
+  ASSERT_NO_THROW(collapsed.CollapseDuplicates());
+  EXPECT_EQ(collapsed.dataset().d1.size(), base->d1.size());
+  EXPECT_EQ(collapsed.metrics().Find("CollapseDuplicates")->count("vertices"),
+            base->d1.size());
+  for (auto* solver : {&plain, &collapsed}) {
+    ASSERT_NO_THROW(solver->ConstructGrid());
+    ASSERT_NO_THROW(solver->InsertEdges());
+    ASSERT_NO_THROW(solver->FinalizeGraph());
+    ASSERT_NO_THROW(solver->ClassifyNoises());
+    ASSERT_NO_THROW(solver->IdentifyClusters());
+  }
+  EXPECT_THROW(collapsed.CollapseDuplicates(), std::runtime_error);
+  EXPECT_LT(3 * collapsed.graph().neighbours.size(),
+            plain.graph().neighbours.size());
+  EXPECT_EQ(collapsed.dataset().d1, points->d1);
+  EXPECT_EQ(collapsed.cluster_ids, plain.cluster_ids);
+  EXPECT_EQ(collapsed.memberships, plain.memberships);
+  EXPECT_GT(std::count(plain.memberships.begin(), plain.memberships.end(),
+                       DBSCAN::Border),
+            0);
+}
+
+namespace {
+// The labels of |query| against those of a full run of the same solver
+// parameters: the lowest core of each full cluster must be the query's.
+void ExpectFullRunLabels_(const DBSCAN::Solver& full,
+                          const DBSCAN::region::Result& query) {
+  std::map<int, int64_t> lowest_core;
+  for (uint64_t u = full.cluster_ids.size(); u-- > 0;) {
+    if (full.memberships[u] == DBSCAN::Core)
+      lowest_core[full.cluster_ids[u]] = u;
+  }
+  ASSERT_EQ(query.clusters.size(), query.vertices.size());
+  for (uint64_t i = 0; i < query.vertices.size(); ++i) {
+    const uint64_t u = query.vertices[i];
+    EXPECT_EQ(query.memberships[i], full.memberships[u]) << u;
+    EXPECT_EQ(query.clusters[i], full.cluster_ids[u] == -1
+                                     ? -1
+                                     : lowest_core[full.cluster_ids[u]])
+        << u;
+  }
+}
+}  // namespace
+
+TEST(Region, matches_full_run_inside_the_box) {
+  using namespace DBSCAN;
+  const auto input = DBSCAN_TestVariables::abs_loc + "/test_input_20k.txt";
+  Solver full(input, 30, 0.15f, 2u);
+  ASSERT_NO_THROW(full.ConstructGrid());
+  ASSERT_NO_THROW(full.InsertEdges());
+  ASSERT_NO_THROW(full.FinalizeGraph());
+  ASSERT_NO_THROW(full.ClassifyNoises());
+  ASSERT_NO_THROW(full.IdentifyClusters());
+
+  Solver query(std::make_unique<input_type::TwoDimPoints>(full.dataset()), 30,
+               0.15f, 2u);
+  const auto& xs = full.dataset().d1;
+  const auto& ys = full.dataset().d2;
+  const auto [min_x, max_x] = std::minmax_element(xs.begin(), xs.end());
+  const auto [min_y, max_y] = std::minmax_element(ys.begin(), ys.end());
+  const float w = *max_x - *min_x, h = *max_y - *min_y;
+  std::mt19937 gen(11);
+  std::uniform_real_distribution<float> at(0.f, 1.f);
+  uint64_t num_borders = 0;
+  for (int trial = 0; trial < 8; ++trial) {
+    const float x = *min_x + at(gen) * w, y = *min_y + at(gen) * h;
+    const region::Box box{x, y, x + w / 8, y + h / 8};
+    const auto result = query.QueryRegion(box);
+    uint64_t inside = 0;
+    for (uint64_t u = 0; u < xs.size(); ++u)
+      inside += box.Contains(xs[u], ys[u]);
+    EXPECT_EQ(result.vertices.size(), inside);
+    EXPECT_TRUE(std::is_sorted(result.vertices.begin(), result.vertices.end()));
+    ExpectFullRunLabels_(full, result);
+    num_borders += std::count(result.memberships.begin(),
+                              result.memberships.end(), Border);
+  }
+  EXPECT_GT(num_borders, 0u);
+  EXPECT_EQ(query.metrics().Find("InsertEdges"), nullptr);
+}
+
+TEST(Region, follows_clusters_out_of_the_box_only) {
+  using namespace DBSCAN;
+  // two far apart clusters: a 100-point line through the box and a blob.
+  auto points = std::make_unique<input_type::TwoDimPoints>(300);
+  for (uint64_t i = 0; i < 100; ++i) {
+    points->d1[i] = 0.1f * i;
+    points->d2[i] = 0.f;
+  }
+  std::mt19937 gen(5);
+  std::normal_distribution<float> blob(100.f, 0.5f);
+  for (uint64_t i = 100; i < 300; ++i) {
+    points->d1[i] = blob(gen);
+    points->d2[i] = blob(gen);
+  }
+  Solver full(std::make_unique<input_type::TwoDimPoints>(*points), 2, 0.15f,
+              1u);
+  ASSERT_NO_THROW(full.InsertEdges());
+  ASSERT_NO_THROW(full.FinalizeGraph());
+  ASSERT_NO_THROW(full.ClassifyNoises());
+  ASSERT_NO_THROW(full.IdentifyClusters());
+  Solver query(std::move(points), 2, 0.15f, 1u);
+  const auto result = query.QueryRegion({4.95f, -1.f, 5.25f, 1.f});
+  ASSERT_THAT(result.vertices, testing::ElementsAre(50, 51, 52));
+  // the line's lowest core is its second point; the blob is never searched.
+  EXPECT_THAT(result.clusters, testing::ElementsAre(1, 1, 1));
+  ExpectFullRunLabels_(full, result);
+  EXPECT_EQ(result.num_visited, 100u);
+}
+
+TEST(Server, clusters_resident_datasets) {
+  using namespace DBSCAN;
+  const auto input = DBSCAN_TestVariables::abs_loc + "/test_input_20k.txt";
+  const std::string socket = testing::TempDir() + "/dbscan_test.sock";
+  server::Server server(2, 2u, 8, true);
+  std::thread serving([&] { server.Serve(socket); });
+  std::unique_ptr<server::Client> client;
+  // the server may not listen yet.
+  for (int attempt = 0; client == nullptr; ++attempt) {
+    try {
+      client = std::make_unique<server::Client>(socket);
+    } catch (const std::runtime_error&) {
+      ASSERT_LT(attempt, 500);
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+
+  EXPECT_EQ(client->Load("blobs", input), 20000u);
+  EXPECT_THROW(client->Cluster({"none", 0.15f, 30}), std::runtime_error);
+  for (const uint64_t min_pts : {30u, 10u}) {
+    Solver solver(input, min_pts, 0.15f, 1u);
+    ASSERT_NO_THROW(solver.InsertEdges());
+    ASSERT_NO_THROW(solver.FinalizeGraph());
+    ASSERT_NO_THROW(solver.ClassifyNoises());
+    ASSERT_NO_THROW(solver.IdentifyClusters());
+    for (const bool cached : {false, true}) {
+      const auto reply = client->Cluster({"blobs", 0.15f, min_pts});
+      EXPECT_EQ(reply.cached, cached);
+      EXPECT_TRUE(reply.labels.vertices.empty());
+      EXPECT_TRUE(std::equal(reply.labels.clusters.begin(),
+                             reply.labels.clusters.end(),
+                             solver.cluster_ids.begin(),
+                             solver.cluster_ids.end()));
+      EXPECT_EQ(reply.labels.memberships, solver.memberships);
+    }
+    // a region of the same resident solver, from another connection.
+    const region::Box box{-5.f, -5.f, 0.f, 0.f};
+    const auto region = server::Client(socket).Cluster(
+        {"blobs", 0.15f, min_pts, true, box});
+    EXPECT_FALSE(region.cached);
+    Solver query(std::make_unique<input_type::TwoDimPoints>(solver.dataset()),
+                 min_pts, 0.15f, 1u);
+    const auto expected = query.QueryRegion(box);
+    EXPECT_FALSE(expected.vertices.empty());
+    EXPECT_EQ(region.labels.vertices, expected.vertices);
+    EXPECT_EQ(region.labels.clusters, expected.clusters);
+    EXPECT_EQ(region.labels.memberships, expected.memberships);
+  }
+  // a reload drops the results of the previous points.
+  EXPECT_EQ(client->Load("blobs", input), 20000u);
+  EXPECT_FALSE(client->Cluster({"blobs", 0.15f, 30}).cached);
+
+  // an idle client does not keep the server from stopping.
+  server::Client idle(socket);
+  client->Shutdown();
+  serving.join();
+  EXPECT_THROW(server::Client{socket}, std::runtime_error);
+}
+
+TEST(Server, handles_concurrent_requests) {
+  using namespace DBSCAN;
+  const auto input = DBSCAN_TestVariables::abs_loc + "/test_input_20k.txt";
+  server::Server server(4, 1u, 0, false);
+  auto load = transport::Message();
+  load.Put(server::Op::Load);
+  load.Put(std::string("blobs"));
+  load.Put(input);
+  ASSERT_EQ(server.Handle(load).Get<uint8_t>(), 0);
+
+  Solver solver(input, 20, 0.1f, 1u);
+  ASSERT_NO_THROW(solver.InsertEdges());
+  ASSERT_NO_THROW(solver.FinalizeGraph());
+  ASSERT_NO_THROW(solver.ClassifyNoises());
+  ASSERT_NO_THROW(solver.IdentifyClusters());
+  std::vector<std::thread> clients;
+  std::vector<std::vector<int64_t>> labels(4);
+  for (uint64_t c = 0; c < labels.size(); ++c) {
+    clients.emplace_back([&, c] {
+      auto request = transport::Message();
+      request.Put(server::Op::Cluster);
+      request.Put(std::string("blobs"));
+      request.Put(c % 2 ? 0.1f : 0.15f);
+      request.Put<uint64_t>(20);
+      request.Put<uint8_t>(0);
+      request.Put(region::Box{});
+      auto reply = server.Handle(request);
+      // status, cached, no vertices for a whole dataset, then the clusters.
+      if (reply.Get<uint8_t>() != 0 || reply.Get<uint8_t>() != 0 ||
+          !reply.GetVector<uint64_t>().empty())
+        return;
+      labels[c] = reply.GetVector<int64_t>();
+    });
+  }
+  for (auto& client : clients) client.join();
+  const std::vector<int64_t> expected(solver.cluster_ids.cbegin(),
+                                      solver.cluster_ids.cend());
+  EXPECT_EQ(labels[1], expected);
+  EXPECT_EQ(labels[3], expected);
+  EXPECT_EQ(labels[0], labels[2]);
+  EXPECT_EQ(labels[0].size(), expected.size());
+  // without |keep_graphs| a whole dataset leaves no solver behind.
+  EXPECT_TRUE(server.datasets_.at("blobs").entries.empty());
+
+  auto garbage = transport::Message();
+  garbage.Put<uint8_t>(7);
+  auto reply = server.Handle(garbage);
+  EXPECT_EQ(reply.Get<uint8_t>(), 1);
+  EXPECT_EQ(reply.GetString(), "unknown request");
+}
+
+TEST(Server, shares_points_and_evicts_solvers) {
+  using namespace DBSCAN;
+  server::Server server(1, 1u, 0, true, 2);
+  auto load = transport::Message();
+  load.Put(server::Op::Load);
+  load.Put(std::string("blobs"));
+  load.Put(DBSCAN_TestVariables::abs_loc + "/test_input_20k.txt");
+  ASSERT_EQ(server.Handle(load).Get<uint8_t>(), 0);
+  for (const float eps : {0.1f, 0.15f, 0.1f, 0.2f}) {
+    auto request = transport::Message();
+    request.Put(server::Op::Cluster);
+    request.Put(std::string("blobs"));
+    request.Put(eps);
+    request.Put<uint64_t>(20);
+    request.Put<uint8_t>(0);
+    request.Put(region::Box{});
+    ASSERT_EQ(server.Handle(request).Get<uint8_t>(), 0);
+  }
+  // 0.15 was the least recently used when 0.2 came in.
+  const auto& resident = server.datasets_.at("blobs");
+  std::vector<float> eps;
+  for (const auto& entry : resident.entries) {
+    eps.push_back(entry.first);
+    // no copy of the points per solver.
+    EXPECT_EQ(entry.second->solver->dataset_, resident.points);
+  }
+  EXPECT_THAT(eps, testing::ElementsAre(0.2f, 0.1f));
+  EXPECT_EQ(resident.points.use_count(), 3);
+}
+
+TEST(Server, hangs_up_on_idle_clients) {
+  using namespace DBSCAN;
+  const std::string socket = testing::TempDir() + "/dbscan_idle.sock";
+  // one worker, which an idle client would otherwise hold forever.
+  server::Server server(1, 1u, 0, true, 4, 100);
+  std::thread serving([&] { server.Serve(socket); });
+  std::unique_ptr<server::Client> idle;
+  for (int attempt = 0; idle == nullptr; ++attempt) {
+    try {
+      idle = std::make_unique<server::Client>(socket);
+    } catch (const std::runtime_error&) {
+      ASSERT_LT(attempt, 500);
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+  server::Client client(socket);
+  EXPECT_EQ(client.Load("blobs", DBSCAN_TestVariables::abs_loc +
+                                     "/test_input1.txt"),
+            6u);
+  EXPECT_THROW(idle->Load("blobs", DBSCAN_TestVariables::abs_loc +
+                                       "/test_input1.txt"),
+               std::runtime_error);
+  client.Shutdown();
+  serving.join();
+}
+
+TEST(Server, survives_oversized_and_truncated_requests) {
+  using namespace DBSCAN;
+  // a count past the end of the message is not allocated.
+  transport::Message truncated;
+  truncated.Put<uint64_t>(1ull << 62);
+  EXPECT_THROW(truncated.GetVector<uint64_t>(), std::runtime_error);
+
+  const std::string socket = testing::TempDir() + "/dbscan_frame.sock";
+  server::Server server(1, 1u, 0, true);
+  std::thread serving([&] { server.Serve(socket); });
+  std::unique_ptr<server::Client> client;
+  for (int attempt = 0; client == nullptr; ++attempt) {
+    try {
+      client = std::make_unique<server::Client>(socket);
+    } catch (const std::runtime_error&) {
+      ASSERT_LT(attempt, 500);
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+  client.reset();
+  {
+    // just the header of a 4 EiB request: the server hangs up.
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, socket.c_str(), sizeof(addr.sun_path) - 1);
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_EQ(connect(fd, reinterpret_cast<const sockaddr*>(&addr),
+                      sizeof(addr)),
+              0);
+    const uint64_t n = 1ull << 62;
+    EXPECT_EQ(write(fd, &n, sizeof(n)), static_cast<ssize_t>(sizeof(n)));
+    char byte;
+    EXPECT_LE(read(fd, &byte, 1), 0);
+    close(fd);
+  }
+  server::Client next(socket);
+  EXPECT_EQ(next.Load("blobs", DBSCAN_TestVariables::abs_loc +
+                                   "/test_input1.txt"),
+            6u);
+  next.Shutdown();
+  serving.join();
+}
+
 int main(int argc, char* argv[]) {
   auto logger = spdlog::stdout_color_mt("console");
   logger->set_level(spdlog::level::off);
@@ -22,6 +22,12 @@ parser.add_argument('--algorithm', type=str, default=['kd_tree'],
                     help="algorithm used to fixed-radius neighbour query. "
                          "Choose between 'brute' and 'kd_tree'",
                     choices=['brute', 'kd_tree'], nargs=1)
+parser.add_argument('--engine', type=str, default='sklearn',
+                    help="'sklearn', or an engine of the dbscan_cpu module "
+                         "built under cpu/python",
+                    choices=['sklearn', 'exact', 'tiled', 'approx'])
+parser.add_argument('--num-threads', type=int, default=1,
+                    help='threads of the dbscan_cpu engines')
 
 args = parser.parse_args()
 
@@ -33,24 +39,31 @@ with open(args.input) as fin:
       continue
     points.append(np.array([float(line[1]), float(line[2])]))
 
-points = np.array(points)
+points = np.array(points, dtype=np.float32 if args.engine != 'sklearn'
+                  else np.float64)
 
 N = len(points)
 
 t = time.time()
-assert len(args.algorithm) == 1
-db = DBSCAN(eps=args.eps, min_samples=args.min_pts + 1,
-            algorithm=args.algorithm[0]).fit(points)
+if args.engine == 'sklearn':
+  assert len(args.algorithm) == 1
+  db = DBSCAN(eps=args.eps, min_samples=args.min_pts + 1,
+              algorithm=args.algorithm[0]).fit(points)
+  labels = db.labels_
+  core_samples_mask = np.zeros_like(labels, dtype=bool)
+  core_samples_mask[db.core_sample_indices_] = True
+else:
+  import dbscan_cpu
+  labels, memberships = dbscan_cpu.fit(points, args.eps, args.min_pts,
+                                       num_threads=args.num_threads,
+                                       engine=args.engine)
+  core_samples_mask = memberships == 0
 print(f"DBSCAN takes {time.time() - t:.4f} seconds")
 
 if args.print:
-  for l in db.labels_:
+  for l in labels:
     print(l)
 
-core_samples_mask = np.zeros_like(db.labels_, dtype=bool)
-core_samples_mask[db.core_sample_indices_] = True
-labels = db.labels_
-
 # Number of clusters in labels, ignoring noise if present.
 n_clusters_ = len(set(labels)) - (1 if -1 in labels else 0)
 n_noise_ = list(labels).count(-1)
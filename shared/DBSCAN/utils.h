@@ -6,6 +6,7 @@
 #define DBSCAN_INCLUDE_UTILS_H_
 
 #include <cmath>
+#include <cstdint>
 #include <cstdlib>
 #include <limits>
 #include <new>
@@ -16,9 +17,9 @@
 
 namespace DBSCAN {
 namespace utils {
-template <class T>
+template <class T, class Alloc>
 std::string print_vector(const std::string& vector_name,
-                         std::vector<T> vector) {
+                         const std::vector<T, Alloc>& vector) {
   std::ostringstream oss;
   oss << vector_name << ": ";
   if (vector.empty()) {